@@ -0,0 +1,111 @@
+#include "camera.h"
+#include <math.h>
+
+#define DEGREES_TO_RADIANS ((float)M_PI / 180.0f)
+
+static void matrix_identity(float m[16]) {
+    for (int i = 0; i < 16; i++) {
+        m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    }
+}
+
+// out = a * b, all column-major; out may not alias a or b
+static void matrix_multiply(const float a[16], const float b[16], float out[16]) {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            out[col * 4 + row] = sum;
+        }
+    }
+}
+
+void camera_view_matrix(const Camera* camera, float matrix[16]) {
+    // Same sequence as glRotatef(-pitch, 1, 0, 0); glRotatef(-yaw, 0, 1, 0);
+    // glTranslatef(-x, -y, -z)
+    float pitch = -camera->pitch * DEGREES_TO_RADIANS;
+    float yaw = -camera->yaw * DEGREES_TO_RADIANS;
+    float rotate_x[16], rotate_y[16], rotation[16], translate[16];
+
+    matrix_identity(rotate_x);
+    rotate_x[5] = cosf(pitch);
+    rotate_x[6] = sinf(pitch);
+    rotate_x[9] = -sinf(pitch);
+    rotate_x[10] = cosf(pitch);
+
+    matrix_identity(rotate_y);
+    rotate_y[0] = cosf(yaw);
+    rotate_y[2] = -sinf(yaw);
+    rotate_y[8] = sinf(yaw);
+    rotate_y[10] = cosf(yaw);
+
+    matrix_identity(translate);
+    translate[12] = -camera->x;
+    translate[13] = -camera->y;
+    translate[14] = -camera->z;
+
+    matrix_multiply(rotate_x, rotate_y, rotation);
+    matrix_multiply(rotation, translate, matrix);
+}
+
+void camera_forward(const Camera* camera, float direction[3]) {
+    // The view looks down -z, which is minus the third row of its rotation
+    float view[16];
+    camera_view_matrix(camera, view);
+    direction[0] = -view[2];
+    direction[1] = -view[6];
+    direction[2] = -view[10];
+}
+
+void projection_matrix(const Projection* projection, float matrix[16]) {
+    float f = 1.0f / tanf(projection->fov_y * 0.5f * DEGREES_TO_RADIANS);
+    float near_plane = projection->near_plane;
+    float far_plane = projection->far_plane;
+
+    for (int i = 0; i < 16; i++) matrix[i] = 0.0f;
+    matrix[0] = f / projection->aspect;
+    matrix[5] = f;
+    matrix[10] = (far_plane + near_plane) / (near_plane - far_plane);
+    matrix[11] = -1.0f;
+    matrix[14] = 2.0f * far_plane * near_plane / (near_plane - far_plane);
+}
+
+void frustum_from_camera(Frustum* frustum, const Camera* camera, const Projection* projection) {
+    float view[16], proj[16], clip[16];
+    camera_view_matrix(camera, view);
+    projection_matrix(projection, proj);
+    matrix_multiply(proj, view, clip);
+    for (int i = 0; i < 16; i++) frustum->clip[i] = clip[i];
+    frustum->eye[0] = camera->x;
+    frustum->eye[1] = camera->y;
+    frustum->eye[2] = camera->z;
+
+    // Each plane is the w row plus or minus the x, y or z row of the clip
+    // matrix: left, right, bottom, top, near, far
+    for (int p = 0; p < 6; p++) {
+        int row = p / 2;
+        float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+        float* plane = frustum->planes[p];
+        for (int c = 0; c < 4; c++) {
+            plane[c] = clip[c * 4 + 3] + sign * clip[c * 4 + row];
+        }
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            for (int c = 0; c < 4; c++) plane[c] /= length;
+        }
+    }
+}
+
+bool frustum_intersects_box(const Frustum* frustum, const float min[3], const float max[3]) {
+    for (int p = 0; p < 6; p++) {
+        const float* plane = frustum->planes[p];
+        // The box corner furthest along the plane normal
+        float x = plane[0] >= 0.0f ? max[0] : min[0];
+        float y = plane[1] >= 0.0f ? max[1] : min[1];
+        float z = plane[2] >= 0.0f ? max[2] : min[2];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) return false;
+    }
+    return true;
+}
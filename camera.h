@@ -0,0 +1,45 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <stdbool.h>
+
+// First-person camera; angles are in degrees, pitch up is positive
+typedef struct {
+    float x, y, z;
+    float pitch, yaw;
+} Camera;
+
+// Perspective projection, as passed to gluPerspective
+typedef struct {
+    float fov_y;  // Vertical field of view in degrees
+    float aspect;  // Width / height
+    float near_plane;
+    float far_plane;
+} Projection;
+
+// Six clip planes (a, b, c, d) in world space, normals pointing inwards:
+// a point is inside a plane when a*x + b*y + c*z + d >= 0
+typedef struct {
+    float planes[6][4];
+    float clip[16];  // Projection * view, column-major
+    float eye[3];  // Camera position
+} Frustum;
+
+// Column-major modelview matrix of the camera: pitch about X, then yaw
+// about Y, then the inverse camera translation
+void camera_view_matrix(const Camera* camera, float matrix[16]);
+
+// Unit vector along the camera's line of sight, in world space
+void camera_forward(const Camera* camera, float direction[3]);
+
+// Column-major projection matrix, identical to gluPerspective
+void projection_matrix(const Projection* projection, float matrix[16]);
+
+// Extract the world-space view frustum of a camera
+void frustum_from_camera(Frustum* frustum, const Camera* camera, const Projection* projection);
+
+// False only if the box is entirely outside one of the planes. Boxes near
+// a frustum corner may pass without intersecting it, never the reverse.
+bool frustum_intersects_box(const Frustum* frustum, const float min[3], const float max[3]);
+
+#endif // CAMERA_H
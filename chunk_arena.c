@@ -0,0 +1,70 @@
+#include "chunk_arena.h"
+
+static void free_retired_ranges(VertexArena* arena, VoxelWorld* world) {
+    for (int i = 0; i < world->retired_count; i++) {
+        vertex_arena_free(arena, world->retired_ranges[i].first, world->retired_ranges[i].count);
+    }
+    world->retired_count = 0;
+}
+
+// Make sure a stale chunk has a range that fits its new mesh without wasting
+// more than half of it; false if the arena has no room left
+static bool place_chunk(VertexArena* arena, Chunk* chunk) {
+    int count = chunk->mesh.vertex_count;
+    if (count <= chunk->vbo_capacity && count * 2 >= chunk->vbo_capacity) return true;
+    if (chunk->vbo_capacity > 0) vertex_arena_free(arena, chunk->vbo_first, chunk->vbo_capacity);
+    chunk->vbo_first = 0;
+    chunk->vbo_capacity = 0;
+    if (count == 0) return true;
+    int first = vertex_arena_alloc(arena, count);
+    if (first < 0) return false;
+    chunk->vbo_first = first;
+    chunk->vbo_capacity = count;
+    return true;
+}
+
+// Give every loaded chunk a new range, packed from the start of an arena
+// with room for all of them. This is both the defragmentation and the
+// resize; the meshes are still in memory, so nothing is copied from the old
+// ranges.
+static void repack(VertexArena* arena, VoxelWorld* world) {
+    long needed = 0;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            const Chunk* chunk = chunk_at_slot(world, x, z);
+            if (chunk->is_loaded) needed += chunk->mesh.vertex_count;
+        }
+    }
+    long capacity = arena->capacity > 0 ? arena->capacity : CHUNK_ARENA_INITIAL_VERTICES;
+    while (capacity - capacity / CHUNK_ARENA_HEADROOM < needed) capacity *= 2;
+    vertex_arena_reset(arena, (int)capacity);
+    world->retired_count = 0;
+
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            chunk->vbo_first = 0;
+            chunk->vbo_capacity = 0;
+            if (!chunk->is_loaded) continue;
+            if (chunk->mesh.vertex_count > 0) {
+                chunk->vbo_first = vertex_arena_alloc(arena, chunk->mesh.vertex_count);
+                chunk->vbo_capacity = chunk->mesh.vertex_count;
+            }
+            chunk->vbo_stale = true;
+        }
+    }
+}
+
+bool chunk_arena_place(VertexArena* arena, VoxelWorld* world) {
+    free_retired_ranges(arena, world);
+    bool fits = arena->capacity > 0;
+    for (int x = 0; x < world->chunk_count && fits; x++) {
+        for (int z = 0; z < world->chunk_count && fits; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            if (chunk->is_loaded && chunk->vbo_stale) fits = place_chunk(arena, chunk);
+        }
+    }
+    if (fits) return false;
+    repack(arena, world);
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef CHUNK_ARENA_H
+#define CHUNK_ARENA_H
+
+#include <stdbool.h>
+#include "voxel_world.h"
+#include "vertex_arena.h"
+
+#define CHUNK_ARENA_INITIAL_VERTICES (1 << 20)  // 1M vertices before the first resize
+#define CHUNK_ARENA_HEADROOM 4  // A repack leaves at least 1/CHUNK_ARENA_HEADROOM of the arena free
+
+// Placement of chunk meshes in one shared vertex buffer. Each chunk keeps
+// its range in vbo_first and vbo_capacity; the renderer copies the meshes
+// in and draws every visible range from the one buffer.
+
+// Free the ranges of chunks that left the view, then find a range for every
+// loaded chunk whose mesh was rebuilt (vbo_stale). A range is reused while
+// the mesh fits and fills at least half of it. If a mesh finds no room,
+// the arena is repacked: every loaded chunk gets a new range, packed from
+// the start, in an arena grown as needed, and is marked stale. Returns true
+// after a repack; the caller's copy of the buffer is then void, and it must
+// be resized if the arena's capacity changed. An empty arena (capacity 0)
+// is always repacked.
+bool chunk_arena_place(VertexArena* arena, VoxelWorld* world);
+
+#endif // CHUNK_ARENA_H
@@ -0,0 +1,103 @@
+#include "chunk_cache.h"
+#include <stdlib.h>
+
+static unsigned int bucket_of(int chunk_x, int chunk_z) {
+    unsigned int h = (unsigned int)chunk_x * 0x9e3779b1u ^ (unsigned int)chunk_z * 0x85ebca77u;
+    return (h ^ (h >> 15)) & (CHUNK_CACHE_BUCKETS - 1);
+}
+
+static ChunkCacheEntry** find_link(ChunkCache* cache, int chunk_x, int chunk_z) {
+    ChunkCacheEntry** link = &cache->buckets[bucket_of(chunk_x, chunk_z)];
+    while (*link && ((*link)->chunk_x != chunk_x || (*link)->chunk_z != chunk_z)) {
+        link = &(*link)->hash_next;
+    }
+    return link;
+}
+
+static void unlink_lru(ChunkCache* cache, ChunkCacheEntry* entry) {
+    if (entry->newer) entry->newer->older = entry->older;
+    else cache->newest = entry->older;
+    if (entry->older) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+// Unlink an entry found through `link` and hand its contents to the caller
+static void remove_entry(ChunkCache* cache, ChunkCacheEntry** link, ChunkStorage* storage, bool* needs_save) {
+    ChunkCacheEntry* entry = *link;
+    *link = entry->hash_next;
+    unlink_lru(cache, entry);
+    cache->count--;
+    cache->bytes -= entry->bytes;
+    *storage = entry->storage;
+    *needs_save = entry->needs_save;
+    free(entry);
+}
+
+void chunk_cache_init(ChunkCache* cache, size_t byte_limit) {
+    for (int i = 0; i < CHUNK_CACHE_BUCKETS; i++) {
+        cache->buckets[i] = NULL;
+    }
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->count = 0;
+    cache->bytes = 0;
+    cache->byte_limit = byte_limit;
+    cache->stats = (ChunkCacheStats){0};
+}
+
+bool chunk_cache_put(ChunkCache* cache, int chunk_x, int chunk_z, ChunkStorage* storage, bool needs_save) {
+    ChunkCacheEntry* entry = cache->byte_limit ? malloc(sizeof(ChunkCacheEntry)) : NULL;
+    if (!entry) return false;
+
+    // A chunk is only cached while out of view, so a stale entry is unusual
+    ChunkCacheEntry** link = find_link(cache, chunk_x, chunk_z);
+    if (*link) {
+        ChunkStorage stale;
+        bool stale_needs_save;
+        remove_entry(cache, link, &stale, &stale_needs_save);
+        chunk_storage_free(&stale);
+    }
+
+    entry->chunk_x = chunk_x;
+    entry->chunk_z = chunk_z;
+    entry->storage = *storage;
+    entry->needs_save = needs_save;
+    entry->bytes = sizeof(ChunkCacheEntry) + chunk_storage_bytes(storage);
+    chunk_storage_init(storage);
+
+    entry->hash_next = cache->buckets[bucket_of(chunk_x, chunk_z)];
+    cache->buckets[bucket_of(chunk_x, chunk_z)] = entry;
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) cache->newest->newer = entry;
+    else cache->oldest = entry;
+    cache->newest = entry;
+    cache->count++;
+    cache->bytes += entry->bytes;
+    return true;
+}
+
+bool chunk_cache_take(ChunkCache* cache, int chunk_x, int chunk_z, ChunkStorage* storage, bool* needs_save) {
+    ChunkCacheEntry** link = find_link(cache, chunk_x, chunk_z);
+    if (!*link) {
+        cache->stats.misses++;
+        return false;
+    }
+    remove_entry(cache, link, storage, needs_save);
+    cache->stats.hits++;
+    return true;
+}
+
+bool chunk_cache_over_limit(const ChunkCache* cache) {
+    return cache->bytes > cache->byte_limit;
+}
+
+bool chunk_cache_pop_oldest(ChunkCache* cache, int* chunk_x, int* chunk_z, ChunkStorage* storage, bool* needs_save) {
+    ChunkCacheEntry* entry = cache->oldest;
+    if (!entry) return false;
+    *chunk_x = entry->chunk_x;
+    *chunk_z = entry->chunk_z;
+    remove_entry(cache, find_link(cache, entry->chunk_x, entry->chunk_z), storage, needs_save);
+    cache->stats.evictions++;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef CHUNK_CACHE_H
+#define CHUNK_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "chunk_storage.h"
+
+#define CHUNK_CACHE_BUCKETS 1024  // Hash buckets (power of two)
+
+// A chunk that left the view, kept so coming back does not reload it
+typedef struct ChunkCacheEntry {
+    int chunk_x;
+    int chunk_z;
+    ChunkStorage storage;
+    bool needs_save;  // Blocks differ from the saved copy
+    size_t bytes;  // Memory charged against the cache limit
+    struct ChunkCacheEntry* newer;  // LRU list, oldest at the tail
+    struct ChunkCacheEntry* older;
+    struct ChunkCacheEntry* hash_next;
+} ChunkCacheEntry;
+
+typedef struct {
+    long hits;
+    long misses;
+    long evictions;  // Entries removed by chunk_cache_pop_oldest
+} ChunkCacheStats;
+
+// Least-recently-used cache of evicted chunk blocks keyed by chunk
+// coordinates. Block storage is moved in and out, never copied.
+typedef struct {
+    ChunkCacheEntry* buckets[CHUNK_CACHE_BUCKETS];
+    ChunkCacheEntry* newest;
+    ChunkCacheEntry* oldest;
+    int count;
+    size_t bytes;
+    size_t byte_limit;  // 0 disables the cache
+    ChunkCacheStats stats;
+} ChunkCache;
+
+void chunk_cache_init(ChunkCache* cache, size_t byte_limit);
+
+// Take ownership of a chunk's storage, leaving `storage` empty. Replaces any
+// entry for the same chunk. The cache may exceed its limit until
+// chunk_cache_pop_oldest drains it. Returns false, leaving `storage` with the
+// caller, when the cache is disabled or out of memory.
+bool chunk_cache_put(ChunkCache* cache, int chunk_x, int chunk_z, ChunkStorage* storage, bool needs_save);
+
+// Move a cached chunk's storage out and drop the entry; false on a miss
+bool chunk_cache_take(ChunkCache* cache, int chunk_x, int chunk_z, ChunkStorage* storage, bool* needs_save);
+
+// True while the cache holds more than its memory limit
+bool chunk_cache_over_limit(const ChunkCache* cache);
+
+// Remove the least recently used entry, handing its storage to the caller
+// (which must free it); false if the cache is empty
+bool chunk_cache_pop_oldest(ChunkCache* cache, int* chunk_x, int* chunk_z, ChunkStorage* storage, bool* needs_save);
+
+#endif // CHUNK_CACHE_H
@@ -0,0 +1,548 @@
+#include "chunk_mesh.h"
+#include "lighting.h"
+#include "profiler.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PADDED_X (CHUNK_SIZE + 2)
+#define PADDED_Y (WORLD_HEIGHT + 2)
+#define PADDED_Z (CHUNK_SIZE + 2)
+#define MASK_DIM (WORLD_HEIGHT > CHUNK_SIZE ? WORLD_HEIGHT : CHUNK_SIZE)
+// Face mask entries hold the block type, the face's light above it, and
+// above that two bits of ambient occlusion per corner
+#define FACE_LIGHT_SHIFT 8
+#define FACE_AO_SHIFT 12
+#define FACE_OPEN (0xffu << FACE_AO_SHIFT)  // Every corner unoccluded
+#define LIGHT_AMBIENT 0.1f  // Brightness of a face no light reaches
+#define LIGHT_FALLOFF 0.8f  // Brightness kept per light level below MAX_LIGHT
+
+_Static_assert(SECTION_HEIGHT % (1 << (LOD_LEVELS - 1)) == 0, "coarsest cells must not straddle sections");
+_Static_assert(CHUNK_SIZE < 32 && WORLD_HEIGHT < 64, "corners must fit the packed position fields");
+_Static_assert(BLOCK_TYPE_COUNT <= 64 && PACKED_LIGHT_LEVELS <= 32, "packed vertex fields too narrow");
+
+// Chunk blocks plus a one-block border on every side, so face culling never
+// needs bounds checks. Border cells are air unless filled in from neighbours.
+// Below full detail each cell stands for scale^3 blocks and only the low
+// corner of the array is used.
+typedef struct {
+    unsigned char blocks[PADDED_X][PADDED_Y][PADDED_Z];
+    // Brighter of sky and block light per cell; full where it is not known
+    // (missing neighbours, above the world, coarser levels of detail)
+    unsigned char light[PADDED_X][PADDED_Y][PADDED_Z];
+    int scale;  // Blocks per cell side
+} PaddedChunk;
+
+// Colour of each block type's top, sides and bottom
+static const Color block_colors[BLOCK_TYPE_COUNT][3] = {
+    [BLOCK_DIRT] = {{1.0f, 0.5f, 0.0f}, {1.0f, 0.5f, 0.0f}, {1.0f, 0.5f, 0.0f}},
+    [BLOCK_GRASS] = {{0.0f, 0.8f, 0.0f}, {1.0f, 0.5f, 0.0f}, {1.0f, 0.5f, 0.0f}},
+    [BLOCK_LAMP] = {{1.0f, 0.9f, 0.6f}, {1.0f, 0.9f, 0.6f}, {1.0f, 0.9f, 0.6f}},
+};
+
+// Shading by face direction, indexed by axis * 2 + side (side 0 faces -axis, side 1 faces +axis)
+static const float face_shade[6] = {0.75f, 0.65f, 0.5f, 1.0f, 0.8f, 0.7f};
+
+// Brightness by ambient occlusion level
+static const float occlusion_brightness[4] = {0.45f, 0.65f, 0.85f, 1.0f};
+
+// Corners of a face in (u, v), in the order their occlusion is packed
+static const int corner_u[4] = {0, 1, 1, 0};
+static const int corner_v[4] = {0, 0, 1, 1};
+
+static MeshShading shading;
+static pthread_once_t shading_once = PTHREAD_ONCE_INIT;
+
+static void build_shading(void) {
+    for (int block = 0; block < BLOCK_TYPE_COUNT; block++) {
+        for (int normal = 0; normal < 6; normal++) {
+            // Top, sides, bottom
+            int part = normal == 3 ? 0 : normal == 2 ? 2 : 1;
+            shading.face_color[block][normal] = block_colors[block][part];
+        }
+    }
+    for (int normal = 0; normal < 6; normal++) {
+        for (int light = 0; light <= MAX_LIGHT; light++) {
+            shading.brightness[normal][light] =
+                face_shade[normal] * (LIGHT_AMBIENT + (1.0f - LIGHT_AMBIENT) * powf(LIGHT_FALLOFF, MAX_LIGHT - light));
+        }
+        shading.brightness[normal][PACKED_LIGHT_EMISSIVE] = 1.0f;
+    }
+    memcpy(shading.occlusion, occlusion_brightness, sizeof(shading.occlusion));
+}
+
+const MeshShading* chunk_mesh_shading(void) {
+    pthread_once(&shading_once, build_shading);
+    return &shading;
+}
+
+static unsigned char combined_light(unsigned char light) {
+    int sky = light_sky(light), block = light_block(light);
+    return (unsigned char)(sky > block ? sky : block);
+}
+
+static void build_padded(const DenseBlocks blocks, const ChunkLight* light, const ChunkNeighbours* neighbours,
+                         PaddedChunk* padded) {
+    memset(padded->blocks, 0, sizeof(padded->blocks));
+    memset(padded->light, MAX_LIGHT, sizeof(padded->light));
+    padded->scale = 1;
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < WORLD_HEIGHT; y++) {
+            memcpy(&padded->blocks[x + 1][y + 1][1], blocks[x][y], CHUNK_SIZE);
+            for (int z = 0; z < CHUNK_SIZE; z++) padded->light[x + 1][y + 1][z + 1] = combined_light(chunk_light_get(light, x, y, z));
+        }
+    }
+    if (!neighbours) return;
+
+    // Copy the edge slab of each loaded neighbour into the border
+    for (int y = 0; y < WORLD_HEIGHT; y++) {
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            if (neighbours->neg_x) {
+                padded->blocks[0][y + 1][i + 1] = chunk_storage_get(&neighbours->neg_x->storage, CHUNK_SIZE - 1, y, i);
+                padded->light[0][y + 1][i + 1] = combined_light(chunk_light_get(&neighbours->neg_x->light, CHUNK_SIZE - 1, y, i));
+            }
+            if (neighbours->pos_x) {
+                padded->blocks[PADDED_X - 1][y + 1][i + 1] = chunk_storage_get(&neighbours->pos_x->storage, 0, y, i);
+                padded->light[PADDED_X - 1][y + 1][i + 1] = combined_light(chunk_light_get(&neighbours->pos_x->light, 0, y, i));
+            }
+            if (neighbours->neg_z) {
+                padded->blocks[i + 1][y + 1][0] = chunk_storage_get(&neighbours->neg_z->storage, i, y, CHUNK_SIZE - 1);
+                padded->light[i + 1][y + 1][0] = combined_light(chunk_light_get(&neighbours->neg_z->light, i, y, CHUNK_SIZE - 1));
+            }
+            if (neighbours->pos_z) {
+                padded->blocks[i + 1][y + 1][PADDED_Z - 1] = chunk_storage_get(&neighbours->pos_z->storage, i, y, 0);
+                padded->light[i + 1][y + 1][PADDED_Z - 1] = combined_light(chunk_light_get(&neighbours->pos_z->light, i, y, 0));
+            }
+        }
+    }
+}
+
+// A downsampled cell is solid when at least half its blocks are, and takes
+// the type of its highest solid block so grass stays on top
+static unsigned char downsample_cell(const DenseBlocks blocks, int cx, int cy, int cz, int scale) {
+    int solid = 0;
+    unsigned char top = 0;
+    for (int y = cy * scale; y < (cy + 1) * scale; y++) {
+        for (int x = cx * scale; x < (cx + 1) * scale; x++) {
+            for (int z = cz * scale; z < (cz + 1) * scale; z++) {
+                if (blocks[x][y][z] == 0) continue;
+                solid++;
+                top = blocks[x][y][z];
+            }
+        }
+    }
+    return solid * 2 >= scale * scale * scale ? top : 0;
+}
+
+// Padded cells of a chunk downsampled by `scale`, with the border taken from
+// the neighbours downsampled the same way
+static void build_padded_lod(const DenseBlocks blocks, const ChunkNeighbours* neighbours, int scale,
+                             PaddedChunk* padded) {
+    int cells = CHUNK_SIZE / scale;
+    int layers = WORLD_HEIGHT / scale;
+    memset(padded->blocks, 0, sizeof(padded->blocks));
+    memset(padded->light, MAX_LIGHT, sizeof(padded->light));
+    padded->scale = scale;
+    for (int x = 0; x < cells; x++) {
+        for (int y = 0; y < layers; y++) {
+            for (int z = 0; z < cells; z++) {
+                padded->blocks[x + 1][y + 1][z + 1] = downsample_cell(blocks, x, y, z, scale);
+            }
+        }
+    }
+    if (!neighbours) return;
+
+    DenseBlocks edge;
+    if (neighbours->neg_x) {
+        chunk_storage_decode(&neighbours->neg_x->storage, edge);
+        for (int y = 0; y < layers; y++) {
+            for (int i = 0; i < cells; i++) padded->blocks[0][y + 1][i + 1] = downsample_cell(edge, cells - 1, y, i, scale);
+        }
+    }
+    if (neighbours->pos_x) {
+        chunk_storage_decode(&neighbours->pos_x->storage, edge);
+        for (int y = 0; y < layers; y++) {
+            for (int i = 0; i < cells; i++) padded->blocks[cells + 1][y + 1][i + 1] = downsample_cell(edge, 0, y, i, scale);
+        }
+    }
+    if (neighbours->neg_z) {
+        chunk_storage_decode(&neighbours->neg_z->storage, edge);
+        for (int y = 0; y < layers; y++) {
+            for (int i = 0; i < cells; i++) padded->blocks[i + 1][y + 1][0] = downsample_cell(edge, i, y, cells - 1, scale);
+        }
+    }
+    if (neighbours->pos_z) {
+        chunk_storage_decode(&neighbours->pos_z->storage, edge);
+        for (int y = 0; y < layers; y++) {
+            for (int i = 0; i < cells; i++) padded->blocks[i + 1][y + 1][cells + 1] = downsample_cell(edge, i, y, 0, scale);
+        }
+    }
+}
+
+static unsigned char padded_at(const PaddedChunk* padded, const int pos[3]) {
+    return padded->blocks[pos[0] + 1][pos[1] + 1][pos[2] + 1];
+}
+
+static unsigned char padded_light(const PaddedChunk* padded, const int pos[3]) {
+    return padded->light[pos[0] + 1][pos[1] + 1][pos[2] + 1];
+}
+
+static void mesh_reset(ChunkMesh* mesh) {
+    mesh->vertex_count = 0;
+    mesh->quad_count = 0;
+}
+
+static PackedVertex* mesh_reserve_quad(ChunkMesh* mesh) {
+    if (mesh->vertex_count + QUAD_VERTICES > mesh->capacity) {
+        int new_capacity = mesh->capacity ? mesh->capacity * 2 : 1024;
+        PackedVertex* vertices = realloc(mesh->vertices, new_capacity * sizeof(PackedVertex));
+        if (!vertices) return NULL;
+        mesh->vertices = vertices;
+        mesh->capacity = new_capacity;
+    }
+    PackedVertex* quad = &mesh->vertices[mesh->vertex_count];
+    mesh->vertex_count += QUAD_VERTICES;
+    mesh->quad_count++;
+    return quad;
+}
+
+static int face_corner_occlusion(uint32_t face, int corner) {
+    return (face >> (FACE_AO_SHIFT + corner * 2)) & 3;
+}
+
+// True if a face's occlusion changes along u (axis 0) or v (axis 1); such
+// faces cannot be stretched that way without smearing the gradient
+static bool occlusion_varies(uint32_t face, int axis) {
+    int a = axis ? 3 : 1, b = axis ? 1 : 3;
+    return face_corner_occlusion(face, 0) != face_corner_occlusion(face, a) ||
+           face_corner_occlusion(face, b) != face_corner_occlusion(face, 2);
+}
+
+static unsigned char color_byte(float value) {
+    return (unsigned char)(value >= 1.0f ? 255 : value * 255.0f + 0.5f);
+}
+
+// Emit a w x h quad on the plane at `origin`, spanning axes u and v, all in
+// cells of `scale` blocks, shaded for the face mask entry `face`.
+// Vertices are wound counter-clockwise when seen from the face normal.
+static void emit_quad(ChunkMesh* mesh, int d, int side, const int origin[3], int w, int h, int scale,
+                      uint32_t face) {
+    PackedVertex* quad = mesh_reserve_quad(mesh);
+    if (!quad) return;
+
+    int u = (d + 1) % 3;
+    int v = (d + 2) % 3;
+    // u x v points along +d, so the positive face walks the corners forwards
+    static const int positive_order[4] = {0, 1, 2, 3};
+    static const int negative_order[4] = {0, 3, 2, 1};
+    const int* order = side ? positive_order : negative_order;
+
+    // Faces darken with the light in front of them; lamps always glow
+    uint32_t block = face & 0xff;
+    if (block >= BLOCK_TYPE_COUNT) block = BLOCK_DIRT;
+    uint32_t light = block == BLOCK_LAMP ? PACKED_LIGHT_EMISSIVE : (face >> FACE_LIGHT_SHIFT) & 15;
+    uint32_t shared = (uint32_t)(d * 2 + side) << PACKED_NORMAL_SHIFT | light << PACKED_LIGHT_SHIFT |
+                      block << PACKED_BLOCK_SHIFT;
+
+    uint32_t corners[4];
+    int ao[4];
+    for (int i = 0; i < 4; i++) {
+        int corner = order[i];
+        int position[3] = {origin[0] * scale, origin[1] * scale, origin[2] * scale};
+        position[u] += corner_u[corner] * w * scale;
+        position[v] += corner_v[corner] * h * scale;
+        ao[i] = face_corner_occlusion(face, corner);
+        corners[i] = shared | (uint32_t)position[0] << PACKED_X_SHIFT | (uint32_t)position[1] << PACKED_Y_SHIFT |
+                     (uint32_t)position[2] << PACKED_Z_SHIFT | (uint32_t)ao[i] << PACKED_AO_SHIFT;
+    }
+
+    // Split along the darker diagonal, so it runs through the odd corner
+    // and the occlusion fades evenly either side of it
+    int first = ao[0] + ao[2] > ao[1] + ao[3] ? 1 : 0;
+    static const int split[QUAD_VERTICES] = {0, 1, 2, 0, 2, 3};
+    for (int i = 0; i < QUAD_VERTICES; i++) quad[i] = (PackedVertex){corners[(first + split[i]) % 4], 0, 0};
+}
+
+// Cell bounds of one vertical section: [lo, hi) on each axis
+static void section_bounds(int section, int scale, int lo[3], int hi[3]) {
+    lo[0] = 0;
+    lo[1] = section * SECTION_HEIGHT / scale;
+    lo[2] = 0;
+    hi[0] = CHUNK_SIZE / scale;
+    hi[1] = lo[1] + SECTION_HEIGHT / scale;
+    hi[2] = CHUNK_SIZE / scale;
+}
+
+// Occlusion of each corner of a face from the cells beside and diagonal to
+// it in the layer in front of the face: 3 when open, 0 in an inside corner
+static uint32_t face_occlusion(const PaddedChunk* padded, const int front[3], int u, int v) {
+    uint32_t occlusion = 0;
+    for (int corner = 0; corner < 4; corner++) {
+        int step_u = corner_u[corner] ? 1 : -1, step_v = corner_v[corner] ? 1 : -1;
+        int pos[3] = {front[0], front[1], front[2]};
+        pos[u] += step_u;
+        int side_u = padded_at(padded, pos) != 0;
+        pos[v] += step_v;
+        int diagonal = padded_at(padded, pos) != 0;
+        pos[u] -= step_u;
+        int side_v = padded_at(padded, pos) != 0;
+        int level = side_u && side_v ? 0 : 3 - (side_u + side_v + diagonal);
+        occlusion |= (uint32_t)level << (corner * 2);
+    }
+    return occlusion << FACE_AO_SHIFT;
+}
+
+// Fill `mask` with the block type, light and corner occlusion of every
+// exposed face in slice `i` along axis d, or 0 where the face is hidden by a
+// solid neighbour. A face is lit by the air cell in front of it. Only blocks
+// inside [lo, hi) are considered; the mask is (hi[u] - lo[u]) wide.
+static void build_face_mask(const PaddedChunk* padded, int d, int side, int i,
+                            const int lo[3], const int hi[3],
+                            uint32_t mask[MASK_DIM * MASK_DIM]) {
+    int u = (d + 1) % 3;
+    int v = (d + 2) % 3;
+    int du = hi[u] - lo[u];
+    int pos[3];
+    int neighbour[3];
+
+    for (int b = 0; b < hi[v] - lo[v]; b++) {
+        for (int a = 0; a < du; a++) {
+            pos[d] = i;
+            pos[u] = lo[u] + a;
+            pos[v] = lo[v] + b;
+            neighbour[0] = pos[0];
+            neighbour[1] = pos[1];
+            neighbour[2] = pos[2];
+            neighbour[d] += side ? 1 : -1;
+
+            unsigned char block = padded_at(padded, pos);
+            if (block == 0 || padded_at(padded, neighbour) != 0) {
+                mask[a + b * du] = 0;
+                continue;
+            }
+            uint32_t occlusion = block == BLOCK_LAMP ? FACE_OPEN : face_occlusion(padded, neighbour, u, v);
+            mask[a + b * du] = block | (uint32_t)padded_light(padded, neighbour) << FACE_LIGHT_SHIFT | occlusion;
+        }
+    }
+}
+
+// Greedy-mesh the faces of one section's cells
+static inline void greedy_section(const PaddedChunk* padded, int section, int scale, ChunkMesh* mesh) {
+    uint32_t mask[MASK_DIM * MASK_DIM];
+    int lo[3], hi[3];
+    section_bounds(section, scale, lo, hi);
+
+    for (int d = 0; d < 3; d++) {
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int du = hi[u] - lo[u];
+        int dv = hi[v] - lo[v];
+
+        for (int side = 0; side < 2; side++) {
+            for (int i = lo[d]; i < hi[d]; i++) {
+                build_face_mask(padded, d, side, i, lo, hi, mask);
+
+                // Greedily grow rectangles of identical faces, along an
+                // axis only if their occlusion is flat along it
+                for (int b = 0; b < dv; b++) {
+                    for (int a = 0; a < du;) {
+                        uint32_t type = mask[a + b * du];
+                        if (type == 0) {
+                            a++;
+                            continue;
+                        }
+
+                        int w = 1;
+                        if (!occlusion_varies(type, 0)) {
+                            while (a + w < du && mask[a + w + b * du] == type) w++;
+                        }
+
+                        int h = 1;
+                        while (b + h < dv && !occlusion_varies(type, 1)) {
+                            int row_matches = 1;
+                            for (int k = 0; k < w; k++) {
+                                if (mask[a + k + (b + h) * du] != type) {
+                                    row_matches = 0;
+                                    break;
+                                }
+                            }
+                            if (!row_matches) break;
+                            h++;
+                        }
+
+                        int origin[3];
+                        origin[d] = i + side;
+                        origin[u] = lo[u] + a;
+                        origin[v] = lo[v] + b;
+                        emit_quad(mesh, d, side, origin, w, h, scale, type);
+
+                        for (int y = 0; y < h; y++) {
+                            memset(&mask[a + (b + y) * du], 0, w * sizeof(mask[0]));
+                        }
+                        a += w;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Full detail gets its own copy with constant bounds, so the common case
+// does not pay for the runtime scale
+static void mesh_section(const PaddedChunk* padded, int section, ChunkMesh* mesh) {
+    if (padded->scale == 1) {
+        greedy_section(padded, section, 1, mesh);
+    } else {
+        greedy_section(padded, section, padded->scale, mesh);
+    }
+}
+
+// One quad per exposed face of one section's blocks
+static void mesh_section_naive(const PaddedChunk* padded, int section, ChunkMesh* mesh) {
+    uint32_t mask[MASK_DIM * MASK_DIM];
+    int lo[3], hi[3];
+    section_bounds(section, padded->scale, lo, hi);
+
+    for (int d = 0; d < 3; d++) {
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int du = hi[u] - lo[u];
+
+        for (int side = 0; side < 2; side++) {
+            for (int i = lo[d]; i < hi[d]; i++) {
+                build_face_mask(padded, d, side, i, lo, hi, mask);
+
+                for (int b = 0; b < hi[v] - lo[v]; b++) {
+                    for (int a = 0; a < du; a++) {
+                        if (mask[a + b * du] == 0) continue;
+                        int origin[3];
+                        origin[d] = i + side;
+                        origin[u] = lo[u] + a;
+                        origin[v] = lo[v] + b;
+                        emit_quad(mesh, d, side, origin, 1, 1, padded->scale, mask[a + b * du]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Lowest solid run from the bottom of the world over each cell's columns
+static void build_skin(const DenseBlocks blocks, ChunkMesh* mesh) {
+    for (int cx = 0; cx < SKIN_CELLS; cx++) {
+        for (int cz = 0; cz < SKIN_CELLS; cz++) {
+            int lowest = WORLD_HEIGHT;
+            for (int x = cx * SKIN_CELL_SIZE; x < (cx + 1) * SKIN_CELL_SIZE; x++) {
+                for (int z = cz * SKIN_CELL_SIZE; z < (cz + 1) * SKIN_CELL_SIZE; z++) {
+                    int y = 0;
+                    while (y < lowest && blocks[x][y][z] != 0) y++;
+                    lowest = y;
+                }
+            }
+            mesh->skin_height[cx][cz] = (unsigned char)lowest;
+        }
+    }
+}
+
+// Neighbours meshed at another level of detail are treated as air, so both
+// sides of the seam keep their border faces and together skirt the crack
+static ChunkNeighbours same_lod_neighbours(const Chunk* chunk, const ChunkNeighbours* neighbours) {
+    ChunkNeighbours same = *neighbours;
+    if (same.neg_x && same.neg_x->lod != chunk->lod) same.neg_x = NULL;
+    if (same.pos_x && same.pos_x->lod != chunk->lod) same.pos_x = NULL;
+    if (same.neg_z && same.neg_z->lod != chunk->lod) same.neg_z = NULL;
+    if (same.pos_z && same.pos_z->lod != chunk->lod) same.pos_z = NULL;
+    return same;
+}
+
+// Mesh every section in order, recording where each one's vertices start
+static void build_sections(const Chunk* chunk, const ChunkNeighbours* neighbours, ChunkMesh* mesh,
+                           void (*mesh_one)(const PaddedChunk*, int, ChunkMesh*)) {
+    DenseBlocks blocks;
+    chunk_storage_decode(&chunk->storage, blocks);
+    ChunkNeighbours same;
+    if (neighbours) {
+        same = same_lod_neighbours(chunk, neighbours);
+        neighbours = &same;
+    }
+
+    PaddedChunk padded;
+    if (chunk->lod == 0) {
+        build_padded(blocks, &chunk->light, neighbours, &padded);
+    } else {
+        build_padded_lod(blocks, neighbours, 1 << chunk->lod, &padded);
+    }
+    mesh_reset(mesh);
+    mesh->lod = chunk->lod;
+
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        mesh->section_first[s] = mesh->vertex_count;
+        // A section holding nothing but air has no faces of its own
+        if (!chunk_section_is_air(&chunk->storage, s)) mesh_one(&padded, s, mesh);
+        mesh->section_vertex_count[s] = mesh->vertex_count - mesh->section_first[s];
+    }
+    int16_t chunk_x = (int16_t)(uint16_t)chunk->world_x, chunk_z = (int16_t)(uint16_t)chunk->world_z;
+    for (int i = 0; i < mesh->vertex_count; i++) {
+        mesh->vertices[i].chunk_x = chunk_x;
+        mesh->vertices[i].chunk_z = chunk_z;
+    }
+    build_skin(blocks, mesh);
+}
+
+void chunk_mesh_build(const Chunk* chunk, const ChunkNeighbours* neighbours, ChunkMesh* mesh) {
+    PROFILE_ZONE("chunk_mesh_build");
+    build_sections(chunk, neighbours, mesh, mesh_section);
+    PROFILE_COUNT("quads_emitted", mesh->quad_count);
+}
+
+void chunk_mesh_build_naive(const Chunk* chunk, const ChunkNeighbours* neighbours, ChunkMesh* mesh) {
+    build_sections(chunk, neighbours, mesh, mesh_section_naive);
+}
+
+void chunk_mesh_decode_vertex(const PackedVertex* vertex, MeshVertex* out) {
+    const MeshShading* table = chunk_mesh_shading();
+    int normal = packed_vertex_field(vertex, PACKED_NORMAL_SHIFT, 3);
+    int ao = packed_vertex_field(vertex, PACKED_AO_SHIFT, 2);
+    int light = packed_vertex_field(vertex, PACKED_LIGHT_SHIFT, 5);
+    int block = packed_vertex_field(vertex, PACKED_BLOCK_SHIFT, 6);
+    const Color* color = &table->face_color[block < BLOCK_TYPE_COUNT ? block : BLOCK_DIRT][normal < 6 ? normal : 0];
+    float shade = table->brightness[normal < 6 ? normal : 0][light < PACKED_LIGHT_LEVELS ? light : MAX_LIGHT] *
+                  table->occlusion[ao];
+    out->x = (float)packed_vertex_field(vertex, PACKED_X_SHIFT, 5);
+    out->y = (float)packed_vertex_field(vertex, PACKED_Y_SHIFT, 6);
+    out->z = (float)packed_vertex_field(vertex, PACKED_Z_SHIFT, 5);
+    out->r = color_byte(color->r * shade);
+    out->g = color_byte(color->g * shade);
+    out->b = color_byte(color->b * shade);
+    out->ao = (unsigned char)ao;
+}
+
+float chunk_mesh_surface_area(const ChunkMesh* mesh) {
+    float area = 0.0f;
+    for (int i = 0; i + QUAD_VERTICES <= mesh->vertex_count; i += QUAD_VERTICES) {
+        // Sides from corner 0 to its neighbours, vertices 1 and 5
+        MeshVertex q[3];
+        chunk_mesh_decode_vertex(&mesh->vertices[i], &q[0]);
+        chunk_mesh_decode_vertex(&mesh->vertices[i + 1], &q[1]);
+        chunk_mesh_decode_vertex(&mesh->vertices[i + 5], &q[2]);
+        float ax = q[1].x - q[0].x, ay = q[1].y - q[0].y, az = q[1].z - q[0].z;
+        float bx = q[2].x - q[0].x, by = q[2].y - q[0].y, bz = q[2].z - q[0].z;
+        area += sqrtf(ax * ax + ay * ay + az * az) * sqrtf(bx * bx + by * by + bz * bz);
+    }
+    return area;
+}
+
+void chunk_mesh_free(ChunkMesh* mesh) {
+    free(mesh->vertices);
+    mesh->vertices = NULL;
+    mesh->vertex_count = 0;
+    mesh->capacity = 0;
+    mesh->quad_count = 0;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        mesh->section_first[s] = 0;
+        mesh->section_vertex_count[s] = 0;
+    }
+    mesh->lod = 0;
+    memset(mesh->skin_height, 0, sizeof(mesh->skin_height));
+}
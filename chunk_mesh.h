@@ -0,0 +1,54 @@
+#ifndef CHUNK_MESH_H
+#define CHUNK_MESH_H
+
+#include "voxel_world.h"
+
+// Build a greedy mesh for a chunk: only exposed faces are emitted, and
+// coplanar faces of the same block type, light and corner occlusion are
+// merged into larger quads. Each face is shaded by the light of the air block
+// in front of it, and each vertex darkened by the blocks around its corner
+// (ambient occlusion, stored per vertex). Vertices are packed; the shading
+// is applied when they are decoded. Quads are split into two triangles
+// along their darker diagonal, so every renderer draws the same split.
+// Occlusion only sees the four edge neighbours, so corners against a
+// diagonal neighbour chunk are left open.
+// Faces against a loaded neighbour's edge blocks are culled; missing
+// neighbours (NULL, or a NULL `neighbours`) are treated as air.
+// Chunks with a nonzero `lod` are meshed from cells of (1 << lod)^3 blocks.
+// Neighbours at another level of detail count as missing, so the faces on
+// both sides of the seam stay and hide any crack between the two surfaces.
+void chunk_mesh_build(const Chunk* chunk, const ChunkNeighbours* neighbours, ChunkMesh* mesh);
+
+// Reference mesher: one quad per exposed face, no merging
+void chunk_mesh_build_naive(const Chunk* chunk, const ChunkNeighbours* neighbours, ChunkMesh* mesh);
+
+// Colours and brightness that a packed vertex's fields select; renderers
+// that decode vertices themselves load these tables
+typedef struct {
+    Color face_color[BLOCK_TYPE_COUNT][6];  // By block type and face normal
+    float brightness[6][PACKED_LIGHT_LEVELS];  // By face normal and light
+    float occlusion[4];  // By corner occlusion
+} MeshShading;
+
+const MeshShading* chunk_mesh_shading(void);
+
+// Decode a vertex to chunk-local floats and its shaded colour
+void chunk_mesh_decode_vertex(const PackedVertex* vertex, MeshVertex* out);
+
+static inline int packed_vertex_field(const PackedVertex* vertex, int shift, int bits) {
+    return (int)(vertex->fields >> shift) & ((1 << bits) - 1);
+}
+
+// Chunk coordinate of a vertex's wrapped one, given a chunk `near` it (within
+// 32767 chunks), as the renderers place vertices
+static inline int chunk_mesh_unwrap_chunk(int16_t wrapped, int near) {
+    return near + (int16_t)(uint16_t)(wrapped - near);
+}
+
+// Total area of all quads in the mesh, in block faces
+float chunk_mesh_surface_area(const ChunkMesh* mesh);
+
+// Release the mesh's vertex storage
+void chunk_mesh_free(ChunkMesh* mesh);
+
+#endif // CHUNK_MESH_H
@@ -0,0 +1,448 @@
+#include "chunk_storage.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int section_words(int bits) {
+    return SECTION_VOLUME / (32 / bits);
+}
+
+static unsigned int read_index(const ChunkSection* section, int index) {
+    int per_word = 32 / section->bits;
+    uint32_t word = section->data[index / per_word];
+    return (word >> ((index % per_word) * section->bits)) & ((1u << section->bits) - 1);
+}
+
+static void write_index(ChunkSection* section, int index, unsigned int value) {
+    int per_word = 32 / section->bits;
+    int shift = (index % per_word) * section->bits;
+    uint32_t mask = ((1u << section->bits) - 1) << shift;
+    uint32_t* word = &section->data[index / per_word];
+    *word = (*word & ~mask) | ((uint32_t)value << shift);
+}
+
+// Pack one byte-sized index per voxel into `bits`-wide fields, a word at a time
+static inline void pack_indices_bits(uint32_t* data, const unsigned char* values, int bits) {
+    int per_word = 32 / bits;
+    for (int w = 0; w < SECTION_VOLUME / per_word; w++) {
+        uint32_t word = 0;
+        for (int i = 0; i < per_word; i++) {
+            word |= (uint32_t)values[w * per_word + i] << (i * bits);
+        }
+        data[w] = word;
+    }
+}
+
+static inline void unpack_indices_bits(const uint32_t* data, unsigned char* values, int bits) {
+    int per_word = 32 / bits;
+    uint32_t mask = (1u << bits) - 1;
+    for (int w = 0; w < SECTION_VOLUME / per_word; w++) {
+        uint32_t word = data[w];
+        for (int i = 0; i < per_word; i++) {
+            values[w * per_word + i] = (unsigned char)((word >> (i * bits)) & mask);
+        }
+    }
+}
+
+// Dispatch on the width so each loop is compiled with a constant shift
+static void pack_indices(uint32_t* data, const unsigned char* values, int bits) {
+    switch (bits) {
+    case 1: pack_indices_bits(data, values, 1); break;
+    case 2: pack_indices_bits(data, values, 2); break;
+    case 4: pack_indices_bits(data, values, 4); break;
+    default: pack_indices_bits(data, values, 8); break;
+    }
+}
+
+static void unpack_indices(const uint32_t* data, unsigned char* values, int bits) {
+    switch (bits) {
+    case 1: unpack_indices_bits(data, values, 1); break;
+    case 2: unpack_indices_bits(data, values, 2); break;
+    case 4: unpack_indices_bits(data, values, 4); break;
+    default: unpack_indices_bits(data, values, 8); break;
+    }
+}
+
+static unsigned char section_block(const ChunkSection* section, int index) {
+    if (section->bits == 0) return section->palette[0];
+    unsigned int value = read_index(section, index);
+    return section->bits == 8 ? (unsigned char)value : section->palette[value];
+}
+
+// Flip the occupancy of one section-local voxel
+static void occupancy_toggle(ChunkSection* section, int x, int y, int z) {
+    int brick = occupancy_brick(x, y, z);
+    uint64_t bit = 1ull << occupancy_bit(x, y, z);
+    section->bricks[brick] ^= bit;
+    section->solid_count += (section->bricks[brick] & bit) ? 1 : -1;
+    if (section->bricks[brick]) {
+        section->solid_bricks |= 1ull << brick;
+    } else {
+        section->solid_bricks &= ~(1ull << brick);
+    }
+}
+
+static void section_make_uniform(ChunkSection* section, unsigned char block_type) {
+    free(section->data);
+    section->data = NULL;
+    section->bits = 0;
+    section->palette_size = 1;
+    section->palette[0] = block_type;
+
+    bool solid = block_type != 0;
+    memset(section->bricks, solid ? 0xff : 0, sizeof(section->bricks));
+    section->solid_bricks = solid ? ~0ull : 0;
+    section->solid_count = solid ? SECTION_VOLUME : 0;
+}
+
+// Set the occupancy bits of one row of blocks along z; a brick's z run is
+// four adjacent bits, so each brick takes one nibble
+static void occupancy_add_row(ChunkSection* section, int x, int y, const unsigned char row[CHUNK_SIZE]) {
+    for (int z = 0; z < CHUNK_SIZE; z += BRICK_SIZE) {
+        uint64_t nibble = (row[z] != 0) | (row[z + 1] != 0) << 1 | (row[z + 2] != 0) << 2 | (row[z + 3] != 0) << 3;
+        section->bricks[occupancy_brick(x, y, z)] |= nibble << occupancy_bit(x, y, 0);
+    }
+}
+
+// Derive the brick mask and solid count from the voxel bits
+static void occupancy_summarize(ChunkSection* section) {
+    section->solid_bricks = 0;
+    section->solid_count = 0;
+    for (int brick = 0; brick < BRICKS_PER_SECTION; brick++) {
+        if (!section->bricks[brick]) continue;
+        section->solid_bricks |= 1ull << brick;
+        section->solid_count += __builtin_popcountll(section->bricks[brick]);
+    }
+}
+
+// Recompute the occupancy of a section from its blocks
+static void section_rebuild_occupancy(ChunkSection* section) {
+    memset(section->bricks, 0, sizeof(section->bricks));
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < SECTION_HEIGHT; y++) {
+            unsigned char row[CHUNK_SIZE];
+            for (int z = 0; z < CHUNK_SIZE; z++) {
+                row[z] = section_block(section, (x * SECTION_HEIGHT + y) * CHUNK_SIZE + z);
+            }
+            occupancy_add_row(section, x, y, row);
+        }
+    }
+    occupancy_summarize(section);
+}
+
+// Smallest supported index width that can address `palette_size` entries
+static int bits_for_palette(int palette_size) {
+    if (palette_size <= 1) return 0;
+    if (palette_size <= 2) return 1;
+    if (palette_size <= 4) return 2;
+    if (palette_size <= SECTION_PALETTE_MAX) return 4;
+    return 8;
+}
+
+// Re-pack a section at a wider index width, keeping its contents
+static void section_widen(ChunkSection* section, int new_bits) {
+    ChunkSection widened = *section;
+    widened.bits = new_bits;
+    widened.data = calloc(section_words(new_bits), sizeof(uint32_t));
+    if (!widened.data) return;
+
+    for (int i = 0; i < SECTION_VOLUME; i++) {
+        unsigned int value;
+        if (section->bits == 0) {
+            value = new_bits == 8 ? section->palette[0] : 0;
+        } else {
+            value = read_index(section, i);
+            if (new_bits == 8) value = section->palette[value];
+        }
+        write_index(&widened, i, value);
+    }
+
+    free(section->data);
+    *section = widened;
+}
+
+void chunk_storage_init(ChunkStorage* storage) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        storage->sections[s].data = NULL;
+        section_make_uniform(&storage->sections[s], 0);
+    }
+}
+
+void chunk_storage_free(ChunkStorage* storage) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        section_make_uniform(&storage->sections[s], 0);
+    }
+}
+
+// Store a block type at a voxel index; false if out of memory
+static bool section_write(ChunkSection* section, int index, unsigned char block_type) {
+    if (section->bits != 8) {
+        int entry = 0;
+        while (entry < section->palette_size && section->palette[entry] != block_type) entry++;
+
+        if (entry == section->palette_size) {
+            // New block type: widen the indices if the palette is full
+            int needed_bits = bits_for_palette(section->palette_size + 1);
+            if (needed_bits > section->bits) {
+                section_widen(section, needed_bits);
+                if (section->bits != needed_bits) return false;
+            }
+            if (section->bits != 8) {
+                section->palette[section->palette_size++] = block_type;
+            }
+        }
+        if (section->bits != 8) {
+            write_index(section, index, entry);
+            return true;
+        }
+    }
+    write_index(section, index, block_type);
+    return true;
+}
+
+void chunk_storage_set(ChunkStorage* storage, int x, int y, int z, unsigned char block_type) {
+    ChunkSection* section = &storage->sections[y / SECTION_HEIGHT];
+    int local_y = y % SECTION_HEIGHT;
+    int index = (x * SECTION_HEIGHT + local_y) * CHUNK_SIZE + z;
+
+    if (section->bits == 0 && section->palette[0] == block_type) return;
+    if (!section_write(section, index, block_type)) return;
+    if (chunk_storage_is_solid(storage, x, y, z) != (block_type != 0)) occupancy_toggle(section, x, local_y, z);
+}
+
+// Voxel `index` of a section is blocks[x][base_y + y][z] with
+// index = (x * SECTION_HEIGHT + y) * CHUNK_SIZE + z, so each x slab of a
+// section is SECTION_HEIGHT * CHUNK_SIZE contiguous bytes of DenseBlocks
+#define SECTION_SLAB (SECTION_HEIGHT * CHUNK_SIZE)
+
+static void encode_section(ChunkSection* section, const DenseBlocks blocks, int section_index) {
+    int base_y = section_index * SECTION_HEIGHT;
+    unsigned char palette[256];
+    int palette_size = 0;
+    unsigned char seen[256] = {0};
+
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        const unsigned char* slab = blocks[x][base_y];
+        for (int i = 0; i < SECTION_SLAB; i++) {
+            if (!seen[slab[i]]) {
+                seen[slab[i]] = 1;
+                palette[palette_size++] = slab[i];
+            }
+        }
+    }
+
+    section_make_uniform(section, palette[0]);
+    int bits = bits_for_palette(palette_size);
+    if (bits == 0) return;
+
+    memset(section->bricks, 0, sizeof(section->bricks));
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < SECTION_HEIGHT; y++) occupancy_add_row(section, x, y, blocks[x][base_y + y]);
+    }
+    occupancy_summarize(section);
+
+    section->data = malloc(section_words(bits) * sizeof(uint32_t));
+    if (!section->data) return;
+    section->bits = bits;
+    if (bits != 8) {
+        section->palette_size = palette_size;
+        memcpy(section->palette, palette, palette_size);
+    }
+
+    unsigned char palette_index[256];
+    for (int i = 0; i < 256; i++) palette_index[i] = (unsigned char)i;
+    if (bits != 8) {
+        for (int i = 0; i < palette_size; i++) palette_index[palette[i]] = (unsigned char)i;
+    }
+
+    unsigned char values[SECTION_VOLUME];
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        const unsigned char* slab = blocks[x][base_y];
+        for (int i = 0; i < SECTION_SLAB; i++) {
+            values[x * SECTION_SLAB + i] = palette_index[slab[i]];
+        }
+    }
+    pack_indices(section->data, values, bits);
+}
+
+void chunk_storage_encode(ChunkStorage* storage, const DenseBlocks blocks) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        encode_section(&storage->sections[s], blocks, s);
+    }
+}
+
+void chunk_storage_decode(const ChunkStorage* storage, DenseBlocks blocks) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        const ChunkSection* section = &storage->sections[s];
+        int base_y = s * SECTION_HEIGHT;
+
+        if (section->bits == 0) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                memset(blocks[x][base_y], section->palette[0], SECTION_SLAB);
+            }
+            continue;
+        }
+
+        unsigned char values[SECTION_VOLUME];
+        unpack_indices(section->data, values, section->bits);
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            unsigned char* slab = blocks[x][base_y];
+            const unsigned char* slab_values = values + x * SECTION_SLAB;
+            if (section->bits == 8) {
+                memcpy(slab, slab_values, SECTION_SLAB);
+            } else {
+                for (int i = 0; i < SECTION_SLAB; i++) {
+                    slab[i] = section->palette[slab_values[i]];
+                }
+            }
+        }
+    }
+}
+
+void chunk_storage_compact(ChunkStorage* storage) {
+    DenseBlocks blocks;
+    chunk_storage_decode(storage, blocks);
+    chunk_storage_encode(storage, blocks);
+}
+
+size_t chunk_storage_bytes(const ChunkStorage* storage) {
+    size_t bytes = 0;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        if (storage->sections[s].bits != 0) {
+            bytes += section_words(storage->sections[s].bits) * sizeof(uint32_t);
+        }
+    }
+    return bytes;
+}
+
+// Each section is written as: bits, palette size, palette entries, then the
+// packed index words as little-endian bytes (absent for uniform sections)
+size_t chunk_storage_serialize(const ChunkStorage* storage, unsigned char* out) {
+    unsigned char* p = out;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        const ChunkSection* section = &storage->sections[s];
+        int palette_size = section->bits == 8 ? 0 : section->palette_size;
+        *p++ = section->bits;
+        *p++ = (unsigned char)palette_size;
+        memcpy(p, section->palette, palette_size);
+        p += palette_size;
+        if (section->bits == 0) continue;
+
+        for (int w = 0; w < section_words(section->bits); w++) {
+            uint32_t word = section->data[w];
+            *p++ = (unsigned char)word;
+            *p++ = (unsigned char)(word >> 8);
+            *p++ = (unsigned char)(word >> 16);
+            *p++ = (unsigned char)(word >> 24);
+        }
+    }
+    return (size_t)(p - out);
+}
+
+bool chunk_storage_deserialize(ChunkStorage* storage, const unsigned char* in, size_t length) {
+    const unsigned char* p = in;
+    const unsigned char* end = in + length;
+
+    chunk_storage_free(storage);
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        ChunkSection* section = &storage->sections[s];
+        if (end - p < 2) goto malformed;
+        int bits = p[0];
+        int palette_size = p[1];
+        p += 2;
+        if (bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8) goto malformed;
+        if (palette_size > SECTION_PALETTE_MAX || end - p < palette_size) goto malformed;
+        if (bits != 8 && palette_size < 1) goto malformed;
+
+        section_make_uniform(section, palette_size ? p[0] : 0);
+        memcpy(section->palette, p, palette_size);
+        section->palette_size = (unsigned char)palette_size;
+        p += palette_size;
+        if (bits == 0) continue;
+
+        int words = section_words(bits);
+        if (end - p < words * 4) goto malformed;
+        section->data = malloc(words * sizeof(uint32_t));
+        if (!section->data) goto malformed;
+        section->bits = (unsigned char)bits;
+        for (int w = 0; w < words; w++, p += 4) {
+            section->data[w] = (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+                               (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        }
+
+        // Indices past the palette would read garbage later
+        if (bits != 8) {
+            for (int i = 0; i < SECTION_VOLUME; i++) {
+                if (read_index(section, i) >= (unsigned int)palette_size) goto malformed;
+            }
+        }
+        section_rebuild_occupancy(section);
+    }
+    return true;
+
+malformed:
+    chunk_storage_free(storage);
+    return false;
+}
+
+void chunk_light_init(ChunkLight* light) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        light->sections[s].data = NULL;
+        light->sections[s].uniform = 0;
+    }
+}
+
+void chunk_light_fill(ChunkLight* light, unsigned char value) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        free(light->sections[s].data);
+        light->sections[s].data = NULL;
+        light->sections[s].uniform = value;
+    }
+}
+
+void chunk_light_free(ChunkLight* light) {
+    chunk_light_fill(light, 0);
+}
+
+bool chunk_light_expand(SectionLight* section) {
+    section->data = malloc(SECTION_VOLUME);
+    if (!section->data) return false;
+    memset(section->data, section->uniform, SECTION_VOLUME);
+    return true;
+}
+
+void chunk_light_compact(ChunkLight* light) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        SectionLight* section = &light->sections[s];
+        if (!section->data) continue;
+        int i = 1;
+        while (i < SECTION_VOLUME && section->data[i] == section->data[0]) i++;
+        if (i < SECTION_VOLUME) continue;
+        section->uniform = section->data[0];
+        free(section->data);
+        section->data = NULL;
+    }
+}
+
+void chunk_light_decode(const ChunkLight* light, DenseLight dense) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        const SectionLight* section = &light->sections[s];
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            for (int y = 0; y < SECTION_HEIGHT; y++) {
+                unsigned char* row = dense[x][s * SECTION_HEIGHT + y];
+                if (section->data) {
+                    memcpy(row, &section->data[(x * SECTION_HEIGHT + y) * CHUNK_SIZE], CHUNK_SIZE);
+                } else {
+                    memset(row, section->uniform, CHUNK_SIZE);
+                }
+            }
+        }
+    }
+}
+
+size_t chunk_light_bytes(const ChunkLight* light) {
+    size_t bytes = 0;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        if (light->sections[s].data) bytes += SECTION_VOLUME;
+    }
+    return bytes;
+}
@@ -0,0 +1,175 @@
+#ifndef CHUNK_STORAGE_H
+#define CHUNK_STORAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHUNK_SIZE 16
+#define WORLD_HEIGHT 32
+#define SECTION_HEIGHT 16  // Blocks per vertical section
+#define SECTIONS_PER_CHUNK (WORLD_HEIGHT / SECTION_HEIGHT)
+#define SECTION_VOLUME (CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE)
+#define SECTION_PALETTE_MAX 16  // Largest palette before falling back to raw 8-bit IDs
+#define BRICK_SIZE 4  // Blocks per side of an occupancy brick, so a brick's voxels fit in 64 bits
+#define BRICKS_PER_SECTION ((CHUNK_SIZE / BRICK_SIZE) * (SECTION_HEIGHT / BRICK_SIZE) * (CHUNK_SIZE / BRICK_SIZE))
+
+// Upper bound on chunk_storage_serialize output: every section at 8 bits
+#define CHUNK_STORAGE_MAX_SERIALIZED (SECTIONS_PER_CHUNK * (2 + SECTION_PALETTE_MAX + SECTION_VOLUME))
+
+// One 16x16x16 section of blocks. A section holding a single block type is
+// stored as just that value; otherwise each voxel is an index into a small
+// palette, packed `bits` to a 32-bit word. With bits == 8 the indices are
+// raw block IDs and the palette is unused.
+//
+// Alongside the blocks, every change keeps an occupancy hierarchy up to
+// date: a solid count for the section, a bit per 4x4x4 brick that holds
+// anything solid, and a bit per voxel within each brick.
+typedef struct {
+    unsigned char bits;  // 0 (uniform), 1, 2, 4 or 8
+    unsigned char palette_size;
+    unsigned char palette[SECTION_PALETTE_MAX];  // palette[0] is the uniform value when bits == 0
+    uint32_t* data;  // Packed indices, NULL when uniform
+    uint16_t solid_count;  // Non-air voxels; 0 is empty, SECTION_VOLUME full
+    uint64_t solid_bricks;  // Bit occupancy_brick() set when that brick holds a solid voxel
+    uint64_t bricks[BRICKS_PER_SECTION];  // Bit occupancy_bit() set per solid voxel
+} ChunkSection;
+
+_Static_assert(BRICKS_PER_SECTION == 64 && BRICK_SIZE * BRICK_SIZE * BRICK_SIZE == 64,
+               "bricks and their voxels are addressed by 64-bit masks");
+
+// Brick of a section holding section-local block (x, y, z)
+static inline int occupancy_brick(int x, int y, int z) {
+    return ((x / BRICK_SIZE) * (SECTION_HEIGHT / BRICK_SIZE) + y / BRICK_SIZE) * (CHUNK_SIZE / BRICK_SIZE) +
+           z / BRICK_SIZE;
+}
+
+// Bit of that block within its brick's mask
+static inline int occupancy_bit(int x, int y, int z) {
+    return ((x % BRICK_SIZE) * BRICK_SIZE + y % BRICK_SIZE) * BRICK_SIZE + z % BRICK_SIZE;
+}
+
+// Palette-compressed blocks of one chunk, split into vertical sections
+typedef struct {
+    ChunkSection sections[SECTIONS_PER_CHUNK];
+} ChunkStorage;
+
+// Dense block layout used for generation and meshing
+typedef unsigned char DenseBlocks[CHUNK_SIZE][WORLD_HEIGHT][CHUNK_SIZE];
+
+// Light of one section: every voxel holds `uniform` while `data` is NULL,
+// as in open sky or solid ground; a section takes a byte per voxel, laid out
+// like the block indices, only once its light is mixed
+typedef struct {
+    unsigned char uniform;
+    unsigned char* data;  // SECTION_VOLUME bytes, NULL when uniform
+} SectionLight;
+
+// Per-voxel light of one chunk, split into vertical sections like its blocks
+typedef struct {
+    SectionLight sections[SECTIONS_PER_CHUNK];
+} ChunkLight;
+
+// Dense light layout, for snapshots and comparisons
+typedef unsigned char DenseLight[CHUNK_SIZE][WORLD_HEIGHT][CHUNK_SIZE];
+
+// Initialize storage to all air
+void chunk_storage_init(ChunkStorage* storage);
+
+// Release packed section data and reset to all air
+void chunk_storage_free(ChunkStorage* storage);
+
+// Set one block; grows the section's palette or index width as needed
+void chunk_storage_set(ChunkStorage* storage, int x, int y, int z, unsigned char block_type);
+
+// Replace the contents with `blocks`, choosing the smallest encoding per section
+void chunk_storage_encode(ChunkStorage* storage, const DenseBlocks blocks);
+
+// Expand the storage into the dense layout
+void chunk_storage_decode(const ChunkStorage* storage, DenseBlocks blocks);
+
+// Re-encode sections to drop unused palette entries after edits
+void chunk_storage_compact(ChunkStorage* storage);
+
+// Heap bytes held by the packed section data
+size_t chunk_storage_bytes(const ChunkStorage* storage);
+
+// Write the packed sections to `out` (at least CHUNK_STORAGE_MAX_SERIALIZED
+// bytes) in a byte-order independent layout; returns the bytes written
+size_t chunk_storage_serialize(const ChunkStorage* storage, unsigned char* out);
+
+// Replace the contents with serialized sections; false if the data is malformed
+bool chunk_storage_deserialize(ChunkStorage* storage, const unsigned char* in, size_t length);
+
+// Get one block (local coordinates, no bounds checks)
+static inline unsigned char chunk_storage_get(const ChunkStorage* storage, int x, int y, int z) {
+    const ChunkSection* section = &storage->sections[y / SECTION_HEIGHT];
+    if (section->bits == 0) return section->palette[0];
+
+    int index = (x * SECTION_HEIGHT + y % SECTION_HEIGHT) * CHUNK_SIZE + z;
+    int per_word = 32 / section->bits;
+    uint32_t word = section->data[index / per_word];
+    unsigned int value = (word >> ((index % per_word) * section->bits)) & ((1u << section->bits) - 1);
+    return section->bits == 8 ? (unsigned char)value : section->palette[value];
+}
+
+// True if the section holds nothing but air
+static inline bool chunk_section_is_air(const ChunkStorage* storage, int section) {
+    return storage->sections[section].solid_count == 0;
+}
+
+// False only if no block of the section can be `block_type`; sections with
+// raw 8-bit IDs keep no palette and always may
+static inline bool chunk_section_may_contain(const ChunkStorage* storage, int section, unsigned char block_type) {
+    const ChunkSection* s = &storage->sections[section];
+    if (s->bits == 8) return true;
+    for (int i = 0; i < s->palette_size; i++) {
+        if (s->palette[i] == block_type) return true;
+    }
+    return false;
+}
+
+// True if the block is not air, from the occupancy bits alone
+static inline bool chunk_storage_is_solid(const ChunkStorage* storage, int x, int y, int z) {
+    const ChunkSection* section = &storage->sections[y / SECTION_HEIGHT];
+    int local_y = y % SECTION_HEIGHT;
+    return (section->bricks[occupancy_brick(x, local_y, z)] >> occupancy_bit(x, local_y, z)) & 1;
+}
+
+// Initialize light to darkness, with no dense sections
+void chunk_light_init(ChunkLight* light);
+
+// Set every section of the light to `value`, releasing dense sections
+void chunk_light_fill(ChunkLight* light, unsigned char value);
+
+// Release dense sections and reset to darkness
+void chunk_light_free(ChunkLight* light);
+
+// Give a uniform section a dense array holding its value; false if out of memory
+bool chunk_light_expand(SectionLight* section);
+
+// Return dense sections whose voxels all match to the uniform form
+void chunk_light_compact(ChunkLight* light);
+
+// Expand the light into the dense layout
+void chunk_light_decode(const ChunkLight* light, DenseLight dense);
+
+// Heap bytes held by dense light sections
+size_t chunk_light_bytes(const ChunkLight* light);
+
+// Get one voxel's light (local coordinates, no bounds checks)
+static inline unsigned char chunk_light_get(const ChunkLight* light, int x, int y, int z) {
+    const SectionLight* section = &light->sections[y / SECTION_HEIGHT];
+    if (!section->data) return section->uniform;
+    return section->data[(x * SECTION_HEIGHT + y % SECTION_HEIGHT) * CHUNK_SIZE + z];
+}
+
+// Set one voxel's light; a uniform section is expanded only if the value
+// differs. Out of memory, the write is dropped.
+static inline void chunk_light_set(ChunkLight* light, int x, int y, int z, unsigned char value) {
+    SectionLight* section = &light->sections[y / SECTION_HEIGHT];
+    if (!section->data && (value == section->uniform || !chunk_light_expand(section))) return;
+    section->data[(x * SECTION_HEIGHT + y % SECTION_HEIGHT) * CHUNK_SIZE + z] = value;
+}
+
+#endif // CHUNK_STORAGE_H
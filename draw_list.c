@@ -0,0 +1,133 @@
+#include "draw_list.h"
+#include "profiler.h"
+#include <stdlib.h>
+#include <time.h>
+
+static void chunk_bounds(const Chunk* chunk, int y_min, int y_max, float min[3], float max[3]) {
+    min[0] = (float)(chunk->world_x * CHUNK_SIZE);
+    min[1] = (float)y_min;
+    min[2] = (float)(chunk->world_z * CHUNK_SIZE);
+    max[0] = min[0] + CHUNK_SIZE;
+    max[1] = (float)y_max;
+    max[2] = min[2] + CHUNK_SIZE;
+}
+
+static void add_range(DrawList* list, const Chunk* chunk, int first, int count) {
+    if (count == 0) return;
+
+    // Extend the previous item when this section follows it in the buffer
+    if (list->count > 0) {
+        DrawItem* last = &list->items[list->count - 1];
+        if (last->chunk == chunk && last->first_vertex + last->vertex_count == first) {
+            last->vertex_count += count;
+            return;
+        }
+    }
+
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 128;
+        DrawItem* items = realloc(list->items, capacity * sizeof(DrawItem));
+        if (!items) return;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = (DrawItem){chunk, first, count};
+}
+
+bool chunk_in_frustum(const Chunk* chunk, const Frustum* frustum) {
+    float min[3], max[3];
+    chunk_bounds(chunk, 0, WORLD_HEIGHT, min, max);
+    return frustum_intersects_box(frustum, min, max);
+}
+
+static int compare_distance(const void* a, const void* b) {
+    float x = ((const VisibleChunk*)a)->distance_sq;
+    float y = ((const VisibleChunk*)b)->distance_sq;
+    return (x > y) - (x < y);
+}
+
+static long elapsed_ns(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000L + (now.tv_nsec - start->tv_nsec);
+}
+
+// Gather the loaded chunks that pass the frustum test, nearest first
+static int collect_visible_chunks(DrawList* list, VoxelWorld* world, const Frustum* frustum) {
+    int slots = world->chunk_count * world->chunk_count;
+    if (list->chunk_capacity < slots) {
+        VisibleChunk* chunks = realloc(list->chunks, slots * sizeof(VisibleChunk));
+        if (!chunks) return 0;
+        list->chunks = chunks;
+        list->chunk_capacity = slots;
+    }
+
+    int count = 0;
+    for (int i = 0; i < slots; i++) {
+        const Chunk* chunk = &world->chunks[i];
+        if (!chunk->is_loaded) continue;
+
+        if (!chunk_in_frustum(chunk, frustum)) {
+            list->stats.chunks_culled++;
+            list->stats.sections_culled += SECTIONS_PER_CHUNK;
+            continue;
+        }
+        float dx = (chunk->world_x + 0.5f) * CHUNK_SIZE - frustum->eye[0];
+        float dz = (chunk->world_z + 0.5f) * CHUNK_SIZE - frustum->eye[2];
+        list->chunks[count++] = (VisibleChunk){chunk, dx * dx + dz * dz};
+    }
+    qsort(list->chunks, count, sizeof(VisibleChunk), compare_distance);
+    list->stats.chunks_visible = count;
+    return count;
+}
+
+void draw_list_build(DrawList* list, VoxelWorld* world, const Frustum* frustum, OcclusionBuffer* occlusion) {
+    PROFILE_ZONE("draw_list_build");
+    list->count = 0;
+    list->stats = (CullStats){0};
+    int count = collect_visible_chunks(list, world, frustum);
+
+    struct timespec start;
+    if (occlusion) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        occlusion_begin(occlusion, frustum);
+        for (int i = 0; i < count; i++) {
+            occlusion_add_chunk(occlusion, list->chunks[i].chunk);
+        }
+        list->stats.occluder_quads = occlusion->occluder_quads;
+        list->stats.occlusion_ns = elapsed_ns(&start);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
+    for (int i = 0; i < count; i++) {
+        const Chunk* chunk = list->chunks[i].chunk;
+        for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+            float min[3], max[3];
+            chunk_bounds(chunk, s * SECTION_HEIGHT, (s + 1) * SECTION_HEIGHT, min, max);
+            if (!frustum_intersects_box(frustum, min, max)) {
+                list->stats.sections_culled++;
+                continue;
+            }
+            // Sections without geometry are not worth an occlusion test
+            int vertex_count = chunk->vbo_section_count[s];
+            if (occlusion && vertex_count > 0 && !occlusion_box_visible(occlusion, min, max)) {
+                list->stats.sections_occluded++;
+                continue;
+            }
+            list->stats.sections_visible++;
+            add_range(list, chunk, chunk->vbo_section_first[s], vertex_count);
+        }
+    }
+    // The section pass is charged to occlusion only when it runs the tests
+    if (occlusion) list->stats.occlusion_ns += elapsed_ns(&start);
+}
+
+void draw_list_free(DrawList* list) {
+    free(list->items);
+    free(list->chunks);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    list->chunks = NULL;
+    list->chunk_capacity = 0;
+}
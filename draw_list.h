@@ -0,0 +1,54 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include "voxel_world.h"
+#include "camera.h"
+#include "occlusion.h"
+
+// A contiguous range of one chunk's uploaded vertices; adjacent visible
+// sections of a chunk are merged into a single item
+typedef struct {
+    const Chunk* chunk;
+    int first_vertex;
+    int vertex_count;
+} DrawItem;
+
+// Culling results for one frame
+typedef struct {
+    int chunks_visible;
+    int chunks_culled;
+    int sections_visible;
+    int sections_culled;  // Outside the frustum, including every section of a culled chunk
+    int sections_occluded;  // In the frustum but hidden behind occluders
+    int occluder_quads;
+    long occlusion_ns;  // Time spent rasterizing occluders and testing sections
+} CullStats;
+
+// A chunk that passed the frustum test, with its distance from the camera
+typedef struct {
+    const Chunk* chunk;
+    float distance_sq;
+} VisibleChunk;
+
+typedef struct {
+    DrawItem* items;  // Front to back
+    int count;
+    int capacity;
+    VisibleChunk* chunks;  // Scratch, one per window slot
+    int chunk_capacity;
+    CullStats stats;
+} DrawList;
+
+// Test every loaded chunk in the window against the frustum, then each
+// 16-high section of the chunks that pass, and list the uploaded geometry
+// of the visible sections nearest first. With an occlusion buffer, the
+// heightmap skins of the visible chunks are rasterized front to back and
+// sections hidden behind them are left out too.
+void draw_list_build(DrawList* list, VoxelWorld* world, const Frustum* frustum, OcclusionBuffer* occlusion);
+
+// True if any part of the chunk's column can be inside the frustum
+bool chunk_in_frustum(const Chunk* chunk, const Frustum* frustum);
+
+void draw_list_free(DrawList* list);
+
+#endif // DRAW_LIST_H
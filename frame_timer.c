@@ -0,0 +1,107 @@
+#include "frame_timer.h"
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#define PRINT_BAR_WIDTH 50  // Characters in the longest histogram bar
+
+double frame_clock_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void frame_clock_sleep_until(double deadline) {
+    double remaining = deadline - frame_clock_seconds();
+    if (remaining <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)remaining;
+    ts.tv_nsec = (long)((remaining - ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+}
+
+void fixed_step_init(FixedStep* fixed, double step, int max_steps) {
+    fixed->step = step;
+    fixed->accumulator = 0.0;
+    fixed->max_steps = max_steps;
+    fixed->dropped_seconds = 0.0;
+}
+
+int fixed_step_advance(FixedStep* fixed, double frame_seconds) {
+    if (frame_seconds > 0.0) fixed->accumulator += frame_seconds;
+    int steps = (int)(fixed->accumulator / fixed->step);
+
+    // Catching up after a stall would only make the next frame longer
+    if (steps > fixed->max_steps) {
+        double kept = fixed->accumulator - (steps - fixed->max_steps) * fixed->step;
+        fixed->dropped_seconds += fixed->accumulator - kept;
+        fixed->accumulator = kept;
+        steps = fixed->max_steps;
+    }
+    fixed->accumulator -= steps * fixed->step;
+    if (fixed->accumulator < 0.0) fixed->accumulator = 0.0;
+    return steps;
+}
+
+float fixed_step_alpha(const FixedStep* fixed) {
+    float alpha = (float)(fixed->accumulator / fixed->step);
+    return alpha < 1.0f ? alpha : 0.99999994f;
+}
+
+void frame_histogram_reset(FrameHistogram* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+void frame_histogram_add(FrameHistogram* histogram, double seconds) {
+    if (seconds < 0.0) seconds = 0.0;
+    long bucket = (long)(seconds * 1e6 / FRAME_HISTOGRAM_BUCKET_US);
+    if (bucket >= FRAME_HISTOGRAM_BUCKETS) bucket = FRAME_HISTOGRAM_BUCKETS - 1;
+    histogram->buckets[bucket]++;
+    if (histogram->count == 0 || seconds < histogram->min_seconds) histogram->min_seconds = seconds;
+    if (histogram->count == 0 || seconds > histogram->max_seconds) histogram->max_seconds = seconds;
+    histogram->count++;
+    histogram->total_seconds += seconds;
+}
+
+double frame_histogram_percentile(const FrameHistogram* histogram, double p) {
+    if (histogram->count == 0) return 0.0;
+    long rank = (long)ceil(p / 100.0 * histogram->count);
+    if (rank < 1) rank = 1;
+    long seen = 0;
+    for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen < rank) continue;
+        if (i == FRAME_HISTOGRAM_BUCKETS - 1) break;  // Past the last edge; only the maximum is known
+        double edge = (i + 1) * FRAME_HISTOGRAM_BUCKET_US * 1e-6;
+        return edge < histogram->max_seconds ? edge : histogram->max_seconds;
+    }
+    return histogram->max_seconds;
+}
+
+void frame_histogram_print(const FrameHistogram* histogram, FILE* out) {
+    if (histogram->count == 0) {
+        fprintf(out, "No frames timed\n");
+        return;
+    }
+    fprintf(out, "%ld frames, %.1f fps mean; ms min %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f\n", histogram->count,
+            histogram->count / histogram->total_seconds, histogram->min_seconds * 1e3,
+            frame_histogram_percentile(histogram, 50.0) * 1e3, frame_histogram_percentile(histogram, 90.0) * 1e3,
+            frame_histogram_percentile(histogram, 99.0) * 1e3, histogram->max_seconds * 1e3);
+
+    // Regroup the buckets by whole milliseconds for printing
+    enum { PER_MS = 1000 / FRAME_HISTOGRAM_BUCKET_US, ROWS = FRAME_HISTOGRAM_BUCKETS / PER_MS };
+    long rows[ROWS] = {0};
+    long largest = 0;
+    int first = ROWS, last = 0;
+    for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++) rows[i / PER_MS] += histogram->buckets[i];
+    for (int r = 0; r < ROWS; r++) {
+        if (rows[r] > largest) largest = rows[r];
+        if (rows[r] > 0 && r < first) first = r;
+        if (rows[r] > 0) last = r;
+    }
+    for (int r = first; r <= last; r++) {
+        int width = (int)((rows[r] * PRINT_BAR_WIDTH + largest - 1) / largest);
+        fprintf(out, "%3d%s ms %7ld %.*s\n", r, r == ROWS - 1 ? "+" : " ", rows[r], width,
+                "##################################################");
+    }
+}
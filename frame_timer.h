@@ -0,0 +1,57 @@
+#ifndef FRAME_TIMER_H
+#define FRAME_TIMER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define FRAME_HISTOGRAM_BUCKET_US 50  // Width of a frame time bucket
+#define FRAME_HISTOGRAM_BUCKETS 1000  // Buckets up to 50 ms; slower frames share the last one
+
+// Seconds on a monotonic high-resolution clock with an arbitrary origin
+double frame_clock_seconds(void);
+
+// Sleep until frame_clock_seconds() reaches `deadline`; returns at once if it has
+void frame_clock_sleep_until(double deadline);
+
+// Fixed-timestep accumulator. Real frame time is banked and paid out in
+// whole simulation steps, so the simulation advances at the same rate and
+// in the same increments whatever the frame rate. The remainder is the
+// fraction of a step to interpolate the rendered state by.
+typedef struct {
+    double step;  // Seconds of simulation per step
+    double accumulator;  // Real time not yet simulated, under one step after advancing
+    int max_steps;  // Most steps paid out per frame; time beyond that is dropped
+    double dropped_seconds;  // Time dropped after long frames so far
+} FixedStep;
+
+void fixed_step_init(FixedStep* fixed, double step, int max_steps);
+
+// Bank a frame's real time; returns the number of steps to simulate
+int fixed_step_advance(FixedStep* fixed, double frame_seconds);
+
+// How far the real time is between the last two simulated states, in [0, 1)
+float fixed_step_alpha(const FixedStep* fixed);
+
+// Frame times in fixed-width buckets, for percentiles without keeping
+// every sample. Percentiles are accurate to a bucket width.
+typedef struct {
+    uint32_t buckets[FRAME_HISTOGRAM_BUCKETS];
+    long count;
+    double total_seconds;
+    double min_seconds;
+    double max_seconds;
+} FrameHistogram;
+
+void frame_histogram_reset(FrameHistogram* histogram);
+
+void frame_histogram_add(FrameHistogram* histogram, double seconds);
+
+// Upper edge of the bucket holding the nearest-rank percentile `p` (0 to
+// 100), never more than the slowest frame; 0 when empty. Frames past the
+// last bucket report the slowest frame.
+double frame_histogram_percentile(const FrameHistogram* histogram, double p);
+
+// Frame count, mean frame rate, percentiles and a bar per millisecond
+void frame_histogram_print(const FrameHistogram* histogram, FILE* out);
+
+#endif // FRAME_TIMER_H
@@ -0,0 +1,282 @@
+#include "job_system.h"
+#include "profiler.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define JOB_DEQUE_MASK (JOB_DEQUE_SIZE - 1)
+
+typedef struct Job {
+    JobFunc func;
+    void* data;
+    struct Job* next;  // Link in the shared injection list
+} Job;
+
+// Chase-Lev work-stealing deque: the owner pushes and pops at the bottom,
+// thieves take from the top
+typedef struct {
+    _Atomic long top;
+    _Atomic long bottom;
+    _Atomic(Job*) slots[JOB_DEQUE_SIZE];
+} WorkDeque;
+
+typedef struct {
+    JobSystem* jobs;
+    int index;
+    pthread_t thread;
+    WorkDeque deque;
+} Worker;
+
+struct JobSystem {
+    Worker* workers;
+    int worker_count;
+
+    // Jobs submitted from outside the pool land here until a worker takes a batch
+    pthread_mutex_t mutex;
+    pthread_cond_t work_available;
+    pthread_cond_t idle;
+    Job* injected_head;
+    Job* injected_tail;
+    int injected_count;
+
+    _Atomic int queued;  // Submitted jobs not yet picked up by a worker
+    _Atomic int pending;  // Submitted jobs not yet finished
+    bool shutdown;
+};
+
+static bool deque_push(WorkDeque* deque, Job* job) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= JOB_DEQUE_SIZE) return false;
+
+    atomic_store_explicit(&deque->slots[bottom & JOB_DEQUE_MASK], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+static Job* deque_pop(WorkDeque* deque) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    Job* job = atomic_load_explicit(&deque->slots[bottom & JOB_DEQUE_MASK], memory_order_relaxed);
+    if (top == bottom) {
+        // Last job: race any thief for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            job = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+static Job* deque_steal(WorkDeque* deque) {
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) return NULL;
+
+    Job* job = atomic_load_explicit(&deque->slots[top & JOB_DEQUE_MASK], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return job;
+}
+
+// Move a share of the injected jobs into the worker's own deque and return one to run
+static Job* take_injected(Worker* worker) {
+    JobSystem* jobs = worker->jobs;
+    pthread_mutex_lock(&jobs->mutex);
+
+    Job* first = jobs->injected_head;
+    if (first) {
+        int batch = jobs->injected_count / jobs->worker_count;
+        if (batch < 1) batch = 1;
+
+        jobs->injected_head = first->next;
+        jobs->injected_count--;
+        for (int i = 1; i < batch && jobs->injected_head; i++) {
+            Job* job = jobs->injected_head;
+            if (!deque_push(&worker->deque, job)) break;
+            jobs->injected_head = job->next;
+            jobs->injected_count--;
+        }
+        if (!jobs->injected_head) jobs->injected_tail = NULL;
+    }
+
+    pthread_mutex_unlock(&jobs->mutex);
+    return first;
+}
+
+static Job* steal_any(Worker* worker) {
+    JobSystem* jobs = worker->jobs;
+    for (int i = 1; i < jobs->worker_count; i++) {
+        Worker* victim = &jobs->workers[(worker->index + i) % jobs->worker_count];
+        Job* job = deque_steal(&victim->deque);
+        if (job) return job;
+    }
+    return NULL;
+}
+
+static Job* find_job(Worker* worker) {
+    Job* job = deque_pop(&worker->deque);
+    if (!job) job = take_injected(worker);
+    if (!job) job = steal_any(worker);
+    if (job) atomic_fetch_sub(&worker->jobs->queued, 1);
+    return job;
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = arg;
+    JobSystem* jobs = worker->jobs;
+    PROFILE_THREAD_NAME("worker");
+
+    for (;;) {
+        Job* job = find_job(worker);
+        if (job) {
+            job->func(job->data);
+            free(job);
+            if (atomic_fetch_sub(&jobs->pending, 1) == 1) {
+                pthread_mutex_lock(&jobs->mutex);
+                pthread_cond_broadcast(&jobs->idle);
+                pthread_mutex_unlock(&jobs->mutex);
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&jobs->mutex);
+        while (atomic_load(&jobs->queued) == 0 && !jobs->shutdown) {
+            pthread_cond_wait(&jobs->work_available, &jobs->mutex);
+        }
+        bool done = jobs->shutdown && atomic_load(&jobs->queued) == 0;
+        pthread_mutex_unlock(&jobs->mutex);
+        if (done) break;
+    }
+    return NULL;
+}
+
+int job_system_core_count(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+JobSystem* job_system_create(int worker_count) {
+    if (worker_count <= 0) {
+        worker_count = job_system_core_count() - 1;
+        if (worker_count < 1) worker_count = 1;
+    }
+    if (worker_count > MAX_JOB_WORKERS) worker_count = MAX_JOB_WORKERS;
+
+    JobSystem* jobs = calloc(1, sizeof(JobSystem));
+    if (!jobs) return NULL;
+    jobs->workers = calloc(worker_count, sizeof(Worker));
+    if (!jobs->workers) {
+        free(jobs);
+        return NULL;
+    }
+    jobs->worker_count = worker_count;
+    pthread_mutex_init(&jobs->mutex, NULL);
+    pthread_cond_init(&jobs->work_available, NULL);
+    pthread_cond_init(&jobs->idle, NULL);
+
+    for (int i = 0; i < worker_count; i++) {
+        jobs->workers[i].jobs = jobs;
+        jobs->workers[i].index = i;
+        pthread_create(&jobs->workers[i].thread, NULL, worker_main, &jobs->workers[i]);
+    }
+    return jobs;
+}
+
+int job_system_worker_count(const JobSystem* jobs) {
+    return jobs->worker_count;
+}
+
+void job_system_submit(JobSystem* jobs, JobFunc func, void* data) {
+    Job* job = malloc(sizeof(Job));
+    if (!job) {
+        func(data);  // Out of memory: run inline rather than drop the work
+        return;
+    }
+    job->func = func;
+    job->data = data;
+    job->next = NULL;
+
+    atomic_fetch_add(&jobs->pending, 1);
+
+    pthread_mutex_lock(&jobs->mutex);
+    if (jobs->injected_tail) {
+        jobs->injected_tail->next = job;
+    } else {
+        jobs->injected_head = job;
+    }
+    jobs->injected_tail = job;
+    jobs->injected_count++;
+    atomic_fetch_add(&jobs->queued, 1);
+    pthread_cond_signal(&jobs->work_available);
+    pthread_mutex_unlock(&jobs->mutex);
+}
+
+void job_system_wait_idle(JobSystem* jobs) {
+    pthread_mutex_lock(&jobs->mutex);
+    while (atomic_load(&jobs->pending) > 0) {
+        pthread_cond_wait(&jobs->idle, &jobs->mutex);
+    }
+    pthread_mutex_unlock(&jobs->mutex);
+}
+
+void job_system_destroy(JobSystem* jobs) {
+    if (!jobs) return;
+
+    job_system_wait_idle(jobs);
+
+    pthread_mutex_lock(&jobs->mutex);
+    jobs->shutdown = true;
+    pthread_cond_broadcast(&jobs->work_available);
+    pthread_mutex_unlock(&jobs->mutex);
+
+    for (int i = 0; i < jobs->worker_count; i++) {
+        pthread_join(jobs->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&jobs->idle);
+    pthread_cond_destroy(&jobs->work_available);
+    pthread_mutex_destroy(&jobs->mutex);
+    free(jobs->workers);
+    free(jobs);
+}
+
+void completion_queue_init(CompletionQueue* queue) {
+    atomic_init(&queue->head, NULL);
+}
+
+void completion_queue_push(CompletionQueue* queue, CompletionNode* node) {
+    CompletionNode* head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    do {
+        node->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&queue->head, &head, node,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+CompletionNode* completion_queue_take_all(CompletionQueue* queue) {
+    // The consumer detaches the whole stack at once, so there is no ABA hazard
+    CompletionNode* node = atomic_exchange_explicit(&queue->head, NULL, memory_order_acquire);
+
+    // Reverse into publication order
+    CompletionNode* ordered = NULL;
+    while (node) {
+        CompletionNode* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+    return ordered;
+}
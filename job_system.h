@@ -0,0 +1,51 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define JOB_DEQUE_SIZE 1024  // Per-worker deque capacity (power of two)
+#define MAX_JOB_WORKERS 64
+
+typedef void (*JobFunc)(void* data);
+
+typedef struct JobSystem JobSystem;
+
+// Intrusive node for the completion queue; embed it as the first member of
+// whatever a job publishes back to the main thread
+typedef struct CompletionNode {
+    struct CompletionNode* next;
+} CompletionNode;
+
+// Lock-free multi-producer, single-consumer queue of completed work
+typedef struct {
+    _Atomic(CompletionNode*) head;
+} CompletionQueue;
+
+// Start a pool of worker threads; 0 picks one per core, leaving one for the main thread
+JobSystem* job_system_create(int worker_count);
+
+// Number of worker threads in the pool
+int job_system_worker_count(const JobSystem* jobs);
+
+// Queue a job; it runs on some worker thread
+void job_system_submit(JobSystem* jobs, JobFunc func, void* data);
+
+// Block until every submitted job has finished
+void job_system_wait_idle(JobSystem* jobs);
+
+// Finish all submitted jobs, then stop and free the pool
+void job_system_destroy(JobSystem* jobs);
+
+// Number of online CPU cores
+int job_system_core_count(void);
+
+void completion_queue_init(CompletionQueue* queue);
+
+// Publish a node; safe to call from any thread
+void completion_queue_push(CompletionQueue* queue, CompletionNode* node);
+
+// Take every published node, oldest first; consumer thread only
+CompletionNode* completion_queue_take_all(CompletionQueue* queue);
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,325 @@
+#include "lighting.h"
+#include "profiler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SKY_SHIFT 4
+#define BLOCK_SHIFT 0
+#define DOWN 2  // Index of -y in neighbour_offsets
+
+static const int neighbour_offsets[6][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+// A voxel waiting in a queue, with the light level it had when queued
+typedef struct {
+    int x, y, z;
+    int level;
+} LightNode;
+
+// Growable FIFO of voxels in world coordinates
+typedef struct {
+    LightNode* nodes;
+    int head;
+    int tail;
+    int capacity;
+} LightQueue;
+
+// Looks up the chunks a pass touches, remembering the last one; with no
+// world the pass is confined to `chunk`
+typedef struct {
+    VoxelWorld* world;
+    Chunk* chunk;
+    int chunk_x;
+    int chunk_z;
+    int changed;  // Voxels whose light the pass changed
+} LightCursor;
+
+static void queue_push(LightQueue* queue, int x, int y, int z, int level) {
+    if (queue->tail == queue->capacity) {
+        if (queue->head > 0 && queue->head >= queue->capacity / 2) {
+            // Reuse the consumed front rather than grow
+            memmove(queue->nodes, queue->nodes + queue->head, (queue->tail - queue->head) * sizeof(LightNode));
+            queue->tail -= queue->head;
+            queue->head = 0;
+        } else {
+            int capacity = queue->capacity ? queue->capacity * 2 : 1024;
+            LightNode* nodes = realloc(queue->nodes, capacity * sizeof(LightNode));
+            if (!nodes) return;  // Out of memory: the light stays a little wrong
+            queue->nodes = nodes;
+            queue->capacity = capacity;
+        }
+    }
+    queue->nodes[queue->tail++] = (LightNode){x, y, z, level};
+}
+
+static Chunk* cursor_chunk(LightCursor* cursor, int x, int z, int* local_x, int* local_z) {
+    int chunk_x = block_to_chunk(x);
+    int chunk_z = block_to_chunk(z);
+    if (!cursor->chunk || chunk_x != cursor->chunk_x || chunk_z != cursor->chunk_z) {
+        if (!cursor->world) return NULL;
+        Chunk* chunk = find_chunk(cursor->world, chunk_x, chunk_z);
+        if (!chunk) return NULL;
+        cursor->chunk = chunk;
+        cursor->chunk_x = chunk_x;
+        cursor->chunk_z = chunk_z;
+    }
+    *local_x = x - chunk_x * CHUNK_SIZE;
+    *local_z = z - chunk_z * CHUNK_SIZE;
+    return cursor->chunk;
+}
+
+static int light_level(const Chunk* chunk, int x, int y, int z, int shift) {
+    return (chunk_light_get(&chunk->light, x, y, z) >> shift) & 15;
+}
+
+static void set_light(LightCursor* cursor, Chunk* chunk, int x, int y, int z, int shift, int level) {
+    unsigned char light = chunk_light_get(&chunk->light, x, y, z);
+    chunk_light_set(&chunk->light, x, y, z, (unsigned char)((light & ~(15 << shift)) | level << shift));
+    cursor->changed++;
+    if (!cursor->world) return;
+
+    // The chunk's faces and, on an edge, the neighbour's faces lit by this block
+    mark_chunk_dirty(cursor->world, chunk);
+    if (x == 0) mark_chunk_dirty_at(cursor->world, chunk->world_x - 1, chunk->world_z);
+    if (x == CHUNK_SIZE - 1) mark_chunk_dirty_at(cursor->world, chunk->world_x + 1, chunk->world_z);
+    if (z == 0) mark_chunk_dirty_at(cursor->world, chunk->world_x, chunk->world_z - 1);
+    if (z == CHUNK_SIZE - 1) mark_chunk_dirty_at(cursor->world, chunk->world_x, chunk->world_z + 1);
+}
+
+// Light a block passes on to a neighbour in direction `i`
+static int light_reach(int level, int shift, int i) {
+    return shift == SKY_SHIFT && i == DOWN && level == MAX_LIGHT ? MAX_LIGHT : level - 1;
+}
+
+// Spread light from every queued voxel into the air around it until
+// nothing brighter can be reached
+static void propagate_add(LightCursor* cursor, LightQueue* queue, int shift) {
+    while (queue->head < queue->tail) {
+        LightNode node = queue->nodes[queue->head++];
+        int local_x, local_z;
+        Chunk* chunk = cursor_chunk(cursor, node.x, node.z, &local_x, &local_z);
+        if (!chunk) continue;
+        int level = light_level(chunk, local_x, node.y, local_z, shift);
+        if (level <= 1) continue;
+
+        for (int i = 0; i < 6; i++) {
+            int x = node.x + neighbour_offsets[i][0];
+            int y = node.y + neighbour_offsets[i][1];
+            int z = node.z + neighbour_offsets[i][2];
+            if (y < 0 || y >= WORLD_HEIGHT) continue;
+            int nx, nz;
+            Chunk* next = cursor_chunk(cursor, x, z, &nx, &nz);
+            if (!next || chunk_storage_is_solid(&next->storage, nx, y, nz)) continue;
+
+            int reach = light_reach(level, shift, i);
+            if (light_level(next, nx, y, nz, shift) >= reach) continue;
+            set_light(cursor, next, nx, y, nz, shift, reach);
+            queue_push(queue, x, y, z, reach);
+        }
+    }
+    queue->head = queue->tail = 0;
+}
+
+// Darken everything the queued voxels lit, given the levels they had.
+// Brighter or equal light met on the way has another source and is queued
+// in `refill` to spread back into the darkened blocks.
+static void propagate_remove(LightCursor* cursor, LightQueue* queue, LightQueue* refill, int shift) {
+    while (queue->head < queue->tail) {
+        LightNode node = queue->nodes[queue->head++];
+        for (int i = 0; i < 6; i++) {
+            int x = node.x + neighbour_offsets[i][0];
+            int y = node.y + neighbour_offsets[i][1];
+            int z = node.z + neighbour_offsets[i][2];
+            if (y < 0 || y >= WORLD_HEIGHT) continue;
+            int nx, nz;
+            Chunk* next = cursor_chunk(cursor, x, z, &nx, &nz);
+            if (!next) continue;
+
+            int level = light_level(next, nx, y, nz, shift);
+            if (level == 0) continue;
+            if (level < node.level || light_reach(node.level, shift, i) == MAX_LIGHT) {
+                set_light(cursor, next, nx, y, nz, shift, 0);
+                queue_push(queue, x, y, z, level);
+            } else {
+                queue_push(refill, x, y, z, level);
+            }
+        }
+    }
+    queue->head = queue->tail = 0;
+}
+
+void light_chunk_local(Chunk* chunk) {
+    PROFILE_ZONE("light_chunk_local");
+    const ChunkStorage* storage = &chunk->storage;
+
+    // Open sky down to the first solid block of every column. Sections
+    // above every column's top start as uniform sky and the rest as uniform
+    // darkness, so only sections the surface crosses take dense light.
+    int top[CHUNK_SIZE][CHUNK_SIZE];
+    int highest = 0;
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int y = WORLD_HEIGHT;
+            while (y > 0 && !chunk_storage_is_solid(storage, x, y - 1, z)) y--;
+            top[x][z] = y;
+            if (y > highest) highest = y;
+        }
+    }
+    int open_section = (highest + SECTION_HEIGHT - 1) / SECTION_HEIGHT;
+    chunk_light_fill(&chunk->light, 0);
+    for (int s = open_section; s < SECTIONS_PER_CHUNK; s++) {
+        chunk->light.sections[s].uniform = MAX_LIGHT << SKY_SHIFT;
+    }
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = top[x][z]; y < open_section * SECTION_HEIGHT; y++) {
+                chunk_light_set(&chunk->light, x, y, z, MAX_LIGHT << SKY_SHIFT);
+            }
+        }
+    }
+
+    LightCursor cursor = {NULL, chunk, chunk->world_x, chunk->world_z, 0};
+    LightQueue queue = {0};
+    int base_x = chunk->world_x * CHUNK_SIZE, base_z = chunk->world_z * CHUNK_SIZE;
+
+    // Open sky only lights a neighbouring column sideways at heights where
+    // that column is not open itself but has air: under an overhang or in a cave
+    static const int sideways[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int i = 0; i < 4; i++) {
+                int nx = x + sideways[i][0], nz = z + sideways[i][1];
+                if (nx < 0 || nx >= CHUNK_SIZE || nz < 0 || nz >= CHUNK_SIZE) continue;
+                for (int y = top[x][z]; y < top[nx][nz]; y++) {
+                    if (!chunk_storage_is_solid(storage, nx, y, nz)) {
+                        queue_push(&queue, base_x + x, y, base_z + z, MAX_LIGHT);
+                    }
+                }
+            }
+        }
+    }
+    propagate_add(&cursor, &queue, SKY_SHIFT);
+
+    // Lamps are the only emissive blocks, so only sections that may hold one are searched
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        if (!chunk_section_may_contain(storage, s, BLOCK_LAMP)) continue;
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            for (int y = s * SECTION_HEIGHT; y < (s + 1) * SECTION_HEIGHT; y++) {
+                for (int z = 0; z < CHUNK_SIZE; z++) {
+                    int emission = block_light_emission(chunk_storage_get(storage, x, y, z));
+                    if (emission == 0) continue;
+                    unsigned char light = chunk_light_get(&chunk->light, x, y, z);
+                    chunk_light_set(&chunk->light, x, y, z, (unsigned char)(light | emission << BLOCK_SHIFT));
+                    queue_push(&queue, base_x + x, y, base_z + z, emission);
+                }
+            }
+        }
+    }
+    propagate_add(&cursor, &queue, BLOCK_SHIFT);
+    free(queue.nodes);
+
+    // Light that spread back out evenly needs no dense sections
+    chunk_light_compact(&chunk->light);
+}
+
+// Queue whichever side of each pair of facing edge blocks can light the other
+static void queue_border(LightQueue* queue, const Chunk* chunk, const Chunk* neighbour, int axis, int shift) {
+    bool along_x = axis == 0;
+    int side = along_x ? neighbour->world_x - chunk->world_x : neighbour->world_z - chunk->world_z;
+    int own = side > 0 ? CHUNK_SIZE - 1 : 0;
+    int other = CHUNK_SIZE - 1 - own;
+
+    for (int y = 0; y < WORLD_HEIGHT; y++) {
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            int ax = along_x ? own : i, az = along_x ? i : own;
+            int bx = along_x ? other : i, bz = along_x ? i : other;
+            int a = light_level(chunk, ax, y, az, shift);
+            int b = light_level(neighbour, bx, y, bz, shift);
+            if (a > b + 1) {
+                queue_push(queue, chunk->world_x * CHUNK_SIZE + ax, y, chunk->world_z * CHUNK_SIZE + az, a);
+            } else if (b > a + 1) {
+                queue_push(queue, neighbour->world_x * CHUNK_SIZE + bx, y, neighbour->world_z * CHUNK_SIZE + bz, b);
+            }
+        }
+    }
+}
+
+int light_chunk_borders(VoxelWorld* world, Chunk* chunk) {
+    PROFILE_ZONE("light_chunk_borders");
+    ChunkNeighbours neighbours = get_chunk_neighbours(world, chunk);
+    const Chunk* sides[4] = {neighbours.neg_x, neighbours.pos_x, neighbours.neg_z, neighbours.pos_z};
+    LightCursor cursor = {world, NULL, 0, 0, 0};
+    LightQueue queue = {0};
+
+    for (int shift = BLOCK_SHIFT; shift <= SKY_SHIFT; shift += SKY_SHIFT) {
+        for (int i = 0; i < 4; i++) {
+            if (sides[i]) queue_border(&queue, chunk, sides[i], i < 2 ? 0 : 2, shift);
+        }
+        propagate_add(&cursor, &queue, shift);
+    }
+    free(queue.nodes);
+    return cursor.changed;
+}
+
+int light_update_block(VoxelWorld* world, int x, int y, int z, unsigned char old_type, unsigned char new_type) {
+    PROFILE_ZONE("light_update_block");
+    if (y < 0 || y >= WORLD_HEIGHT) return 0;
+    LightCursor cursor = {world, NULL, 0, 0, 0};
+    int local_x, local_z;
+    Chunk* chunk = cursor_chunk(&cursor, x, z, &local_x, &local_z);
+    if (!chunk) return 0;
+
+    LightQueue add = {0};
+    LightQueue remove = {0};
+    for (int shift = BLOCK_SHIFT; shift <= SKY_SHIFT; shift += SKY_SHIFT) {
+        int old_level = light_level(chunk, local_x, y, local_z, shift);
+        int emission = shift == BLOCK_SHIFT ? block_light_emission(new_type) : 0;
+        if (old_level == emission && (new_type != 0) == (old_type != 0)) continue;
+
+        // Unwind the light the block had: what passed through it, or what it gave off
+        if (old_level > 0) {
+            set_light(&cursor, chunk, local_x, y, local_z, shift, 0);
+            queue_push(&remove, x, y, z, old_level);
+            propagate_remove(&cursor, &remove, &add, shift);
+        }
+
+        if (new_type != 0) {
+            if (emission > 0) {
+                set_light(&cursor, chunk, local_x, y, local_z, shift, emission);
+                queue_push(&add, x, y, z, emission);
+            }
+        } else if (shift == SKY_SHIFT && y == WORLD_HEIGHT - 1) {
+            // Nothing above the top layer: an opened block there is open sky
+            set_light(&cursor, chunk, local_x, y, local_z, shift, MAX_LIGHT);
+            queue_push(&add, x, y, z, MAX_LIGHT);
+        } else {
+            // Let the light around the opened block flow into it
+            for (int i = 0; i < 6; i++) {
+                int nx = x + neighbour_offsets[i][0];
+                int ny = y + neighbour_offsets[i][1];
+                int nz = z + neighbour_offsets[i][2];
+                if (ny < 0 || ny >= WORLD_HEIGHT) continue;
+                int lx, lz;
+                Chunk* next = cursor_chunk(&cursor, nx, nz, &lx, &lz);
+                if (!next) continue;
+                int level = light_level(next, lx, ny, lz, shift);
+                if (level > 0) queue_push(&add, nx, ny, nz, level);
+            }
+        }
+        propagate_add(&cursor, &add, shift);
+    }
+    free(add.nodes);
+    free(remove.nodes);
+    return cursor.changed;
+}
+
+unsigned char get_light(VoxelWorld* world, int x, int y, int z) {
+    if (y >= WORLD_HEIGHT) return MAX_LIGHT << SKY_SHIFT;
+    if (y < 0) return 0;
+    int chunk_x = block_to_chunk(x);
+    int chunk_z = block_to_chunk(z);
+    const Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+    if (!chunk) return 0;
+    return chunk_light_get(&chunk->light, x - chunk_x * CHUNK_SIZE, y, z - chunk_z * CHUNK_SIZE);
+}
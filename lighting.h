@@ -0,0 +1,49 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include "voxel_world.h"
+
+// Flood-fill voxel lighting with two channels. Sky light is MAX_LIGHT in
+// every air block open to the sky, falls straight down without losing
+// strength and loses a level per block sideways or upwards. Block light
+// starts at an emissive block and loses a level per block in any direction.
+// Any solid block stops both.
+//
+// A chunk is lit on its own when it is loaded, then exchanges light with
+// its loaded neighbours when it is published. After that, edits only relight
+// the blocks whose light they change: removed light is unwound with a removal
+// queue and whatever still reaches the hole is refilled with an add queue,
+// across chunk borders. Chunks whose light changed are marked for remeshing.
+// Light is read and written through chunk_light_get/set, so sections of open
+// sky or solid ground keep a single value rather than a byte per voxel.
+
+static inline int light_sky(unsigned char light) {
+    return light >> 4;
+}
+
+static inline int light_block(unsigned char light) {
+    return light & 15;
+}
+
+// Block light a block type emits
+static inline int block_light_emission(unsigned char block_type) {
+    return block_type == BLOCK_LAMP ? MAX_LIGHT : 0;
+}
+
+// Light a chunk from its own blocks alone, treating its neighbours as
+// missing. Touches nothing but the chunk, so it can run on a worker.
+void light_chunk_local(Chunk* chunk);
+
+// Let light flow both ways between a published chunk and its loaded
+// neighbours. Returns the number of voxels whose light changed.
+int light_chunk_borders(VoxelWorld* world, Chunk* chunk);
+
+// Update light after the block at (x, y, z) changed from `old_type` to
+// `new_type`. Returns the number of voxels whose light changed.
+int light_update_block(VoxelWorld* world, int x, int y, int z, unsigned char old_type, unsigned char new_type);
+
+// Packed light at world coordinates: open sky above the world, darkness
+// below it and in chunks that are not loaded
+unsigned char get_light(VoxelWorld* world, int x, int y, int z);
+
+#endif // LIGHTING_H
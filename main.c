@@ -1,70 +1,118 @@
 #include <SDL.h>
-#include <OpenGL/gl.h>
-#include <OpenGL/glu.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <math.h>
+#include <string.h>
 #include "voxel_world.h"
+#include "camera.h"
+#include "draw_list.h"
+#include "frame_timer.h"
+#include "player.h"
+#include "profiler.h"
+#include "raycast.h"
+#include "render_gl.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
-#define MOVEMENT_SPEED 0.1f
+#define MOVEMENT_SPEED 6.0f  // Blocks per second
 #define MOUSE_SENSITIVITY 0.2f
-#define MOUSE_MOVE_SPEED 0.5f
-
-typedef struct {
-    float x, y, z;
-    float pitch, yaw;
-} Camera;
+#define MOUSE_MOVE_SPEED 30.0f  // Blocks per second
+#define SIMULATION_HZ 60  // Fixed simulation steps per second, whatever the frame rate
+#define MAX_STEPS_PER_FRAME 8  // Simulation time beyond this after a stall is dropped
+#define CAPPED_FPS 60  // Frame rate limit in the capped pacing mode
+#define SAVE_DIRECTORY "world"  // Region files for visited chunks, relative to the working directory
+#define STATS_INTERVAL_MS 1000  // How often the window title shows culling counters
+#define REACH_DISTANCE 8.0f  // Blocks away the player can break or place
+#define PLACED_BLOCK BLOCK_DIRT
+#define TRACE_PATH "profile_trace.json"  // Written by T, relative to the working directory
 
 void init_gl() {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
     
-    // Enable lighting for 3D effect
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    
-    // Set up light position and properties
-    float light_pos[] = {1.0f, 1.0f, 1.0f, 0.0f};
-    float light_ambient[] = {0.3f, 0.3f, 0.3f, 1.0f};
-    float light_diffuse[] = {0.7f, 0.7f, 0.7f, 1.0f};
-    
-    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
-    
-    // Enable color material for simpler coloring
-    glEnable(GL_COLOR_MATERIAL);
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    // No fixed-function lighting: chunk colours carry the baked per-voxel
+    // light and the sky is drawn in flat colours
+}
+
+// How frames are paced: slept to CAPPED_FPS, synced to the display, or
+// drawn as fast as possible
+typedef enum {
+    PACING_CAPPED,
+    PACING_VSYNC,
+    PACING_UNCAPPED,
+    PACING_COUNT
+} FramePacing;
+
+static const char* const pacing_names[PACING_COUNT] = {"capped", "vsync", "uncapped"};
+
+// Set the swap interval for a pacing mode; falls back to capped if the
+// driver refuses vsync
+FramePacing apply_frame_pacing(FramePacing pacing) {
+    if (SDL_GL_SetSwapInterval(pacing == PACING_VSYNC ? 1 : 0) != 0 && pacing == PACING_VSYNC) {
+        printf("Vsync unavailable (%s); capping at %d fps\n", SDL_GetError(), CAPPED_FPS);
+        return PACING_CAPPED;
+    }
+    return pacing;
 }
 
-void setup_camera(Camera* camera) {
-    glLoadIdentity();
-    glRotatef(-camera->pitch, 1.0f, 0.0f, 0.0f);
-    glRotatef(-camera->yaw, 0.0f, 1.0f, 0.0f);
-    glTranslatef(-camera->x, -camera->y, -camera->z);
+void move_camera(Camera* camera, float forward, float right, float delta_time) {
+    float angle = camera->yaw * M_PI / 180.0f;
+    float distance = MOVEMENT_SPEED * delta_time;
+    camera->x += sinf(angle) * forward * distance;
+    camera->z += cosf(angle) * forward * distance;
+    camera->x += sinf(angle + M_PI/2) * right * distance;
+    camera->z += cosf(angle + M_PI/2) * right * distance;
 }
 
-void move_camera(Camera* camera, float forward, float right) {
+void move_camera_forward(Camera* camera, float delta_time) {
     float angle = camera->yaw * M_PI / 180.0f;
-    camera->x += sinf(angle) * forward * MOVEMENT_SPEED;
-    camera->z += cosf(angle) * forward * MOVEMENT_SPEED;
-    camera->x += sinf(angle + M_PI/2) * right * MOVEMENT_SPEED;
-    camera->z += cosf(angle + M_PI/2) * right * MOVEMENT_SPEED;
+    camera->x += sinf(angle) * MOUSE_MOVE_SPEED * delta_time;
+    camera->z += cosf(angle) * MOUSE_MOVE_SPEED * delta_time;
 }
 
-void move_camera_forward(Camera* camera) {
+void move_camera_backward(Camera* camera, float delta_time) {
     float angle = camera->yaw * M_PI / 180.0f;
-    camera->x += sinf(angle) * MOUSE_MOVE_SPEED;
-    camera->z += cosf(angle) * MOUSE_MOVE_SPEED;
+    camera->x -= sinf(angle) * MOUSE_MOVE_SPEED * delta_time;
+    camera->z -= cosf(angle) * MOUSE_MOVE_SPEED * delta_time;
 }
 
-void move_camera_backward(Camera* camera) {
+// Walking velocity for the movement keys, relative to where the camera faces
+PlayerInput walk_input(const Camera* camera, float forward, float right, bool jump) {
     float angle = camera->yaw * M_PI / 180.0f;
-    camera->x -= sinf(angle) * MOUSE_MOVE_SPEED;
-    camera->z -= cosf(angle) * MOUSE_MOVE_SPEED;
+    PlayerInput input;
+    input.move[0] = (sinf(angle) * forward + sinf(angle + M_PI/2) * right) * MOVEMENT_SPEED;
+    input.move[1] = (cosf(angle) * forward + cosf(angle + M_PI/2) * right) * MOVEMENT_SPEED;
+    input.jump = jump;
+    return input;
+}
+
+// Camera to render between the last two simulated positions; the view
+// angles follow the mouse directly and are taken from the latest
+Camera interpolate_camera(const Camera* previous, const Camera* current, float alpha) {
+    Camera view = *current;
+    view.x = previous->x + (current->x - previous->x) * alpha;
+    view.y = previous->y + (current->y - previous->y) * alpha;
+    view.z = previous->z + (current->z - previous->z) * alpha;
+    return view;
+}
+
+// Break the block the camera is looking at (block_type 0), or place one
+// against the face it looks at
+void edit_block_in_view(VoxelWorld* world, const Camera* camera, unsigned char block_type) {
+    float origin[3] = {camera->x, camera->y, camera->z};
+    float direction[3];
+    camera_forward(camera, direction);
+    RayHit hit;
+    if (!raycast(world, origin, direction, REACH_DISTANCE, &hit)) return;
+
+    if (block_type == 0) {
+        set_block(world, hit.block[0], hit.block[1], hit.block[2], 0);
+    } else if (hit.normal[0] || hit.normal[1] || hit.normal[2]) {
+        set_block(world, hit.block[0] + hit.normal[0], hit.block[1] + hit.normal[1],
+                  hit.block[2] + hit.normal[2], block_type);
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -101,24 +149,56 @@ int main(int argc, char* argv[]) {
     // Initialize OpenGL
     init_gl();
     glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(45.0f, (float)WINDOW_WIDTH / WINDOW_HEIGHT, 0.1f, 1000.0f);
-    glMatrixMode(GL_MODELVIEW);
+    Projection projection = {
+        .fov_y = 45.0f,
+        .aspect = (float)WINDOW_WIDTH / WINDOW_HEIGHT,
+        .near_plane = 0.1f,
+        .far_plane = 1000.0f
+    };
+    Renderer* renderer = gl_renderer_get();
 
-    // Initialize voxel world
+    // Initialize voxel world. Arguments: a view distance, --vsync or
+    // --uncapped to change the frame pacing, and --stars N
     VoxelWorld world;
-    init_voxel_world(&world);
+    WorldConfig world_config = default_world_config();
+    world_config.save_directory = SAVE_DIRECTORY;
+    FramePacing pacing = PACING_CAPPED;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vsync") == 0) {
+            pacing = PACING_VSYNC;
+        } else if (strcmp(argv[i], "--uncapped") == 0) {
+            pacing = PACING_UNCAPPED;
+        } else if (strcmp(argv[i], "--stars") == 0 && i + 1 < argc) {
+            world_config.star_count = atoi(argv[++i]);
+        } else {
+            world_config.view_distance = atoi(argv[i]);
+        }
+    }
+    pacing = apply_frame_pacing(pacing);
+    if (!init_voxel_world_with_config(&world, &world_config)) {
+        printf("Could not allocate the chunk window\n");
+        SDL_GL_DeleteContext(gl_context);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
 
     // Initialize camera
     Camera camera = {
-        .x = CHUNK_SIZE * CHUNK_COUNT / 2,
+        .x = CHUNK_SIZE / 2,  // Centre of the player's starting chunk
         .y = WORLD_HEIGHT + 10,  // Position camera higher up
-        .z = CHUNK_SIZE * CHUNK_COUNT / 2,
+        .z = CHUNK_SIZE / 2,
         .pitch = -30.0f,  // Look down at a better angle
         .yaw = 0.0f
     };
 
+    // The player walks from the start; F toggles free flight through terrain
+    Player player;
+    player_init(&player, camera.x, camera.y - PLAYER_EYE_HEIGHT, camera.z);
+    bool flying = false;
+
+    PROFILE_THREAD_NAME("main");
+
     // Main loop variables
     bool quit = false;
     SDL_Event event;
@@ -127,56 +207,129 @@ int main(int argc, char* argv[]) {
     const Uint8* keyboard_state = SDL_GetKeyboardState(NULL);
     bool left_mouse_down = false;
     bool right_mouse_down = false;
+    DrawList draw_list = {0};
+    static OcclusionBuffer occlusion;
+    bool occlusion_enabled = false;  // Costs more than it saves on open terrain; O toggles it
+    Uint32 last_stats_time = SDL_GetTicks();
+
+    // Simulation runs in fixed steps; rendering interpolates between the
+    // last two and runs as often as the pacing allows
+    FixedStep simulation;
+    fixed_step_init(&simulation, 1.0 / SIMULATION_HZ, MAX_STEPS_PER_FRAME);
+    Camera previous_camera = camera;
+    static FrameHistogram session_frames;  // Printed on exit
+    static FrameHistogram recent_frames;  // Shown in the title, reset with the stats
+    frame_histogram_reset(&session_frames);
+    frame_histogram_reset(&recent_frames);
+    double last_frame_time = frame_clock_seconds();
 
     // Capture mouse
     SDL_SetRelativeMouseMode(SDL_TRUE);
 
     while (!quit) {
+        double frame_start = frame_clock_seconds();
+        double frame_seconds = frame_start - last_frame_time;
+        last_frame_time = frame_start;
+        frame_histogram_add(&session_frames, frame_seconds);
+        frame_histogram_add(&recent_frames, frame_seconds);
+        PROFILE_FRAME();
+
         // Handle events
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                quit = true;
-            }
-            else if (event.type == SDL_KEYDOWN) {
-                if (event.key.keysym.sym == SDLK_ESCAPE) {
+        {
+            PROFILE_ZONE("input");
+            while (SDL_PollEvent(&event)) {
+                if (event.type == SDL_QUIT) {
                     quit = true;
                 }
-            }
-            else if (event.type == SDL_MOUSEBUTTONDOWN) {
-                if (event.button.button == SDL_BUTTON_LEFT) {
-                    right_mouse_down = true;
-                }
-                else if (event.button.button == SDL_BUTTON_RIGHT) {
-                    left_mouse_down = true;
-                }
-            }
-            else if (event.type == SDL_MOUSEBUTTONUP) {
-                if (event.button.button == SDL_BUTTON_LEFT) {
-                    right_mouse_down = false;
+                else if (event.type == SDL_KEYDOWN) {
+                    if (event.key.keysym.sym == SDLK_ESCAPE) {
+                        quit = true;
+                    }
+                    // Shrink or grow the view distance
+                    else if (event.key.keysym.sym == SDLK_LEFTBRACKET) {
+                        set_view_distance(&world, world.view_distance - 1);
+                    }
+                    else if (event.key.keysym.sym == SDLK_RIGHTBRACKET) {
+                        set_view_distance(&world, world.view_distance + 1);
+                    }
+                    // Toggle occlusion culling to compare frame times
+                    else if (event.key.keysym.sym == SDLK_o) {
+                        occlusion_enabled = !occlusion_enabled;
+                    }
+                    // M switches between one multi-draw and a draw call per range
+                    else if (event.key.keysym.sym == SDLK_m) {
+                        gl_set_multi_draw(!gl_render_stats()->multi_draw);
+                    }
+                    // Cycle capped, vsync and uncapped frame pacing
+                    else if (event.key.keysym.sym == SDLK_v) {
+                        pacing = apply_frame_pacing((pacing + 1) % PACING_COUNT);
+                    }
+                    // F switches between walking and free flight
+                    else if (event.key.keysym.sym == SDLK_f) {
+                        flying = !flying;
+                        if (!flying) {
+                            player_init(&player, camera.x, camera.y - PLAYER_EYE_HEIGHT, camera.z);
+                        }
+                    }
+                    // P prints per-zone timings, T writes a trace for chrome://tracing
+                    else if (event.key.keysym.sym == SDLK_p) {
+                        profile_print_summary(stdout);
+                    }
+                    else if (event.key.keysym.sym == SDLK_t) {
+                        long events = profile_write_trace(TRACE_PATH);
+                        if (events >= 0) {
+                            printf("Wrote %ld profiler events to %s\n", events, TRACE_PATH);
+                        } else {
+                            printf("Could not write %s\n", TRACE_PATH);
+                        }
+                    }
+                    // Q breaks the block in view, E places one against it, L a lamp
+                    else if (event.key.keysym.sym == SDLK_q) {
+                        edit_block_in_view(&world, &camera, 0);
+                    }
+                    else if (event.key.keysym.sym == SDLK_e) {
+                        edit_block_in_view(&world, &camera, PLACED_BLOCK);
+                    }
+                    else if (event.key.keysym.sym == SDLK_l) {
+                        edit_block_in_view(&world, &camera, BLOCK_LAMP);
+                    }
                 }
-                else if (event.button.button == SDL_BUTTON_RIGHT) {
-                    left_mouse_down = false;
+                else if (event.type == SDL_MOUSEBUTTONDOWN) {
+                    if (event.button.button == SDL_BUTTON_LEFT) {
+                        right_mouse_down = true;
+                    }
+                    else if (event.button.button == SDL_BUTTON_RIGHT) {
+                        left_mouse_down = true;
+                    }
                 }
-            }
-            else if (event.type == SDL_MOUSEMOTION) {
-                if (first_mouse) {
-                    last_mouse_x = event.motion.x;
-                    last_mouse_y = event.motion.y;
-                    first_mouse = false;
-                    continue;
+                else if (event.type == SDL_MOUSEBUTTONUP) {
+                    if (event.button.button == SDL_BUTTON_LEFT) {
+                        right_mouse_down = false;
+                    }
+                    else if (event.button.button == SDL_BUTTON_RIGHT) {
+                        left_mouse_down = false;
+                    }
                 }
+                else if (event.type == SDL_MOUSEMOTION) {
+                    if (first_mouse) {
+                        last_mouse_x = event.motion.x;
+                        last_mouse_y = event.motion.y;
+                        first_mouse = false;
+                        continue;
+                    }
 
-                float xoffset = event.motion.xrel * MOUSE_SENSITIVITY;
-                float yoffset = event.motion.yrel * MOUSE_SENSITIVITY;
+                    float xoffset = event.motion.xrel * MOUSE_SENSITIVITY;
+                    float yoffset = event.motion.yrel * MOUSE_SENSITIVITY;
 
-                camera.yaw += xoffset;
-                camera.pitch += yoffset;
+                    camera.yaw += xoffset;
+                    camera.pitch += yoffset;
 
-                // Constrain pitch
-                if (camera.pitch > 89.0f)
-                    camera.pitch = 89.0f;
-                if (camera.pitch < -89.0f)
-                    camera.pitch = -89.0f;
+                    // Constrain pitch
+                    if (camera.pitch > 89.0f)
+                        camera.pitch = 89.0f;
+                    if (camera.pitch < -89.0f)
+                        camera.pitch = -89.0f;
+                }
             }
         }
 
@@ -186,52 +339,87 @@ int main(int argc, char* argv[]) {
         if (keyboard_state[SDL_SCANCODE_W]) forward -= 1.0f;
         if (keyboard_state[SDL_SCANCODE_A]) right -= 1.0f;
         if (keyboard_state[SDL_SCANCODE_D]) right += 1.0f;
-        
-        move_camera(&camera, forward, right);
 
-        // Handle mouse movement
-        if (left_mouse_down) {
-            move_camera_forward(&camera);
-        }
-        if (right_mouse_down) {
-            move_camera_backward(&camera);
+        // Step the simulation for the time that has passed
+        int steps = fixed_step_advance(&simulation, frame_seconds);
+        float step = (float)simulation.step;
+        for (int i = 0; i < steps; i++) {
+            PROFILE_ZONE("simulation_step");
+            previous_camera = camera;
+            if (flying) {
+                move_camera(&camera, forward, right, step);
+                if (left_mouse_down) {
+                    move_camera_forward(&camera, step);
+                }
+                if (right_mouse_down) {
+                    move_camera_backward(&camera, step);
+                }
+            } else {
+                PlayerInput input = walk_input(&camera, forward, right, keyboard_state[SDL_SCANCODE_SPACE]);
+                player_step(&world, &player, &input, step);
+                camera.x = player.position[0];
+                camera.y = player.position[1] + PLAYER_EYE_HEIGHT;
+                camera.z = player.position[2];
+            }
+            update_skybox(&world, step);
         }
+        Camera view = interpolate_camera(&previous_camera, &camera, fixed_step_alpha(&simulation));
 
         // Update chunks based on player position
-        update_chunks(&world, camera.x, camera.z);
-
-        // Clear screen
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glLoadIdentity();
-
-        // Update skybox colors (before camera setup)
-        update_skybox(&world, 0.016f);  // Assuming 60 FPS
-        
-        // Setup camera
-        setup_camera(&camera);
-
-        // Render skybox and stars (before blocks)
-        render_skybox(&world);
-
-        // Render world
-        for (int x = 0; x < CHUNK_COUNT; x++) {
-            for (int z = 0; z < CHUNK_COUNT; z++) {
-                glPushMatrix();
-                // Position chunks relative to the center chunk (player's chunk)
-                float chunk_x = (x - VIEW_DISTANCE) * CHUNK_SIZE;
-                float chunk_z = (z - VIEW_DISTANCE) * CHUNK_SIZE;
-                glTranslatef(chunk_x, 0, chunk_z);
-                render_chunk(&world.chunks[x][z]);
-                glPopMatrix();
-            }
+        update_chunks(&world, view.x, view.z);
+
+        // Clear to the sky and set up the camera; the culling frustum is
+        // built from the same one
+        renderer_begin_frame(renderer, &world, &view, &projection);
+
+        // Upload any chunk meshes rebuilt this frame
+        renderer_upload(renderer, &world);
+
+        // Render the chunk sections inside the view frustum and not hidden
+        // behind nearer terrain
+        Frustum frustum;
+        frustum_from_camera(&frustum, &view, &projection);
+        draw_list_build(&draw_list, &world, &frustum, occlusion_enabled ? &occlusion : NULL);
+        renderer_draw(renderer, &draw_list);
+
+        Uint32 now = SDL_GetTicks();
+        if (now - last_stats_time >= STATS_INTERVAL_MS) {
+            const CullStats* cull = &draw_list.stats;
+            const GlRenderStats* render = gl_render_stats();
+            char title[384];
+            snprintf(title, sizeof(title),
+                     "Voxel Game - %.0f fps %s, p99 %.1f ms - chunks %d visible / %d culled, "
+                     "sections %d / %d culled / %d occluded (%.2f ms) - %d draws for %d ranges, "
+                     "arena %.0f%% used, %.0f%% fragmented",
+                     recent_frames.count / recent_frames.total_seconds, pacing_names[pacing],
+                     frame_histogram_percentile(&recent_frames, 99.0) * 1e3,
+                     cull->chunks_visible, cull->chunks_culled, cull->sections_visible,
+                     cull->sections_culled, cull->sections_occluded, cull->occlusion_ns / 1e6,
+                     render->draw_calls, render->draw_ranges,
+                     render->arena_capacity ? 100.0 * render->arena_used / render->arena_capacity : 0.0,
+                     render->arena_fragmentation * 100.0);
+            SDL_SetWindowTitle(window, title);
+            frame_histogram_reset(&recent_frames);
+            last_stats_time = now;
         }
 
         // Swap buffers
-        SDL_GL_SwapWindow(window);
-        SDL_Delay(16); // Cap to ~60 FPS
+        {
+            PROFILE_ZONE("swap");
+            SDL_GL_SwapWindow(window);
+        }
+        if (pacing == PACING_CAPPED) {
+            frame_clock_sleep_until(frame_start + 1.0 / CAPPED_FPS);
+        }
     }
 
+    printf("Frame times (%s):\n", pacing_names[pacing]);
+    frame_histogram_print(&session_frames, stdout);
+
     // Cleanup
+    draw_list_free(&draw_list);
+    renderer_release(renderer, &world);
+    renderer_destroy(renderer);
     cleanup_voxel_world(&world);
     SDL_GL_DeleteContext(gl_context);
     SDL_DestroyWindow(window);
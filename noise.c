@@ -0,0 +1,294 @@
+#include "noise.h"
+#include <math.h>
+#include <pthread.h>
+
+// The SIMD paths must round exactly like the scalar reference, so never fuse
+// multiply-adds in this file
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NOISE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define HASH_X 0x27d4eb2du
+#define HASH_Z 0x165667b1u
+#define HASH_MIX 0x2c1b3c6du
+#define OCTAVE_SEED_STEP 0x9e3779b9u
+
+static unsigned int hash_lattice(unsigned int seed, int ix, int iz) {
+    unsigned int h = seed ^ ((unsigned int)ix * HASH_X) ^ ((unsigned int)iz * HASH_Z);
+    h ^= h >> 15;
+    h *= HASH_MIX;
+    h ^= h >> 12;
+    return h;
+}
+
+// Dot product with one of the four diagonal gradients (+-1, +-1)
+static float gradient_dot(unsigned int h, float dx, float dz) {
+    float gx = (h & 1) ? -dx : dx;
+    float gz = (h & 2) ? -dz : dz;
+    return gx + gz;
+}
+
+// Quintic smoothstep 6t^5 - 15t^4 + 10t^3
+static float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+float noise_gradient2d(unsigned int seed, float x, float z) {
+    float fx = floorf(x);
+    float fz = floorf(z);
+    int ix = (int)fx;
+    int iz = (int)fz;
+    float dx = x - fx;
+    float dz = z - fz;
+
+    float n00 = gradient_dot(hash_lattice(seed, ix, iz), dx, dz);
+    float n10 = gradient_dot(hash_lattice(seed, ix + 1, iz), dx - 1.0f, dz);
+    float n01 = gradient_dot(hash_lattice(seed, ix, iz + 1), dx, dz - 1.0f);
+    float n11 = gradient_dot(hash_lattice(seed, ix + 1, iz + 1), dx - 1.0f, dz - 1.0f);
+
+    float u = fade(dx);
+    float v = fade(dz);
+    float nx0 = n00 + u * (n10 - n00);
+    float nx1 = n01 + u * (n11 - n01);
+    return nx0 + v * (nx1 - nx0);
+}
+
+float noise_fbm2d(unsigned int seed, float x, float z, int octaves) {
+    float sum = 0.0f;
+    float total = 0.0f;
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+
+    for (int octave = 0; octave < octaves; octave++) {
+        unsigned int octave_seed = seed + (unsigned int)octave * OCTAVE_SEED_STEP;
+        float n = noise_gradient2d(octave_seed, x * frequency, z * frequency);
+        sum = sum + amplitude * n;
+        total = total + amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return total > 0.0f ? sum / total : 0.0f;
+}
+
+void noise_fbm_grid_scalar(unsigned int seed, int base_x, int base_z, float frequency,
+                           int octaves, float* out) {
+    for (int x = 0; x < NOISE_GRID_SIZE; x++) {
+        float sample_x = (float)(base_x + x) * frequency;
+        for (int z = 0; z < NOISE_GRID_SIZE; z++) {
+            float sample_z = (float)(base_z + z) * frequency;
+            out[x * NOISE_GRID_SIZE + z] = noise_fbm2d(seed, sample_x, sample_z, octaves);
+        }
+    }
+}
+
+#ifdef NOISE_X86_SIMD
+
+// Each SIMD path below is a lane-wise transcription of noise_gradient2d and
+// noise_fbm2d, performing the same float operations in the same order
+
+__attribute__((target("avx2")))
+static __m256i hash_lattice8(__m256i seed, __m256i ix, __m256i iz) {
+    __m256i h = _mm256_xor_si256(seed, _mm256_mullo_epi32(ix, _mm256_set1_epi32((int)HASH_X)));
+    h = _mm256_xor_si256(h, _mm256_mullo_epi32(iz, _mm256_set1_epi32((int)HASH_Z)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)HASH_MIX));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+    return h;
+}
+
+__attribute__((target("avx2")))
+static __m256 gradient_dot8(__m256i h, __m256 dx, __m256 dz) {
+    // Flip the sign bit of dx when bit 0 is set, of dz when bit 1 is set
+    __m256i sign_x = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31);
+    __m256i sign_z = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30);
+    __m256 gx = _mm256_xor_ps(dx, _mm256_castsi256_ps(sign_x));
+    __m256 gz = _mm256_xor_ps(dz, _mm256_castsi256_ps(sign_z));
+    return _mm256_add_ps(gx, gz);
+}
+
+__attribute__((target("avx2")))
+static __m256 fade8(__m256 t) {
+    __m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+    __m256 inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f));
+    inner = _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(t3, inner);
+}
+
+__attribute__((target("avx2")))
+static __m256 gradient8(unsigned int seed, __m256 x, __m256 z) {
+    __m256 fx = _mm256_floor_ps(x);
+    __m256 fz = _mm256_floor_ps(z);
+    __m256i ix = _mm256_cvttps_epi32(fx);
+    __m256i iz = _mm256_cvttps_epi32(fz);
+    __m256i ix1 = _mm256_add_epi32(ix, _mm256_set1_epi32(1));
+    __m256i iz1 = _mm256_add_epi32(iz, _mm256_set1_epi32(1));
+    __m256 dx = _mm256_sub_ps(x, fx);
+    __m256 dz = _mm256_sub_ps(z, fz);
+    __m256 dx1 = _mm256_sub_ps(dx, _mm256_set1_ps(1.0f));
+    __m256 dz1 = _mm256_sub_ps(dz, _mm256_set1_ps(1.0f));
+    __m256i seeds = _mm256_set1_epi32((int)seed);
+
+    __m256 n00 = gradient_dot8(hash_lattice8(seeds, ix, iz), dx, dz);
+    __m256 n10 = gradient_dot8(hash_lattice8(seeds, ix1, iz), dx1, dz);
+    __m256 n01 = gradient_dot8(hash_lattice8(seeds, ix, iz1), dx, dz1);
+    __m256 n11 = gradient_dot8(hash_lattice8(seeds, ix1, iz1), dx1, dz1);
+
+    __m256 u = fade8(dx);
+    __m256 v = fade8(dz);
+    __m256 nx0 = _mm256_add_ps(n00, _mm256_mul_ps(u, _mm256_sub_ps(n10, n00)));
+    __m256 nx1 = _mm256_add_ps(n01, _mm256_mul_ps(u, _mm256_sub_ps(n11, n01)));
+    return _mm256_add_ps(nx0, _mm256_mul_ps(v, _mm256_sub_ps(nx1, nx0)));
+}
+
+__attribute__((target("avx2")))
+static void fbm_grid_avx2(unsigned int seed, int base_x, int base_z, float frequency,
+                          int octaves, float* out) {
+    for (int x = 0; x < NOISE_GRID_SIZE; x++) {
+        __m256 sample_x = _mm256_set1_ps((float)(base_x + x) * frequency);
+        for (int z = 0; z < NOISE_GRID_SIZE; z += 8) {
+            __m256i lane_z = _mm256_add_epi32(_mm256_set1_epi32(base_z + z),
+                                              _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            __m256 sample_z = _mm256_mul_ps(_mm256_cvtepi32_ps(lane_z), _mm256_set1_ps(frequency));
+
+            __m256 sum = _mm256_setzero_ps();
+            float total = 0.0f;
+            float amplitude = 1.0f;
+            float octave_frequency = 1.0f;
+            for (int octave = 0; octave < octaves; octave++) {
+                unsigned int octave_seed = seed + (unsigned int)octave * OCTAVE_SEED_STEP;
+                __m256 scale = _mm256_set1_ps(octave_frequency);
+                __m256 n = gradient8(octave_seed, _mm256_mul_ps(sample_x, scale),
+                                     _mm256_mul_ps(sample_z, scale));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(amplitude), n));
+                total = total + amplitude;
+                amplitude *= 0.5f;
+                octave_frequency *= 2.0f;
+            }
+            __m256 result = total > 0.0f ? _mm256_div_ps(sum, _mm256_set1_ps(total))
+                                         : _mm256_setzero_ps();
+            _mm256_storeu_ps(&out[x * NOISE_GRID_SIZE + z], result);
+        }
+    }
+}
+
+__attribute__((target("sse4.1")))
+static __m128i hash_lattice4(__m128i seed, __m128i ix, __m128i iz) {
+    __m128i h = _mm_xor_si128(seed, _mm_mullo_epi32(ix, _mm_set1_epi32((int)HASH_X)));
+    h = _mm_xor_si128(h, _mm_mullo_epi32(iz, _mm_set1_epi32((int)HASH_Z)));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = _mm_mullo_epi32(h, _mm_set1_epi32((int)HASH_MIX));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+    return h;
+}
+
+__attribute__((target("sse4.1")))
+static __m128 gradient_dot4(__m128i h, __m128 dx, __m128 dz) {
+    __m128i sign_x = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31);
+    __m128i sign_z = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30);
+    __m128 gx = _mm_xor_ps(dx, _mm_castsi128_ps(sign_x));
+    __m128 gz = _mm_xor_ps(dz, _mm_castsi128_ps(sign_z));
+    return _mm_add_ps(gx, gz);
+}
+
+__attribute__((target("sse4.1")))
+static __m128 fade4(__m128 t) {
+    __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+    __m128 inner = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f));
+    inner = _mm_add_ps(_mm_mul_ps(t, inner), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(t3, inner);
+}
+
+__attribute__((target("sse4.1")))
+static __m128 gradient4(unsigned int seed, __m128 x, __m128 z) {
+    __m128 fx = _mm_floor_ps(x);
+    __m128 fz = _mm_floor_ps(z);
+    __m128i ix = _mm_cvttps_epi32(fx);
+    __m128i iz = _mm_cvttps_epi32(fz);
+    __m128i ix1 = _mm_add_epi32(ix, _mm_set1_epi32(1));
+    __m128i iz1 = _mm_add_epi32(iz, _mm_set1_epi32(1));
+    __m128 dx = _mm_sub_ps(x, fx);
+    __m128 dz = _mm_sub_ps(z, fz);
+    __m128 dx1 = _mm_sub_ps(dx, _mm_set1_ps(1.0f));
+    __m128 dz1 = _mm_sub_ps(dz, _mm_set1_ps(1.0f));
+    __m128i seeds = _mm_set1_epi32((int)seed);
+
+    __m128 n00 = gradient_dot4(hash_lattice4(seeds, ix, iz), dx, dz);
+    __m128 n10 = gradient_dot4(hash_lattice4(seeds, ix1, iz), dx1, dz);
+    __m128 n01 = gradient_dot4(hash_lattice4(seeds, ix, iz1), dx, dz1);
+    __m128 n11 = gradient_dot4(hash_lattice4(seeds, ix1, iz1), dx1, dz1);
+
+    __m128 u = fade4(dx);
+    __m128 v = fade4(dz);
+    __m128 nx0 = _mm_add_ps(n00, _mm_mul_ps(u, _mm_sub_ps(n10, n00)));
+    __m128 nx1 = _mm_add_ps(n01, _mm_mul_ps(u, _mm_sub_ps(n11, n01)));
+    return _mm_add_ps(nx0, _mm_mul_ps(v, _mm_sub_ps(nx1, nx0)));
+}
+
+__attribute__((target("sse4.1")))
+static void fbm_grid_sse41(unsigned int seed, int base_x, int base_z, float frequency,
+                           int octaves, float* out) {
+    for (int x = 0; x < NOISE_GRID_SIZE; x++) {
+        __m128 sample_x = _mm_set1_ps((float)(base_x + x) * frequency);
+        for (int z = 0; z < NOISE_GRID_SIZE; z += 4) {
+            __m128i lane_z = _mm_add_epi32(_mm_set1_epi32(base_z + z), _mm_setr_epi32(0, 1, 2, 3));
+            __m128 sample_z = _mm_mul_ps(_mm_cvtepi32_ps(lane_z), _mm_set1_ps(frequency));
+
+            __m128 sum = _mm_setzero_ps();
+            float total = 0.0f;
+            float amplitude = 1.0f;
+            float octave_frequency = 1.0f;
+            for (int octave = 0; octave < octaves; octave++) {
+                unsigned int octave_seed = seed + (unsigned int)octave * OCTAVE_SEED_STEP;
+                __m128 scale = _mm_set1_ps(octave_frequency);
+                __m128 n = gradient4(octave_seed, _mm_mul_ps(sample_x, scale),
+                                     _mm_mul_ps(sample_z, scale));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amplitude), n));
+                total = total + amplitude;
+                amplitude *= 0.5f;
+                octave_frequency *= 2.0f;
+            }
+            __m128 result = total > 0.0f ? _mm_div_ps(sum, _mm_set1_ps(total)) : _mm_setzero_ps();
+            _mm_storeu_ps(&out[x * NOISE_GRID_SIZE + z], result);
+        }
+    }
+}
+
+#endif // NOISE_X86_SIMD
+
+typedef void (*FbmGridFunc)(unsigned int, int, int, float, int, float*);
+
+static FbmGridFunc fbm_grid_impl = noise_fbm_grid_scalar;
+static const char* fbm_grid_name = "scalar";
+static pthread_once_t fbm_grid_once = PTHREAD_ONCE_INIT;
+
+// Pick the widest implementation the CPU supports
+static void select_fbm_grid(void) {
+#ifdef NOISE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        fbm_grid_impl = fbm_grid_avx2;
+        fbm_grid_name = "avx2";
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        fbm_grid_impl = fbm_grid_sse41;
+        fbm_grid_name = "sse4.1";
+    }
+#endif
+}
+
+void noise_fbm_grid(unsigned int seed, int base_x, int base_z, float frequency,
+                    int octaves, float* out) {
+    pthread_once(&fbm_grid_once, select_fbm_grid);
+    fbm_grid_impl(seed, base_x, base_z, frequency, octaves, out);
+}
+
+const char* noise_simd_level(void) {
+    pthread_once(&fbm_grid_once, select_fbm_grid);
+    return fbm_grid_name;
+}
@@ -0,0 +1,29 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdbool.h>
+
+#define NOISE_GRID_SIZE 16  // Samples per side of a batched grid (one chunk)
+
+// Seeded 2D gradient noise in roughly [-1, 1]; a pure function of its arguments
+float noise_gradient2d(unsigned int seed, float x, float z);
+
+// Fractal Brownian motion: `octaves` layers of gradient noise, each at twice
+// the frequency and half the amplitude of the last, normalised to [-1, 1]
+float noise_fbm2d(unsigned int seed, float x, float z, int octaves);
+
+// Evaluate fBm over a NOISE_GRID_SIZE x NOISE_GRID_SIZE grid of integer
+// lattice points. out[x * NOISE_GRID_SIZE + z] receives
+// noise_fbm2d(seed, (base_x + x) * frequency, (base_z + z) * frequency, octaves),
+// bit for bit, using AVX2 or SSE4.1 lanes when the CPU has them.
+void noise_fbm_grid(unsigned int seed, int base_x, int base_z, float frequency,
+                    int octaves, float* out);
+
+// Same as noise_fbm_grid but always scalar; the reference for the SIMD paths
+void noise_fbm_grid_scalar(unsigned int seed, int base_x, int base_z, float frequency,
+                           int octaves, float* out);
+
+// Name of the implementation noise_fbm_grid dispatches to ("avx2", "sse4.1" or "scalar")
+const char* noise_simd_level(void);
+
+#endif // NOISE_H
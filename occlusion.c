@@ -0,0 +1,309 @@
+#include "occlusion.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#define OCCLUSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// A box corner or quad vertex projected to depth buffer pixels
+typedef struct {
+    float x, y, z;  // Pixels, pixels, NDC depth
+} ScreenPoint;
+
+// Project a world point; false if it is in front of the near plane
+static bool project_point(const OcclusionBuffer* buffer, const float p[3], ScreenPoint* out) {
+    const float* m = buffer->clip;
+    float cx = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+    float cy = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+    float cz = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+    float cw = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+    if (cz < -cw || cw <= 0.0f) return false;
+
+    float inv_w = 1.0f / cw;
+    out->x = (cx * inv_w * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+    out->y = (cy * inv_w * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+    out->z = cz * inv_w;
+    return true;
+}
+
+// Pixel span [first, last] touched by [lo, hi] on an axis of `size` pixels;
+// false if it misses the buffer
+static bool pixel_span(float lo, float hi, int size, int* first, int* last) {
+    if (hi <= 0.0f || lo >= (float)size) return false;
+    *first = lo <= 0.0f ? 0 : (int)lo;
+    *last = hi >= (float)size ? size - 1 : (int)ceilf(hi) - 1;
+    return *first <= *last;
+}
+
+// Rasterize a convex planar quad at pixel centres, so quads sharing an edge
+// leave no gaps, with the farthest depth the quad's plane reaches in each pixel
+static void rasterize_quad(OcclusionBuffer* buffer, const float corners[4][3]) {
+    ScreenPoint p[4];
+    for (int i = 0; i < 4; i++) {
+        // Occluders crossing the near plane are dropped, which is always safe
+        if (!project_point(buffer, corners[i], &p[i])) return;
+    }
+
+    float area = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        const ScreenPoint* a = &p[i];
+        const ScreenPoint* b = &p[(i + 1) % 4];
+        area += a->x * b->y - b->x * a->y;
+    }
+    if (fabsf(area) < 1e-4f) return;
+    float orientation = area > 0.0f ? 1.0f : -1.0f;
+
+    // Edge functions E = A*x + B*y + C, non-negative inside
+    float edge_a[4], edge_b[4], edge_c[4];
+    float min_x = p[0].x, max_x = p[0].x, min_y = p[0].y, max_y = p[0].y, max_z = p[0].z;
+    for (int i = 0; i < 4; i++) {
+        const ScreenPoint* a = &p[i];
+        const ScreenPoint* b = &p[(i + 1) % 4];
+        float dx = b->x - a->x;
+        float dy = b->y - a->y;
+        edge_a[i] = -dy * orientation;
+        edge_b[i] = dx * orientation;
+        edge_c[i] = (dy * a->x - dx * a->y) * orientation;
+
+        if (a->x < min_x) min_x = a->x;
+        if (a->x > max_x) max_x = a->x;
+        if (a->y < min_y) min_y = a->y;
+        if (a->y > max_y) max_y = a->y;
+        if (a->z > max_z) max_z = a->z;
+    }
+    int x0, x1, y0, y1;
+    if (!pixel_span(min_x, max_x, OCCLUSION_WIDTH, &x0, &x1)) return;
+    if (!pixel_span(min_y, max_y, OCCLUSION_HEIGHT, &y0, &y1)) return;
+
+    // Depth is affine in screen space; fit its plane to the better-shaped
+    // half of the quad and bias it to the far corner of each pixel
+    int i1 = 1, i2 = 2;
+    float det_a = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+    float det_b = (p[2].x - p[0].x) * (p[3].y - p[0].y) - (p[3].x - p[0].x) * (p[2].y - p[0].y);
+    if (fabsf(det_b) > fabsf(det_a)) {
+        i1 = 2;
+        i2 = 3;
+    }
+    float ux = p[i1].x - p[0].x, uy = p[i1].y - p[0].y, uz = p[i1].z - p[0].z;
+    float vx = p[i2].x - p[0].x, vy = p[i2].y - p[0].y, vz = p[i2].z - p[0].z;
+    float det = ux * vy - vx * uy;
+    if (fabsf(det) < 1e-6f) return;
+    float dz_dx = (uz * vy - vz * uy) / det;
+    float dz_dy = (ux * vz - vx * uz) / det;
+    float z_base = p[0].z - dz_dx * p[0].x - dz_dy * p[0].y + 0.5f * (fabsf(dz_dx) + fabsf(dz_dy));
+
+    // Where each edge crosses a row, as x = slope * y + intercept. Edges
+    // with A > 0 bound the row from the left, A < 0 from the right, and
+    // horizontal edges bound the rows instead.
+    float left_slope[4], left_intercept[4], right_slope[4], right_intercept[4];
+    int lefts = 0, rights = 0;
+    for (int i = 0; i < 4; i++) {
+        if (edge_a[i] == 0.0f) {
+            float bound = -edge_c[i] / edge_b[i] - 0.5f;  // Row centre where the edge lies
+            if (edge_b[i] > 0.0f && bound > (float)y0) y0 = (int)ceilf(bound);
+            if (edge_b[i] < 0.0f && bound < (float)y1) y1 = (int)floorf(bound);
+        } else if (edge_a[i] > 0.0f) {
+            left_slope[lefts] = -edge_b[i] / edge_a[i];
+            left_intercept[lefts++] = -edge_c[i] / edge_a[i] - 1.5f;
+        } else {
+            right_slope[rights] = -edge_b[i] / edge_a[i];
+            right_intercept[rights++] = -edge_c[i] / edge_a[i] + 0.5f;
+        }
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        float cy = y + 0.5f;
+        float* row = buffer->depth[y];
+
+        // Narrow the row to the pixel centres every edge can accept, with a
+        // pixel of slack; the per-pixel edge tests still decide coverage
+        float span_lo = (float)x0, span_hi = (float)x1;
+        for (int i = 0; i < lefts; i++) span_lo = fmaxf(span_lo, left_slope[i] * cy + left_intercept[i]);
+        for (int i = 0; i < rights; i++) span_hi = fminf(span_hi, right_slope[i] * cy + right_intercept[i]);
+        if (span_lo > span_hi) continue;
+        int last = (int)span_hi + 1;  // Both are non-negative, so truncation floors
+        if (last > x1) last = x1;
+        int x = (int)span_lo & ~3;
+#ifdef OCCLUSION_SSE2
+        // Edge and depth values of four pixels, stepped four pixels at a time
+        __m128 cx = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+        __m128 e[4], e_step[4];
+        for (int i = 0; i < 4; i++) {
+            e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[i]), cx), _mm_set1_ps(edge_b[i] * cy + edge_c[i]));
+            e_step[i] = _mm_set1_ps(edge_a[i] * 4.0f);
+        }
+        __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dz_dx), cx), _mm_set1_ps(dz_dy * cy + z_base));
+        __m128 z_step = _mm_set1_ps(dz_dx * 4.0f);
+        __m128 z_cap = _mm_set1_ps(max_z);
+        __m128 zero = _mm_setzero_ps();
+        for (; x <= last; x += 4) {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)),
+                                       _mm_and_ps(_mm_cmpge_ps(e[2], zero), _mm_cmpge_ps(e[3], zero)));
+            __m128 old = _mm_load_ps(&row[x]);
+            __m128 merged = _mm_min_ps(old, _mm_min_ps(z, z_cap));
+            _mm_store_ps(&row[x], _mm_or_ps(_mm_and_ps(inside, merged), _mm_andnot_ps(inside, old)));
+            for (int i = 0; i < 4; i++) e[i] = _mm_add_ps(e[i], e_step[i]);
+            z = _mm_add_ps(z, z_step);
+        }
+#else
+        for (; x <= last; x++) {
+            float cx = x + 0.5f;
+            bool inside = true;
+            for (int i = 0; i < 4; i++) {
+                inside = inside && edge_a[i] * cx + edge_b[i] * cy + edge_c[i] >= 0.0f;
+            }
+            if (!inside) continue;
+            float z = dz_dx * cx + dz_dy * cy + z_base;
+            if (z > max_z) z = max_z;
+            if (z < row[x]) row[x] = z;
+        }
+#endif
+    }
+    buffer->occluder_quads++;
+}
+
+// Rasterize the faces of a box selected by `faces` (bit axis * 2 + side,
+// side 1 being the +axis face) that face the camera
+static void add_box_faces(OcclusionBuffer* buffer, const float min[3], const float max[3], unsigned int faces) {
+    for (int d = 0; d < 3; d++) {
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        for (int side = 0; side < 2; side++) {
+            if (!(faces & (1u << (d * 2 + side)))) continue;
+            float plane = side ? max[d] : min[d];
+            bool facing = side ? buffer->eye[d] > plane : buffer->eye[d] < plane;
+            if (!facing) continue;
+
+            float corners[4][3];
+            for (int i = 0; i < 4; i++) {
+                corners[i][d] = plane;
+                corners[i][u] = (i == 1 || i == 2) ? max[u] : min[u];
+                corners[i][v] = (i >= 2) ? max[v] : min[v];
+            }
+            rasterize_quad(buffer, corners);
+        }
+    }
+}
+
+void occlusion_begin(OcclusionBuffer* buffer, const Frustum* frustum) {
+    for (int y = 0; y < OCCLUSION_HEIGHT; y++) {
+        for (int x = 0; x < OCCLUSION_WIDTH; x++) {
+            buffer->depth[y][x] = 1.0f;
+        }
+    }
+    for (int i = 0; i < 16; i++) buffer->clip[i] = frustum->clip[i];
+    for (int i = 0; i < 3; i++) buffer->eye[i] = frustum->eye[i];
+    buffer->occluder_quads = 0;
+}
+
+void occlusion_add_box(OcclusionBuffer* buffer, const float min[3], const float max[3]) {
+    add_box_faces(buffer, min, max, 0x3f);
+}
+
+// True if any skin cell in the rectangle is lower than `height`; cells
+// outside the chunk count as lower
+static bool skin_lower(const ChunkMesh* mesh, int x0, int x1, int z0, int z1, int height) {
+    for (int x = x0; x <= x1; x++) {
+        for (int z = z0; z <= z1; z++) {
+            if (x < 0 || x >= SKIN_CELLS || z < 0 || z >= SKIN_CELLS) return true;
+            if (mesh->skin_height[x][z] < height) return true;
+        }
+    }
+    return false;
+}
+
+void occlusion_add_chunk(OcclusionBuffer* buffer, const Chunk* chunk) {
+    const ChunkMesh* mesh = &chunk->mesh;
+    bool done[SKIN_CELLS][SKIN_CELLS] = {{false}};
+    for (int cx = 0; cx < SKIN_CELLS; cx++) {
+        for (int cz = 0; cz < SKIN_CELLS; cz++) {
+            int height = mesh->skin_height[cx][cz];
+            if (height == 0 || done[cx][cz]) continue;
+
+            // Merge cells of equal height into a rectangle, as the mesher
+            // does with faces: each occluder quad costs a setup per row
+            int depth = 1;
+            while (cz + depth < SKIN_CELLS && !done[cx][cz + depth] &&
+                   mesh->skin_height[cx][cz + depth] == height) {
+                depth++;
+            }
+            int width = 1;
+            for (; cx + width < SKIN_CELLS; width++) {
+                bool same = true;
+                for (int z = cz; z < cz + depth && same; z++) {
+                    same = !done[cx + width][z] && mesh->skin_height[cx + width][z] == height;
+                }
+                if (!same) break;
+            }
+            for (int x = cx; x < cx + width; x++) {
+                for (int z = cz; z < cz + depth; z++) done[x][z] = true;
+            }
+
+            // Top face always; a side face only where some cell next to it
+            // in this chunk is lower, since otherwise it is buried
+            int x1 = cx + width - 1, z1 = cz + depth - 1;
+            unsigned int faces = 1u << 3;
+            if (skin_lower(mesh, cx - 1, cx - 1, cz, z1, height)) faces |= 1u << 0;
+            if (skin_lower(mesh, x1 + 1, x1 + 1, cz, z1, height)) faces |= 1u << 1;
+            if (skin_lower(mesh, cx, x1, cz - 1, cz - 1, height)) faces |= 1u << 4;
+            if (skin_lower(mesh, cx, x1, z1 + 1, z1 + 1, height)) faces |= 1u << 5;
+
+            float min[3] = {
+                (float)(chunk->world_x * CHUNK_SIZE + cx * SKIN_CELL_SIZE),
+                0.0f,
+                (float)(chunk->world_z * CHUNK_SIZE + cz * SKIN_CELL_SIZE)
+            };
+            float max[3] = {
+                min[0] + width * SKIN_CELL_SIZE,
+                (float)height,
+                min[2] + depth * SKIN_CELL_SIZE
+            };
+            add_box_faces(buffer, min, max, faces);
+        }
+    }
+}
+
+bool occlusion_box_visible(const OcclusionBuffer* buffer, const float min[3], const float max[3]) {
+    float min_x = 0.0f, max_x = 0.0f, min_y = 0.0f, max_y = 0.0f, min_z = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        float corner[3] = {(i & 1) ? max[0] : min[0], (i & 2) ? max[1] : min[1], (i & 4) ? max[2] : min[2]};
+        ScreenPoint p;
+        // Reaching past the near plane: too close to judge
+        if (!project_point(buffer, corner, &p)) return true;
+        if (i == 0 || p.x < min_x) min_x = p.x;
+        if (i == 0 || p.x > max_x) max_x = p.x;
+        if (i == 0 || p.y < min_y) min_y = p.y;
+        if (i == 0 || p.y > max_y) max_y = p.y;
+        if (i == 0 || p.z < min_z) min_z = p.z;
+    }
+    // Grow the box by a pixel: an occluder edge can claim up to half a pixel
+    // it does not cover
+    int x0, x1, y0, y1;
+    if (!pixel_span(min_x - 1.0f, max_x + 1.0f, OCCLUSION_WIDTH, &x0, &x1)) return false;
+    if (!pixel_span(min_y - 1.0f, max_y + 1.0f, OCCLUSION_HEIGHT, &y0, &y1)) return false;
+
+    // Visible if any covered pixel's occluder is not strictly nearer
+    for (int y = y0; y <= y1; y++) {
+        const float* row = buffer->depth[y];
+        int x = x0;
+#ifdef OCCLUSION_SSE2
+        __m128 nearest = _mm_set1_ps(min_z);
+        for (; x + 3 <= x1; x += 4) {
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(&row[x]), nearest))) return true;
+        }
+#endif
+        for (; x <= x1; x++) {
+            if (row[x] >= min_z) return true;
+        }
+    }
+    return false;
+}
+
+const char* occlusion_simd_level(void) {
+#ifdef OCCLUSION_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
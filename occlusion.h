@@ -0,0 +1,38 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <stdbool.h>
+#include "voxel_world.h"
+#include "camera.h"
+
+#define OCCLUSION_WIDTH 64  // Depth buffer resolution; width must be a multiple of 4
+#define OCCLUSION_HEIGHT 48
+
+// Low-resolution CPU depth buffer for occlusion culling. Occluders are
+// rasterized at pixel centres, so neighbouring faces of the skin leave no
+// cracks, but with the farthest depth they reach anywhere in the pixel.
+// Tested boxes are grown by a pixel to cover the half pixel an occluder edge
+// may claim, so a box is not reported hidden while it could still be seen.
+typedef struct {
+    _Alignas(16) float depth[OCCLUSION_HEIGHT][OCCLUSION_WIDTH];  // NDC depth, 1 is the far plane
+    float clip[16];
+    float eye[3];
+    int occluder_quads;  // Quads rasterized since occlusion_begin
+} OcclusionBuffer;
+
+// Clear the buffer for a new frame seen through `frustum`
+void occlusion_begin(OcclusionBuffer* buffer, const Frustum* frustum);
+
+// Rasterize the camera-facing faces of a solid box
+void occlusion_add_box(OcclusionBuffer* buffer, const float min[3], const float max[3]);
+
+// Rasterize a chunk's heightmap skin (ChunkMesh.skin_height) as occluders
+void occlusion_add_chunk(OcclusionBuffer* buffer, const Chunk* chunk);
+
+// False only if the box is entirely behind occluders already rasterized
+bool occlusion_box_visible(const OcclusionBuffer* buffer, const float min[3], const float max[3]);
+
+// "sse2" or "scalar"
+const char* occlusion_simd_level(void);
+
+#endif // OCCLUSION_H
@@ -0,0 +1,196 @@
+#include "occupancy.h"
+
+#define BRICKS_ACROSS (CHUNK_SIZE / BRICK_SIZE)
+#define BRICKS_HIGH (SECTION_HEIGHT / BRICK_SIZE)
+
+static int max_int(int a, int b) { return a > b ? a : b; }
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+// Calls `visit` with the storage and chunk-local box of every loaded chunk
+// the world box overlaps, until it returns false; false if it ever did
+typedef bool (*ChunkBoxVisitor)(const ChunkStorage* storage, int chunk_x, int chunk_z, const int lo[3],
+                                const int hi[3], void* context);
+
+static bool visit_chunks(VoxelWorld* world, const int min[3], const int max[3], ChunkBoxVisitor visit,
+                         void* context) {
+    int y0 = max_int(min[1], 0), y1 = min_int(max[1], WORLD_HEIGHT);
+    if (y0 >= y1 || min[0] >= max[0] || min[2] >= max[2]) return true;
+
+    for (int chunk_x = block_to_chunk(min[0]); chunk_x <= block_to_chunk(max[0] - 1); chunk_x++) {
+        for (int chunk_z = block_to_chunk(min[2]); chunk_z <= block_to_chunk(max[2] - 1);
+             chunk_z++) {
+            const Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+            if (!chunk) continue;
+            int base_x = chunk_x * CHUNK_SIZE, base_z = chunk_z * CHUNK_SIZE;
+            int lo[3] = {max_int(min[0] - base_x, 0), y0, max_int(min[2] - base_z, 0)};
+            int hi[3] = {min_int(max[0] - base_x, CHUNK_SIZE), y1, min_int(max[2] - base_z, CHUNK_SIZE)};
+            if (!visit(&chunk->storage, chunk_x, chunk_z, lo, hi, context)) return false;
+        }
+    }
+    return true;
+}
+
+// Mask of the bits of one brick inside the brick-local box [lo, hi)
+static uint64_t brick_box_mask(const int lo[3], const int hi[3]) {
+    uint64_t row = ((1ull << (hi[2] - lo[2])) - 1) << lo[2];
+    uint64_t plane = 0;
+    for (int y = lo[1]; y < hi[1]; y++) plane |= row << (y * BRICK_SIZE);
+    uint64_t mask = 0;
+    for (int x = lo[0]; x < hi[0]; x++) mask |= plane << (x * BRICK_SIZE * BRICK_SIZE);
+    return mask;
+}
+
+// Solid voxels of brick (bx, by, bz) of a section inside the section-local
+// box [lo, hi)
+static uint64_t masked_brick(const ChunkSection* section, int bx, int by, int bz, const int lo[3],
+                             const int hi[3]) {
+    int brick = (bx * BRICKS_HIGH + by) * BRICKS_ACROSS + bz;
+    if (!((section->solid_bricks >> brick) & 1)) return 0;
+
+    int base[3] = {bx * BRICK_SIZE, by * BRICK_SIZE, bz * BRICK_SIZE};
+    int brick_lo[3], brick_hi[3];
+    bool whole = true;
+    for (int i = 0; i < 3; i++) {
+        brick_lo[i] = max_int(lo[i] - base[i], 0);
+        brick_hi[i] = min_int(hi[i] - base[i], BRICK_SIZE);
+        whole = whole && brick_lo[i] == 0 && brick_hi[i] == BRICK_SIZE;
+    }
+    return whole ? section->bricks[brick] : section->bricks[brick] & brick_box_mask(brick_lo, brick_hi);
+}
+
+static bool chunk_box_empty(const ChunkStorage* storage, int chunk_x, int chunk_z, const int lo[3],
+                            const int hi[3], void* context) {
+    (void)chunk_x;
+    (void)chunk_z;
+    (void)context;
+    for (int s = lo[1] / SECTION_HEIGHT; s <= (hi[1] - 1) / SECTION_HEIGHT; s++) {
+        const ChunkSection* section = &storage->sections[s];
+        if (section->solid_count == 0) continue;
+        if (section->solid_count == SECTION_VOLUME) return false;
+
+        int base_y = s * SECTION_HEIGHT;
+        int section_lo[3] = {lo[0], max_int(lo[1] - base_y, 0), lo[2]};
+        int section_hi[3] = {hi[0], min_int(hi[1] - base_y, SECTION_HEIGHT), hi[2]};
+        for (int bx = section_lo[0] / BRICK_SIZE; bx <= (section_hi[0] - 1) / BRICK_SIZE; bx++) {
+            for (int by = section_lo[1] / BRICK_SIZE; by <= (section_hi[1] - 1) / BRICK_SIZE; by++) {
+                for (int bz = section_lo[2] / BRICK_SIZE; bz <= (section_hi[2] - 1) / BRICK_SIZE; bz++) {
+                    if (masked_brick(section, bx, by, bz, section_lo, section_hi)) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool occupancy_region_empty(VoxelWorld* world, const int min[3], const int max[3]) {
+    return visit_chunks(world, min, max, chunk_box_empty, NULL);
+}
+
+int occupancy_first_solid_below(VoxelWorld* world, int x, int y, int z) {
+    if (y < 0) return -1;
+    if (y >= WORLD_HEIGHT) y = WORLD_HEIGHT - 1;
+    int chunk_x = block_to_chunk(x), chunk_z = block_to_chunk(z);
+    const Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+    if (!chunk) return -1;
+    int local_x = x - chunk_x * CHUNK_SIZE, local_z = z - chunk_z * CHUNK_SIZE;
+
+    // The column's bits within a brick, one per height
+    uint64_t column = 0;
+    for (int i = 0; i < BRICK_SIZE; i++) column |= 1ull << occupancy_bit(local_x, i, local_z);
+
+    for (int s = y / SECTION_HEIGHT; s >= 0; s--) {
+        const ChunkSection* section = &chunk->storage.sections[s];
+        int top = s == y / SECTION_HEIGHT ? y % SECTION_HEIGHT : SECTION_HEIGHT - 1;
+        if (section->solid_count == 0) continue;
+        if (section->solid_count == SECTION_VOLUME) return s * SECTION_HEIGHT + top;
+
+        for (int by = top / BRICK_SIZE; by >= 0; by--) {
+            int brick = occupancy_brick(local_x, by * BRICK_SIZE, local_z);
+            uint64_t bits = section->bricks[brick] & column;
+            // Drop the heights above `top` in its own brick; 2 << 63 wraps to 0, leaving all
+            if (by == top / BRICK_SIZE) bits &= (2ull << occupancy_bit(local_x, top, local_z)) - 1;
+            if (bits) {
+                int bit = 63 - __builtin_clzll(bits);
+                return s * SECTION_HEIGHT + by * BRICK_SIZE + (bit / BRICK_SIZE) % BRICK_SIZE;
+            }
+        }
+    }
+    return -1;
+}
+
+typedef struct {
+    bool found;
+    int min[3], max[3];
+} SolidBounds;
+
+static void grow_bounds(SolidBounds* bounds, const int lo[3], const int hi[3]) {
+    for (int i = 0; i < 3; i++) {
+        if (!bounds->found || lo[i] < bounds->min[i]) bounds->min[i] = lo[i];
+        if (!bounds->found || hi[i] > bounds->max[i]) bounds->max[i] = hi[i];
+    }
+    bounds->found = true;
+}
+
+// Per axis, the brick's voxels lying in each of its four slices
+static const uint64_t slice_masks[3] = {0x000000000000ffffull, 0x000f000f000f000full, 0x1111111111111111ull};
+static const int slice_shifts[3] = {BRICK_SIZE * BRICK_SIZE, BRICK_SIZE, 1};
+
+static bool chunk_box_bounds(const ChunkStorage* storage, int chunk_x, int chunk_z, const int lo[3],
+                             const int hi[3], void* context) {
+    SolidBounds* bounds = context;
+    int origin[3] = {chunk_x * CHUNK_SIZE, 0, chunk_z * CHUNK_SIZE};
+
+    for (int s = lo[1] / SECTION_HEIGHT; s <= (hi[1] - 1) / SECTION_HEIGHT; s++) {
+        const ChunkSection* section = &storage->sections[s];
+        if (section->solid_count == 0) continue;
+
+        int base_y = s * SECTION_HEIGHT;
+        int section_lo[3] = {lo[0], max_int(lo[1] - base_y, 0), lo[2]};
+        int section_hi[3] = {hi[0], min_int(hi[1] - base_y, SECTION_HEIGHT), hi[2]};
+        if (section->solid_count == SECTION_VOLUME) {
+            int box_lo[3], box_hi[3];
+            for (int i = 0; i < 3; i++) {
+                int offset = origin[i] + (i == 1 ? base_y : 0);
+                box_lo[i] = offset + section_lo[i];
+                box_hi[i] = offset + section_hi[i];
+            }
+            grow_bounds(bounds, box_lo, box_hi);
+            continue;
+        }
+
+        for (int bx = section_lo[0] / BRICK_SIZE; bx <= (section_hi[0] - 1) / BRICK_SIZE; bx++) {
+            for (int by = section_lo[1] / BRICK_SIZE; by <= (section_hi[1] - 1) / BRICK_SIZE; by++) {
+                for (int bz = section_lo[2] / BRICK_SIZE; bz <= (section_hi[2] - 1) / BRICK_SIZE; bz++) {
+                    uint64_t bits = masked_brick(section, bx, by, bz, section_lo, section_hi);
+                    if (!bits) continue;
+
+                    // Project the brick's solid voxels onto each axis
+                    int brick_origin[3] = {origin[0] + bx * BRICK_SIZE, base_y + by * BRICK_SIZE,
+                                           origin[2] + bz * BRICK_SIZE};
+                    int box_lo[3], box_hi[3];
+                    for (int i = 0; i < 3; i++) {
+                        int first = 0, last = BRICK_SIZE - 1;
+                        while (!(bits & (slice_masks[i] << (first * slice_shifts[i])))) first++;
+                        while (!(bits & (slice_masks[i] << (last * slice_shifts[i])))) last--;
+                        box_lo[i] = brick_origin[i] + first;
+                        box_hi[i] = brick_origin[i] + last + 1;
+                    }
+                    grow_bounds(bounds, box_lo, box_hi);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool occupancy_solid_bounds(VoxelWorld* world, const int min[3], const int max[3], int out_min[3],
+                            int out_max[3]) {
+    SolidBounds bounds = {0};
+    visit_chunks(world, min, max, chunk_box_bounds, &bounds);
+    if (!bounds.found) return false;
+    for (int i = 0; i < 3; i++) {
+        out_min[i] = bounds.min[i];
+        out_max[i] = bounds.max[i];
+    }
+    return true;
+}
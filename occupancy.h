@@ -0,0 +1,25 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <stdbool.h>
+#include "voxel_world.h"
+
+// Spatial queries over the occupancy hierarchy chunk storage keeps per
+// section: all-air and all-solid sections are answered from their solid
+// count, bricks with nothing solid are skipped from one mask, and only the
+// bricks left are tested, 64 voxels per AND. Boxes are half-open [min, max)
+// in world coordinates; chunks that are not loaded and heights outside the
+// world count as air, as with get_block.
+
+// True if no block in the box is solid
+bool occupancy_region_empty(VoxelWorld* world, const int min[3], const int max[3]);
+
+// Height of the highest solid block at or below y in column (x, z), or -1
+int occupancy_first_solid_below(VoxelWorld* world, int x, int y, int z);
+
+// Tight bounds [out_min, out_max) of the solid blocks in the box; false,
+// leaving the outputs untouched, if there are none
+bool occupancy_solid_bounds(VoxelWorld* world, const int min[3], const int max[3], int out_min[3],
+                            int out_max[3]);
+
+#endif // OCCUPANCY_H
@@ -0,0 +1,110 @@
+#include "player.h"
+#include "occupancy.h"
+#include <math.h>
+
+// True if any cell of [min, max) is solid, below the world, or in a chunk
+// that is not loaded
+static bool cells_blocked(VoxelWorld* world, const int min[3], const int max[3]) {
+    if (min[1] < 0) return true;
+    if (min[1] >= WORLD_HEIGHT) return false;
+    for (int chunk_x = block_to_chunk(min[0]); chunk_x <= block_to_chunk(max[0] - 1); chunk_x++) {
+        for (int chunk_z = block_to_chunk(min[2]); chunk_z <= block_to_chunk(max[2] - 1);
+             chunk_z++) {
+            if (!find_chunk(world, chunk_x, chunk_z)) return true;
+        }
+    }
+    return !occupancy_region_empty(world, min, max);
+}
+
+// Distance the box can travel along one axis, up to `distance`; sets
+// *blocked if a layer of cells stopped it
+static float sweep_axis(VoxelWorld* world, const float min[3], const float max[3], int axis, float distance,
+                        bool* blocked) {
+    *blocked = false;
+    if (distance == 0.0f) return 0.0f;
+
+    // The cells the box spans across the other two axes
+    int lo[3], hi[3];
+    for (int i = 0; i < 3; i++) {
+        lo[i] = (int)floorf(min[i]);
+        hi[i] = (int)ceilf(max[i]);
+    }
+
+    // Cells the moving face enters, nearest first
+    int first, last, step;
+    if (distance > 0.0f) {
+        first = (int)ceilf(max[axis]);
+        last = (int)ceilf(max[axis] + distance) - 1;
+        step = 1;
+    } else {
+        first = (int)floorf(min[axis]) - 1;
+        last = (int)floorf(min[axis] + distance);
+        step = -1;
+    }
+    if ((last - first) * step < 0) return distance;
+
+    // Most moves cross nothing, so test every cell entered at once before
+    // going layer by layer
+    lo[axis] = step > 0 ? first : last;
+    hi[axis] = (step > 0 ? last : first) + 1;
+    if (!cells_blocked(world, lo, hi)) return distance;
+
+    for (int cell = first;; cell += step) {
+        lo[axis] = cell;
+        hi[axis] = cell + 1;
+        if (cell != last && !cells_blocked(world, lo, hi)) continue;
+        *blocked = true;
+        float travel = step > 0 ? cell - PLAYER_SKIN - max[axis] : cell + 1 + PLAYER_SKIN - min[axis];
+        return step > 0 ? fmaxf(travel, 0.0f) : fminf(travel, 0.0f);
+    }
+}
+
+int player_move_box(VoxelWorld* world, float min[3], float max[3], const float delta[3]) {
+    static const int order[3] = {1, 0, 2};
+    int blocked_axes = 0;
+    for (int i = 0; i < 3; i++) {
+        int axis = order[i];
+        bool blocked;
+        float travel = sweep_axis(world, min, max, axis, delta[axis], &blocked);
+        min[axis] += travel;
+        max[axis] += travel;
+        if (blocked) blocked_axes |= 1 << axis;
+    }
+    return blocked_axes;
+}
+
+void player_init(Player* player, float x, float y, float z) {
+    *player = (Player){{x, y, z}, {0.0f, 0.0f, 0.0f}, false};
+}
+
+void player_box(const Player* player, float min[3], float max[3]) {
+    const float half = PLAYER_WIDTH / 2;
+    min[0] = player->position[0] - half;
+    min[1] = player->position[1];
+    min[2] = player->position[2] - half;
+    max[0] = player->position[0] + half;
+    max[1] = player->position[1] + PLAYER_HEIGHT;
+    max[2] = player->position[2] + half;
+}
+
+void player_step(VoxelWorld* world, Player* player, const PlayerInput* input, float delta_time) {
+    // Walking speed follows the input at once; only falling has momentum
+    player->velocity[0] = input->move[0];
+    player->velocity[2] = input->move[1];
+    if (input->jump && player->on_ground) player->velocity[1] = PLAYER_JUMP_SPEED;
+    player->velocity[1] -= PLAYER_GRAVITY * delta_time;
+    if (player->velocity[1] < -PLAYER_TERMINAL_SPEED) player->velocity[1] = -PLAYER_TERMINAL_SPEED;
+
+    float min[3], max[3];
+    player_box(player, min, max);
+    float delta[3] = {player->velocity[0] * delta_time, player->velocity[1] * delta_time,
+                      player->velocity[2] * delta_time};
+    float start[3] = {min[0], min[1], min[2]};
+    int blocked = player_move_box(world, min, max, delta);
+
+    for (int axis = 0; axis < 3; axis++) player->position[axis] += min[axis] - start[axis];
+    player->on_ground = (blocked & 2) && delta[1] < 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        if (blocked & (1 << axis)) player->velocity[axis] = 0.0f;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <stdbool.h>
+#include "voxel_world.h"
+
+#define PLAYER_WIDTH 0.6f  // Blocks across the collision box, on x and z
+#define PLAYER_HEIGHT 1.8f
+#define PLAYER_EYE_HEIGHT 1.62f  // Camera height above the feet
+#define PLAYER_GRAVITY 28.0f  // Blocks per second squared
+#define PLAYER_JUMP_SPEED 9.0f  // Upward speed at take-off; clears one block
+#define PLAYER_TERMINAL_SPEED 60.0f  // Fastest fall, in blocks per second
+#define PLAYER_SKIN 0.001f  // Gap kept between the box and a face it stops against
+
+// Walking player: an axis-aligned box that falls, jumps and collides with
+// solid blocks. Below the world and inside chunks that are not loaded yet
+// counts as solid, so the player never falls through missing terrain.
+typedef struct {
+    float position[3];  // Centre of the bottom of the box
+    float velocity[3];  // Blocks per second
+    bool on_ground;
+} Player;
+
+// What the player wants this step
+typedef struct {
+    float move[2];  // Horizontal velocity on x and z, in blocks per second
+    bool jump;
+} PlayerInput;
+
+// Place the player at rest with its feet at (x, y, z)
+void player_init(Player* player, float x, float y, float z);
+
+// Collision box of the player, [min, max]
+void player_box(const Player* player, float min[3], float max[3]);
+
+// Advance the player by `delta_time` seconds: apply the input, gravity and
+// collisions
+void player_step(VoxelWorld* world, Player* player, const PlayerInput* input, float delta_time);
+
+// Move a box by `delta`, one axis at a time (y, then x, then z). Each axis
+// sweeps the layers of cells the moving face enters, nearest first, so no
+// distance can carry the box through a block; the box stops PLAYER_SKIN
+// short of the first solid layer. Cells the box already overlaps are
+// ignored, so a box stuck inside blocks can move out. Returns a bit per
+// blocked axis.
+int player_move_box(VoxelWorld* world, float min[3], float max[3], const float delta[3]);
+
+#endif // PLAYER_H
@@ -0,0 +1,321 @@
+#include "profiler.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One thread's ring. Only its owner writes events and `head`; readers
+// copy the ring and then drop whatever the owner may have overwritten
+// during the copy.
+typedef struct {
+    ProfileEvent events[PROFILE_RING_EVENTS];
+    _Atomic uint64_t head;  // Events ever recorded
+    _Atomic uint64_t cleared;  // Value of `head` at the last reset
+    _Atomic bool in_use;  // False once the thread exits; the slot is reused
+    const char* name;
+    int id;
+} ThreadProfile;
+
+// A buffered event and the thread that recorded it
+typedef struct {
+    ProfileEvent event;
+    int thread;
+} TaggedEvent;
+
+static ThreadProfile* thread_profiles[PROFILE_MAX_THREADS];
+static _Atomic int thread_profile_count;
+static pthread_mutex_t profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t profile_once = PTHREAD_ONCE_INIT;
+static pthread_key_t profile_key;
+static _Thread_local ThreadProfile* current_profile;
+
+static void release_thread_profile(void* data) {
+    ThreadProfile* profile = data;
+    atomic_store(&profile->in_use, false);
+}
+
+static void create_profile_key(void) {
+    pthread_key_create(&profile_key, release_thread_profile);
+}
+
+// The calling thread's ring, claimed on first use; NULL if every slot is taken
+static ThreadProfile* claim_thread_profile(void) {
+    pthread_once(&profile_once, create_profile_key);
+    ThreadProfile* profile = NULL;
+    pthread_mutex_lock(&profile_mutex);
+    int count = atomic_load(&thread_profile_count);
+    for (int i = 0; i < count && !profile; i++) {
+        if (!atomic_load(&thread_profiles[i]->in_use)) profile = thread_profiles[i];
+    }
+    if (!profile && count < PROFILE_MAX_THREADS) {
+        profile = calloc(1, sizeof(ThreadProfile));
+        if (profile) {
+            profile->id = count;
+            thread_profiles[count] = profile;
+            atomic_store(&thread_profile_count, count + 1);
+        }
+    }
+    if (profile) {
+        atomic_store(&profile->in_use, true);
+        profile->name = NULL;
+        // Events of the thread that had the slot before are not this one's
+        atomic_store(&profile->cleared, atomic_load(&profile->head));
+    }
+    pthread_mutex_unlock(&profile_mutex);
+
+    if (profile) pthread_setspecific(profile_key, profile);
+    current_profile = profile;
+    return profile;
+}
+
+static void record(const char* name, uint64_t start_ns, uint64_t value, ProfileEventKind kind) {
+    ThreadProfile* profile = current_profile ? current_profile : claim_thread_profile();
+    if (!profile) return;
+    uint64_t head = atomic_load_explicit(&profile->head, memory_order_relaxed);
+    profile->events[head % PROFILE_RING_EVENTS] = (ProfileEvent){name, start_ns, value, kind};
+    atomic_store_explicit(&profile->head, head + 1, memory_order_release);
+}
+
+uint64_t profile_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void profile_zone_end(ProfileZone* zone) {
+    record(zone->name, zone->start_ns, profile_now_ns() - zone->start_ns, PROFILE_EVENT_ZONE);
+}
+
+void profile_count(const char* name, uint64_t amount) {
+    record(name, profile_now_ns(), amount, PROFILE_EVENT_COUNTER);
+}
+
+void profile_frame(void) {
+    record("frame", profile_now_ns(), 0, PROFILE_EVENT_FRAME);
+}
+
+void profile_thread_name(const char* name) {
+    ThreadProfile* profile = current_profile ? current_profile : claim_thread_profile();
+    if (profile) profile->name = name;
+}
+
+void profile_reset(void) {
+    int count = atomic_load(&thread_profile_count);
+    for (int i = 0; i < count; i++) {
+        atomic_store(&thread_profiles[i]->cleared, atomic_load(&thread_profiles[i]->head));
+    }
+}
+
+// First event index of a ring still readable after a reset and overwrites
+static uint64_t readable_from(ThreadProfile* profile, uint64_t head) {
+    uint64_t cleared = atomic_load_explicit(&profile->cleared, memory_order_relaxed);
+    uint64_t oldest = head > PROFILE_RING_EVENTS ? head - PROFILE_RING_EVENTS : 0;
+    return cleared > oldest ? cleared : oldest;
+}
+
+int profile_thread_count(void) {
+    int threads = 0;
+    int count = atomic_load(&thread_profile_count);
+    for (int i = 0; i < count; i++) {
+        uint64_t head = atomic_load_explicit(&thread_profiles[i]->head, memory_order_acquire);
+        threads += readable_from(thread_profiles[i], head) < head;
+    }
+    return threads;
+}
+
+static int compare_events(const void* a, const void* b) {
+    uint64_t x = ((const TaggedEvent*)a)->event.start_ns;
+    uint64_t y = ((const TaggedEvent*)b)->event.start_ns;
+    return (x > y) - (x < y);
+}
+
+// Copy every readable event of every thread, oldest first; the caller frees
+static TaggedEvent* snapshot_events(long* count) {
+    int threads = atomic_load(&thread_profile_count);
+    long capacity = (long)threads * PROFILE_RING_EVENTS;
+    TaggedEvent* events = malloc((capacity ? capacity : 1) * sizeof(TaggedEvent));
+    *count = 0;
+    if (!events) return NULL;
+
+    for (int t = 0; t < threads; t++) {
+        ThreadProfile* profile = thread_profiles[t];
+        uint64_t head = atomic_load_explicit(&profile->head, memory_order_acquire);
+        uint64_t first = readable_from(profile, head);
+        long copied_from = *count;
+        for (uint64_t i = first; i < head; i++) {
+            events[(*count)++] = (TaggedEvent){profile->events[i % PROFILE_RING_EVENTS], profile->id};
+        }
+        // Drop what the owner overwrote while it was being copied
+        uint64_t overwritten = readable_from(profile, atomic_load_explicit(&profile->head, memory_order_acquire));
+        if (overwritten > first) {
+            long stale = (long)(overwritten - first);
+            if (stale > *count - copied_from) stale = *count - copied_from;
+            memmove(&events[copied_from], &events[copied_from + stale],
+                    (*count - copied_from - stale) * sizeof(TaggedEvent));
+            *count -= stale;
+        }
+    }
+    qsort(events, *count, sizeof(TaggedEvent), compare_events);
+    return events;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted durations
+static double duration_percentile(const uint64_t* sorted, long count, double p) {
+    long rank = (long)ceil(p / 100.0 * count);
+    if (rank < 1) rank = 1;
+    return (double)sorted[rank - 1];
+}
+
+// Entry of `summaries` for an event's name and kind, added if new; -1 if full
+static int summary_slot(ProfileSummary* summaries, int* entries, int max_entries, const ProfileEvent* event) {
+    for (int i = 0; i < *entries; i++) {
+        const ProfileSummary* s = &summaries[i];
+        if (s->kind == event->kind && (s->name == event->name || strcmp(s->name, event->name) == 0)) return i;
+    }
+    if (*entries == max_entries) return -1;
+    summaries[*entries] = (ProfileSummary){.name = event->name, .kind = event->kind};
+    return (*entries)++;
+}
+
+int profile_summarize(ProfileSummary* out, int max_entries) {
+    long count;
+    TaggedEvent* events = snapshot_events(&count);
+    int* slots = malloc((count ? count : 1) * sizeof(int));
+    uint64_t* durations = malloc((count ? count : 1) * sizeof(uint64_t));
+    ProfileSummary found[PROFILE_MAX_NAMES];
+    if (!events || !slots || !durations) {
+        free(events);
+        free(slots);
+        free(durations);
+        return 0;
+    }
+
+    // Give every zone and counter event its name's entry, in order of first appearance
+    long frames = 0;
+    int entries = 0;
+    for (long i = 0; i < count; i++) {
+        const ProfileEvent* event = &events[i].event;
+        slots[i] = -1;
+        if (event->kind == PROFILE_EVENT_FRAME) {
+            frames++;
+            continue;
+        }
+        slots[i] = summary_slot(found, &entries, PROFILE_MAX_NAMES, event);
+        if (slots[i] < 0) continue;
+        found[slots[i]].count++;
+        found[slots[i]].total += event->value;
+    }
+
+    // Zones first, each with the percentiles of its durations
+    int written = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        ProfileEventKind kind = pass == 0 ? PROFILE_EVENT_ZONE : PROFILE_EVENT_COUNTER;
+        for (int e = 0; e < entries && written < max_entries; e++) {
+            ProfileSummary* summary = &found[e];
+            if (summary->kind != kind) continue;
+            if (kind == PROFILE_EVENT_ZONE) {
+                long n = 0;
+                for (long i = 0; i < count; i++) {
+                    if (slots[i] == e) durations[n++] = events[i].event.value;
+                }
+                qsort(durations, n, sizeof(uint64_t), compare_u64);
+                summary->mean_ns = (double)summary->total / n;
+                summary->p50_ns = duration_percentile(durations, n, 50.0);
+                summary->p99_ns = duration_percentile(durations, n, 99.0);
+                summary->max_ns = (double)durations[n - 1];
+                summary->total = 0;
+            } else {
+                summary->per_frame = frames > 0 ? (double)summary->total / frames : (double)summary->total;
+            }
+            out[written++] = *summary;
+        }
+    }
+    free(durations);
+    free(slots);
+    free(events);
+    return written;
+}
+
+void profile_print_summary(FILE* out) {
+    ProfileSummary summaries[PROFILE_MAX_NAMES];
+    int count = profile_summarize(summaries, PROFILE_MAX_NAMES);
+    fprintf(out, "%-24s %8s %10s %10s %10s\n", "zone", "count", "p50 us", "p99 us", "max us");
+    for (int i = 0; i < count; i++) {
+        const ProfileSummary* s = &summaries[i];
+        if (s->kind != PROFILE_EVENT_ZONE) continue;
+        fprintf(out, "%-24s %8ld %10.1f %10.1f %10.1f\n", s->name, s->count, s->p50_ns / 1e3, s->p99_ns / 1e3,
+                s->max_ns / 1e3);
+    }
+    fprintf(out, "%-24s %8s %10s %10s\n", "counter", "adds", "total", "per frame");
+    for (int i = 0; i < count; i++) {
+        const ProfileSummary* s = &summaries[i];
+        if (s->kind != PROFILE_EVENT_COUNTER) continue;
+        fprintf(out, "%-24s %8ld %10llu %10.1f\n", s->name, s->count, (unsigned long long)s->total, s->per_frame);
+    }
+}
+
+long profile_write_trace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return -1;
+    long count;
+    TaggedEvent* events = snapshot_events(&count);
+    if (!events) {
+        fclose(file);
+        return -1;
+    }
+
+    // Counters are plotted as running totals, so keep one per name
+    const char* counter_names[PROFILE_MAX_NAMES];
+    uint64_t counter_totals[PROFILE_MAX_NAMES];
+    int counters = 0;
+
+    uint64_t origin = count > 0 ? events[0].event.start_ns : 0;
+    fprintf(file, "{\"traceEvents\":[");
+    int threads = atomic_load(&thread_profile_count);
+    for (int t = 0; t < threads; t++) {
+        const char* name = thread_profiles[t]->name;
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                t > 0 ? "," : "", t, name ? name : "thread");
+    }
+    for (long i = 0; i < count; i++) {
+        const ProfileEvent* event = &events[i].event;
+        double ts = (event->start_ns - origin) / 1e3;
+        const char* separator = i > 0 || threads > 0 ? "," : "";
+        switch (event->kind) {
+        case PROFILE_EVENT_ZONE:
+            fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    separator, event->name, events[i].thread, ts, event->value / 1e3);
+            break;
+        case PROFILE_EVENT_COUNTER: {
+            int c = 0;
+            while (c < counters && strcmp(counter_names[c], event->name) != 0) c++;
+            if (c == counters && counters < PROFILE_MAX_NAMES) {
+                counter_names[counters] = event->name;
+                counter_totals[counters++] = 0;
+            }
+            uint64_t total = 0;
+            if (c < counters) total = counter_totals[c] += event->value;
+            fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+                    separator, event->name, ts, (unsigned long long)total);
+            break;
+        }
+        case PROFILE_EVENT_FRAME:
+            fprintf(file, "%s\n{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+                    separator, events[i].thread, ts);
+            break;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    free(events);
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    return ok ? count : -1;
+}
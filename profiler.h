@@ -0,0 +1,103 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROFILE_RING_EVENTS 32768  // Events kept per thread; the oldest are overwritten
+#define PROFILE_MAX_THREADS 80  // Threads recording at once; later ones are not recorded
+#define PROFILE_MAX_NAMES 64  // Distinct zone and counter names in a summary
+
+// Hot-path profiler. Scoped zones time a block until it exits, counters
+// add up amounts such as quads emitted, and frame marks split the timeline.
+// Each thread records into its own ring buffer without locks; summaries and
+// traces are built from whatever the buffers still hold.
+//
+// Instrument code with the PROFILE_* macros. They record only when the
+// build defines VOXEL_PROFILE and compile to nothing otherwise. Names must
+// be string literals or otherwise outlive the profiler.
+
+typedef enum {
+    PROFILE_EVENT_ZONE,
+    PROFILE_EVENT_COUNTER,
+    PROFILE_EVENT_FRAME
+} ProfileEventKind;
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t value;  // Duration in ns for zones, the amount added for counters
+    ProfileEventKind kind;
+} ProfileEvent;
+
+// A zone being timed; ends when it goes out of scope
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+} ProfileZone;
+
+// Aggregate of every buffered event with one name
+typedef struct {
+    const char* name;
+    ProfileEventKind kind;
+    long count;  // Zones entered, or amounts added to the counter
+    double mean_ns;  // Zones only, as are the percentiles
+    double p50_ns;
+    double p99_ns;
+    double max_ns;
+    uint64_t total;  // Counters: sum of the amounts
+    double per_frame;  // Counters: total over the frame marks buffered, or the total without any
+} ProfileSummary;
+
+// Monotonic time in nanoseconds
+uint64_t profile_now_ns(void);
+
+static inline ProfileZone profile_zone_begin(const char* name) {
+    return (ProfileZone){name, profile_now_ns()};
+}
+
+void profile_zone_end(ProfileZone* zone);
+
+void profile_count(const char* name, uint64_t amount);
+
+// Mark the start of a frame
+void profile_frame(void);
+
+// Label the calling thread in traces
+void profile_thread_name(const char* name);
+
+// Forget every buffered event
+void profile_reset(void);
+
+// Threads that have recorded anything since the last reset
+int profile_thread_count(void);
+
+// Aggregate the buffered events by name, zones first; returns the number
+// of entries written to `out`
+int profile_summarize(ProfileSummary* out, int max_entries);
+
+// Per-zone p50/p99 and counter totals as a table
+void profile_print_summary(FILE* out);
+
+// Write the buffered events as Chrome trace-event JSON (chrome://tracing,
+// Perfetto); returns the number of events written, or -1 on failure
+long profile_write_trace(const char* path);
+
+#ifdef VOXEL_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) \
+    ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__) __attribute__((cleanup(profile_zone_end))) = \
+        profile_zone_begin(name)
+#define PROFILE_COUNT(name, amount) profile_count((name), (amount))
+#define PROFILE_FRAME() profile_frame()
+#define PROFILE_THREAD_NAME(name) profile_thread_name(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_COUNT(name, amount) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // PROFILER_H
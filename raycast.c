@@ -0,0 +1,185 @@
+#include "raycast.h"
+#include <math.h>
+
+#define LOOKUP_SLOTS 16  // Chunk lookups remembered while casting, direct-mapped
+
+// Recently looked up chunk columns; `chunk` is NULL for columns not loaded
+typedef struct {
+    bool valid[LOOKUP_SLOTS];
+    int chunk_x[LOOKUP_SLOTS];
+    int chunk_z[LOOKUP_SLOTS];
+    Chunk* chunk[LOOKUP_SLOTS];
+} ChunkLookup;
+
+static Chunk* lookup_chunk(VoxelWorld* world, ChunkLookup* lookup, int chunk_x, int chunk_z) {
+    int slot = (chunk_x & 3) * 4 + (chunk_z & 3);
+    if (!lookup->valid[slot] || lookup->chunk_x[slot] != chunk_x || lookup->chunk_z[slot] != chunk_z) {
+        lookup->valid[slot] = true;
+        lookup->chunk_x[slot] = chunk_x;
+        lookup->chunk_z[slot] = chunk_z;
+        lookup->chunk[slot] = find_chunk(world, chunk_x, chunk_z);
+    }
+    return lookup->chunk[slot];
+}
+
+static bool column_is_air(const Chunk* chunk) {
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        if (!chunk_section_is_air(&chunk->storage, s)) return false;
+    }
+    return true;
+}
+
+// Traversal state: the current block, the ray distance at which the next
+// boundary on each axis is crossed, and the distance between crossings
+typedef struct {
+    int block[3];
+    int step[3];
+    float t_max[3];
+    float t_delta[3];
+} Traversal;
+
+// Advance to the last block of the ray inside the cell [lo, hi), so the next
+// step leaves it; false if that is beyond `t_end`
+static bool skip_cell(Traversal* walk, const int lo[3], const int hi[3], float t_end) {
+    // Distance at which the ray leaves the cell through each axis
+    int room[3];
+    float t_exit = INFINITY;
+    for (int i = 0; i < 3; i++) {
+        room[i] = 0;
+        if (walk->step[i] == 0) continue;
+        room[i] = walk->step[i] > 0 ? hi[i] - 1 - walk->block[i] : walk->block[i] - lo[i];
+        float t = walk->t_max[i] + room[i] * walk->t_delta[i];
+        if (t < t_exit) t_exit = t;
+    }
+    if (t_exit > t_end) return false;
+
+    // Take every crossing before that on each axis at once
+    for (int i = 0; i < 3; i++) {
+        if (walk->step[i] == 0 || walk->t_max[i] >= t_exit) continue;
+        int crossings = (int)ceilf((t_exit - walk->t_max[i]) / walk->t_delta[i]);
+        if (crossings > room[i]) crossings = room[i];
+        walk->block[i] += walk->step[i] * crossings;
+        walk->t_max[i] += crossings * walk->t_delta[i];
+    }
+    return true;
+}
+
+static bool cast(VoxelWorld* world, ChunkLookup* lookup, const float origin[3], const float direction[3],
+                 float max_distance, RayHit* hit) {
+    *hit = (RayHit){0};
+    float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    if (length == 0.0f) return false;
+    float dir[3] = {direction[0] / length, direction[1] / length, direction[2] / length};
+
+    // Only the loaded window, up to the world's height, can hold blocks: the
+    // ray is cut to the part inside it, so it never walks unloaded space
+    int box_lo[3] = {(world->world_offset_x - world->view_distance) * CHUNK_SIZE, 0,
+                     (world->world_offset_z - world->view_distance) * CHUNK_SIZE};
+    int box_hi[3] = {(world->world_offset_x + world->view_distance + 1) * CHUNK_SIZE, WORLD_HEIGHT,
+                     (world->world_offset_z + world->view_distance + 1) * CHUNK_SIZE};
+    float t = 0.0f, t_end = max_distance;
+    int axis = -1;  // Axis the ray entered the window through, if it started outside
+    for (int i = 0; i < 3; i++) {
+        if (dir[i] == 0.0f) {
+            if (origin[i] < box_lo[i] || origin[i] >= box_hi[i]) return false;
+            continue;
+        }
+        float t0 = (box_lo[i] - origin[i]) / dir[i];
+        float t1 = (box_hi[i] - origin[i]) / dir[i];
+        if (t0 > t1) {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        if (t0 > t) {
+            t = t0;
+            axis = i;
+        }
+        if (t1 < t_end) t_end = t1;
+    }
+    if (!(t <= t_end)) return false;
+
+    Traversal walk;
+    for (int i = 0; i < 3; i++) {
+        walk.block[i] = (int)floorf(origin[i] + dir[i] * t);
+        if (walk.block[i] < box_lo[i]) walk.block[i] = box_lo[i];
+        if (walk.block[i] >= box_hi[i]) walk.block[i] = box_hi[i] - 1;
+        walk.step[i] = dir[i] > 0.0f ? 1 : (dir[i] < 0.0f ? -1 : 0);
+        walk.t_delta[i] = walk.step[i] ? 1.0f / fabsf(dir[i]) : INFINITY;
+    }
+    // Entering the window from outside lands on the face it came through
+    if (axis >= 0) walk.block[axis] = dir[axis] < 0.0f ? box_hi[axis] - 1 : box_lo[axis];
+    for (int i = 0; i < 3; i++) {
+        walk.t_max[i] = walk.step[i]
+            ? ((walk.block[i] + (walk.step[i] > 0)) - origin[i]) / dir[i] : INFINITY;
+    }
+
+    for (;;) {
+        for (int i = 0; i < 3; i++) {
+            if (walk.block[i] < box_lo[i] || walk.block[i] >= box_hi[i]) return false;
+        }
+        int chunk_x = block_to_chunk(walk.block[0]);
+        int chunk_z = block_to_chunk(walk.block[2]);
+        const Chunk* chunk = lookup_chunk(world, lookup, chunk_x, chunk_z);
+
+        // Cross an empty column, section or brick in one go; otherwise test the block
+        int lo[3] = {chunk_x * CHUNK_SIZE, 0, chunk_z * CHUNK_SIZE};
+        int hi[3] = {lo[0] + CHUNK_SIZE, WORLD_HEIGHT, lo[2] + CHUNK_SIZE};
+        bool empty = !chunk || column_is_air(chunk);
+        int local[3] = {walk.block[0] - lo[0], walk.block[1] % SECTION_HEIGHT, walk.block[2] - lo[2]};
+        const ChunkSection* section = NULL;
+        if (!empty) {
+            int index = walk.block[1] / SECTION_HEIGHT;
+            section = &chunk->storage.sections[index];
+            lo[1] = index * SECTION_HEIGHT;
+            hi[1] = lo[1] + SECTION_HEIGHT;
+            empty = section->solid_count == 0;
+        }
+        if (!empty) {
+            int brick = occupancy_brick(local[0], local[1], local[2]);
+            if (!((section->solid_bricks >> brick) & 1)) {
+                empty = true;
+                for (int i = 0; i < 3; i++) {
+                    lo[i] = walk.block[i] - local[i] % BRICK_SIZE;
+                    hi[i] = lo[i] + BRICK_SIZE;
+                }
+            }
+        }
+        if (empty) {
+            if (!skip_cell(&walk, lo, hi, t_end)) return false;
+        } else if (chunk_storage_is_solid(&chunk->storage, local[0], walk.block[1], local[2])) {
+            hit->hit = true;
+            for (int i = 0; i < 3; i++) {
+                hit->block[i] = walk.block[i];
+                hit->normal[i] = i == axis ? -walk.step[i] : 0;
+            }
+            hit->distance = t;
+            hit->block_type = chunk_storage_get(&chunk->storage, local[0], walk.block[1], local[2]);
+            return true;
+        }
+
+        // Step into the neighbouring block across the nearest boundary
+        axis = 0;
+        if (walk.t_max[1] < walk.t_max[axis]) axis = 1;
+        if (walk.t_max[2] < walk.t_max[axis]) axis = 2;
+        t = walk.t_max[axis];
+        if (t > t_end) return false;
+        walk.block[axis] += walk.step[axis];
+        walk.t_max[axis] += walk.t_delta[axis];
+    }
+}
+
+bool raycast(VoxelWorld* world, const float origin[3], const float direction[3], float max_distance,
+             RayHit* hit) {
+    ChunkLookup lookup = {0};
+    return cast(world, &lookup, origin, direction, max_distance, hit);
+}
+
+int raycast_batch(VoxelWorld* world, const Ray* rays, int count, RayHit* hits) {
+    ChunkLookup lookup = {0};
+    int hit_count = 0;
+    for (int i = 0; i < count; i++) {
+        hit_count += cast(world, &lookup, rays[i].origin, rays[i].direction, rays[i].max_distance, &hits[i]);
+    }
+    return hit_count;
+}
@@ -0,0 +1,36 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <stdbool.h>
+#include "voxel_world.h"
+
+// First solid block along a ray
+typedef struct {
+    bool hit;
+    int block[3];  // World coordinates of the block
+    int normal[3];  // Face the ray entered through; block + normal is the empty block before it
+    float distance;  // Blocks from the ray origin to the entry point
+    unsigned char block_type;
+} RayHit;
+
+typedef struct {
+    float origin[3];
+    float direction[3];  // Need not be unit length
+    float max_distance;  // In blocks
+} Ray;
+
+// Walk the blocks a ray passes through (Amanatides-Woo) and report the first
+// solid one within `max_distance`. Chunk columns that are not loaded or hold
+// only air, and all-air sections and 4x4x4 bricks, are crossed in one jump,
+// and blocks are tested against the occupancy bits. Only the loaded window
+// is walked: a ray misses once it leaves the window, however long it is. A
+// ray starting inside a solid block hits it at distance 0 with a zero normal.
+bool raycast(VoxelWorld* world, const float origin[3], const float direction[3], float max_distance,
+             RayHit* hit);
+
+// Cast `count` rays, reusing chunk lookups between them; rays sharing an
+// origin (explosions, line of sight from one viewer) benefit most. Returns
+// the number of rays that hit.
+int raycast_batch(VoxelWorld* world, const Ray* rays, int count, RayHit* hits);
+
+#endif // RAYCAST_H
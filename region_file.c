@@ -0,0 +1,394 @@
+#include "region_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define REGION_CHUNKS (REGION_SIZE * REGION_SIZE)
+#define REGION_MAGIC "VVR1"
+// Header: magic, seed, then an (offset, length) pair per chunk; offset 0 means absent
+#define REGION_TABLE_OFFSET 8
+#define REGION_HEADER_SIZE (REGION_TABLE_OFFSET + REGION_CHUNKS * 8)
+#define REGION_COMPACT_MIN_BYTES (64 << 10)  // Dead payload bytes worth rewriting a file for
+
+typedef struct {
+    int region_x;
+    int region_z;
+    int fd;  // -1 when the cache entry is unused
+    unsigned char* map;  // Read-only mapping of the first map_size bytes
+    size_t map_size;
+    size_t file_size;
+    uint32_t offsets[REGION_CHUNKS];
+    uint32_t lengths[REGION_CHUNKS];
+    unsigned int last_used;
+} RegionFile;
+
+// A serialized chunk waiting for a write-back job
+typedef struct PendingSave {
+    struct PendingSave* next;
+    RegionStore* store;
+    int chunk_x;
+    int chunk_z;
+    size_t length;
+    unsigned char* payload;
+} PendingSave;
+
+struct RegionStore {
+    char directory[512];
+    unsigned int seed;
+    JobSystem* jobs;
+    pthread_mutex_t lock;  // Guards everything below, including file I/O
+    RegionFile files[REGION_CACHE_SIZE];
+    unsigned int use_clock;
+    PendingSave* pending;
+    RegionStats stats;
+};
+
+static void put_u32(unsigned char* p, uint32_t value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Floor division by REGION_SIZE, so negative chunks land in the right region
+static int region_coord(int chunk_coord) {
+    int q = chunk_coord / REGION_SIZE;
+    if (chunk_coord % REGION_SIZE != 0 && chunk_coord < 0) q--;
+    return q;
+}
+
+static int region_index(int chunk_x, int chunk_z) {
+    int local_x = chunk_x - region_coord(chunk_x) * REGION_SIZE;
+    int local_z = chunk_z - region_coord(chunk_z) * REGION_SIZE;
+    return local_z * REGION_SIZE + local_x;
+}
+
+static void unmap_region(RegionFile* region) {
+    if (region->map) munmap(region->map, region->map_size);
+    region->map = NULL;
+    region->map_size = 0;
+}
+
+// Map the whole file as it is now; payloads appended later need a remap
+static bool map_region(RegionFile* region) {
+    unmap_region(region);
+    void* map = mmap(NULL, region->file_size, PROT_READ, MAP_SHARED, region->fd, 0);
+    if (map == MAP_FAILED) return false;
+    region->map = map;
+    region->map_size = region->file_size;
+    return true;
+}
+
+static void close_region(RegionFile* region) {
+    unmap_region(region);
+    if (region->fd >= 0) close(region->fd);
+    region->fd = -1;
+}
+
+// Start the file over as an empty region for `seed`
+static bool reset_region(RegionFile* region, unsigned int seed) {
+    unsigned char header[REGION_HEADER_SIZE] = {0};
+    memcpy(header, REGION_MAGIC, 4);
+    put_u32(header + 4, seed);
+    if (ftruncate(region->fd, 0) != 0) return false;
+    if (pwrite(region->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) return false;
+
+    memset(region->offsets, 0, sizeof(region->offsets));
+    memset(region->lengths, 0, sizeof(region->lengths));
+    region->file_size = REGION_HEADER_SIZE;
+    return map_region(region);
+}
+
+static void region_path(const RegionStore* store, int region_x, int region_z, const char* suffix, char* path,
+                        size_t size) {
+    snprintf(path, size, "%s/r.%d.%d.vvr%s", store->directory, region_x, region_z, suffix);
+}
+
+// Rewrite the file with only its live payloads, packed after the header, once
+// replaced payloads take more room than the live ones. The packed copy is
+// written to a temporary file and renamed over the region, so a crash leaves
+// either the old file or the new one. Caller holds the lock.
+static void compact_region(RegionStore* store, RegionFile* region) {
+    size_t live = 0;
+    for (int i = 0; i < REGION_CHUNKS; i++) live += region->lengths[i];
+    size_t dead = region->file_size - REGION_HEADER_SIZE - live;
+    if (dead < REGION_COMPACT_MIN_BYTES || dead < live) return;
+    if (region->map_size < region->file_size && !map_region(region)) return;
+
+    char path[600], temp_path[608];
+    region_path(store, region->region_x, region->region_z, "", path, sizeof(path));
+    region_path(store, region->region_x, region->region_z, ".tmp", temp_path, sizeof(temp_path));
+    unsigned char* packed = malloc(REGION_HEADER_SIZE + live);
+    if (!packed) return;
+    memcpy(packed, region->map, REGION_TABLE_OFFSET);
+    uint32_t offsets[REGION_CHUNKS];
+    size_t end = REGION_HEADER_SIZE;
+    for (int i = 0; i < REGION_CHUNKS; i++) {
+        offsets[i] = region->lengths[i] ? (uint32_t)end : 0;
+        memcpy(packed + end, region->map + region->offsets[i], region->lengths[i]);
+        put_u32(packed + REGION_TABLE_OFFSET + i * 8, offsets[i]);
+        put_u32(packed + REGION_TABLE_OFFSET + i * 8 + 4, region->lengths[i]);
+        end += region->lengths[i];
+    }
+
+    int fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0 && pwrite(fd, packed, end, 0) == (ssize_t)end && fsync(fd) == 0;
+    free(packed);
+    if (!written || rename(temp_path, path) != 0) {
+        if (fd >= 0) close(fd);
+        unlink(temp_path);
+        return;
+    }
+    close_region(region);
+    region->fd = fd;
+    region->file_size = end;
+    memcpy(region->offsets, offsets, sizeof(offsets));
+    if (!map_region(region)) close_region(region);
+    store->stats.compactions++;
+}
+
+static bool open_region(RegionStore* store, RegionFile* region, int region_x, int region_z) {
+    char path[600];
+    region_path(store, region_x, region_z, "", path, sizeof(path));
+
+    region->region_x = region_x;
+    region->region_z = region_z;
+    region->map = NULL;
+    region->map_size = 0;
+    region->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (region->fd < 0) return false;
+
+    struct stat info;
+    if (fstat(region->fd, &info) != 0) {
+        close_region(region);
+        return false;
+    }
+    region->file_size = (size_t)info.st_size;
+
+    bool valid = region->file_size >= REGION_HEADER_SIZE && map_region(region) &&
+                 memcmp(region->map, REGION_MAGIC, 4) == 0 && get_u32(region->map + 4) == store->seed;
+    if (!valid) {
+        if (!reset_region(region, store->seed)) {
+            close_region(region);
+            return false;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < REGION_CHUNKS; i++) {
+        const unsigned char* entry = region->map + REGION_TABLE_OFFSET + i * 8;
+        region->offsets[i] = get_u32(entry);
+        region->lengths[i] = get_u32(entry + 4);
+        // Entries pointing past the end came from an interrupted write
+        if ((size_t)region->offsets[i] + region->lengths[i] > region->file_size) {
+            region->offsets[i] = 0;
+            region->lengths[i] = 0;
+        }
+    }
+    compact_region(store, region);
+    return region->fd >= 0;
+}
+
+// Find or open the region holding a chunk, closing the least recently used
+// one when the cache is full. Caller holds the lock.
+static RegionFile* acquire_region(RegionStore* store, int chunk_x, int chunk_z) {
+    int region_x = region_coord(chunk_x);
+    int region_z = region_coord(chunk_z);
+    RegionFile* victim = &store->files[0];
+
+    for (int i = 0; i < REGION_CACHE_SIZE; i++) {
+        RegionFile* region = &store->files[i];
+        if (region->fd >= 0 && region->region_x == region_x && region->region_z == region_z) {
+            region->last_used = ++store->use_clock;
+            return region;
+        }
+        if (region->fd < 0 || (victim->fd >= 0 && region->last_used < victim->last_used)) {
+            victim = region;
+        }
+    }
+
+    close_region(victim);
+    if (!open_region(store, victim, region_x, region_z)) return NULL;
+    victim->last_used = ++store->use_clock;
+    return victim;
+}
+
+// Write one payload and its table entry. The payload is always appended and
+// the entry switched to it only once it is written, so a write cut short
+// leaves the entry on the old copy; the space of replaced copies is taken
+// back by compaction. Caller holds the lock.
+static bool write_chunk(RegionStore* store, const PendingSave* save) {
+    RegionFile* region = acquire_region(store, save->chunk_x, save->chunk_z);
+    if (!region) return false;
+
+    int index = region_index(save->chunk_x, save->chunk_z);
+    size_t offset = region->file_size;
+    if (offset + save->length > UINT32_MAX) return false;
+
+    if (pwrite(region->fd, save->payload, save->length, (off_t)offset) != (ssize_t)save->length) {
+        return false;
+    }
+    unsigned char entry[8];
+    put_u32(entry, (uint32_t)offset);
+    put_u32(entry + 4, (uint32_t)save->length);
+    if (pwrite(region->fd, entry, sizeof(entry), REGION_TABLE_OFFSET + index * 8) != (ssize_t)sizeof(entry)) {
+        return false;
+    }
+
+    region->offsets[index] = (uint32_t)offset;
+    region->lengths[index] = (uint32_t)save->length;
+    region->file_size = offset + save->length;
+    store->stats.chunks_saved++;
+    store->stats.bytes_written += (long)save->length;
+    compact_region(store, region);
+    return true;
+}
+
+static void unlink_pending(RegionStore* store, PendingSave* save) {
+    PendingSave** link = &store->pending;
+    while (*link && *link != save) link = &(*link)->next;
+    if (*link) *link = save->next;
+}
+
+static PendingSave* find_pending(RegionStore* store, int chunk_x, int chunk_z) {
+    for (PendingSave* save = store->pending; save; save = save->next) {
+        if (save->chunk_x == chunk_x && save->chunk_z == chunk_z) return save;
+    }
+    return NULL;
+}
+
+static void free_pending(PendingSave* save) {
+    free(save->payload);
+    free(save);
+}
+
+// Write-back job. The whole write happens under the lock, so a save stays
+// visible to loads through the pending list until its bytes are on disk.
+static void run_write_back_job(void* data) {
+    PendingSave* save = data;
+    RegionStore* store = save->store;
+
+    pthread_mutex_lock(&store->lock);
+    if (!write_chunk(store, save)) store->stats.write_errors++;
+    unlink_pending(store, save);
+    pthread_mutex_unlock(&store->lock);
+    free_pending(save);
+}
+
+RegionStore* region_store_open(const char* directory, unsigned int seed, JobSystem* jobs) {
+    if (strlen(directory) >= sizeof(((RegionStore*)0)->directory)) return NULL;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) return NULL;
+
+    RegionStore* store = calloc(1, sizeof(RegionStore));
+    if (!store) return NULL;
+    strcpy(store->directory, directory);
+    store->seed = seed;
+    store->jobs = jobs;
+    pthread_mutex_init(&store->lock, NULL);
+    for (int i = 0; i < REGION_CACHE_SIZE; i++) {
+        store->files[i].fd = -1;
+    }
+    return store;
+}
+
+void region_store_close(RegionStore* store) {
+    if (!store) return;
+
+    // Anything still queued had its job discarded; write it now
+    while (store->pending) {
+        PendingSave* save = store->pending;
+        store->pending = save->next;
+        if (!write_chunk(store, save)) store->stats.write_errors++;
+        free_pending(save);
+    }
+    for (int i = 0; i < REGION_CACHE_SIZE; i++) {
+        close_region(&store->files[i]);
+    }
+    pthread_mutex_destroy(&store->lock);
+    free(store);
+}
+
+bool region_store_load(RegionStore* store, int chunk_x, int chunk_z, ChunkStorage* storage) {
+    bool loaded = false;
+    pthread_mutex_lock(&store->lock);
+
+    // A queued save is newer than anything on disk
+    PendingSave* save = find_pending(store, chunk_x, chunk_z);
+    if (save) {
+        loaded = chunk_storage_deserialize(storage, save->payload, save->length);
+    } else {
+        RegionFile* region = acquire_region(store, chunk_x, chunk_z);
+        int index = region_index(chunk_x, chunk_z);
+        if (region && region->offsets[index] != 0) {
+            size_t end = (size_t)region->offsets[index] + region->lengths[index];
+            if (end <= region->map_size || map_region(region)) {
+                loaded = chunk_storage_deserialize(storage, region->map + region->offsets[index],
+                                                   region->lengths[index]);
+            }
+        }
+    }
+
+    if (loaded) store->stats.chunks_loaded++;
+    pthread_mutex_unlock(&store->lock);
+    return loaded;
+}
+
+void region_store_save(RegionStore* store, int chunk_x, int chunk_z, const ChunkStorage* storage) {
+    unsigned char buffer[CHUNK_STORAGE_MAX_SERIALIZED];
+    size_t length = chunk_storage_serialize(storage, buffer);
+    unsigned char* payload = malloc(length);
+    if (!payload) return;
+    memcpy(payload, buffer, length);
+
+    pthread_mutex_lock(&store->lock);
+    PendingSave* save = find_pending(store, chunk_x, chunk_z);
+    if (save) {
+        // Its job has not run yet; let it write the newer blocks instead
+        free(save->payload);
+        save->payload = payload;
+        save->length = length;
+        pthread_mutex_unlock(&store->lock);
+        return;
+    }
+
+    save = malloc(sizeof(PendingSave));
+    if (!save) {
+        pthread_mutex_unlock(&store->lock);
+        free(payload);
+        return;
+    }
+    save->store = store;
+    save->chunk_x = chunk_x;
+    save->chunk_z = chunk_z;
+    save->length = length;
+    save->payload = payload;
+
+    if (!store->jobs) {
+        if (!write_chunk(store, save)) store->stats.write_errors++;
+        pthread_mutex_unlock(&store->lock);
+        free_pending(save);
+        return;
+    }
+    save->next = store->pending;
+    store->pending = save;
+    pthread_mutex_unlock(&store->lock);
+    job_system_submit(store->jobs, run_write_back_job, save);
+}
+
+RegionStats region_store_stats(RegionStore* store) {
+    pthread_mutex_lock(&store->lock);
+    RegionStats stats = store->stats;
+    pthread_mutex_unlock(&store->lock);
+    return stats;
+}
@@ -0,0 +1,46 @@
+#ifndef REGION_FILE_H
+#define REGION_FILE_H
+
+#include <stdbool.h>
+#include "chunk_storage.h"
+#include "job_system.h"
+
+#define REGION_SIZE 32  // Chunks per side of one region file
+#define REGION_CACHE_SIZE 8  // Region files kept open and mapped at once
+
+// On-disk chunk persistence. Chunks are grouped into REGION_SIZE x
+// REGION_SIZE region files, each starting with an offset table followed by
+// serialized, palette-packed chunk payloads. Reads go through a read-only
+// memory map of the file; writes are queued and applied by background jobs.
+// A saved chunk is appended and its table entry switched afterwards, so an
+// interrupted write never damages the copy already on disk; files are
+// compacted once replaced copies outweigh the live ones.
+// All functions are safe to call from any thread.
+typedef struct RegionStore RegionStore;
+
+typedef struct {
+    long chunks_loaded;  // Chunks read back from disk or the pending-write queue
+    long chunks_saved;  // Chunks written to region files
+    long bytes_written;
+    long write_errors;
+    long compactions;  // Region files rewritten to drop replaced payloads
+} RegionStats;
+
+// Open (creating if needed) a store in `directory`. Region files written
+// with a different seed are discarded. `jobs` runs write-back; NULL writes inline.
+RegionStore* region_store_open(const char* directory, unsigned int seed, JobSystem* jobs);
+
+// Write back every queued chunk and close all files. The job system passed
+// to region_store_open must be idle or destroyed before calling this.
+void region_store_close(RegionStore* store);
+
+// Load a chunk's blocks; false if the chunk was never saved
+bool region_store_load(RegionStore* store, int chunk_x, int chunk_z, ChunkStorage* storage);
+
+// Snapshot a chunk's blocks and queue them to be written back
+void region_store_save(RegionStore* store, int chunk_x, int chunk_z, const ChunkStorage* storage);
+
+// Totals since the store was opened
+RegionStats region_store_stats(RegionStore* store);
+
+#endif // REGION_FILE_H
@@ -0,0 +1,438 @@
+#include "render_gl.h"
+#include "chunk_arena.h"
+#include "chunk_mesh.h"
+#include "profiler.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FIELDS_ATTRIBUTE 0
+#define CHUNK_ATTRIBUTE 1
+
+// Every chunk mesh lives in one vertex buffer, in ranges placed by
+// chunk_arena.c. Vertices go up packed, exactly as the mesher stores them,
+// and carry their chunk, so the visible ranges of all chunks are drawn with
+// one glMultiDrawArrays and no per-chunk transform.
+static GLuint arena_buffer;
+static VertexArena arena;
+static GLuint chunk_program;
+static bool chunk_program_failed;
+static GLint origin_location;
+static GLint origin_wrapped_location;
+static GLint* draw_firsts;  // Ranges of the frame's multi-draw
+static GLsizei* draw_counts;
+static int draw_capacity;
+static bool multi_draw = true;
+static GlRenderStats render_stats;
+
+// Copy a chunk's mesh into its range
+static void upload_chunk(VoxelWorld* world, Chunk* chunk) {
+    int count = chunk->mesh.vertex_count;
+    long bytes = (long)count * sizeof(PackedVertex);
+    if (count > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, chunk->vbo_first * (long)sizeof(PackedVertex), bytes,
+                        chunk->mesh.vertices);
+    }
+    chunk->vbo_vertex_count = count;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        chunk->vbo_section_first[s] = chunk->mesh.section_first[s];
+        chunk->vbo_section_count[s] = chunk->mesh.section_vertex_count[s];
+    }
+    chunk->vbo_stale = false;
+
+    world->stats.uploads++;
+    world->stats.bytes_uploaded += bytes;
+    world->stats.total_bytes_uploaded += bytes;
+}
+
+void upload_chunk_meshes(VoxelWorld* world) {
+    PROFILE_ZONE("upload_chunk_meshes");
+    // Find room for every rebuilt mesh first; a repack marks every chunk
+    // for upload, into a new buffer if the arena grew
+    int capacity = arena.capacity;
+    if (chunk_arena_place(&arena, world)) {
+        render_stats.repacks++;
+        if (!arena_buffer || arena.capacity != capacity) {
+            if (!arena_buffer) glGenBuffers(1, &arena_buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, arena_buffer);
+            glBufferData(GL_ARRAY_BUFFER, arena.capacity * (long)sizeof(PackedVertex), NULL, GL_STATIC_DRAW);
+        }
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, arena_buffer);
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            if (chunk->is_loaded && chunk->vbo_stale) upload_chunk(world, chunk);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Decodes packed chunk vertices. GLSL 1.20 has no integer operations, so the
+// fields word is read as two unsigned 16-bit halves (low half first, on
+// little-endian hosts) and split with float arithmetic, which is exact at
+// these sizes. The wrapped chunk coordinates are unwrapped against a chunk
+// of the frame, as chunk_mesh_unwrap_chunk does. The colour comes from the
+// mesher's shading tables alone, since the baked per-voxel light already
+// shades every face; fragments are left to the fixed-function pipeline.
+static const char* chunk_vertex_source =
+    "attribute vec2 fields;\n"
+    "attribute vec2 chunk;\n"
+    "uniform vec2 origin;\n"
+    "uniform vec2 origin_wrapped;\n"
+    "uniform vec3 face_color[BLOCK_TYPES * 6];\n"
+    "uniform float brightness[6 * LIGHT_LEVELS];\n"
+    "uniform float occlusion[4];\n"
+    "void main() {\n"
+    "    vec3 local = vec3(mod(fields.x, 32.0), mod(floor(fields.x / 32.0), 64.0), floor(fields.x / 2048.0));\n"
+    "    float normal = mod(fields.y, 8.0);\n"
+    "    float ao = mod(floor(fields.y / 8.0), 4.0);\n"
+    "    float light = mod(floor(fields.y / 32.0), 32.0);\n"
+    "    float block = floor(fields.y / 1024.0);\n"
+    "    vec2 offset = mod(chunk - origin_wrapped, 65536.0);\n"
+    "    offset -= step(32768.0, offset) * 65536.0;\n"
+    "    vec2 base = (origin + offset) * CHUNK_SIZE;\n"
+    "    vec4 eye = gl_ModelViewMatrix * vec4(local.x + base.x, local.y, local.z + base.y, 1.0);\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "    vec3 color = face_color[int(block * 6.0 + normal)] *\n"
+    "                 brightness[int(normal * float(LIGHT_LEVELS) + light)] * occlusion[int(ao)];\n"
+    "    gl_FrontColor = vec4(color, 1.0);\n"
+    "    gl_FogFragCoord = -eye.z;\n"
+    "}\n";
+
+// Compile and link the chunk program and load the shading tables into it;
+// false, once, with the log on stderr if the driver rejects it
+static bool load_chunk_program(void) {
+    if (chunk_program) return true;
+    if (chunk_program_failed) return false;
+
+    char header[128];
+    snprintf(header, sizeof(header), "#version 120\n#define CHUNK_SIZE %d.0\n#define BLOCK_TYPES %d\n"
+             "#define LIGHT_LEVELS %d\n", CHUNK_SIZE, BLOCK_TYPE_COUNT, PACKED_LIGHT_LEVELS);
+    const char* sources[2] = {header, chunk_vertex_source};
+    GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(shader, 2, sources, NULL);
+    glCompileShader(shader);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glBindAttribLocation(program, FIELDS_ATTRIBUTE, "fields");
+    glBindAttribLocation(program, CHUNK_ATTRIBUTE, "chunk");
+    glLinkProgram(program);
+
+    GLint compiled = GL_FALSE, linked = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!compiled || !linked) {
+        char log[1024] = "";
+        if (compiled) {
+            glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        } else {
+            glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        }
+        fprintf(stderr, "Chunk shader failed: %s\n", log);
+        glDeleteShader(shader);
+        glDeleteProgram(program);
+        chunk_program_failed = true;
+        return false;
+    }
+    glDeleteShader(shader);  // Freed with the program
+
+    const MeshShading* shading = chunk_mesh_shading();
+    glUseProgram(program);
+    glUniform3fv(glGetUniformLocation(program, "face_color"), BLOCK_TYPE_COUNT * 6, &shading->face_color[0][0].r);
+    glUniform1fv(glGetUniformLocation(program, "brightness"), 6 * PACKED_LIGHT_LEVELS, &shading->brightness[0][0]);
+    glUniform1fv(glGetUniformLocation(program, "occlusion"), 4, shading->occlusion);
+    glUseProgram(0);
+    origin_location = glGetUniformLocation(program, "origin");
+    origin_wrapped_location = glGetUniformLocation(program, "origin_wrapped");
+    chunk_program = program;
+    return true;
+}
+
+void render_draw_list(const DrawList* list) {
+    PROFILE_ZONE("render_draw_list");
+    if (list->count > draw_capacity) {
+        GLint* firsts = realloc(draw_firsts, list->count * sizeof(GLint));
+        if (firsts) draw_firsts = firsts;
+        GLsizei* counts = realloc(draw_counts, list->count * sizeof(GLsizei));
+        if (counts) draw_counts = counts;
+        if (!firsts || !counts) return;
+        draw_capacity = list->count;
+    }
+    
+    // Ranges that meet in the buffer are drawn as one
+    int ranges = 0;
+    for (int i = 0; i < list->count; i++) {
+        const DrawItem* item = &list->items[i];
+        GLint first = item->chunk->vbo_first + item->first_vertex;
+        if (ranges > 0 && draw_firsts[ranges - 1] + draw_counts[ranges - 1] == first) {
+            draw_counts[ranges - 1] += item->vertex_count;
+        } else {
+            draw_firsts[ranges] = first;
+            draw_counts[ranges] = item->vertex_count;
+            ranges++;
+        }
+    }
+    render_stats.draw_ranges = ranges;
+    render_stats.draw_calls = 0;
+    if (ranges == 0 || !load_chunk_program()) return;
+    
+    // Every drawn chunk is within the view distance of the first one
+    const Chunk* origin = list->items[0].chunk;
+    glUseProgram(chunk_program);
+    glUniform2f(origin_location, (float)origin->world_x, (float)origin->world_z);
+    glUniform2f(origin_wrapped_location, (float)(int16_t)(uint16_t)origin->world_x,
+                (float)(int16_t)(uint16_t)origin->world_z);
+    glEnableVertexAttribArray(FIELDS_ATTRIBUTE);
+    glEnableVertexAttribArray(CHUNK_ATTRIBUTE);
+    glBindBuffer(GL_ARRAY_BUFFER, arena_buffer);
+    glVertexAttribPointer(FIELDS_ATTRIBUTE, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(PackedVertex),
+                          (const void*)offsetof(PackedVertex, fields));
+    glVertexAttribPointer(CHUNK_ATTRIBUTE, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex),
+                          (const void*)offsetof(PackedVertex, chunk_x));
+    if (multi_draw) {
+        glMultiDrawArrays(GL_TRIANGLES, draw_firsts, draw_counts, ranges);
+        render_stats.draw_calls = 1;
+    } else {
+        for (int i = 0; i < ranges; i++) {
+            glDrawArrays(GL_TRIANGLES, draw_firsts[i], draw_counts[i]);
+        }
+        render_stats.draw_calls = ranges;
+    }
+    glDisableVertexAttribArray(CHUNK_ATTRIBUTE);
+    glDisableVertexAttribArray(FIELDS_ATTRIBUTE);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
+
+void gl_set_multi_draw(bool enabled) {
+    multi_draw = enabled;
+}
+
+const GlRenderStats* gl_render_stats(void) {
+    render_stats.multi_draw = multi_draw;
+    render_stats.arena_capacity = arena.capacity;
+    render_stats.arena_used = arena.used;
+    render_stats.arena_free_ranges = arena.free_count;
+    render_stats.arena_fragmentation = vertex_arena_fragmentation(&arena);
+    return &render_stats;
+}
+
+#define SKY_SIZE 100.0f  // Half the width of the sky cube
+#define SUN_DISTANCE 50.0f
+#define SUN_RADIUS 5.0f
+#define SUN_SEGMENTS 32
+#define SKY_CUBE_VERTICES 24
+#define SUN_VERTICES (SUN_SEGMENTS + 2)
+
+// Corners of the sky cube's faces, drawn as GL_QUADS in this order
+static const float sky_cube[SKY_CUBE_VERTICES][3] = {
+    {-1, -1,  1}, { 1, -1,  1}, { 1,  1,  1}, {-1,  1,  1},  // Front
+    {-1, -1, -1}, {-1,  1, -1}, { 1,  1, -1}, { 1, -1, -1},  // Back
+    {-1,  1, -1}, {-1,  1,  1}, { 1,  1,  1}, { 1,  1, -1},  // Top
+    {-1, -1, -1}, { 1, -1, -1}, { 1, -1,  1}, {-1, -1,  1},  // Bottom
+    { 1, -1, -1}, { 1,  1, -1}, { 1,  1,  1}, { 1, -1,  1},  // Right
+    {-1, -1, -1}, {-1, -1,  1}, {-1,  1,  1}, {-1,  1, -1},  // Left
+};
+
+// Shade of each face relative to the sky colour
+static const float sky_face_shade[6] = {0.8f, 0.8f, 1.0f, 0.6f, 0.9f, 0.9f};
+
+typedef struct {
+    float x, y, z;
+    unsigned char r, g, b, a;
+} StarVertex;
+
+// Upload the sky cube, the sun and the stars once. None of them change after
+// this; each frame only sets colours, the sun's rotation and the star fade.
+static void upload_sky_buffers(Skybox* skybox) {
+    // The cube's corners, then the sun as a fan around the origin
+    float sky[(SKY_CUBE_VERTICES + SUN_VERTICES) * 3];
+    for (int i = 0; i < SKY_CUBE_VERTICES; i++) {
+        for (int axis = 0; axis < 3; axis++) sky[i * 3 + axis] = sky_cube[i][axis] * SKY_SIZE;
+    }
+    float* sun = sky + SKY_CUBE_VERTICES * 3;
+    sun[0] = sun[1] = sun[2] = 0.0f;
+    for (int i = 0; i <= SUN_SEGMENTS; i++) {
+        float angle = i * 2.0f * M_PI / SUN_SEGMENTS;
+        sun[(i + 1) * 3 + 0] = cos(angle) * SUN_RADIUS;
+        sun[(i + 1) * 3 + 1] = sin(angle) * SUN_RADIUS;
+        sun[(i + 1) * 3 + 2] = 0.0f;
+    }
+    glGenBuffers(1, &skybox->sky_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, skybox->sky_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(sky), sky, GL_STATIC_DRAW);
+    
+    // Stars at full brightness; the fade scales them as they are drawn
+    glGenBuffers(1, &skybox->star_buffer);
+    StarVertex* stars = malloc(sizeof(StarVertex) * (skybox->star_count > 0 ? skybox->star_count : 1));
+    if (stars) {
+        for (int i = 0; i < skybox->star_count; i++) {
+            const Star* star = &skybox->stars[i];
+            unsigned char level = (unsigned char)(star->brightness * 255.0f + 0.5f);
+            stars[i] = (StarVertex){star->position.x, star->position.y, star->position.z, level, level, level, 255};
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, skybox->star_buffer);
+        glBufferData(GL_ARRAY_BUFFER, (long)sizeof(StarVertex) * skybox->star_count, stars, GL_STATIC_DRAW);
+        free(stars);
+    } else {
+        skybox->star_count = 0;  // Go without stars rather than draw an empty buffer
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void render_skybox(VoxelWorld* world) {
+    PROFILE_ZONE("render_skybox");
+    Skybox* skybox = &world->skybox;
+    if (!skybox->sky_buffer) {
+        upload_sky_buffers(skybox);
+    }
+    
+    // Save current matrix
+    glPushMatrix();
+    
+    // Reset the modelview matrix to identity
+    glLoadIdentity();
+    
+    // Disable depth testing for skybox
+    glDisable(GL_DEPTH_TEST);
+    
+    // Set sky color
+    glClearColor(skybox->sky_color.r, skybox->sky_color.g, skybox->sky_color.b, 1.0f);
+    
+    // Set fog color
+    glFogfv(GL_FOG_COLOR, (float*)&skybox->fog_color);
+    
+    // Draw skybox cube, one face per shade
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, skybox->sky_buffer);
+    glVertexPointer(3, GL_FLOAT, 0, (const void*)0);
+    for (int face = 0; face < 6; face++) {
+        float shade = sky_face_shade[face];
+        glColor3f(skybox->sky_color.r * shade, skybox->sky_color.g * shade, skybox->sky_color.b * shade);
+        glDrawArrays(GL_QUADS, face * 4, 4);
+    }
+    
+    // Draw sun during day, carried around the sky by a rotation
+    if (skybox->time_of_day >= 0.25f && skybox->time_of_day <= 0.75f) {
+        glPushMatrix();
+        glTranslatef(0.0f, 0.0f, -SUN_DISTANCE);
+        glRotatef(skybox->sun_angle * 180.0f / M_PI, 0.0f, 0.0f, 1.0f);
+        glTranslatef(SUN_DISTANCE, 0.0f, 0.0f);
+        glColor3f(1.0f, 1.0f, 0.8f);
+        glDrawArrays(GL_TRIANGLE_FAN, SKY_CUBE_VERTICES, SUN_VERTICES);
+        glPopMatrix();
+    }
+    
+    // Draw stars during night (with the skybox). The blend colour scales
+    // every star by the fade, so the buffer never changes.
+    if (skybox->star_fade > 0.0f && skybox->star_count > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, skybox->star_buffer);
+        glVertexPointer(3, GL_FLOAT, sizeof(StarVertex), (const void*)offsetof(StarVertex, x));
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_UNSIGNED_BYTE, sizeof(StarVertex), (const void*)offsetof(StarVertex, r));
+        glEnable(GL_BLEND);
+        glBlendColor(skybox->star_fade, skybox->star_fade, skybox->star_fade, 1.0f);
+        glBlendFunc(GL_CONSTANT_COLOR, GL_ZERO);
+        glDrawArrays(GL_POINTS, 0, skybox->star_count);
+        glDisable(GL_BLEND);
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    // Restore matrix
+    glPopMatrix();
+    
+    // Re-enable depth testing
+    glEnable(GL_DEPTH_TEST);
+}
+
+void release_chunk_buffers(VoxelWorld* world) {
+    world->retired_count = 0;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            chunk->vbo_first = 0;
+            chunk->vbo_capacity = 0;
+            chunk->vbo_vertex_count = 0;
+            chunk->vbo_stale = chunk->is_loaded;
+        }
+    }
+    if (arena_buffer) {
+        glDeleteBuffers(1, &arena_buffer);
+        arena_buffer = 0;
+    }
+    vertex_arena_destroy(&arena);
+    if (chunk_program) {
+        glDeleteProgram(chunk_program);
+        chunk_program = 0;
+    }
+    free(draw_firsts);
+    free(draw_counts);
+    draw_firsts = NULL;
+    draw_counts = NULL;
+    draw_capacity = 0;
+    if (world->skybox.sky_buffer) {
+        glDeleteBuffers(1, &world->skybox.sky_buffer);
+        glDeleteBuffers(1, &world->skybox.star_buffer);
+        world->skybox.sky_buffer = 0;
+        world->skybox.star_buffer = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Backend
+
+static void gl_begin_frame(Renderer* renderer, VoxelWorld* world, const Camera* camera,
+                           const Projection* projection) {
+    (void)renderer;
+    float matrix[16];
+    projection_matrix(projection, matrix);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(matrix);
+    glMatrixMode(GL_MODELVIEW);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    camera_view_matrix(camera, matrix);
+    glLoadMatrixf(matrix);
+
+    // Render skybox and stars (before blocks)
+    render_skybox(world);
+}
+
+static void gl_upload(Renderer* renderer, VoxelWorld* world) {
+    (void)renderer;
+    upload_chunk_meshes(world);
+}
+
+static void gl_draw(Renderer* renderer, const DrawList* list) {
+    (void)renderer;
+    render_draw_list(list);
+}
+
+static void gl_release(Renderer* renderer, VoxelWorld* world) {
+    (void)renderer;
+    release_chunk_buffers(world);
+}
+
+// The GL backend has no state of its own to free
+static void gl_destroy(Renderer* renderer) {
+    (void)renderer;
+}
+
+static const RendererOps gl_ops = {
+    gl_begin_frame,
+    gl_upload,
+    gl_draw,
+    gl_release,
+    gl_destroy,
+};
+
+static Renderer gl_renderer = {&gl_ops, "opengl"};
+
+Renderer* gl_renderer_get(void) {
+    return &gl_renderer;
+}
@@ -0,0 +1,61 @@
+#ifndef RENDER_GL_H
+#define RENDER_GL_H
+
+// Buffer objects are GL 1.5; ask for their prototypes on platforms whose
+// gl.h stops at 1.1
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#endif
+
+#include "voxel_world.h"
+#include "draw_list.h"
+#include "renderer.h"
+
+// Counters of the chunk renderer
+typedef struct {
+    int draw_calls;  // Last frame: 1 with multi-draw, else one per range
+    int draw_ranges;  // Last frame: vertex ranges drawn, after merging neighbours
+    bool multi_draw;
+    int arena_capacity;  // Vertices the shared buffer holds
+    int arena_used;
+    int arena_free_ranges;
+    float arena_fragmentation;  // See vertex_arena_fragmentation
+    int repacks;  // Times the buffer was repacked or resized
+} GlRenderStats;
+
+// Free the ranges of chunks that left the view, then upload rebuilt chunk
+// meshes into their ranges of the shared vertex buffer, repacking it when a
+// mesh does not fit
+void upload_chunk_meshes(VoxelWorld* world);
+
+// Draw the visible chunk sections collected by draw_list_build with one
+// glMultiDrawArrays, or one glDrawArrays per range with multi-draw off. A
+// vertex shader decodes the packed vertices; the shader is built on first
+// use, and nothing is drawn if the driver rejects it.
+void render_draw_list(const DrawList* list);
+
+// Choose between the single multi-draw and a draw call per range
+void gl_set_multi_draw(bool enabled);
+
+const GlRenderStats* gl_render_stats(void);
+
+// Render the skybox, uploading its static geometry on first use
+void render_skybox(VoxelWorld* world);
+
+// Delete the shared chunk buffer and the sky's buffers; call with the GL
+// context current, before cleanup_voxel_world
+void release_chunk_buffers(VoxelWorld* world);
+
+// The OpenGL backend, drawing into the current context with the functions
+// above. The sky is cleared and drawn by begin_frame.
+Renderer* gl_renderer_get(void);
+
+#endif // RENDER_GL_H
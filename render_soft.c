@@ -0,0 +1,655 @@
+#include "render_soft.h"
+#include "chunk_mesh.h"
+#include "job_system.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SUBPIXEL_BITS 8  // Fractional bits of fixed-point screen positions
+#define SUBPIXEL_SCALE (1 << SUBPIXEL_BITS)
+#define MAX_CLIP_VERTICES 9  // A triangle clipped by all six planes, a vertex more per plane
+#define CLIP_PLANES 6
+
+// Vertex in clip space, with its colour in 0..255
+typedef struct {
+    float x, y, z, w;
+    float r, g, b;
+} ClipVertex;
+
+// Vertex in screen space: pixels with y down, depth in [0, 1], and the
+// colour divided by w for perspective-correct interpolation
+typedef struct {
+    float x, y, z;
+    float inv_w;
+    float r, g, b;
+} ScreenVertex;
+
+enum { PLANE_DEPTH, PLANE_INV_W, PLANE_R, PLANE_G, PLANE_B, PLANE_COUNT };
+
+// A triangle ready to fill. Coverage uses fixed-point edge functions,
+// E(x, y) = a*x + b*y + c in subpixels, with the top-left fill rule folded
+// into c so a pixel is inside when all three are >= 0. The other values are
+// planes over pixel coordinates: value = p[0] * x + p[1] * y + p[2].
+typedef struct {
+    int64_t edge_a[3], edge_b[3], edge_c[3];
+    int min_x, min_y, max_x, max_y;  // Pixel bounds, inclusive
+    float plane[PLANE_COUNT][3];
+} SoftTriangle;
+
+// Indices of one slice's triangles that touch a tile, in draw order
+typedef struct {
+    uint32_t* items;
+    int count;
+    int capacity;
+} TileBin;
+
+// Work of one thread: a contiguous run of the draw list's triangles, set up
+// and binned, then some of the tiles
+typedef struct {
+    SoftTriangle* triangles;
+    int triangle_count;
+    int triangle_capacity;
+    TileBin* bins;  // One per tile
+    long first_triangle;
+    long end_triangle;
+    long triangles_submitted;
+    long triangles_drawn;
+    long pixels_written;
+} SoftSlice;
+
+typedef struct SoftRenderer SoftRenderer;
+
+typedef struct {
+    SoftRenderer* soft;
+    int index;
+} SliceTask;
+
+struct SoftRenderer {
+    Renderer base;
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+    uint32_t* color;
+    float* depth;
+    uint32_t clear_color;
+    bool needs_clear;  // No draw since begin_frame; the raster pass clears each tile first
+    float clip[16];  // Projection * view, column-major
+    const DrawList* list;  // Being drawn
+    long* item_triangles;  // Triangles before each item of the list, then the total
+    int item_capacity;
+    int thread_count;
+    JobSystem* jobs;  // thread_count - 1 workers; the calling thread takes the first slice
+    SoftSlice slices[SOFT_MAX_THREADS];
+    SliceTask tasks[SOFT_MAX_THREADS];
+    atomic_int next_tile;
+    SoftFrameStats stats;
+};
+
+static long elapsed_ns(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000L + (now.tv_nsec - start->tv_nsec);
+}
+
+static inline int min_int(int a, int b) {
+    return a < b ? a : b;
+}
+
+static inline int max_int(int a, int b) {
+    return a > b ? a : b;
+}
+
+// Run `func` once per slice, the first on the calling thread, and wait for all
+static void run_slices(SoftRenderer* soft, JobFunc func) {
+    for (int i = 1; i < soft->thread_count; i++) {
+        job_system_submit(soft->jobs, func, &soft->tasks[i]);
+    }
+    func(&soft->tasks[0]);
+    if (soft->thread_count > 1) job_system_wait_idle(soft->jobs);
+}
+
+// ---------------------------------------------------------------------------
+// Geometry
+
+// Signed distance of a vertex inside each clip plane: -x, +x, -y, +y, near, far
+static inline float plane_distance(const ClipVertex* v, int plane) {
+    switch (plane) {
+        case 0: return v->w + v->x;
+        case 1: return v->w - v->x;
+        case 2: return v->w + v->y;
+        case 3: return v->w - v->y;
+        case 4: return v->w + v->z;
+        default: return v->w - v->z;
+    }
+}
+
+static inline unsigned int outcode(const ClipVertex* v) {
+    unsigned int code = 0;
+    for (int plane = 0; plane < CLIP_PLANES; plane++) {
+        if (plane_distance(v, plane) < 0.0f) code |= 1u << plane;
+    }
+    return code;
+}
+
+static inline ClipVertex lerp_vertex(const ClipVertex* a, const ClipVertex* b, float t) {
+    return (ClipVertex){a->x + (b->x - a->x) * t, a->y + (b->y - a->y) * t, a->z + (b->z - a->z) * t,
+                        a->w + (b->w - a->w) * t, a->r + (b->r - a->r) * t, a->g + (b->g - a->g) * t,
+                        a->b + (b->b - a->b) * t};
+}
+
+// Clip a convex polygon against the planes in `planes` (Sutherland-Hodgman);
+// returns the new vertex count
+static int clip_polygon(ClipVertex* polygon, int count, unsigned int planes) {
+    ClipVertex scratch[MAX_CLIP_VERTICES];
+    ClipVertex* in = polygon;
+    ClipVertex* out = scratch;
+    for (int plane = 0; plane < CLIP_PLANES && count >= 3; plane++) {
+        if (!(planes & (1u << plane))) continue;
+        int out_count = 0;
+        for (int i = 0; i < count; i++) {
+            const ClipVertex* a = &in[i];
+            const ClipVertex* b = &in[(i + 1) % count];
+            float da = plane_distance(a, plane), db = plane_distance(b, plane);
+            if (da >= 0.0f) out[out_count++] = *a;
+            if ((da >= 0.0f) != (db >= 0.0f)) out[out_count++] = lerp_vertex(a, b, da / (da - db));
+        }
+        ClipVertex* swap = in;
+        in = out;
+        out = swap;
+        count = out_count;
+    }
+    if (in != polygon) memcpy(polygon, in, sizeof(ClipVertex) * count);
+    return count;
+}
+
+static bool bin_append(TileBin* bin, uint32_t item) {
+    if (bin->count == bin->capacity) {
+        int capacity = bin->capacity ? bin->capacity * 2 : 64;
+        uint32_t* items = realloc(bin->items, sizeof(uint32_t) * capacity);
+        if (!items) return false;
+        bin->items = items;
+        bin->capacity = capacity;
+    }
+    bin->items[bin->count++] = item;
+    return true;
+}
+
+// Plane through three values at the vertices, over pixel coordinates; the
+// constant is moved to pixel centres
+static void attribute_plane(float plane[3], const float x[3], const float y[3], const float f[3], float area) {
+    float dx = ((f[1] - f[0]) * (y[2] - y[0]) - (f[2] - f[0]) * (y[1] - y[0])) / area;
+    float dy = ((f[2] - f[0]) * (x[1] - x[0]) - (f[1] - f[0]) * (x[2] - x[0])) / area;
+    plane[0] = dx;
+    plane[1] = dy;
+    plane[2] = f[0] - dx * x[0] - dy * y[0] + 0.5f * (dx + dy);
+}
+
+// Snap a triangle to the subpixel grid, set it up and bin it to the tiles
+// its bounds touch. The vertices wind with positive area in y-down space.
+static void setup_triangle(SoftRenderer* soft, SoftSlice* slice, const ScreenVertex* v0, const ScreenVertex* v1,
+                           const ScreenVertex* v2) {
+    const ScreenVertex* v[3] = {v0, v1, v2};
+    int64_t sx[3], sy[3];
+    for (int i = 0; i < 3; i++) {
+        sx[i] = lrintf(v[i]->x * SUBPIXEL_SCALE);
+        sy[i] = lrintf(v[i]->y * SUBPIXEL_SCALE);
+    }
+    int64_t area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+    if (area <= 0) return;  // Degenerate once snapped
+
+    if (slice->triangle_count == slice->triangle_capacity) {
+        int capacity = slice->triangle_capacity ? slice->triangle_capacity * 2 : 1024;
+        SoftTriangle* triangles = realloc(slice->triangles, sizeof(SoftTriangle) * capacity);
+        if (!triangles) return;
+        slice->triangles = triangles;
+        slice->triangle_capacity = capacity;
+    }
+    SoftTriangle* triangle = &slice->triangles[slice->triangle_count];
+
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        int64_t a = sy[i] - sy[j], b = sx[j] - sx[i];
+        int64_t c = -(a * sx[i] + b * sy[i]);
+        // Pixels exactly on an edge belong to it only if it is a left edge
+        // (going up) or a top edge (flat, going right)
+        bool top_left = a > 0 || (a == 0 && b > 0);
+        triangle->edge_a[i] = a;
+        triangle->edge_b[i] = b;
+        triangle->edge_c[i] = top_left ? c : c - 1;
+    }
+
+    int64_t min_x = sx[0], max_x = sx[0], min_y = sy[0], max_y = sy[0];
+    for (int i = 1; i < 3; i++) {
+        if (sx[i] < min_x) min_x = sx[i];
+        if (sx[i] > max_x) max_x = sx[i];
+        if (sy[i] < min_y) min_y = sy[i];
+        if (sy[i] > max_y) max_y = sy[i];
+    }
+    triangle->min_x = max_int((int)(min_x >> SUBPIXEL_BITS), 0);
+    triangle->min_y = max_int((int)(min_y >> SUBPIXEL_BITS), 0);
+    triangle->max_x = min_int((int)(max_x >> SUBPIXEL_BITS), soft->width - 1);
+    triangle->max_y = min_int((int)(max_y >> SUBPIXEL_BITS), soft->height - 1);
+    if (triangle->min_x > triangle->max_x || triangle->min_y > triangle->max_y) return;
+
+    float x[3], y[3];
+    for (int i = 0; i < 3; i++) {
+        x[i] = (float)sx[i] / SUBPIXEL_SCALE;
+        y[i] = (float)sy[i] / SUBPIXEL_SCALE;
+    }
+    float area_pixels = (float)area / (SUBPIXEL_SCALE * SUBPIXEL_SCALE);
+    float values[PLANE_COUNT][3];
+    for (int i = 0; i < 3; i++) {
+        values[PLANE_DEPTH][i] = v[i]->z;
+        values[PLANE_INV_W][i] = v[i]->inv_w;
+        values[PLANE_R][i] = v[i]->r;
+        values[PLANE_G][i] = v[i]->g;
+        values[PLANE_B][i] = v[i]->b;
+    }
+    for (int p = 0; p < PLANE_COUNT; p++) {
+        attribute_plane(triangle->plane[p], x, y, values[p], area_pixels);
+    }
+
+    uint32_t index = (uint32_t)slice->triangle_count++;
+    slice->triangles_drawn++;
+    for (int ty = triangle->min_y / SOFT_TILE_SIZE; ty <= triangle->max_y / SOFT_TILE_SIZE; ty++) {
+        for (int tx = triangle->min_x / SOFT_TILE_SIZE; tx <= triangle->max_x / SOFT_TILE_SIZE; tx++) {
+            bin_append(&slice->bins[ty * soft->tiles_x + tx], index);
+        }
+    }
+}
+
+// Decode one triangle, transform it, clip it, drop it if it faces away,
+// and fan what is left of it into triangles
+static void process_triangle(SoftRenderer* soft, SoftSlice* slice, const PackedVertex* triangle,
+                             const float offset[4]) {
+    const float* m = soft->clip;
+    ClipVertex polygon[MAX_CLIP_VERTICES];
+    unsigned int all_outside = ~0u, any_outside = 0;
+    for (int i = 0; i < 3; i++) {
+        MeshVertex in;
+        chunk_mesh_decode_vertex(&triangle[i], &in);
+        ClipVertex* out = &polygon[i];
+        out->x = m[0] * in.x + m[4] * in.y + m[8] * in.z + m[12] + offset[0];
+        out->y = m[1] * in.x + m[5] * in.y + m[9] * in.z + m[13] + offset[1];
+        out->z = m[2] * in.x + m[6] * in.y + m[10] * in.z + m[14] + offset[2];
+        out->w = m[3] * in.x + m[7] * in.y + m[11] * in.z + m[15] + offset[3];
+        out->r = in.r;
+        out->g = in.g;
+        out->b = in.b;
+        unsigned int code = outcode(out);
+        all_outside &= code;
+        any_outside |= code;
+    }
+    if (all_outside) return;
+    int count = any_outside ? clip_polygon(polygon, 3, any_outside) : 3;
+    if (count < 3) return;
+
+    ScreenVertex screen[MAX_CLIP_VERTICES];
+    for (int i = 0; i < count; i++) {
+        float inv_w = 1.0f / polygon[i].w;
+        screen[i].x = (polygon[i].x * inv_w * 0.5f + 0.5f) * soft->width;
+        screen[i].y = (0.5f - polygon[i].y * inv_w * 0.5f) * soft->height;
+        screen[i].z = polygon[i].z * inv_w * 0.5f + 0.5f;
+        screen[i].inv_w = inv_w;
+        screen[i].r = polygon[i].r * inv_w;
+        screen[i].g = polygon[i].g * inv_w;
+        screen[i].b = polygon[i].b * inv_w;
+    }
+
+    // Front faces wind counter-clockwise with y up, so clockwise (negative
+    // area) with y down
+    float area = 0.0f;
+    for (int i = 0; i < count; i++) {
+        const ScreenVertex* a = &screen[i];
+        const ScreenVertex* b = &screen[(i + 1) % count];
+        area += a->x * b->y - b->x * a->y;
+    }
+    if (area >= 0.0f) return;
+
+    for (int i = 1; i + 1 < count; i++) {
+        setup_triangle(soft, slice, &screen[0], &screen[i + 1], &screen[i]);
+    }
+}
+
+// Set up and bin this slice's share of the draw list's triangles
+static void geometry_job(void* data) {
+    PROFILE_ZONE("soft_geometry");
+    SliceTask* task = data;
+    SoftRenderer* soft = task->soft;
+    SoftSlice* slice = &soft->slices[task->index];
+    const DrawList* list = soft->list;
+    const float* m = soft->clip;
+
+    // First item holding one of this slice's triangles
+    int lo = 0, hi = list->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (soft->item_triangles[mid + 1] <= slice->first_triangle) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (int i = lo; i < list->count && soft->item_triangles[i] < slice->end_triangle; i++) {
+        const DrawItem* item = &list->items[i];
+        const Chunk* chunk = item->chunk;
+
+        // The chunk's translation, already through the clip matrix
+        float tx = (float)(chunk->world_x * CHUNK_SIZE), tz = (float)(chunk->world_z * CHUNK_SIZE);
+        float offset[4];
+        for (int k = 0; k < 4; k++) offset[k] = m[k] * tx + m[8 + k] * tz;
+
+        long item_first = soft->item_triangles[i], item_end = soft->item_triangles[i + 1];
+        long first = slice->first_triangle > item_first ? slice->first_triangle - item_first : 0;
+        long end = (item_end < slice->end_triangle ? item_end : slice->end_triangle) - item_first;
+        const PackedVertex* vertices = chunk->mesh.vertices + item->first_vertex;
+        for (long t = first; t < end; t++) {
+            process_triangle(soft, slice, vertices + t * 3, offset);
+        }
+        slice->triangles_submitted += end - first;
+    }
+    PROFILE_COUNT("soft_triangles", slice->triangles_drawn);
+}
+
+// ---------------------------------------------------------------------------
+// Raster
+
+static inline uint32_t pack_color(float r, float g, float b) {
+    int ri = (int)(r + 0.5f), gi = (int)(g + 0.5f), bi = (int)(b + 0.5f);
+    ri = ri < 0 ? 0 : ri > 255 ? 255 : ri;
+    gi = gi < 0 ? 0 : gi > 255 ? 255 : gi;
+    bi = bi < 0 ? 0 : bi > 255 ? 255 : bi;
+    return 0xFF000000u | (uint32_t)bi << 16 | (uint32_t)gi << 8 | (uint32_t)ri;
+}
+
+// Fill the part of a triangle inside [x0, x1] x [y0, y1]; returns the
+// pixels that passed the depth test
+static long fill_triangle(SoftRenderer* soft, const SoftTriangle* t, int x0, int y0, int x1, int y1) {
+    int min_x = max_int(t->min_x, x0), max_x = min_int(t->max_x, x1);
+    int min_y = max_int(t->min_y, y0), max_y = min_int(t->max_y, y1);
+    if (min_x > max_x || min_y > max_y) return 0;
+
+    int64_t px = (int64_t)min_x * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+    int64_t py = (int64_t)min_y * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+    int64_t row[3], step_x[3], step_y[3];
+    for (int i = 0; i < 3; i++) {
+        row[i] = t->edge_a[i] * px + t->edge_b[i] * py + t->edge_c[i];
+        step_x[i] = t->edge_a[i] * SUBPIXEL_SCALE;
+        step_y[i] = t->edge_b[i] * SUBPIXEL_SCALE;
+    }
+    const float (*p)[3] = t->plane;
+
+    long written = 0;
+    for (int y = min_y; y <= max_y; y++) {
+        int64_t e0 = row[0], e1 = row[1], e2 = row[2];
+        uint32_t* color = soft->color + (size_t)y * soft->width;
+        float* depth = soft->depth + (size_t)y * soft->width;
+        for (int x = min_x; x <= max_x; x++) {
+            if ((e0 | e1 | e2) >= 0) {
+                float z = p[PLANE_DEPTH][0] * x + p[PLANE_DEPTH][1] * y + p[PLANE_DEPTH][2];
+                if (z < depth[x]) {
+                    float w = 1.0f / (p[PLANE_INV_W][0] * x + p[PLANE_INV_W][1] * y + p[PLANE_INV_W][2]);
+                    float r = (p[PLANE_R][0] * x + p[PLANE_R][1] * y + p[PLANE_R][2]) * w;
+                    float g = (p[PLANE_G][0] * x + p[PLANE_G][1] * y + p[PLANE_G][2]) * w;
+                    float b = (p[PLANE_B][0] * x + p[PLANE_B][1] * y + p[PLANE_B][2]) * w;
+                    depth[x] = z;
+                    color[x] = pack_color(r, g, b);
+                    written++;
+                }
+            }
+            e0 += step_x[0];
+            e1 += step_x[1];
+            e2 += step_x[2];
+        }
+        row[0] += step_y[0];
+        row[1] += step_y[1];
+        row[2] += step_y[2];
+    }
+    return written;
+}
+
+// Take tiles until none are left; clear each if the frame is new, then fill
+// every slice's triangles binned to it, slice by slice
+static void raster_job(void* data) {
+    PROFILE_ZONE("soft_raster");
+    SliceTask* task = data;
+    SoftRenderer* soft = task->soft;
+    SoftSlice* own = &soft->slices[task->index];
+    int tile_count = soft->tiles_x * soft->tiles_y;
+    for (;;) {
+        int tile = atomic_fetch_add(&soft->next_tile, 1);
+        if (tile >= tile_count) break;
+        int x0 = (tile % soft->tiles_x) * SOFT_TILE_SIZE, y0 = (tile / soft->tiles_x) * SOFT_TILE_SIZE;
+        int x1 = min_int(x0 + SOFT_TILE_SIZE, soft->width) - 1, y1 = min_int(y0 + SOFT_TILE_SIZE, soft->height) - 1;
+        if (soft->needs_clear) {
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    soft->color[(size_t)y * soft->width + x] = soft->clear_color;
+                    soft->depth[(size_t)y * soft->width + x] = 1.0f;
+                }
+            }
+        }
+        for (int s = 0; s < soft->thread_count; s++) {
+            const SoftSlice* slice = &soft->slices[s];
+            const TileBin* bin = &slice->bins[tile];
+            for (int i = 0; i < bin->count; i++) {
+                own->pixels_written += fill_triangle(soft, &slice->triangles[bin->items[i]], x0, y0, x1, y1);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Backend
+
+static void soft_begin_frame(Renderer* renderer, VoxelWorld* world, const Camera* camera,
+                             const Projection* projection) {
+    SoftRenderer* soft = (SoftRenderer*)renderer;
+    float view[16], project[16];
+    camera_view_matrix(camera, view);
+    projection_matrix(projection, project);
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) sum += project[k * 4 + row] * view[col * 4 + k];
+            soft->clip[col * 4 + row] = sum;
+        }
+    }
+    const Color* sky = &world->skybox.sky_color;
+    soft->clear_color = pack_color(sky->r * 255.0f, sky->g * 255.0f, sky->b * 255.0f);
+    soft->needs_clear = true;
+    soft->stats = (SoftFrameStats){0};
+}
+
+// The meshes stay in the chunks; uploading only records which ranges to draw
+static void soft_upload(Renderer* renderer, VoxelWorld* world) {
+    (void)renderer;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            if (!chunk->is_loaded || !chunk->vbo_stale) continue;
+            chunk->vbo_vertex_count = chunk->mesh.vertex_count;
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                chunk->vbo_section_first[s] = chunk->mesh.section_first[s];
+                chunk->vbo_section_count[s] = chunk->mesh.section_vertex_count[s];
+            }
+            chunk->vbo_stale = false;
+            world->stats.uploads++;
+        }
+    }
+}
+
+static void soft_draw(Renderer* renderer, const DrawList* list) {
+    PROFILE_ZONE("soft_draw");
+    SoftRenderer* soft = (SoftRenderer*)renderer;
+    if (list->count + 1 > soft->item_capacity) {
+        long* item_triangles = realloc(soft->item_triangles, sizeof(long) * (list->count + 1));
+        if (!item_triangles) return;
+        soft->item_triangles = item_triangles;
+        soft->item_capacity = list->count + 1;
+    }
+    soft->item_triangles[0] = 0;
+    for (int i = 0; i < list->count; i++) {
+        soft->item_triangles[i + 1] = soft->item_triangles[i] + list->items[i].vertex_count / 3;
+    }
+    long triangle_total = soft->item_triangles[list->count];
+    soft->list = list;
+
+    int tile_count = soft->tiles_x * soft->tiles_y;
+    for (int i = 0; i < soft->thread_count; i++) {
+        SoftSlice* slice = &soft->slices[i];
+        slice->triangle_count = 0;
+        for (int t = 0; t < tile_count; t++) slice->bins[t].count = 0;
+        slice->first_triangle = triangle_total * i / soft->thread_count;
+        slice->end_triangle = triangle_total * (i + 1) / soft->thread_count;
+        slice->triangles_submitted = 0;
+        slice->triangles_drawn = 0;
+        slice->pixels_written = 0;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_slices(soft, geometry_job);
+    long geometry_ns = elapsed_ns(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    atomic_store(&soft->next_tile, 0);
+    run_slices(soft, raster_job);
+    long raster_ns = elapsed_ns(&start);
+    soft->needs_clear = false;
+    soft->list = NULL;
+
+    for (int i = 0; i < soft->thread_count; i++) {
+        soft->stats.triangles_submitted += soft->slices[i].triangles_submitted;
+        soft->stats.triangles_drawn += soft->slices[i].triangles_drawn;
+        soft->stats.pixels_written += soft->slices[i].pixels_written;
+    }
+    soft->stats.geometry_ns += geometry_ns;
+    soft->stats.raster_ns += raster_ns;
+    soft->stats.frame_ns += geometry_ns + raster_ns;
+}
+
+static void soft_release(Renderer* renderer, VoxelWorld* world) {
+    (void)renderer;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            chunk->vbo_vertex_count = 0;
+            chunk->vbo_stale = chunk->is_loaded;
+        }
+    }
+}
+
+static void soft_destroy(Renderer* renderer) {
+    SoftRenderer* soft = (SoftRenderer*)renderer;
+    if (soft->jobs) job_system_destroy(soft->jobs);
+    int tile_count = soft->tiles_x * soft->tiles_y;
+    for (int i = 0; i < soft->thread_count; i++) {
+        SoftSlice* slice = &soft->slices[i];
+        if (slice->bins) {
+            for (int t = 0; t < tile_count; t++) free(slice->bins[t].items);
+        }
+        free(slice->bins);
+        free(slice->triangles);
+    }
+    free(soft->item_triangles);
+    free(soft->color);
+    free(soft->depth);
+    free(soft);
+}
+
+static const RendererOps soft_ops = {
+    soft_begin_frame,
+    soft_upload,
+    soft_draw,
+    soft_release,
+    soft_destroy,
+};
+
+Renderer* soft_renderer_create(int width, int height, int thread_count) {
+    if (width <= 0 || height <= 0) return NULL;
+    if (thread_count <= 0) thread_count = job_system_core_count();
+    if (thread_count > SOFT_MAX_THREADS) thread_count = SOFT_MAX_THREADS;
+
+    SoftRenderer* soft = calloc(1, sizeof(SoftRenderer));
+    if (!soft) return NULL;
+    soft->base.ops = &soft_ops;
+    soft->base.name = "software";
+    soft->width = width;
+    soft->height = height;
+    soft->tiles_x = (width + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    soft->tiles_y = (height + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    soft->thread_count = thread_count;
+    soft->color = malloc(sizeof(uint32_t) * width * height);
+    soft->depth = malloc(sizeof(float) * width * height);
+    bool ok = soft->color && soft->depth;
+    for (int i = 0; i < thread_count && ok; i++) {
+        soft->slices[i].bins = calloc(soft->tiles_x * soft->tiles_y, sizeof(TileBin));
+        soft->tasks[i] = (SliceTask){soft, i};
+        ok = soft->slices[i].bins != NULL;
+    }
+    if (ok && thread_count > 1) {
+        soft->jobs = job_system_create(thread_count - 1);
+        ok = soft->jobs != NULL;
+    }
+    if (!ok) {
+        soft_destroy(&soft->base);
+        return NULL;
+    }
+    for (int i = 0; i < width * height; i++) {
+        soft->color[i] = 0xFF000000u;
+        soft->depth[i] = 1.0f;
+    }
+    return &soft->base;
+}
+
+const uint32_t* soft_renderer_pixels(const Renderer* renderer, int* width, int* height) {
+    const SoftRenderer* soft = (const SoftRenderer*)renderer;
+    *width = soft->width;
+    *height = soft->height;
+    return soft->color;
+}
+
+const SoftFrameStats* soft_renderer_stats(const Renderer* renderer) {
+    return &((const SoftRenderer*)renderer)->stats;
+}
+
+int soft_renderer_thread_count(const Renderer* renderer) {
+    return ((const SoftRenderer*)renderer)->thread_count;
+}
+
+uint64_t soft_renderer_hash(const Renderer* renderer) {
+    const SoftRenderer* soft = (const SoftRenderer*)renderer;
+    uint64_t hash = 14695981039346656037ull;
+    for (long i = 0; i < (long)soft->width * soft->height; i++) {
+        for (int channel = 0; channel < 3; channel++) {
+            hash = (hash ^ ((soft->color[i] >> (channel * 8)) & 0xFF)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool soft_renderer_write_ppm(const Renderer* renderer, const char* path) {
+    const SoftRenderer* soft = (const SoftRenderer*)renderer;
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    fprintf(file, "P6\n%d %d\n255\n", soft->width, soft->height);
+    unsigned char* row = malloc((size_t)soft->width * 3);
+    bool ok = row != NULL;
+    for (int y = 0; y < soft->height && ok; y++) {
+        for (int x = 0; x < soft->width; x++) {
+            uint32_t pixel = soft->color[(size_t)y * soft->width + x];
+            row[x * 3 + 0] = pixel & 0xFF;
+            row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+            row[x * 3 + 2] = (pixel >> 16) & 0xFF;
+        }
+        ok = fwrite(row, 3, soft->width, file) == (size_t)soft->width;
+    }
+    free(row);
+    return fclose(file) == 0 && ok;
+}
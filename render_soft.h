@@ -0,0 +1,51 @@
+#ifndef RENDER_SOFT_H
+#define RENDER_SOFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "renderer.h"
+
+#define SOFT_TILE_SIZE 64  // Pixels per side of a raster tile
+#define SOFT_MAX_THREADS 64
+
+// Multithreaded tiled software rasterizer. Chunk triangles are decoded,
+// transformed, clipped and back-face culled in parallel slices of the draw
+// list, and the triangles binned to screen tiles; each tile is then cleared and filled by
+// one thread, depth-tested, with vertex colours interpolated perspective
+// correctly. Only the chunk meshes are drawn: the sky is the clear colour
+// and the GL lighting and fog are not modelled.
+//
+// Triangles reach each tile in draw-list order whatever the thread count,
+// so a frame comes out identical on any number of threads.
+
+// Counters and timings of the last frame
+typedef struct {
+    long triangles_submitted;  // Triangles in the draw list
+    long triangles_drawn;  // Left after clipping and culling, counting clipped pieces
+    long pixels_written;  // Fragments that passed the depth test
+    long geometry_ns;  // Transform, clip, set up and bin
+    long raster_ns;  // Clear and fill the tiles
+    long frame_ns;  // Both, for every draw since begin_frame
+} SoftFrameStats;
+
+// Create a software backend drawing into a width x height frame on
+// `thread_count` threads; 0 picks one per core and 1 draws on the calling
+// thread. Returns NULL if the frame could not be allocated.
+Renderer* soft_renderer_create(int width, int height, int thread_count);
+
+// Only valid on renderers from soft_renderer_create:
+
+// Pixels of the frame, top row first, as 0xAABBGGRR
+const uint32_t* soft_renderer_pixels(const Renderer* renderer, int* width, int* height);
+
+const SoftFrameStats* soft_renderer_stats(const Renderer* renderer);
+
+int soft_renderer_thread_count(const Renderer* renderer);
+
+// FNV-1a hash of the frame's colours, for comparing frames
+uint64_t soft_renderer_hash(const Renderer* renderer);
+
+// Write the frame as a binary PPM; returns false on failure
+bool soft_renderer_write_ppm(const Renderer* renderer, const char* path);
+
+#endif // RENDER_SOFT_H
@@ -0,0 +1,55 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "voxel_world.h"
+#include "camera.h"
+#include "draw_list.h"
+
+// A render backend. The game draws through OpenGL (render_gl.c); the
+// software rasterizer (render_soft.c) draws the same chunk meshes and camera
+// into memory, for machines without a GPU. A frame is begin_frame, upload,
+// then draw for each draw list.
+//
+// Backends embed a Renderer as their first member and cast back from it.
+typedef struct Renderer Renderer;
+
+typedef struct {
+    // Clear the frame to the sky and set up the camera
+    void (*begin_frame)(Renderer* renderer, VoxelWorld* world, const Camera* camera, const Projection* projection);
+    // Take the chunk meshes rebuilt since the last upload
+    void (*upload)(Renderer* renderer, VoxelWorld* world);
+    // Draw the sections collected by draw_list_build
+    void (*draw)(Renderer* renderer, const DrawList* list);
+    // Drop everything held for the world's chunks, before cleanup_voxel_world
+    void (*release)(Renderer* renderer, VoxelWorld* world);
+    // Free the backend itself
+    void (*destroy)(Renderer* renderer);
+} RendererOps;
+
+struct Renderer {
+    const RendererOps* ops;
+    const char* name;
+};
+
+static inline void renderer_begin_frame(Renderer* renderer, VoxelWorld* world, const Camera* camera,
+                                        const Projection* projection) {
+    renderer->ops->begin_frame(renderer, world, camera, projection);
+}
+
+static inline void renderer_upload(Renderer* renderer, VoxelWorld* world) {
+    renderer->ops->upload(renderer, world);
+}
+
+static inline void renderer_draw(Renderer* renderer, const DrawList* list) {
+    renderer->ops->draw(renderer, list);
+}
+
+static inline void renderer_release(Renderer* renderer, VoxelWorld* world) {
+    renderer->ops->release(renderer, world);
+}
+
+static inline void renderer_destroy(Renderer* renderer) {
+    if (renderer) renderer->ops->destroy(renderer);
+}
+
+#endif // RENDERER_H
@@ -0,0 +1,115 @@
+#include "vertex_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Insert a free range at `index`, growing the list if needed
+static bool insert_free(VertexArena* arena, int index, int first, int count) {
+    if (arena->free_count == arena->free_capacity) {
+        int capacity = arena->free_capacity ? arena->free_capacity * 2 : 64;
+        ArenaRange* ranges = realloc(arena->free_ranges, capacity * sizeof(ArenaRange));
+        if (!ranges) return false;
+        arena->free_ranges = ranges;
+        arena->free_capacity = capacity;
+    }
+    memmove(&arena->free_ranges[index + 1], &arena->free_ranges[index],
+            (arena->free_count - index) * sizeof(ArenaRange));
+    arena->free_ranges[index] = (ArenaRange){first, count};
+    arena->free_count++;
+    return true;
+}
+
+static void remove_free(VertexArena* arena, int index) {
+    memmove(&arena->free_ranges[index], &arena->free_ranges[index + 1],
+            (arena->free_count - index - 1) * sizeof(ArenaRange));
+    arena->free_count--;
+}
+
+bool vertex_arena_init(VertexArena* arena, int capacity) {
+    *arena = (VertexArena){0};
+    arena->capacity = capacity;
+    return capacity <= 0 || insert_free(arena, 0, 0, capacity);
+}
+
+void vertex_arena_destroy(VertexArena* arena) {
+    free(arena->free_ranges);
+    *arena = (VertexArena){0};
+}
+
+void vertex_arena_reset(VertexArena* arena, int capacity) {
+    arena->free_count = 0;
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->allocations = 0;
+    if (capacity > 0) insert_free(arena, 0, 0, capacity);
+}
+
+int vertex_arena_alloc(VertexArena* arena, int count) {
+    if (count <= 0) return -1;
+
+    // Best fit keeps the large ranges whole for large meshes
+    int best = -1;
+    for (int i = 0; i < arena->free_count; i++) {
+        int size = arena->free_ranges[i].count;
+        if (size >= count && (best < 0 || size < arena->free_ranges[best].count)) {
+            best = i;
+            if (size == count) break;
+        }
+    }
+    if (best < 0) return -1;
+
+    ArenaRange* range = &arena->free_ranges[best];
+    int first = range->first;
+    range->first += count;
+    range->count -= count;
+    if (range->count == 0) remove_free(arena, best);
+    arena->used += count;
+    arena->allocations++;
+    return first;
+}
+
+void vertex_arena_free(VertexArena* arena, int first, int count) {
+    if (count <= 0) return;
+    arena->used -= count;
+    arena->allocations--;
+
+    // First free range after the one being returned
+    int lo = 0, hi = arena->free_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (arena->free_ranges[mid].first < first) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    ArenaRange* before = lo > 0 ? &arena->free_ranges[lo - 1] : NULL;
+    ArenaRange* after = lo < arena->free_count ? &arena->free_ranges[lo] : NULL;
+    bool joins_before = before && before->first + before->count == first;
+    bool joins_after = after && first + count == after->first;
+
+    if (joins_before && joins_after) {
+        before->count += count + after->count;
+        remove_free(arena, lo);
+    } else if (joins_before) {
+        before->count += count;
+    } else if (joins_after) {
+        after->first = first;
+        after->count += count;
+    } else if (!insert_free(arena, lo, first, count)) {
+        arena->used += count;  // Out of memory: the range stays lost until the next reset
+    }
+}
+
+int vertex_arena_largest_free(const VertexArena* arena) {
+    int largest = 0;
+    for (int i = 0; i < arena->free_count; i++) {
+        if (arena->free_ranges[i].count > largest) largest = arena->free_ranges[i].count;
+    }
+    return largest;
+}
+
+float vertex_arena_fragmentation(const VertexArena* arena) {
+    int free_units = arena->capacity - arena->used;
+    if (free_units <= 0) return 0.0f;
+    return 1.0f - (float)vertex_arena_largest_free(arena) / free_units;
+}
@@ -0,0 +1,51 @@
+#ifndef VERTEX_ARENA_H
+#define VERTEX_ARENA_H
+
+#include <stdbool.h>
+
+// Sub-allocator for one large vertex buffer shared by every chunk. Ranges
+// are handed out best-fit from a free list kept sorted by position, and
+// freed ranges merge with their free neighbours. When no free range is big
+// enough the owner repacks: it resets the arena and allocates every live
+// range again from the start, leaving one free range at the end.
+//
+// Units are whatever the owner counts in (vertices for the renderer); the
+// arena never touches the buffer itself.
+
+typedef struct {
+    int first;
+    int count;
+} ArenaRange;
+
+typedef struct {
+    ArenaRange* free_ranges;  // Sorted by first; never adjacent
+    int free_count;
+    int free_capacity;
+    int capacity;  // Units in the buffer
+    int used;  // Units allocated
+    int allocations;
+} VertexArena;
+
+// Start an arena of `capacity` units, all free; false if out of memory
+bool vertex_arena_init(VertexArena* arena, int capacity);
+
+void vertex_arena_destroy(VertexArena* arena);
+
+// Forget every allocation and set a new capacity, as the first step of a
+// repack or a resize
+void vertex_arena_reset(VertexArena* arena, int capacity);
+
+// First unit of a new range of `count` units, or -1 if no free range fits
+int vertex_arena_alloc(VertexArena* arena, int count);
+
+// Return a range; it must have come from vertex_arena_alloc
+void vertex_arena_free(VertexArena* arena, int first, int count);
+
+// Size of the largest free range
+int vertex_arena_largest_free(const VertexArena* arena);
+
+// Share of the free space outside the largest free range: 0 when it is in
+// one piece, towards 1 as it splinters
+float vertex_arena_fragmentation(const VertexArena* arena);
+
+#endif // VERTEX_ARENA_H
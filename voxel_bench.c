@@ -0,0 +1,3508 @@
+// Headless benchmarks for the world library. Prints one JSON document;
+// every run with the same --seed does the same work, so numbers can be
+// compared across commits.
+//
+// usage: voxel_bench [--seed N] [--frames N] [--crossings N] [--trace FILE] [section ...]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "voxel_world.h"
+#include "chunk_mesh.h"
+#include "camera.h"
+#include "draw_list.h"
+#include "occlusion.h"
+#include "raycast.h"
+#include "occupancy.h"
+#include "lighting.h"
+#include "frame_timer.h"
+#include "profiler.h"
+#include "player.h"
+#include "render_soft.h"
+#include "chunk_arena.h"
+#include "world_edit.h"
+#include "noise.h"
+
+#define DEFAULT_FRAMES 600
+#define DEFAULT_CROSSINGS 64
+#define LEGACY_VIEW_DISTANCE DEFAULT_VIEW_DISTANCE
+#define LEGACY_CHUNK_COUNT (LEGACY_VIEW_DISTANCE * 2 + 1)
+#define JSON_MAX_DEPTH 16
+
+static unsigned int bench_seed = DEFAULT_WORLD_SEED;
+static int bench_frames = DEFAULT_FRAMES;
+static int bench_crossings = DEFAULT_CROSSINGS;
+static int bench_render_distance = DEFAULT_VIEW_DISTANCE;  // View distance of the software_render world
+static const char* bench_image_directory = NULL;  // Where software_render writes its frames, if anywhere
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Cheap deterministic random stream
+static unsigned int next_random(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// ---------------------------------------------------------------------------
+// JSON output
+
+static int json_depth;
+static bool json_first[JSON_MAX_DEPTH];
+
+// Separator, indentation and key for the next value
+static void json_key(const char* key) {
+    if (json_depth > 0) {
+        if (!json_first[json_depth]) printf(",");
+        printf("\n%*s", json_depth * 2, "");
+    }
+    json_first[json_depth] = false;
+    if (key) printf("\"%s\": ", key);
+}
+
+static void json_open(const char* key) {
+    json_key(key);
+    printf("{");
+    json_depth++;
+    json_first[json_depth] = true;
+}
+
+static void json_close(void) {
+    json_depth--;
+    printf("\n%*s}", json_depth * 2, "");
+    if (json_depth == 0) printf("\n");
+}
+
+static void json_int(const char* key, long value) {
+    json_key(key);
+    printf("%ld", value);
+}
+
+static void json_num(const char* key, double value) {
+    json_key(key);
+    printf("%.3f", value);
+}
+
+static void json_str(const char* key, const char* value) {
+    json_key(key);
+    printf("\"%s\"", value);
+}
+
+static void json_bool(const char* key, bool value) {
+    json_key(key);
+    printf("%s", value ? "true" : "false");
+}
+
+// ---------------------------------------------------------------------------
+// Timing samples
+
+typedef struct {
+    double* ns;
+    int count;
+    int capacity;
+} Timings;
+
+static void timings_add(Timings* timings, double ns) {
+    if (timings->count == timings->capacity) {
+        int capacity = timings->capacity ? timings->capacity * 2 : 256;
+        double* grown = realloc(timings->ns, capacity * sizeof(double));
+        if (!grown) return;
+        timings->ns = grown;
+        timings->capacity = capacity;
+    }
+    timings->ns[timings->count++] = ns;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double* sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+// Emit count/mean/p50/p99/max in nanoseconds and release the samples
+static void json_timings(const char* key, Timings* timings) {
+    json_open(key);
+    json_int("count", timings->count);
+    if (timings->count > 0) {
+        double total = 0.0;
+        for (int i = 0; i < timings->count; i++) total += timings->ns[i];
+        qsort(timings->ns, timings->count, sizeof(double), compare_doubles);
+        json_num("mean_ns", total / timings->count);
+        json_num("p50_ns", percentile(timings->ns, timings->count, 50.0));
+        json_num("p99_ns", percentile(timings->ns, timings->count, 99.0));
+        json_num("max_ns", timings->ns[timings->count - 1]);
+    }
+    json_close();
+    free(timings->ns);
+    *timings = (Timings){0};
+}
+
+static bool init_bench_world(VoxelWorld* world, int worker_count) {
+    WorldConfig config = default_world_config();
+    config.worker_count = worker_count;
+    config.seed = bench_seed;
+    if (!init_voxel_world_with_config(world, &config)) return false;
+    wait_for_chunk_loads(world);
+    return true;
+}
+
+// Mesh every chunk waiting for it, however many passes that takes
+static void drain_remesh_queue(VoxelWorld* world) {
+    while (process_remesh_queue(world, world->chunk_count * world->chunk_count) > 0) {
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scripted camera paths through update_chunks
+
+typedef enum {
+    PATH_STRAIGHT,  // Walk along +x
+    PATH_CIRCLE,  // Orbit the origin, crossing chunks on both axes
+    PATH_ZIGZAG,  // Sweep back and forth across one chunk boundary
+    PATH_COUNT
+} CameraPath;
+
+static const char* const path_names[PATH_COUNT] = {"straight", "circle", "zigzag"};
+
+static void camera_position(CameraPath path, int frame, float* x, float* z) {
+    const float speed = 0.5f;  // Blocks per frame
+    switch (path) {
+    case PATH_STRAIGHT:
+        *x = CHUNK_SIZE / 2 + frame * speed;
+        *z = CHUNK_SIZE / 2;
+        break;
+    case PATH_CIRCLE: {
+        const float radius = 3.0f * CHUNK_SIZE;
+        float angle = frame * speed / radius;
+        *x = cosf(angle) * radius;
+        *z = sinf(angle) * radius;
+        break;
+    }
+    default: {
+        // Triangle wave of amplitude one chunk around x = 0
+        float t = fmodf(frame * speed, 4.0f * CHUNK_SIZE);
+        *x = t < 2.0f * CHUNK_SIZE ? t - CHUNK_SIZE : 3.0f * CHUNK_SIZE - t;
+        *z = CHUNK_SIZE / 2;
+        break;
+    }
+    }
+}
+
+static void bench_camera_paths(void) {
+    static VoxelWorld world;
+
+    json_open("camera_paths");
+    json_int("frames", bench_frames);
+    for (int path = 0; path < PATH_COUNT; path++) {
+        // Inline generation so every frame does the same work on every run
+        if (!init_bench_world(&world, -1)) continue;
+        WorldStats start_stats = world.stats;
+        Timings frames = {0};
+
+        for (int frame = 0; frame < bench_frames; frame++) {
+            float x, z;
+            camera_position(path, frame, &x, &z);
+            double start = now_ns();
+            update_chunks(&world, x, z);
+            timings_add(&frames, now_ns() - start);
+        }
+
+        json_open(path_names[path]);
+        json_timings("update_chunks", &frames);
+        json_int("chunks_generated", world.stats.chunks_generated - start_stats.chunks_generated);
+        json_int("remeshes", world.stats.total_remeshes - start_stats.total_remeshes);
+        json_int("cache_hits", world.cache.stats.hits);
+        json_close();
+        cleanup_voxel_world(&world);
+    }
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Individual stages
+
+static void bench_stages(void) {
+    static VoxelWorld world;
+    const int batch = 1024;
+    const int batches = 512;
+
+    json_open("stages");
+
+    // Terrain generation, one chunk at a time
+    Timings generate = {0};
+    Chunk chunk = {0};
+    chunk_storage_init(&chunk.storage);
+    for (int i = 0; i < 256; i++) {
+        chunk.world_x = i % 16 - 8;
+        chunk.world_z = i / 16 - 8;
+        double start = now_ns();
+        generate_chunk_terrain(&chunk, bench_seed);
+        timings_add(&generate, now_ns() - start);
+    }
+    chunk_storage_free(&chunk.storage);
+    json_timings("generate_chunk_terrain", &generate);
+
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+
+    // Greedy meshing of every chunk in the window, with neighbours
+    Timings mesh = {0};
+    long quads = 0;
+    for (int x = 0; x < world.chunk_count; x++) {
+        for (int z = 0; z < world.chunk_count; z++) {
+            Chunk* target = chunk_at_slot(&world, x, z);
+            ChunkNeighbours neighbours = get_chunk_neighbours(&world, target);
+            double start = now_ns();
+            chunk_mesh_build(target, &neighbours, &target->mesh);
+            timings_add(&mesh, now_ns() - start);
+            quads += target->mesh.quad_count;
+        }
+    }
+    json_timings("chunk_mesh_build", &mesh);
+    json_int("mesh_quads", quads);
+
+    // Block access at random positions inside the window, timed per call
+    int span = world.chunk_count * CHUNK_SIZE;
+    int origin = -world.view_distance * CHUNK_SIZE;
+    Timings get = {0};
+    Timings set = {0};
+    unsigned int state = bench_seed;
+    long checksum = 0;
+    for (int b = 0; b < batches; b++) {
+        double start = now_ns();
+        for (int i = 0; i < batch; i++) {
+            unsigned int r = next_random(&state);
+            checksum += get_block(&world, origin + (int)(r % span), (int)((r >> 9) % WORLD_HEIGHT),
+                                  origin + (int)((r >> 14) % span));
+        }
+        timings_add(&get, (now_ns() - start) / batch);
+    }
+    for (int b = 0; b < batches; b++) {
+        double start = now_ns();
+        for (int i = 0; i < batch; i++) {
+            unsigned int r = next_random(&state);
+            set_block(&world, origin + (int)(r % span), (int)((r >> 9) % WORLD_HEIGHT),
+                      origin + (int)((r >> 14) % span), (unsigned char)(r % 3));
+        }
+        timings_add(&set, (now_ns() - start) / batch);
+    }
+    json_timings("get_block", &get);
+    json_timings("set_block", &set);
+    json_int("get_block_checksum", checksum);
+
+    // Remeshing everything those edits dirtied, one frame's budget at a time
+    Timings remesh = {0};
+    for (;;) {
+        double start = now_ns();
+        if (process_remesh_queue(&world, REMESH_BUDGET) == 0) break;
+        timings_add(&remesh, now_ns() - start);
+    }
+    json_timings("process_remesh_queue", &remesh);
+    cleanup_voxel_world(&world);
+
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Frustum culling
+
+// Projection used by the game window
+static const Projection bench_projection = {45.0f, 800.0f / 600.0f, 0.1f, 1000.0f};
+
+static bool chunk_visible(VoxelWorld* world, const Frustum* frustum, int chunk_x, int chunk_z) {
+    const Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+    return chunk && chunk_in_frustum(chunk, frustum);
+}
+
+static bool section_visible(int chunk_x, int chunk_z, int section, const Frustum* frustum) {
+    float min[3] = {chunk_x * CHUNK_SIZE, section * SECTION_HEIGHT, chunk_z * CHUNK_SIZE};
+    float max[3] = {min[0] + CHUNK_SIZE, min[1] + SECTION_HEIGHT, min[2] + CHUNK_SIZE};
+    return frustum_intersects_box(frustum, min, max);
+}
+
+// Known camera poses and the culling each one must produce
+static bool check_pose(VoxelWorld* world, int pose, const Frustum* frustum, const CullStats* stats) {
+    int vd = world->view_distance;
+    bool ok = true;
+    switch (pose) {
+    case 0:  // Looking along -z from the centre: everything with z > 0 is behind
+        for (int x = -vd; x <= vd; x++) {
+            for (int z = 1; z <= vd; z++) ok &= !chunk_visible(world, frustum, x, z);
+        }
+        ok &= chunk_visible(world, frustum, 0, 0) && chunk_visible(world, frustum, 0, -vd);
+        break;
+    case 1:  // Looking along +z: the mirror image
+        for (int x = -vd; x <= vd; x++) {
+            for (int z = -vd; z <= -1; z++) ok &= !chunk_visible(world, frustum, x, z);
+        }
+        ok &= chunk_visible(world, frustum, 0, 0) && chunk_visible(world, frustum, 0, vd);
+        break;
+    case 2:  // Looking straight down: only the chunks under the camera
+        ok &= chunk_visible(world, frustum, 0, 0);
+        ok &= !chunk_visible(world, frustum, vd, vd) && !chunk_visible(world, frustum, -vd, -vd);
+        ok &= stats->chunks_visible < stats->chunks_culled;
+        break;
+    case 3:  // Level, far above the terrain: the whole world is below the view
+        ok &= stats->chunks_visible == 0;
+        break;
+    default:  // Level, just above the terrain: nearby lower sections drop out
+        ok &= chunk_visible(world, frustum, 0, -2);
+        ok &= section_visible(0, -2, 1, frustum) && !section_visible(0, -2, 0, frustum);
+        ok &= stats->sections_culled > stats->chunks_culled * SECTIONS_PER_CHUNK;
+        break;
+    }
+    return ok;
+}
+
+static void bench_frustum_culling(void) {
+    static VoxelWorld world;
+    static const char* const pose_names[] = {
+        "look_neg_z", "look_pos_z", "look_down", "level_high_above", "level_above_terrain"
+    };
+    const Camera poses[] = {
+        {CHUNK_SIZE / 2, WORLD_HEIGHT * 0.75f, CHUNK_SIZE / 2, 0.0f, 0.0f},
+        {CHUNK_SIZE / 2, WORLD_HEIGHT * 0.75f, CHUNK_SIZE / 2, 0.0f, 180.0f},
+        {CHUNK_SIZE / 2, WORLD_HEIGHT + 10, CHUNK_SIZE / 2, -89.9f, 0.0f},
+        {CHUNK_SIZE / 2, 100.0f, CHUNK_SIZE / 2, 0.0f, 0.0f},
+        {CHUNK_SIZE / 2, WORLD_HEIGHT + 8, CHUNK_SIZE / 2, 0.0f, 0.0f},
+    };
+    const int pose_count = (int)(sizeof(poses) / sizeof(poses[0]));
+
+    if (!init_bench_world(&world, -1)) return;
+
+    // Mesh everything and record section ranges as an upload would
+    drain_remesh_queue(&world);
+    long total_vertices = 0;
+    for (int x = 0; x < world.chunk_count; x++) {
+        for (int z = 0; z < world.chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(&world, x, z);
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                chunk->vbo_section_first[s] = chunk->mesh.section_first[s];
+                chunk->vbo_section_count[s] = chunk->mesh.section_vertex_count[s];
+            }
+            total_vertices += chunk->mesh.vertex_count;
+        }
+    }
+
+    DrawList list = {0};
+    bool all_ok = true;
+    json_open("frustum_culling");
+    json_int("vertices_total", total_vertices);
+    for (int p = 0; p < pose_count; p++) {
+        Frustum frustum;
+        frustum_from_camera(&frustum, &poses[p], &bench_projection);
+        draw_list_build(&list, &world, &frustum, NULL);
+        long drawn = 0;
+        for (int i = 0; i < list.count; i++) drawn += list.items[i].vertex_count;
+        bool ok = check_pose(&world, p, &frustum, &list.stats);
+        all_ok &= ok;
+
+        json_open(pose_names[p]);
+        json_int("chunks_visible", list.stats.chunks_visible);
+        json_int("chunks_culled", list.stats.chunks_culled);
+        json_int("sections_visible", list.stats.sections_visible);
+        json_int("sections_culled", list.stats.sections_culled);
+        json_int("draw_items", list.count);
+        json_int("vertices_drawn", drawn);
+        json_bool("expected", ok);
+        json_close();
+    }
+
+    // Cost of extraction and the draw list while turning on the spot
+    Timings build = {0};
+    for (int frame = 0; frame < bench_frames; frame++) {
+        Camera camera = poses[0];
+        camera.pitch = -30.0f;
+        camera.yaw = frame * 360.0f / bench_frames;
+        double start = now_ns();
+        Frustum frustum;
+        frustum_from_camera(&frustum, &camera, &bench_projection);
+        draw_list_build(&list, &world, &frustum, NULL);
+        timings_add(&build, now_ns() - start);
+    }
+    json_timings("draw_list_build", &build);
+    json_bool("all_poses_expected", all_ok);
+    json_close();
+
+    draw_list_free(&list);
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Occlusion culling
+
+// Mesh every chunk in the window and record its section ranges as an upload
+// would; returns the total vertex count
+static long mesh_window(VoxelWorld* world) {
+    drain_remesh_queue(world);
+    long total_vertices = 0;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                chunk->vbo_section_first[s] = chunk->mesh.section_first[s];
+                chunk->vbo_section_count[s] = chunk->mesh.section_vertex_count[s];
+            }
+            total_vertices += chunk->mesh.vertex_count;
+        }
+    }
+    return total_vertices;
+}
+
+static long vertices_drawn(const DrawList* list) {
+    long drawn = 0;
+    for (int i = 0; i < list->count; i++) drawn += list->items[i].vertex_count;
+    return drawn;
+}
+
+// Boxes against a single wall in front of a camera at the origin looking along -z
+static bool check_wall_scene(OcclusionBuffer* buffer) {
+    const Camera camera = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    Frustum frustum;
+    frustum_from_camera(&frustum, &camera, &bench_projection);
+    occlusion_begin(buffer, &frustum);
+    const float wall_min[3] = {-2.0f, -2.0f, -10.0f};
+    const float wall_max[3] = {2.0f, 2.0f, -9.0f};
+    occlusion_add_box(buffer, wall_min, wall_max);
+
+    const float behind_min[3] = {-0.5f, -0.5f, -30.0f}, behind_max[3] = {0.5f, 0.5f, -29.0f};
+    const float front_min[3] = {-0.5f, -0.5f, -6.0f}, front_max[3] = {0.5f, 0.5f, -5.0f};
+    const float beside_min[3] = {6.0f, -0.5f, -30.0f}, beside_max[3] = {7.0f, 0.5f, -29.0f};
+    const float partial_min[3] = {1.0f, -0.5f, -30.0f}, partial_max[3] = {9.0f, 0.5f, -29.0f};
+    bool ok = !occlusion_box_visible(buffer, behind_min, behind_max);
+    ok &= occlusion_box_visible(buffer, front_min, front_max);
+    ok &= occlusion_box_visible(buffer, beside_min, beside_max);
+    ok &= occlusion_box_visible(buffer, partial_min, partial_max);
+
+    // A wall reaching past the near plane is not used, so nothing hides behind it
+    occlusion_begin(buffer, &frustum);
+    const float near_min[3] = {-2.0f, -2.0f, -1.0f};
+    const float near_max[3] = {2.0f, 2.0f, 1.0f};
+    occlusion_add_box(buffer, near_min, near_max);
+    ok &= occlusion_box_visible(buffer, behind_min, behind_max);
+    return ok;
+}
+
+// Build a solid wall filling chunk row z = -2 and check that every section
+// with geometry behind it is occluded while the wall itself is not
+static bool check_world_wall(VoxelWorld* world, OcclusionBuffer* buffer, DrawList* list, int* occluded) {
+    int origin = -world->view_distance * CHUNK_SIZE;
+    int span = world->chunk_count * CHUNK_SIZE;
+    for (int x = origin; x < origin + span; x++) {
+        for (int y = 0; y < WORLD_HEIGHT; y++) {
+            for (int z = -2 * CHUNK_SIZE; z < -CHUNK_SIZE; z++) set_block(world, x, y, z, 1);
+        }
+    }
+    mesh_window(world);
+
+    const Camera camera = {CHUNK_SIZE / 2, WORLD_HEIGHT * 0.6f, CHUNK_SIZE / 2, 0.0f, 0.0f};
+    Frustum frustum;
+    frustum_from_camera(&frustum, &camera, &bench_projection);
+    draw_list_build(list, world, &frustum, buffer);
+    *occluded = list->stats.sections_occluded;
+
+    bool ok = true;
+    for (int i = 0; i < list->count; i++) {
+        ok &= list->items[i].chunk->world_z >= -2;
+    }
+    const Chunk* wall = find_chunk(world, 0, -2);
+    float min[3] = {0.0f, 0.0f, -2.0f * CHUNK_SIZE};
+    float max[3] = {CHUNK_SIZE, WORLD_HEIGHT, -CHUNK_SIZE};
+    ok &= wall && occlusion_box_visible(buffer, min, max);
+
+    // Sections behind the wall with geometry must all have been dropped
+    int behind = 0;
+    for (int x = -world->view_distance; x <= world->view_distance; x++) {
+        for (int z = -world->view_distance; z <= -3; z++) {
+            const Chunk* chunk = find_chunk(world, x, z);
+            if (!chunk || !chunk_in_frustum(chunk, &frustum)) continue;
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                if (chunk->vbo_section_count[s] > 0) behind++;
+            }
+        }
+    }
+    ok &= behind > 0 && *occluded >= behind;
+    return ok;
+}
+
+static void bench_occlusion_culling(void) {
+    static VoxelWorld world;
+    static OcclusionBuffer buffer;
+    DrawList list = {0};
+
+    json_open("occlusion_culling");
+    json_str("simd_level", occlusion_simd_level());
+    json_int("buffer_width", OCCLUSION_WIDTH);
+    json_int("buffer_height", OCCLUSION_HEIGHT);
+    json_bool("wall_scene_expected", check_wall_scene(&buffer));
+
+    // Eye height above the terrain in the middle of the window, looking
+    // level in every direction
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+    long total_vertices = mesh_window(&world);
+    int ground = WORLD_HEIGHT - 1;
+    while (ground > 0 && get_block(&world, CHUNK_SIZE / 2, ground, CHUNK_SIZE / 2) == 0) ground--;
+    Camera camera = {CHUNK_SIZE / 2, ground + 2.0f, CHUNK_SIZE / 2, -5.0f, 0.0f};
+
+    Timings occlusion_timings = {0};
+    Timings frustum_only = {0};
+    long drawn_frustum = 0, drawn_occlusion = 0;
+    long sections_frustum = 0, sections_occluded = 0;
+    int quads = 0;
+    for (int frame = 0; frame < bench_frames; frame++) {
+        camera.yaw = frame * 360.0f / bench_frames;
+        Frustum frustum;
+        frustum_from_camera(&frustum, &camera, &bench_projection);
+
+        double start = now_ns();
+        draw_list_build(&list, &world, &frustum, NULL);
+        timings_add(&frustum_only, now_ns() - start);
+        drawn_frustum += vertices_drawn(&list);
+        sections_frustum += list.stats.sections_visible;
+
+        start = now_ns();
+        draw_list_build(&list, &world, &frustum, &buffer);
+        timings_add(&occlusion_timings, now_ns() - start);
+        drawn_occlusion += vertices_drawn(&list);
+        sections_occluded += list.stats.sections_occluded;
+        quads += list.stats.occluder_quads;
+    }
+    json_open("terrain_turning");
+    json_int("vertices_total", total_vertices);
+    json_num("eye_height", camera.y);
+    json_int("vertices_drawn_frustum", drawn_frustum / bench_frames);
+    json_int("vertices_drawn_occlusion", drawn_occlusion / bench_frames);
+    json_int("sections_after_frustum", sections_frustum / bench_frames);
+    json_int("sections_occluded", sections_occluded / bench_frames);
+    json_int("occluder_quads", quads / bench_frames);
+    json_timings("draw_list_frustum", &frustum_only);
+    json_timings("draw_list_occlusion", &occlusion_timings);
+    json_close();
+
+    int wall_occluded = 0;
+    bool wall_ok = check_world_wall(&world, &buffer, &list, &wall_occluded);
+    json_int("world_wall_sections_occluded", wall_occluded);
+    json_bool("world_wall_expected", wall_ok);
+    json_close();
+
+    draw_list_free(&list);
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Level of detail
+
+static bool init_lod_world(VoxelWorld* world, int view_distance, bool use_lod) {
+    WorldConfig config = default_world_config();
+    config.worker_count = -1;
+    config.seed = bench_seed;
+    config.view_distance = view_distance;
+    if (!use_lod) memset(config.lod_rings, 0, sizeof(config.lod_rings));
+    return init_voxel_world_with_config(world, &config);
+}
+
+// Mesh every chunk in the window, timing each build by its level of detail;
+// returns the total triangle count
+static long mesh_lod_window(VoxelWorld* world, Timings mesh[LOD_LEVELS]) {
+    long triangles = 0;
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        Chunk* chunk = &world->chunks[i];
+        ChunkNeighbours neighbours = get_chunk_neighbours(world, chunk);
+        double start = now_ns();
+        chunk_mesh_build(chunk, &neighbours, &chunk->mesh);
+        if (mesh) timings_add(&mesh[chunk->lod], now_ns() - start);
+        chunk->mesh_dirty = false;
+        triangles += chunk->mesh.quad_count * 2;
+    }
+    return triangles;
+}
+
+// Decode the corners, in winding order, of the quad starting at vertex q
+static void decode_quad(const ChunkMesh* mesh, int q, MeshVertex v[4]) {
+    static const int corners[4] = {0, 1, 2, 5};
+    for (int i = 0; i < 4; i++) chunk_mesh_decode_vertex(&mesh->vertices[q + corners[i]], &v[i]);
+}
+
+// True if the mesh has a quad lying on the chunk's border plane on one side
+// (axis 0 or 2), facing out of the chunk
+static bool has_border_quad(const ChunkMesh* mesh, int axis, int side) {
+    float plane = side ? (float)CHUNK_SIZE : 0.0f;
+    for (int q = 0; q < mesh->vertex_count; q += QUAD_VERTICES) {
+        MeshVertex v[4];
+        decode_quad(mesh, q, v);
+        bool on_plane = true;
+        for (int i = 0; i < 4; i++) on_plane &= (axis == 0 ? v[i].x : v[i].z) == plane;
+        if (!on_plane) continue;
+
+        // The winding gives the normal: (v1 - v0) x (v3 - v0)
+        float ax = v[1].x - v[0].x, ay = v[1].y - v[0].y, az = v[1].z - v[0].z;
+        float bx = v[3].x - v[0].x, by = v[3].y - v[0].y, bz = v[3].z - v[0].z;
+        float normal = axis == 0 ? ay * bz - az * by : ax * by - ay * bx;
+        if ((normal > 0.0f) == (side == 1)) return true;
+    }
+    return false;
+}
+
+// Every seam between chunks at different levels must be closed by border
+// faces on both sides
+static bool seams_skirted(VoxelWorld* world, int* seams) {
+    bool ok = true;
+    *seams = 0;
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        const Chunk* chunk = &world->chunks[i];
+        if (!chunk->is_loaded) continue;
+        const Chunk* pos_x = find_chunk(world, chunk->world_x + 1, chunk->world_z);
+        const Chunk* pos_z = find_chunk(world, chunk->world_x, chunk->world_z + 1);
+        if (pos_x && pos_x->lod != chunk->lod) {
+            (*seams)++;
+            ok &= has_border_quad(&chunk->mesh, 0, 1) && has_border_quad(&pos_x->mesh, 0, 0);
+        }
+        if (pos_z && pos_z->lod != chunk->lod) {
+            (*seams)++;
+            ok &= has_border_quad(&chunk->mesh, 2, 1) && has_border_quad(&pos_z->mesh, 2, 0);
+        }
+    }
+    return ok && *seams > 0;
+}
+
+static void bench_level_of_detail(void) {
+    static VoxelWorld world;
+    static const char* const level_names[LOD_LEVELS] = {"full", "half", "quarter", "eighth"};
+
+    json_open("level_of_detail");
+
+    // Budget to match: the default window, all at full detail
+    if (!init_lod_world(&world, LEGACY_VIEW_DISTANCE, false)) {
+        json_close();
+        return;
+    }
+    long budget = mesh_lod_window(&world, NULL);
+    cleanup_voxel_world(&world);
+    json_int("default_view_distance", LEGACY_VIEW_DISTANCE);
+    json_int("default_triangles", budget);
+
+    // The widest window at full detail, for comparison
+    if (init_lod_world(&world, MAX_VIEW_DISTANCE, false)) {
+        json_int("view_distance", MAX_VIEW_DISTANCE);
+        json_int("full_detail_triangles", mesh_lod_window(&world, NULL));
+        cleanup_voxel_world(&world);
+    }
+
+    if (!init_lod_world(&world, MAX_VIEW_DISTANCE, true)) {
+        json_close();
+        return;
+    }
+    Timings mesh[LOD_LEVELS] = {{0}};
+    long triangles = mesh_lod_window(&world, mesh);
+    json_open("rings");
+    for (int lod = 0; lod < LOD_LEVELS; lod++) {
+        int chunks = 0;
+        long ring_triangles = 0;
+        for (int i = 0; i < world.chunk_count * world.chunk_count; i++) {
+            if (world.chunks[i].lod != lod) continue;
+            chunks++;
+            ring_triangles += world.chunks[i].mesh.quad_count * 2;
+        }
+        json_open(level_names[lod]);
+        json_int("scale", 1 << lod);
+        json_int("from_distance", lod == 0 ? 0 : world.lod_rings[lod - 1]);
+        json_int("chunks", chunks);
+        json_int("triangles", ring_triangles);
+        json_timings("chunk_mesh_build", &mesh[lod]);
+        json_close();
+    }
+    json_close();
+    json_int("lod_triangles", triangles);
+    json_num("triangles_vs_default", (double)triangles / budget);
+
+    int seams = 0;
+    json_bool("seams_skirted", seams_skirted(&world, &seams));
+    json_int("seams", seams);
+
+    // Wobbling within a chunk of the starting point must not change any
+    // level; a step of one chunk must
+    float x = CHUNK_SIZE / 2, z = CHUNK_SIZE / 2;
+    long changes = world.stats.lod_changes;
+    for (int step = 0; step < 100; step++) {
+        float wobble = (step % 2 ? 0.4f : -0.4f) * CHUNK_SIZE;
+        update_chunk_lods(&world, x + wobble, z - wobble);
+    }
+    long wobble_changes = world.stats.lod_changes - changes;
+    update_chunk_lods(&world, x + CHUNK_SIZE, z);
+    long step_changes = world.stats.lod_changes - changes - wobble_changes;
+    json_int("wobble_lod_changes", wobble_changes);
+    json_int("step_lod_changes", step_changes);
+    json_bool("hysteresis_expected", wobble_changes == 0 && step_changes > 0);
+    json_close();
+
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Raycasting
+
+#define RAY_COUNT 65536
+#define RAY_CHECKED 16384  // Rays compared against the reference walk
+#define RAY_LENGTH 64.0f
+
+// Block-by-block walk through get_block with no skipping, for comparison
+static bool reference_raycast(VoxelWorld* world, const Ray* ray, RayHit* hit) {
+    *hit = (RayHit){0};
+    float length = sqrtf(ray->direction[0] * ray->direction[0] + ray->direction[1] * ray->direction[1] +
+                         ray->direction[2] * ray->direction[2]);
+    float dir[3];
+    int block[3], step[3], axis = -1;
+    float t_max[3], t_delta[3], t = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        dir[i] = ray->direction[i] / length;
+        block[i] = (int)floorf(ray->origin[i]);
+        step[i] = dir[i] > 0.0f ? 1 : (dir[i] < 0.0f ? -1 : 0);
+        t_delta[i] = step[i] ? 1.0f / fabsf(dir[i]) : INFINITY;
+        t_max[i] = step[i] ? ((block[i] + (step[i] > 0)) - ray->origin[i]) / dir[i] : INFINITY;
+    }
+    while (t <= ray->max_distance) {
+        unsigned char type = get_block(world, block[0], block[1], block[2]);
+        if (type != 0) {
+            hit->hit = true;
+            for (int i = 0; i < 3; i++) {
+                hit->block[i] = block[i];
+                hit->normal[i] = i == axis ? -step[i] : 0;
+            }
+            hit->distance = t;
+            hit->block_type = type;
+            return true;
+        }
+        axis = 0;
+        if (t_max[1] < t_max[axis]) axis = 1;
+        if (t_max[2] < t_max[axis]) axis = 2;
+        t = t_max[axis];
+        block[axis] += step[axis];
+        t_max[axis] += t_delta[axis];
+    }
+    return false;
+}
+
+static bool same_hit(const RayHit* a, const RayHit* b) {
+    if (a->hit != b->hit) return false;
+    if (!a->hit) return true;
+    for (int i = 0; i < 3; i++) {
+        if (a->block[i] != b->block[i] || a->normal[i] != b->normal[i]) return false;
+    }
+    return fabsf(a->distance - b->distance) < 1e-3f && a->block_type == b->block_type;
+}
+
+static float random_unit(unsigned int* state) {
+    return (next_random(state) & 0xffff) / 65535.0f;
+}
+
+// Rays from random points in and above the window, in random directions
+static void random_rays(VoxelWorld* world, Ray* rays, int count, unsigned int seed) {
+    unsigned int state = seed;
+    float span = (world->view_distance - 1) * CHUNK_SIZE;
+    for (int i = 0; i < count; i++) {
+        Ray* ray = &rays[i];
+        ray->origin[0] = (random_unit(&state) * 2.0f - 1.0f) * span;
+        ray->origin[1] = random_unit(&state) * (WORLD_HEIGHT + 16);
+        ray->origin[2] = (random_unit(&state) * 2.0f - 1.0f) * span;
+        for (int k = 0; k < 3; k++) ray->direction[k] = random_unit(&state) * 2.0f - 1.0f;
+        ray->max_distance = RAY_LENGTH;
+    }
+}
+
+// Rays per second over `passes` runs of all the rays
+static double rays_per_second(double ns, int passes) {
+    return ns > 0.0 ? (double)RAY_COUNT * passes / (ns / 1e9) : 0.0;
+}
+
+static void bench_raycast(void) {
+    static VoxelWorld world;
+    const int passes = 4;
+
+    json_open("raycast");
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+    Ray* rays = malloc(RAY_COUNT * sizeof(Ray));
+    RayHit* hits = malloc(RAY_COUNT * sizeof(RayHit));
+    if (!rays || !hits) {
+        free(rays);
+        free(hits);
+        cleanup_voxel_world(&world);
+        json_close();
+        return;
+    }
+
+    random_rays(&world, rays, RAY_COUNT, bench_seed);
+    int mismatches = 0;
+    for (int i = 0; i < RAY_CHECKED; i++) {
+        RayHit fast, reference;
+        raycast(&world, rays[i].origin, rays[i].direction, rays[i].max_distance, &fast);
+        reference_raycast(&world, &rays[i], &reference);
+        mismatches += !same_hit(&fast, &reference);
+    }
+    json_int("rays", RAY_COUNT);
+    json_num("max_distance", RAY_LENGTH);
+    json_int("reference_mismatches", mismatches);
+    json_bool("matches_reference", mismatches == 0);
+
+    // Level rays with no length limit, along and across the axes, stop at
+    // the window's edge instead of walking forever; one aimed away from the
+    // window from outside it misses at once
+    bool unbounded_ends = true;
+    const float level[4][3] = {{1, 0, 0}, {0, 0, -1}, {1, 0, 1}, {-3, 0, 1}};
+    for (int i = 0; i < 4; i++) {
+        const float origin[3] = {CHUNK_SIZE / 2, WORLD_HEIGHT - 0.5f, CHUNK_SIZE / 2};
+        RayHit hit;
+        if (raycast(&world, origin, level[i], INFINITY, &hit)) unbounded_ends &= isfinite(hit.distance);
+    }
+    const float outside[3] = {(world.view_distance + 4) * CHUNK_SIZE, WORLD_HEIGHT / 2, 0};
+    const float away[3] = {1, 0, 0};
+    RayHit outside_hit;
+    unbounded_ends &= !raycast(&world, outside, away, INFINITY, &outside_hit);
+    json_bool("unbounded_rays_end", unbounded_ends);
+
+    // Random rays one at a time, batched, and through the reference walk
+    int hit_count = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < passes; pass++) {
+        hit_count = 0;
+        for (int i = 0; i < RAY_COUNT; i++) {
+            hit_count += raycast(&world, rays[i].origin, rays[i].direction, rays[i].max_distance, &hits[i]);
+        }
+    }
+    json_num("rays_per_second", rays_per_second(now_ns() - start, passes));
+    json_num("hit_fraction", (double)hit_count / RAY_COUNT);
+
+    start = now_ns();
+    for (int pass = 0; pass < passes; pass++) raycast_batch(&world, rays, RAY_COUNT, hits);
+    json_num("batch_rays_per_second", rays_per_second(now_ns() - start, passes));
+
+    start = now_ns();
+    for (int i = 0; i < RAY_COUNT; i++) reference_raycast(&world, &rays[i], &hits[i]);
+    json_num("reference_rays_per_second", rays_per_second(now_ns() - start, 1));
+
+    // An explosion: rays in every direction from one point above the ground
+    for (int i = 0; i < RAY_COUNT; i++) {
+        rays[i].origin[0] = CHUNK_SIZE / 2;
+        rays[i].origin[1] = WORLD_HEIGHT * 0.75f;
+        rays[i].origin[2] = CHUNK_SIZE / 2;
+    }
+    start = now_ns();
+    for (int pass = 0; pass < passes; pass++) hit_count = raycast_batch(&world, rays, RAY_COUNT, hits);
+    json_num("burst_rays_per_second", rays_per_second(now_ns() - start, passes));
+    json_num("burst_hit_fraction", (double)hit_count / RAY_COUNT);
+    json_close();
+
+    free(rays);
+    free(hits);
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Occupancy queries
+
+#define OCCUPANCY_QUERIES 65536
+#define OCCUPANCY_EDITS 4096
+#define OCCUPANCY_BOX_MAX 16  // Largest box edge in blocks
+
+typedef struct {
+    int min[3], max[3];
+} BenchBox;
+
+// Occupancy rebuilt from get_block agrees with what set_block maintained
+static bool occupancy_consistent(VoxelWorld* world) {
+    for (int slot_x = 0; slot_x < world->chunk_count; slot_x++) {
+        for (int slot_z = 0; slot_z < world->chunk_count; slot_z++) {
+            const ChunkStorage* storage = &chunk_at_slot(world, slot_x, slot_z)->storage;
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                const ChunkSection* section = &storage->sections[s];
+                int solid = 0;
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    for (int y = 0; y < SECTION_HEIGHT; y++) {
+                        for (int z = 0; z < CHUNK_SIZE; z++) {
+                            bool expected = chunk_storage_get(storage, x, s * SECTION_HEIGHT + y, z) != 0;
+                            if (chunk_storage_is_solid(storage, x, s * SECTION_HEIGHT + y, z) != expected) {
+                                return false;
+                            }
+                            if (expected && !((section->solid_bricks >> occupancy_brick(x, y, z)) & 1)) {
+                                return false;
+                            }
+                            solid += expected;
+                        }
+                    }
+                }
+                if (solid != section->solid_count) return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool reference_region_empty(VoxelWorld* world, const BenchBox* box) {
+    for (int x = box->min[0]; x < box->max[0]; x++) {
+        for (int y = box->min[1]; y < box->max[1]; y++) {
+            for (int z = box->min[2]; z < box->max[2]; z++) {
+                if (get_block(world, x, y, z) != 0) return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool reference_solid_bounds(VoxelWorld* world, const BenchBox* box, int out_min[3], int out_max[3]) {
+    bool found = false;
+    for (int x = box->min[0]; x < box->max[0]; x++) {
+        for (int y = box->min[1]; y < box->max[1]; y++) {
+            for (int z = box->min[2]; z < box->max[2]; z++) {
+                if (get_block(world, x, y, z) == 0) continue;
+                int block[3] = {x, y, z};
+                for (int i = 0; i < 3; i++) {
+                    if (!found || block[i] < out_min[i]) out_min[i] = block[i];
+                    if (!found || block[i] + 1 > out_max[i]) out_max[i] = block[i] + 1;
+                }
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+static int reference_first_solid_below(VoxelWorld* world, int x, int y, int z) {
+    for (; y >= 0; y--) {
+        if (get_block(world, x, y, z) != 0) return y;
+    }
+    return -1;
+}
+
+// Boxes of random size anywhere in the window, reaching a little above and below the world
+static void random_boxes(VoxelWorld* world, BenchBox* boxes, int count, unsigned int seed) {
+    unsigned int state = seed;
+    int span = (world->view_distance * 2 - 1) * CHUNK_SIZE;
+    int low = -(world->view_distance - 1) * CHUNK_SIZE;
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < 3; k++) {
+            int size = 1 + next_random(&state) % OCCUPANCY_BOX_MAX;
+            int start = k == 1 ? (int)(next_random(&state) % (WORLD_HEIGHT + 8)) - 4
+                               : low + (int)(next_random(&state) % span);
+            boxes[i].min[k] = start;
+            boxes[i].max[k] = start + size;
+        }
+    }
+}
+
+static void bench_occupancy(void) {
+    static VoxelWorld world;
+
+    json_open("occupancy");
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+    BenchBox* boxes = malloc(OCCUPANCY_QUERIES * sizeof(BenchBox));
+    if (!boxes) {
+        cleanup_voxel_world(&world);
+        json_close();
+        return;
+    }
+
+    // Carve and fill around the spawn chunks, then check the incremental upkeep
+    unsigned int state = bench_seed;
+    for (int i = 0; i < OCCUPANCY_EDITS; i++) {
+        int x = (int)(next_random(&state) % (CHUNK_SIZE * 3)) - CHUNK_SIZE;
+        int y = next_random(&state) % WORLD_HEIGHT;
+        int z = (int)(next_random(&state) % (CHUNK_SIZE * 3)) - CHUNK_SIZE;
+        set_block(&world, x, y, z, next_random(&state) % 3);
+    }
+    json_int("edits", OCCUPANCY_EDITS);
+    json_bool("incremental_consistent", occupancy_consistent(&world));
+
+    random_boxes(&world, boxes, OCCUPANCY_QUERIES, bench_seed);
+    int mismatches = 0, empty_count = 0;
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) {
+        bool empty = occupancy_region_empty(&world, boxes[i].min, boxes[i].max);
+        mismatches += empty != reference_region_empty(&world, &boxes[i]);
+        empty_count += empty;
+
+        int fast_min[3], fast_max[3], reference_min[3], reference_max[3];
+        bool fast = occupancy_solid_bounds(&world, boxes[i].min, boxes[i].max, fast_min, fast_max);
+        bool reference = reference_solid_bounds(&world, &boxes[i], reference_min, reference_max);
+        if (fast != reference || (fast && (memcmp(fast_min, reference_min, sizeof(fast_min)) != 0 ||
+                                           memcmp(fast_max, reference_max, sizeof(fast_max)) != 0))) {
+            mismatches++;
+        }
+
+        int x = boxes[i].min[0], z = boxes[i].min[2], y = boxes[i].max[1];
+        mismatches += occupancy_first_solid_below(&world, x, y, z) != reference_first_solid_below(&world, x, y, z);
+    }
+    json_int("queries", OCCUPANCY_QUERIES);
+    json_num("empty_fraction", (double)empty_count / OCCUPANCY_QUERIES);
+    json_int("reference_mismatches", mismatches);
+    json_bool("matches_reference", mismatches == 0);
+
+    // Each query over every box, against a get_block scan of the same box
+    long checksum = 0;
+    double start = now_ns();
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) {
+        checksum += occupancy_region_empty(&world, boxes[i].min, boxes[i].max);
+    }
+    double empty_ns = now_ns() - start;
+    start = now_ns();
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) checksum += reference_region_empty(&world, &boxes[i]);
+    double reference_empty_ns = now_ns() - start;
+
+    int bounds_min[3], bounds_max[3];
+    start = now_ns();
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) {
+        checksum += occupancy_solid_bounds(&world, boxes[i].min, boxes[i].max, bounds_min, bounds_max);
+    }
+    double bounds_ns = now_ns() - start;
+    start = now_ns();
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) {
+        checksum += reference_solid_bounds(&world, &boxes[i], bounds_min, bounds_max);
+    }
+    double reference_bounds_ns = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) {
+        checksum += occupancy_first_solid_below(&world, boxes[i].min[0], WORLD_HEIGHT - 1, boxes[i].min[2]);
+    }
+    double column_ns = now_ns() - start;
+    start = now_ns();
+    for (int i = 0; i < OCCUPANCY_QUERIES; i++) {
+        checksum += reference_first_solid_below(&world, boxes[i].min[0], WORLD_HEIGHT - 1, boxes[i].min[2]);
+    }
+    double reference_column_ns = now_ns() - start;
+
+    json_num("region_empty_ns", empty_ns / OCCUPANCY_QUERIES);
+    json_num("reference_region_empty_ns", reference_empty_ns / OCCUPANCY_QUERIES);
+    json_num("region_empty_speedup", empty_ns > 0.0 ? reference_empty_ns / empty_ns : 0.0);
+    json_num("solid_bounds_ns", bounds_ns / OCCUPANCY_QUERIES);
+    json_num("reference_solid_bounds_ns", reference_bounds_ns / OCCUPANCY_QUERIES);
+    json_num("solid_bounds_speedup", bounds_ns > 0.0 ? reference_bounds_ns / bounds_ns : 0.0);
+    json_num("first_solid_ns", column_ns / OCCUPANCY_QUERIES);
+    json_num("reference_first_solid_ns", reference_column_ns / OCCUPANCY_QUERIES);
+    json_num("first_solid_speedup", column_ns > 0.0 ? reference_column_ns / column_ns : 0.0);
+    json_int("checksum", checksum);
+    json_close();
+
+    free(boxes);
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Flood-fill lighting
+
+#define LIGHT_EDITS 512
+#define LIGHT_EDIT_RADIUS 24  // Blocks around the spawn chunk that edits land in
+
+// Light every window chunk from scratch, the way loading does: each on its
+// own, then across every border
+static void relight_window(VoxelWorld* world) {
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) light_chunk_local(chunk_at_slot(world, x, z));
+    }
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) light_chunk_borders(world, chunk_at_slot(world, x, z));
+    }
+}
+
+// Copy every slot's light, in slot order
+static void snapshot_light(VoxelWorld* world, DenseLight* snapshot) {
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        chunk_light_decode(&chunk_at_slot(world, i / world->chunk_count, i % world->chunk_count)->light, snapshot[i]);
+    }
+}
+
+// Voxels whose light differs from the snapshot
+static long light_differences(VoxelWorld* world, const DenseLight* snapshot) {
+    long differences = 0;
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        const ChunkLight* light = &chunk_at_slot(world, i / world->chunk_count, i % world->chunk_count)->light;
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            for (int y = 0; y < WORLD_HEIGHT; y++) {
+                for (int z = 0; z < CHUNK_SIZE; z++) differences += snapshot[i][x][y][z] != chunk_light_get(light, x, y, z);
+            }
+        }
+    }
+    return differences;
+}
+
+// A sealed pocket dug under the spawn chunk is dark until a lamp goes in
+static bool lamp_lights_cave(VoxelWorld* world) {
+    int ground = occupancy_first_solid_below(world, 4, WORLD_HEIGHT - 1, 4);
+    if (ground < 6) return false;
+    for (int x = 3; x <= 5; x++) {
+        for (int y = 1; y <= 3; y++) {
+            for (int z = 3; z <= 5; z++) set_block(world, x, y, z, 0);
+        }
+    }
+    bool dark = get_light(world, 4, 2, 4) == 0;
+    set_block(world, 4, 1, 4, BLOCK_LAMP);
+    unsigned char lit = get_light(world, 4, 2, 4);
+    return dark && light_block(lit) == MAX_LIGHT - 1 && light_sky(lit) == 0;
+}
+
+// A lamp in the air just across a chunk edge lights blocks on this side
+static bool light_crosses_border(VoxelWorld* world) {
+    int y = WORLD_HEIGHT - 2;
+    set_block(world, -1, y, 8, BLOCK_LAMP);
+    return light_block(get_light(world, 0, y, 8)) == MAX_LIGHT - 1 &&
+           light_block(get_light(world, 5, y, 8)) == MAX_LIGHT - 6;
+}
+
+static void bench_lighting(void) {
+    static VoxelWorld world;
+
+    json_open("lighting");
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+    int chunks = world.chunk_count * world.chunk_count;
+    DenseLight* snapshot = malloc(chunks * sizeof(DenseLight));
+    Chunk** edited = malloc(LIGHT_EDITS * sizeof(Chunk*));
+    if (!snapshot || !edited) {
+        free(snapshot);
+        free(edited);
+        cleanup_voxel_world(&world);
+        json_close();
+        return;
+    }
+
+    json_bool("lamp_lights_cave", lamp_lights_cave(&world));
+    json_bool("light_crosses_border", light_crosses_border(&world));
+
+    // Dig tunnels, roof over open ground and drop lamps around the spawn chunk
+    Timings edit = {0};
+    long relit_total = 0, relit_max = 0;
+    unsigned int state = bench_seed;
+    int edit_count = 0;
+    for (int i = 0; i < LIGHT_EDITS; i++) {
+        int x = (int)(next_random(&state) % (2 * LIGHT_EDIT_RADIUS)) - LIGHT_EDIT_RADIUS;
+        int z = (int)(next_random(&state) % (2 * LIGHT_EDIT_RADIUS)) - LIGHT_EDIT_RADIUS;
+        int ground = occupancy_first_solid_below(&world, x, WORLD_HEIGHT - 1, z);
+        int y;
+        unsigned char type;
+        switch (next_random(&state) % 3) {
+        case 0:
+            y = (int)(next_random(&state) % (ground + 1));
+            type = 0;
+            break;
+        case 1:
+            y = ground + 2 + (int)(next_random(&state) % 3);
+            type = 1;
+            break;
+        default:
+            y = (int)(next_random(&state) % WORLD_HEIGHT);
+            type = BLOCK_LAMP;
+            break;
+        }
+        if (y >= WORLD_HEIGHT || get_block(&world, x, y, z) == type) continue;
+
+        long before = world.stats.voxels_relit;
+        double start = now_ns();
+        set_block(&world, x, y, z, type);
+        timings_add(&edit, now_ns() - start);
+        long relit = world.stats.voxels_relit - before;
+        relit_total += relit;
+        if (relit > relit_max) relit_max = relit;
+        edited[edit_count++] = find_chunk(&world, (int)floorf(x / (float)CHUNK_SIZE), (int)floorf(z / (float)CHUNK_SIZE));
+    }
+    json_int("edits", edit_count);
+    json_num("voxels_relit_per_edit", edit_count ? (double)relit_total / edit_count : 0.0);
+    json_int("max_voxels_relit", relit_max);
+    json_timings("incremental_edit", &edit);
+
+    // The same chunks relit whole, as an edit would without the queues
+    Timings full = {0};
+    for (int i = 0; i < edit_count; i++) {
+        double start = now_ns();
+        light_chunk_local(edited[i]);
+        light_chunk_borders(&world, edited[i]);
+        timings_add(&full, now_ns() - start);
+    }
+    json_timings("full_chunk_relight", &full);
+
+    // Every incremental update must land where lighting from scratch does
+    snapshot_light(&world, snapshot);
+    double start = now_ns();
+    relight_window(&world);
+    double window_ns = now_ns() - start;
+    long differences = light_differences(&world, snapshot);
+    json_num("window_relight_ms", window_ns / 1e6);
+    json_int("voxels_differing_from_full", differences);
+    json_bool("incremental_matches_full", differences == 0);
+
+    // Light memory against a dense array per chunk: open sky and solid
+    // ground sections stay uniform
+    size_t light_bytes = 0;
+    int dense_sections = 0;
+    for (int i = 0; i < chunks; i++) {
+        const ChunkLight* light = &chunk_at_slot(&world, i / world.chunk_count, i % world.chunk_count)->light;
+        light_bytes += sizeof(ChunkLight) + chunk_light_bytes(light);
+        for (int s = 0; s < SECTIONS_PER_CHUNK; s++) dense_sections += light->sections[s].data != NULL;
+    }
+    json_int("light_bytes", (long)light_bytes);
+    json_int("dense_light_bytes", (long)(chunks * sizeof(DenseLight)));
+    json_num("dense_section_fraction", (double)dense_sections / (chunks * SECTIONS_PER_CHUNK));
+    json_close();
+
+    free(snapshot);
+    free(edited);
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Ambient occlusion
+
+// A dirt floor with a grass-topped wall across it and a lone pillar,
+// meshed on its own
+static void build_occlusion_scene(Chunk* chunk) {
+    static DenseBlocks blocks;
+    memset(blocks, 0, sizeof(blocks));
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) blocks[x][0][z] = BLOCK_DIRT;
+    }
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        blocks[4][1][z] = BLOCK_DIRT;
+        blocks[4][2][z] = BLOCK_GRASS;
+    }
+    blocks[10][1][10] = BLOCK_DIRT;
+    chunk_storage_init(&chunk->storage);
+    chunk_storage_encode(&chunk->storage, blocks);
+    light_chunk_local(chunk);
+}
+
+// Floor tops are occluded exactly where they meet the wall (x 4 to 5) or
+// touch the pillar (x and z 10 to 11)
+static bool floor_occlusion_expected(const ChunkMesh* mesh) {
+    int checked = 0;
+    for (int q = 0; q < mesh->vertex_count; q += QUAD_VERTICES) {
+        MeshVertex v[4];
+        decode_quad(mesh, q, v);
+        if (v[0].y != 1.0f || v[1].y != 1.0f || v[2].y != 1.0f || v[3].y != 1.0f) continue;
+        for (int i = 0; i < 4; i++) {
+            bool by_wall = v[i].x == 4.0f || v[i].x == 5.0f;
+            bool by_pillar = v[i].x >= 10.0f && v[i].x <= 11.0f && v[i].z >= 10.0f && v[i].z <= 11.0f;
+            if ((v[i].ao < 3) != (by_wall || by_pillar)) return false;
+            checked++;
+        }
+    }
+    return checked > 0;
+}
+
+// Both triangles of every quad share the diagonal from its first corner,
+// which must be the darker one; counts the quads where one diagonal was darker
+static bool diagonals_expected(const ChunkMesh* mesh, long* asymmetric) {
+    bool ok = true;
+    for (int q = 0; q < mesh->vertex_count; q += QUAD_VERTICES) {
+        const PackedVertex* t = &mesh->vertices[q];
+        ok &= t[3].fields == t[0].fields && t[4].fields == t[2].fields;
+        MeshVertex v[4];
+        decode_quad(mesh, q, v);
+        int split = v[0].ao + v[2].ao, other = v[1].ao + v[3].ao;
+        ok &= split <= other;
+        *asymmetric += split != other;
+    }
+    return ok;
+}
+
+// Grass tops are green, dirt tops brown, and both are darker on their sides
+static bool block_colors_expected(const ChunkMesh* mesh) {
+    bool grass_top = false, dirt_top = false;
+    for (int q = 0; q < mesh->vertex_count; q += QUAD_VERTICES) {
+        MeshVertex v[4];
+        decode_quad(mesh, q, v);
+        bool top = v[0].y == v[1].y && v[0].y == v[2].y && v[0].y == v[3].y;
+        for (int i = 0; i < 4 && top; i++) {
+            if (v[i].ao != 3) continue;
+            if (v[i].y == 3.0f) grass_top |= v[i].r == 0 && v[i].g > 0 && v[i].b == 0;
+            if (v[i].y == 1.0f) dirt_top |= v[i].r > v[i].g && v[i].g > 0 && v[i].b == 0;
+        }
+    }
+    return grass_top && dirt_top;
+}
+
+static void bench_ambient_occlusion(void) {
+    static VoxelWorld world;
+    static Chunk scene;
+
+    json_open("ambient_occlusion");
+    json_int("vertex_bytes", sizeof(PackedVertex));
+
+    build_occlusion_scene(&scene);
+    chunk_mesh_build(&scene, NULL, &scene.mesh);
+    long asymmetric = 0;
+    json_bool("ao_expected", floor_occlusion_expected(&scene.mesh));
+    json_bool("diagonals_expected", diagonals_expected(&scene.mesh, &asymmetric) && asymmetric > 0);
+    json_bool("block_colors_expected", block_colors_expected(&scene.mesh));
+    chunk_mesh_free(&scene.mesh);
+    chunk_storage_free(&scene.storage);
+
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+
+    // Greedy merging against one quad per face, over the whole window
+    Timings greedy = {0};
+    long greedy_quads = 0, naive_quads = 0;
+    long window_asymmetric = 0;
+    bool diagonals_ok = true;
+    ChunkMesh naive = {0};
+    for (int i = 0; i < world.chunk_count * world.chunk_count; i++) {
+        Chunk* chunk = chunk_at_slot(&world, i / world.chunk_count, i % world.chunk_count);
+        ChunkNeighbours neighbours = get_chunk_neighbours(&world, chunk);
+        double start = now_ns();
+        chunk_mesh_build(chunk, &neighbours, &chunk->mesh);
+        timings_add(&greedy, now_ns() - start);
+        chunk_mesh_build_naive(chunk, &neighbours, &naive);
+        greedy_quads += chunk->mesh.quad_count;
+        naive_quads += naive.quad_count;
+        diagonals_ok &= diagonals_expected(&chunk->mesh, &window_asymmetric);
+        diagonals_ok &= diagonals_expected(&naive, &window_asymmetric);
+    }
+    chunk_mesh_free(&naive);
+    json_timings("chunk_mesh_build", &greedy);
+    json_int("greedy_quads", greedy_quads);
+    json_int("naive_quads", naive_quads);
+    json_num("merge_ratio", greedy_quads ? (double)naive_quads / greedy_quads : 0.0);
+    json_int("asymmetric_quads", window_asymmetric);
+    json_bool("window_diagonals_expected", diagonals_ok);
+    json_close();
+
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Frame timing
+
+#define TIMED_FRAMES 20000
+#define SIMULATED_SECONDS 30.0
+#define BENCH_STEP (1.0 / 60.0)
+
+// A falling, drifting body: the kind of state a frame-rate dependent
+// integrator gets wrong
+typedef struct {
+    double position[2];
+    double velocity[2];
+} Body;
+
+static void body_step(Body* body, double delta_time) {
+    body->velocity[1] -= 9.8 * delta_time;
+    body->velocity[0] *= 1.0 - 0.5 * delta_time;
+    for (int i = 0; i < 2; i++) body->position[i] += body->velocity[i] * delta_time;
+}
+
+// Frame times of a schedule: fixed at `fps`, or jittered 1-40 ms with an
+// occasional half-second stall when fps is 0
+static double schedule_frame(int fps, unsigned int* state) {
+    if (fps > 0) return 1.0 / fps;
+    unsigned int r = next_random(state);
+    if (r % 500 == 0) return 0.5;
+    return 0.001 + (r % 39000) * 1e-6;
+}
+
+// Run a schedule for SIMULATED_SECONDS both ways: fixed steps, and one
+// variable step per frame. Returns the fixed-step body after the steps every
+// schedule reaches; rounding may leave some a step short of the full span.
+static Body run_schedule(int fps, unsigned int seed, Body* variable, bool* conserved, int* max_steps) {
+    const long compared_steps = (long)(SIMULATED_SECONDS / BENCH_STEP) - 1;
+    Body fixed_body = {{0.0, 0.0}, {3.0, 5.0}};
+    *variable = fixed_body;
+    FixedStep fixed;
+    fixed_step_init(&fixed, BENCH_STEP, 64);
+    unsigned int state = seed;
+    double elapsed = 0.0;
+    long steps = 0;
+    *conserved = true;
+    *max_steps = 0;
+    while (elapsed < SIMULATED_SECONDS) {
+        double frame = schedule_frame(fps, &state);
+        if (elapsed + frame > SIMULATED_SECONDS) frame = SIMULATED_SECONDS - elapsed;
+        elapsed += frame;
+        int n = fixed_step_advance(&fixed, frame);
+        for (int i = 0; i < n; i++, steps++) {
+            if (steps < compared_steps) body_step(&fixed_body, BENCH_STEP);
+        }
+        body_step(variable, frame);
+        if (n > *max_steps) *max_steps = n;
+        float alpha = fixed_step_alpha(&fixed);
+        *conserved &= alpha >= 0.0f && alpha < 1.0f;
+        *conserved &= fabs(steps * BENCH_STEP + fixed.accumulator + fixed.dropped_seconds - elapsed) < 1e-6;
+    }
+    *conserved &= steps >= compared_steps;
+    return fixed_body;
+}
+
+static double body_distance(const Body* a, const Body* b) {
+    return hypot(a->position[0] - b->position[0], a->position[1] - b->position[1]);
+}
+
+static void bench_frame_timing(void) {
+    json_open("frame_timing");
+
+    // Cost and granularity of the clock
+    double smallest = 1.0, start = frame_clock_seconds(), previous = start;
+    for (int i = 0; i < TIMED_FRAMES; i++) {
+        double t = frame_clock_seconds();
+        if (t > previous && t - previous < smallest) smallest = t - previous;
+        previous = t;
+    }
+    json_num("clock_read_ns", (previous - start) * 1e9 / TIMED_FRAMES);
+    json_num("clock_resolution_ns", smallest * 1e9);
+
+    // The same span simulated under very different frame rates
+    static const int rates[] = {30, 60, 144, 0};
+    static const char* const rate_names[] = {"fps_30", "fps_60", "fps_144", "jittered"};
+    Body fixed[4], variable[4];
+    bool conserved = true;
+    int worst_steps = 0;
+    for (int i = 0; i < 4; i++) {
+        bool ok;
+        int steps;
+        fixed[i] = run_schedule(rates[i], bench_seed, &variable[i], &ok, &steps);
+        conserved &= ok;
+        if (steps > worst_steps) worst_steps = steps;
+    }
+    // Variable steps against fixed ones over the whole span
+    Body reference = {{0.0, 0.0}, {3.0, 5.0}};
+    for (long i = 0; i < (long)(SIMULATED_SECONDS / BENCH_STEP + 0.5); i++) body_step(&reference, BENCH_STEP);
+    json_open("variable_step_drift");
+    double fixed_drift = 0.0;
+    for (int i = 0; i < 4; i++) {
+        json_num(rate_names[i], body_distance(&variable[i], &reference));
+        double drift = body_distance(&fixed[i], &fixed[1]);
+        if (drift > fixed_drift) fixed_drift = drift;
+    }
+    json_close();
+    json_num("fixed_step_drift", fixed_drift);
+    json_bool("rate_independent", fixed_drift == 0.0);
+    json_bool("time_conserved", conserved);
+    json_int("most_steps_per_frame", worst_steps);
+
+    // A long stall is paid out only up to the step limit and the rest dropped
+    FixedStep stalled;
+    fixed_step_init(&stalled, BENCH_STEP, 8);
+    int stall_steps = fixed_step_advance(&stalled, 1.0);
+    json_bool("stall_clamped", stall_steps == 8 && stalled.accumulator < BENCH_STEP &&
+                                   fabs(8 * BENCH_STEP + stalled.accumulator + stalled.dropped_seconds - 1.0) < 1e-9);
+
+    // Histogram percentiles against exact ones over the jittered schedule
+    static FrameHistogram histogram;
+    Timings exact = {0};
+    frame_histogram_reset(&histogram);
+    unsigned int state = bench_seed;
+    double add_start = now_ns();
+    for (int i = 0; i < TIMED_FRAMES; i++) frame_histogram_add(&histogram, schedule_frame(0, &state));
+    json_num("histogram_add_ns", (now_ns() - add_start) / TIMED_FRAMES);
+    state = bench_seed;
+    for (int i = 0; i < TIMED_FRAMES; i++) timings_add(&exact, schedule_frame(0, &state));
+    qsort(exact.ns, exact.count, sizeof(double), compare_doubles);
+    bool percentiles_ok = exact.count == TIMED_FRAMES;
+    static const double points[] = {50.0, 90.0, 99.0, 100.0};
+    for (int i = 0; i < 4 && percentiles_ok; i++) {
+        double error = frame_histogram_percentile(&histogram, points[i]) - percentile(exact.ns, exact.count, points[i]);
+        percentiles_ok &= error > -1e-9 && error < FRAME_HISTOGRAM_BUCKET_US * 1e-6 + 1e-9;
+    }
+    free(exact.ns);
+    json_num("jittered_p50_ms", frame_histogram_percentile(&histogram, 50.0) * 1e3);
+    json_num("jittered_p99_ms", frame_histogram_percentile(&histogram, 99.0) * 1e3);
+    json_bool("histogram_percentiles_expected", percentiles_ok);
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Profiler
+
+#define PROFILED_ZONES 200000  // Empty zones timed for the per-zone cost
+
+static const ProfileSummary* find_summary(const ProfileSummary* summaries, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(summaries[i].name, name) == 0) return &summaries[i];
+    }
+    return NULL;
+}
+
+// Occurrences of `needle` in the file, or -1 if it cannot be read; checks
+// the file opens and closes a trace event list
+static long count_in_trace(const char* path, const char* needle, bool* framed) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = malloc(size + 1);
+    if (!text || fread(text, 1, size, file) != (size_t)size) {
+        free(text);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    text[size] = '\0';
+    const char* open = "{\"traceEvents\":[";
+    *framed = strncmp(text, open, strlen(open)) == 0 && size >= 3 && strcmp(text + size - 3, "]}\n") == 0;
+    long count = 0;
+    for (const char* at = strstr(text, needle); at; at = strstr(at + 1, needle)) count++;
+    free(text);
+    return count;
+}
+
+static void bench_profiler(void) {
+    static VoxelWorld world;
+
+    json_open("profiler");
+#ifdef VOXEL_PROFILE
+    json_bool("enabled", true);
+#else
+    json_bool("enabled", false);
+#endif
+
+    // Cost of an empty zone, begin to end
+    double start = now_ns();
+    for (int i = 0; i < PROFILED_ZONES; i++) {
+        PROFILE_ZONE("empty_zone");
+    }
+    json_num("zone_ns", (now_ns() - start) / PROFILED_ZONES);
+#ifndef VOXEL_PROFILE
+    json_close();
+    return;
+#endif
+
+    // Walk the straight camera path with background loading, as the game would
+    profile_reset();
+    if (!init_bench_world(&world, 0)) {
+        json_close();
+        return;
+    }
+    Camera camera = {.y = WORLD_HEIGHT + 10, .pitch = -30.0f, .yaw = 90.0f};
+    DrawList list = {0};
+    for (int frame = 0; frame < bench_frames; frame++) {
+        PROFILE_FRAME();
+        camera_position(PATH_STRAIGHT, frame, &camera.x, &camera.z);
+        update_chunks(&world, camera.x, camera.z);
+        Frustum frustum;
+        frustum_from_camera(&frustum, &camera, &bench_projection);
+        draw_list_build(&list, &world, &frustum, NULL);
+    }
+    wait_for_chunk_loads(&world);
+    draw_list_free(&list);
+
+    ProfileSummary summaries[PROFILE_MAX_NAMES];
+    int count = profile_summarize(summaries, PROFILE_MAX_NAMES);
+    long zone_events = 0;
+    json_open("zones");
+    for (int i = 0; i < count; i++) {
+        const ProfileSummary* summary = &summaries[i];
+        if (summary->kind != PROFILE_EVENT_ZONE) continue;
+        zone_events += summary->count;
+        json_open(summary->name);
+        json_int("count", summary->count);
+        json_num("p50_ns", summary->p50_ns);
+        json_num("p99_ns", summary->p99_ns);
+        json_close();
+    }
+    json_close();
+    json_open("counters");
+    for (int i = 0; i < count; i++) {
+        if (summaries[i].kind == PROFILE_EVENT_COUNTER) json_int(summaries[i].name, (long)summaries[i].total);
+    }
+    json_close();
+    json_int("threads_recorded", profile_thread_count());
+
+    // Counters must agree with the world's own statistics
+    const ProfileSummary* generated = find_summary(summaries, count, "chunks_generated");
+    const ProfileSummary* remeshes = find_summary(summaries, count, "remeshes");
+    const ProfileSummary* loads = find_summary(summaries, count, "load_chunk");
+    json_bool("counters_match_stats", generated && remeshes &&
+                                          generated->total == (uint64_t)world.stats.chunks_generated &&
+                                          remeshes->total == (uint64_t)world.stats.total_remeshes);
+    json_bool("worker_zones_recorded", loads && loads->count >= world.stats.chunks_generated &&
+                                           (job_system_worker_count(world.jobs) == 0 || profile_thread_count() > 1));
+    cleanup_voxel_world(&world);
+
+    // The trace holds one complete event per buffered zone
+    char path[] = "/tmp/voxel_bench_trace_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        start = now_ns();
+        long written = profile_write_trace(path);
+        json_num("trace_write_ms", (now_ns() - start) / 1e6);
+        json_int("trace_events", written);
+        bool framed = false;
+        long complete = count_in_trace(path, "\"ph\":\"X\"", &framed);
+        json_bool("trace_expected", framed && complete == zone_events);
+        remove(path);
+    }
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Player physics
+
+#define PHYSICS_STEP (1.0f / 60.0f)
+#define COLLISION_MOVES 200000  // Random box moves timed against the reference
+#define SCRIPT_STEPS 900
+
+// Highest ground under any corner of the player's box
+static int ground_under(VoxelWorld* world, const Player* player) {
+    float min[3], max[3];
+    player_box(player, min, max);
+    int ground = -1;
+    for (int x = (int)floorf(min[0]); x < (int)ceilf(max[0]); x++) {
+        for (int z = (int)floorf(min[2]); z < (int)ceilf(max[2]); z++) {
+            int height = occupancy_first_solid_below(world, x, (int)floorf(min[1]), z);
+            if (height > ground) ground = height;
+        }
+    }
+    return ground;
+}
+
+static void run_steps(VoxelWorld* world, Player* player, const PlayerInput* input, int steps) {
+    for (int i = 0; i < steps; i++) player_step(world, player, input, PHYSICS_STEP);
+}
+
+// Dropped from above the world, the player comes to rest on the ground
+static bool lands_on_ground(VoxelWorld* world) {
+    Player player;
+    player_init(&player, 8.5f, WORLD_HEIGHT + 5.0f, 8.5f);
+    PlayerInput idle = {{0.0f, 0.0f}, false};
+    run_steps(world, &player, &idle, 180);
+    float feet = player.position[1] - (ground_under(world, &player) + 1);
+    return player.on_ground && feet >= 0.0f && feet <= 2 * PLAYER_SKIN;
+}
+
+// A jump from flat ground rises a little under jump_speed^2 / 2g and lands
+static bool jump_expected(VoxelWorld* world, float* height) {
+    Player player;
+    player_init(&player, 8.5f, WORLD_HEIGHT + 5.0f, 8.5f);
+    PlayerInput idle = {{0.0f, 0.0f}, false}, jump = {{0.0f, 0.0f}, true};
+    run_steps(world, &player, &idle, 180);
+    float ground = player.position[1], top = ground;
+    player_step(world, &player, &jump, PHYSICS_STEP);
+    for (int i = 0; i < 120; i++) {
+        player_step(world, &player, &idle, PHYSICS_STEP);
+        if (player.position[1] > top) top = player.position[1];
+    }
+    *height = top - ground;
+    float ideal = PLAYER_JUMP_SPEED * PLAYER_JUMP_SPEED / (2 * PLAYER_GRAVITY);
+    return *height > 1.0f + PLAYER_SKIN && *height <= ideal && player.on_ground &&
+           fabsf(player.position[1] - ground) <= PLAYER_SKIN;
+}
+
+// Build a wall across +x from the player, `thickness` blocks deep and
+// three above the ground; returns its near face
+static int build_wall(VoxelWorld* world, const Player* player, int distance, int thickness) {
+    int x0 = (int)floorf(player->position[0]) + distance;
+    int base = ground_under(world, player) - 2;
+    for (int x = x0; x < x0 + thickness; x++) {
+        for (int z = (int)player->position[2] - 3; z <= (int)player->position[2] + 3; z++) {
+            for (int y = base; y < base + 8 && y < WORLD_HEIGHT; y++) set_block(world, x, y, z, BLOCK_DIRT);
+        }
+    }
+    return x0;
+}
+
+// Walking into a wall stops flush against it
+static bool wall_stops_walk(VoxelWorld* world) {
+    Player player;
+    player_init(&player, 40.5f, WORLD_HEIGHT + 5.0f, 40.5f);
+    PlayerInput idle = {{0.0f, 0.0f}, false}, walk = {{6.0f, 0.0f}, false};
+    run_steps(world, &player, &idle, 180);
+    int face = build_wall(world, &player, 3, 3);
+    run_steps(world, &player, &walk, 120);
+    float gap = face - (player.position[0] + PLAYER_WIDTH / 2);
+    return gap >= 0.0f && gap <= 2 * PLAYER_SKIN && player.velocity[0] == 0.0f;
+}
+
+// Moves far longer than the world is wide stop at a single block
+static bool no_tunnelling(VoxelWorld* world) {
+    Player player;
+    player_init(&player, -40.5f, WORLD_HEIGHT + 5.0f, 40.5f);
+    PlayerInput idle = {{0.0f, 0.0f}, false};
+    run_steps(world, &player, &idle, 180);
+    int face = build_wall(world, &player, 4, 1);
+    float min[3], max[3];
+    player_box(&player, min, max);
+    float across[3] = {500.0f, 0.0f, 0.0f};
+    bool wall = player_move_box(world, min, max, across) == 1 && max[0] <= face && max[0] >= face - 2 * PLAYER_SKIN;
+
+    // A one block thick platform in the sky catches a box dropped from far above
+    int platform = WORLD_HEIGHT - 4;
+    for (int x = -4; x <= 4; x++) {
+        for (int z = 36; z <= 44; z++) set_block(world, -40 + x, platform, z, BLOCK_DIRT);
+    }
+    float drop_min[3] = {-40.3f, WORLD_HEIGHT + 1000.0f, 40.2f}, drop_max[3] = {-39.7f, WORLD_HEIGHT + 1001.8f, 40.8f};
+    float fall[3] = {0.0f, -100000.0f, 0.0f};
+    bool floor = player_move_box(world, drop_min, drop_max, fall) == 2 && drop_min[1] >= platform + 1 &&
+                 drop_min[1] <= platform + 1 + 2 * PLAYER_SKIN;
+    return wall && floor;
+}
+
+// A scripted walk with jumps, turns and a wall; returns a hash of every
+// position along the way
+static unsigned int scripted_walk(VoxelWorld* world, Player* player) {
+    player_init(player, 24.5f, WORLD_HEIGHT + 5.0f, -20.5f);
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < SCRIPT_STEPS; i++) {
+        float angle = i * 0.01f;
+        PlayerInput input = {{cosf(angle) * 5.0f, sinf(angle) * 5.0f}, i % 90 == 45};
+        player_step(world, player, &input, PHYSICS_STEP);
+        const unsigned char* bytes = (const unsigned char*)player->position;
+        for (size_t b = 0; b < sizeof(player->position); b++) hash = (hash ^ bytes[b]) * 16777619u;
+    }
+    return hash;
+}
+
+// The sweep with every cell read through get_block, as a reference
+static bool reference_blocked(VoxelWorld* world, const int lo[3], const int hi[3]) {
+    if (lo[1] < 0) return true;
+    for (int x = lo[0]; x < hi[0]; x++) {
+        for (int z = lo[2]; z < hi[2]; z++) {
+            if (!find_chunk(world, (int)floorf(x / (float)CHUNK_SIZE), (int)floorf(z / (float)CHUNK_SIZE))) {
+                if (lo[1] < WORLD_HEIGHT) return true;
+                continue;
+            }
+            for (int y = lo[1]; y < hi[1]; y++) {
+                if (get_block(world, x, y, z) != 0) return true;
+            }
+        }
+    }
+    return false;
+}
+
+static int reference_move_box(VoxelWorld* world, float min[3], float max[3], const float delta[3]) {
+    static const int order[3] = {1, 0, 2};
+    int blocked_axes = 0;
+    for (int i = 0; i < 3; i++) {
+        int axis = order[i];
+        float distance = delta[axis], travel = distance;
+        int lo[3], hi[3];
+        for (int k = 0; k < 3; k++) {
+            lo[k] = (int)floorf(min[k]);
+            hi[k] = (int)ceilf(max[k]);
+        }
+        if (distance > 0.0f) {
+            for (int cell = (int)ceilf(max[axis]); cell < (int)ceilf(max[axis] + distance); cell++) {
+                lo[axis] = cell;
+                hi[axis] = cell + 1;
+                if (!reference_blocked(world, lo, hi)) continue;
+                travel = fmaxf(cell - PLAYER_SKIN - max[axis], 0.0f);
+                blocked_axes |= 1 << axis;
+                break;
+            }
+        } else if (distance < 0.0f) {
+            for (int cell = (int)floorf(min[axis]) - 1; cell >= (int)floorf(min[axis] + distance); cell--) {
+                lo[axis] = cell;
+                hi[axis] = cell + 1;
+                if (!reference_blocked(world, lo, hi)) continue;
+                travel = fminf(cell + 1 + PLAYER_SKIN - min[axis], 0.0f);
+                blocked_axes |= 1 << axis;
+                break;
+            }
+        }
+        min[axis] += travel;
+        max[axis] += travel;
+    }
+    return blocked_axes;
+}
+
+// Player-sized boxes near the ground with moves of up to `reach` blocks per axis
+typedef struct {
+    float min[3], max[3], delta[3];
+} BoxMove;
+
+static void random_moves(VoxelWorld* world, BoxMove* moves, int count, float reach, unsigned int seed) {
+    unsigned int state = seed;
+    int span = world->chunk_count * CHUNK_SIZE - 2;
+    int origin = -world->view_distance * CHUNK_SIZE + 1;
+    for (int i = 0; i < count; i++) {
+        float x = origin + (next_random(&state) % (span * 64)) / 64.0f;
+        float z = origin + (next_random(&state) % (span * 64)) / 64.0f;
+        int ground = occupancy_first_solid_below(world, (int)floorf(x), WORLD_HEIGHT - 1, (int)floorf(z));
+        float y = ground + 1 + ((int)(next_random(&state) % 256) - 64) / 64.0f;
+        moves[i] = (BoxMove){{x - 0.3f, y, z - 0.3f}, {x + 0.3f, y + PLAYER_HEIGHT, z + 0.3f}, {0}};
+        for (int k = 0; k < 3; k++) moves[i].delta[k] = ((int)(next_random(&state) % 2049) - 1024) / 1024.0f * reach;
+    }
+}
+
+static void bench_player_physics(void) {
+    static VoxelWorld world;
+
+    json_open("player_physics");
+    if (!init_bench_world(&world, -1)) {
+        json_close();
+        return;
+    }
+
+    json_bool("lands_on_ground", lands_on_ground(&world));
+    float jump_height;
+    json_bool("jump_expected", jump_expected(&world, &jump_height));
+    json_num("jump_height", jump_height);
+    json_bool("wall_stops_walk", wall_stops_walk(&world));
+    json_bool("no_tunnelling", no_tunnelling(&world));
+
+    Player first, second;
+    unsigned int hash = scripted_walk(&world, &first);
+    bool same = scripted_walk(&world, &second) == hash && first.on_ground == second.on_ground &&
+                memcmp(first.position, second.position, sizeof(first.position)) == 0 &&
+                memcmp(first.velocity, second.velocity, sizeof(first.velocity)) == 0;
+    json_int("trajectory_hash", hash);
+    json_bool("deterministic", same);
+
+    // Random moves against the get_block reference, at walking and at
+    // falling-through-the-world reach
+    static const float reaches[] = {0.5f, 8.0f};
+    static const char* const reach_names[] = {"short_moves", "long_moves"};
+    BoxMove* moves = malloc(COLLISION_MOVES * sizeof(BoxMove));
+    BoxMove* reference = malloc(COLLISION_MOVES * sizeof(BoxMove));
+    int* blocked = malloc(COLLISION_MOVES * sizeof(int));
+    bool matches = moves && reference && blocked;
+    for (int r = 0; r < 2 && matches; r++) {
+        random_moves(&world, moves, COLLISION_MOVES, reaches[r], bench_seed + r);
+        memcpy(reference, moves, COLLISION_MOVES * sizeof(BoxMove));
+
+        double start = now_ns();
+        for (int i = 0; i < COLLISION_MOVES; i++) {
+            blocked[i] = player_move_box(&world, moves[i].min, moves[i].max, moves[i].delta);
+        }
+        double swept_ns = now_ns() - start;
+        start = now_ns();
+        long blocked_count = 0;
+        for (int i = 0; i < COLLISION_MOVES; i++) {
+            int axes = reference_move_box(&world, reference[i].min, reference[i].max, reference[i].delta);
+            matches &= axes == blocked[i] && memcmp(&moves[i], &reference[i], sizeof(BoxMove)) == 0;
+            blocked_count += axes != 0;
+        }
+        double reference_ns = now_ns() - start;
+
+        json_open(reach_names[r]);
+        json_num("reach", reaches[r]);
+        json_num("blocked_fraction", (double)blocked_count / COLLISION_MOVES);
+        json_num("moves_per_second", COLLISION_MOVES / (swept_ns / 1e9));
+        json_num("get_block_moves_per_second", COLLISION_MOVES / (reference_ns / 1e9));
+        json_close();
+    }
+    json_bool("matches_get_block_reference", matches);
+    free(moves);
+    free(reference);
+    free(blocked);
+    json_close();
+
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Skybox cost per frame against the star count
+
+#define SKY_FRAMES 2000  // Frames timed per star count with the colour table
+#define SKY_LEGACY_STAR_WRITES 20000000L  // Star vertices written per star count on the old path
+#define SKY_COLOR_SAMPLES 100000
+
+// What the immediate-mode path sent per star each night frame
+typedef struct {
+    float x, y, z, brightness;
+} LegacyStarVertex;
+
+// The sky colour as update_skybox computed it every frame before the table
+static Color legacy_sky_color(float t) {
+    Color dawn = {0.7f, 0.5f, 0.3f}, day = {0.4f, 0.6f, 1.0f};
+    Color dusk = {0.7f, 0.5f, 0.3f}, night = {0.02f, 0.02f, 0.05f};
+    Color from = dawn, to = day;
+    float f = t * 4.0f;
+    if (t >= 0.75f) {
+        from = dusk, to = night, f = (t - 0.75f) * 4.0f;
+    } else if (t >= 0.25f) {
+        from = day, to = dusk, f = (t - 0.25f) * 2.0f;
+    }
+    return (Color){from.r + (to.r - from.r) * f, from.g + (to.g - from.g) * f, from.b + (to.b - from.b) * f};
+}
+
+static float legacy_star_fade(float t) {
+    if (t >= 0.75f) return (t - 0.75f) * 4.0f;
+    if (t <= 0.25f) return (0.25f - t) * 4.0f;
+    return 0.0f;
+}
+
+// One frame of the old path: the colour recomputed, then every star faded
+// and written out again
+static void legacy_sky_frame(Skybox* sky, float delta_time, LegacyStarVertex* out) {
+    sky->time_of_day += sky->day_cycle_speed * delta_time;
+    if (sky->time_of_day >= 1.0f) sky->time_of_day -= 1.0f;
+    float t = sky->time_of_day;
+    sky->sun_angle = t * 2.0f * (float)M_PI;
+    sky->sky_color = legacy_sky_color(t);
+    sky->fog_color = (Color){sky->sky_color.r * 0.8f, sky->sky_color.g * 0.8f, sky->sky_color.b * 0.8f};
+    float fade = legacy_star_fade(t);
+    if (fade <= 0.0f) return;
+    for (int i = 0; i < sky->star_count; i++) {
+        const Star* star = &sky->stars[i];
+        out[i] = (LegacyStarVertex){star->position.x, star->position.y, star->position.z, star->brightness * fade};
+    }
+}
+
+static void bench_skybox(void) {
+    json_open("skybox");
+
+    // The table against the piecewise colours it replaced, across the day
+    Skybox sky;
+    bool colors_match = skybox_init(&sky, 0);
+    double max_error = 0.0;
+    for (int i = 0; i < SKY_COLOR_SAMPLES && colors_match; i++) {
+        float t = (float)i / SKY_COLOR_SAMPLES;
+        sky.time_of_day = t;
+        skybox_advance(&sky, 0.0f);
+        Color want = legacy_sky_color(t);
+        double error = fmax(fabs(sky.sky_color.r - want.r), fmax(fabs(sky.sky_color.g - want.g),
+                                                                  fabs(sky.sky_color.b - want.b)));
+        if (error > max_error) max_error = error;
+        colors_match &= fabs(sky.star_fade - legacy_star_fade(t)) < 1e-6 &&
+                        fabs(sky.fog_color.r - want.r * 0.8f) < 1e-4;
+    }
+    skybox_free(&sky);
+    json_int("lut_entries", SKY_LUT_SIZE);
+    json_num("lut_max_error", max_error);
+    json_bool("lut_matches_piecewise", colors_match && max_error < 1e-4);
+
+    // Night frames, when every star is drawn, at growing star counts
+    static const int star_counts[] = {1000, 10000, 100000, 1000000};
+    const int count_total = (int)(sizeof(star_counts) / sizeof(star_counts[0]));
+    double fewest_ns = 0.0, most_ns = 0.0;
+    bool ran = true;
+    for (int c = 0; c < count_total; c++) {
+        int stars = star_counts[c];
+        LegacyStarVertex* vertices = malloc(sizeof(LegacyStarVertex) * stars);
+        if (!vertices || !skybox_init(&sky, stars)) {
+            free(vertices);
+            ran = false;
+            break;
+        }
+
+        sky.time_of_day = 0.85f;
+        double start = now_ns();
+        for (int f = 0; f < SKY_FRAMES; f++) skybox_advance(&sky, 1.0f / 60.0f);
+        double table_ns = (now_ns() - start) / SKY_FRAMES;
+
+        int legacy_frames = (int)(SKY_LEGACY_STAR_WRITES / stars);
+        if (legacy_frames > SKY_FRAMES) legacy_frames = SKY_FRAMES;
+        sky.time_of_day = 0.85f;
+        start = now_ns();
+        for (int f = 0; f < legacy_frames; f++) legacy_sky_frame(&sky, 1.0f / 60.0f, vertices);
+        double legacy_ns = (now_ns() - start) / legacy_frames;
+
+        char key[32];
+        snprintf(key, sizeof(key), "stars_%d", stars);
+        json_open(key);
+        json_num("frame_ns", table_ns);
+        json_num("legacy_frame_ns", legacy_ns);
+        json_int("star_bytes", (long)(stars * sizeof(Star)));
+        json_close();
+
+        if (c == 0) fewest_ns = table_ns;
+        most_ns = table_ns;
+        skybox_free(&sky);
+        free(vertices);
+    }
+    // Noise on a frame of a few nanoseconds allows a little slack
+    json_bool("flat_cost_expected", ran && most_ns <= fewest_ns * 3.0 + 20.0);
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Software rasterizer: throughput over the whole world and deterministic frames
+
+#define SOFT_WIDTH 640
+#define SOFT_HEIGHT 360
+#define SOFT_FRAMES 8  // Frames timed per pose
+#define SOFT_THREADED 4  // Threads for the frames compared against one thread
+
+static const Projection soft_projection = {60.0f, (float)SOFT_WIDTH / SOFT_HEIGHT, 0.1f, 1000.0f};
+
+// Build the draw list for a pose and draw one frame
+static void soft_frame(Renderer* renderer, VoxelWorld* world, DrawList* list, const Camera* camera) {
+    Frustum frustum;
+    frustum_from_camera(&frustum, camera, &soft_projection);
+    draw_list_build(list, world, &frustum, NULL);
+    renderer_begin_frame(renderer, world, camera, &soft_projection);
+    renderer_draw(renderer, list);
+}
+
+// Fraction of pixels that differ between two frames of the same size
+static double frame_difference(const Renderer* a, const Renderer* b) {
+    int width, height;
+    const uint32_t* pa = soft_renderer_pixels(a, &width, &height);
+    const uint32_t* pb = soft_renderer_pixels(b, &width, &height);
+    long differ = 0;
+    for (long i = 0; i < (long)width * height; i++) differ += pa[i] != pb[i];
+    return (double)differ / ((double)width * height);
+}
+
+// Fraction of pixels not left at the sky colour
+static double frame_coverage(const Renderer* renderer, const VoxelWorld* world) {
+    int width, height;
+    const uint32_t* pixels = soft_renderer_pixels(renderer, &width, &height);
+    uint32_t sky = pixels[0];
+    const Color* c = &world->skybox.sky_color;
+    sky = 0xFF000000u | (uint32_t)(c->b * 255.0f + 0.5f) << 16 | (uint32_t)(c->g * 255.0f + 0.5f) << 8 |
+          (uint32_t)(c->r * 255.0f + 0.5f);
+    long covered = 0;
+    for (long i = 0; i < (long)width * height; i++) covered += pixels[i] != sky;
+    return (double)covered / ((double)width * height);
+}
+
+static void bench_software_render(void) {
+    static VoxelWorld world;
+    const Camera poses[] = {
+        {8.0f, WORLD_HEIGHT * 0.75f, 8.0f, -10.0f, 0.0f},
+        {8.0f, WORLD_HEIGHT * 0.75f, 8.0f, -10.0f, 135.0f},
+        {8.0f, WORLD_HEIGHT + 20.0f, 8.0f, -60.0f, 45.0f},
+    };
+    static const char* const pose_names[] = {"horizon", "horizon_back", "overhead"};
+    const int pose_count = (int)(sizeof(poses) / sizeof(poses[0]));
+
+    json_open("software_render");
+    WorldConfig config = default_world_config();
+    config.worker_count = -1;
+    config.seed = bench_seed;
+    config.view_distance = bench_render_distance;
+    Renderer* renderer = soft_renderer_create(SOFT_WIDTH, SOFT_HEIGHT, 0);
+    Renderer* single = soft_renderer_create(SOFT_WIDTH, SOFT_HEIGHT, 1);
+    Renderer* threaded = soft_renderer_create(SOFT_WIDTH, SOFT_HEIGHT, SOFT_THREADED);
+    if (!renderer || !single || !threaded || !init_voxel_world_with_config(&world, &config)) {
+        renderer_destroy(renderer);
+        renderer_destroy(single);
+        renderer_destroy(threaded);
+        json_close();
+        return;
+    }
+    wait_for_chunk_loads(&world);
+    drain_remesh_queue(&world);
+    renderer_upload(renderer, &world);
+
+    json_int("view_distance", world.view_distance);
+    json_int("width", SOFT_WIDTH);
+    json_int("height", SOFT_HEIGHT);
+    json_int("threads", soft_renderer_thread_count(renderer));
+
+    DrawList list = {0}, reversed = {0};
+    bool deterministic = true, threads_match = true, order_independent = true, terrain_visible = true;
+    double total_ns = 0.0, total_triangles = 0.0;
+    for (int p = 0; p < pose_count; p++) {
+        soft_frame(renderer, &world, &list, &poses[p]);
+        uint64_t hash = soft_renderer_hash(renderer);
+        SoftFrameStats frame = *soft_renderer_stats(renderer);
+
+        double start = now_ns();
+        for (int f = 0; f < SOFT_FRAMES; f++) {
+            soft_frame(renderer, &world, &list, &poses[p]);
+            deterministic &= soft_renderer_hash(renderer) == hash;
+        }
+        double frame_ns = (now_ns() - start) / SOFT_FRAMES;
+        total_ns += frame_ns;
+        total_triangles += frame.triangles_submitted;
+
+        // One thread and several must agree pixel for pixel
+        soft_frame(single, &world, &list, &poses[p]);
+        soft_frame(threaded, &world, &list, &poses[p]);
+        threads_match &= soft_renderer_hash(single) == hash && soft_renderer_hash(threaded) == hash;
+
+        // Drawn back to front, the depth test must give the same picture,
+        // up to pixels where coplanar faces tie
+        if (reversed.capacity < list.count) {
+            free(reversed.items);
+            reversed.items = malloc(sizeof(DrawItem) * list.count);
+            reversed.capacity = reversed.items ? list.count : 0;
+        }
+        reversed.count = reversed.items ? list.count : 0;
+        for (int i = 0; i < reversed.count; i++) reversed.items[i] = list.items[list.count - 1 - i];
+        renderer_begin_frame(single, &world, &poses[p], &soft_projection);
+        renderer_draw(single, &reversed);
+        double reversed_difference = frame_difference(renderer, single);
+        order_independent &= reversed_difference < 0.001;
+
+        double coverage = frame_coverage(renderer, &world);
+        terrain_visible &= coverage > 0.2;
+
+        json_open(pose_names[p]);
+        json_int("draw_items", list.count);
+        json_int("triangles_submitted", frame.triangles_submitted);
+        json_int("triangles_drawn", frame.triangles_drawn);
+        json_int("pixels_written", frame.pixels_written);
+        json_num("coverage", coverage);
+        json_num("geometry_ms", frame.geometry_ns / 1e6);
+        json_num("raster_ms", frame.raster_ns / 1e6);
+        json_num("ms_per_frame", frame_ns / 1e6);
+        json_num("triangles_per_second", frame.triangles_submitted / (frame_ns / 1e9));
+        json_num("reversed_order_difference", reversed_difference);
+        char hash_text[32];
+        snprintf(hash_text, sizeof(hash_text), "%016llx", (unsigned long long)hash);
+        json_str("frame_hash", hash_text);
+        json_close();
+
+        if (bench_image_directory) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/software_%s.ppm", bench_image_directory, pose_names[p]);
+            if (!soft_renderer_write_ppm(renderer, path)) fprintf(stderr, "Could not write %s\n", path);
+        }
+    }
+    json_num("ms_per_frame", total_ns / pose_count / 1e6);
+    json_num("triangles_per_second", total_triangles / (total_ns / 1e9));
+    json_bool("deterministic", deterministic);
+    json_bool("threads_match", threads_match);
+    json_bool("depth_order_independent", order_independent);
+    json_bool("terrain_visible", terrain_visible);
+    json_close();
+
+    free(reversed.items);
+    draw_list_free(&list);
+    renderer_release(renderer, &world);
+    renderer_destroy(renderer);
+    renderer_destroy(single);
+    renderer_destroy(threaded);
+    cleanup_voxel_world(&world);
+}
+
+// ---------------------------------------------------------------------------
+// Shared vertex arena: allocator consistency, fragmentation while streaming,
+// and draw calls with one multi-draw
+
+#define ARENA_TEST_CAPACITY 100000
+#define ARENA_TEST_OPERATIONS 20000
+#define ARENA_TEST_SLOTS 256
+#define ARENA_EDITS_PER_STEP 8
+
+// Random allocations and frees checked against a map of every unit
+static bool arena_allocator_consistent(void) {
+    VertexArena arena;
+    unsigned char* owner = calloc(ARENA_TEST_CAPACITY, 1);
+    if (!owner || !vertex_arena_init(&arena, ARENA_TEST_CAPACITY)) {
+        free(owner);
+        return false;
+    }
+    ArenaRange slots[ARENA_TEST_SLOTS] = {{0, 0}};
+    unsigned int state = bench_seed;
+    bool ok = true;
+    for (int op = 0; op < ARENA_TEST_OPERATIONS && ok; op++) {
+        ArenaRange* slot = &slots[next_random(&state) % ARENA_TEST_SLOTS];
+        if (slot->count > 0) {
+            for (int i = slot->first; i < slot->first + slot->count; i++) owner[i] = 0;
+            vertex_arena_free(&arena, slot->first, slot->count);
+            slot->count = 0;
+        } else {
+            int count = 1 + (int)(next_random(&state) % 2000);
+            int first = vertex_arena_alloc(&arena, count);
+            if (first < 0) continue;
+            *slot = (ArenaRange){first, count};
+            for (int i = first; i < first + count; i++) {
+                ok &= owner[i] == 0;
+                owner[i] = 1;
+            }
+        }
+        // The free list must be sorted, merged and exactly the unowned units
+        int free_units = 0;
+        for (int i = 0; i < arena.free_count; i++) {
+            const ArenaRange* range = &arena.free_ranges[i];
+            if (i > 0) ok &= arena.free_ranges[i - 1].first + arena.free_ranges[i - 1].count < range->first;
+            free_units += range->count;
+        }
+        ok &= free_units + arena.used == arena.capacity;
+    }
+    long owned = 0;
+    for (int i = 0; i < ARENA_TEST_CAPACITY; i++) owned += owner[i];
+    ok &= owned == arena.used;
+    vertex_arena_destroy(&arena);
+    free(owner);
+    return ok;
+}
+
+static int compare_ranges(const void* a, const void* b) {
+    const ArenaRange* ra = a;
+    const ArenaRange* rb = b;
+    return (ra->first > rb->first) - (ra->first < rb->first);
+}
+
+// Every loaded chunk's range inside the arena, none overlapping, and the
+// arena's count of used units matching them
+static bool arena_ranges_disjoint(VoxelWorld* world, const VertexArena* arena) {
+    int total = world->chunk_count * world->chunk_count, count = 0;
+    ArenaRange* ranges = malloc(sizeof(ArenaRange) * total);
+    if (!ranges) return false;
+    long used = 0;
+    bool ok = true;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            const Chunk* chunk = chunk_at_slot(world, x, z);
+            if (chunk->vbo_capacity == 0) continue;
+            ok &= chunk->is_loaded && chunk->mesh.vertex_count <= chunk->vbo_capacity;
+            ranges[count++] = (ArenaRange){chunk->vbo_first, chunk->vbo_capacity};
+            used += chunk->vbo_capacity;
+        }
+    }
+    qsort(ranges, count, sizeof(ArenaRange), compare_ranges);
+    for (int i = 0; i < count; i++) {
+        ok &= ranges[i].first >= 0 && ranges[i].first + ranges[i].count <= arena->capacity;
+        if (i > 0) ok &= ranges[i - 1].first + ranges[i - 1].count <= ranges[i].first;
+    }
+    free(ranges);
+    return ok && used == arena->used;
+}
+
+// Record uploads as the renderer would after placing
+static void mark_chunks_uploaded(VoxelWorld* world) {
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            if (!chunk->is_loaded || !chunk->vbo_stale) continue;
+            chunk->vbo_vertex_count = chunk->mesh.vertex_count;
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                chunk->vbo_section_first[s] = chunk->mesh.section_first[s];
+                chunk->vbo_section_count[s] = chunk->mesh.section_vertex_count[s];
+            }
+            chunk->vbo_stale = false;
+        }
+    }
+}
+
+// Stream the world along x with block edits on the way, placing meshes in
+// an arena that starts at `initial_capacity` vertices (0 for the default)
+static bool arena_streaming(VoxelWorld* world, int initial_capacity, const char* key) {
+    VertexArena arena;
+    if (!vertex_arena_init(&arena, initial_capacity)) return false;
+
+    // Start over as a new renderer would: nothing placed, everything stale
+    world->retired_count = 0;
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            chunk->vbo_first = 0;
+            chunk->vbo_capacity = 0;
+            chunk->vbo_stale = chunk->is_loaded;
+        }
+    }
+    unsigned int state = bench_seed;
+    int repacks = 0;
+    float max_fragmentation = 0.0f;
+    long placements = 0;
+    double place_ns = 0.0;
+    bool disjoint = true;
+    for (int step = 0; step <= bench_crossings; step++) {
+        if (step > 0) scroll_chunk_window(world, world->player_chunk_x + 1, world->player_chunk_z);
+        for (int e = 0; e < ARENA_EDITS_PER_STEP; e++) {
+            int span = world->chunk_count * CHUNK_SIZE;
+            int x = (world->player_chunk_x - world->view_distance) * CHUNK_SIZE + (int)(next_random(&state) % span);
+            int z = (world->player_chunk_z - world->view_distance) * CHUNK_SIZE + (int)(next_random(&state) % span);
+            int y = occupancy_first_solid_below(world, x, WORLD_HEIGHT - 1, z) + 1;
+            if (y > 0 && y < WORLD_HEIGHT) set_block(world, x, y, z, BLOCK_DIRT);
+        }
+        drain_remesh_queue(world);
+        for (int x = 0; x < world->chunk_count; x++) {
+            for (int z = 0; z < world->chunk_count; z++) {
+                const Chunk* chunk = chunk_at_slot(world, x, z);
+                placements += chunk->is_loaded && chunk->vbo_stale;
+            }
+        }
+
+        double start = now_ns();
+        repacks += chunk_arena_place(&arena, world);
+        place_ns += now_ns() - start;
+        disjoint &= arena_ranges_disjoint(world, &arena);
+        mark_chunks_uploaded(world);
+        float fragmentation = vertex_arena_fragmentation(&arena);
+        if (fragmentation > max_fragmentation) max_fragmentation = fragmentation;
+    }
+
+    json_open(key);
+    json_int("initial_capacity", initial_capacity);
+    json_int("capacity", arena.capacity);
+    json_int("used", arena.used);
+    json_int("free_ranges", arena.free_count);
+    json_num("fragmentation", vertex_arena_fragmentation(&arena));
+    json_num("max_fragmentation", max_fragmentation);
+    json_int("repacks", repacks);
+    json_int("placements", placements);
+    json_num("place_ns_per_step", place_ns / (bench_crossings + 1));
+    json_bool("ranges_disjoint", disjoint);
+    json_close();
+    vertex_arena_destroy(&arena);
+    return disjoint;
+}
+
+static void bench_vertex_arena(void) {
+    static VoxelWorld world;
+
+    json_open("vertex_arena");
+    json_bool("allocator_consistent", arena_allocator_consistent());
+
+    bool disjoint = true;
+    if (init_bench_world(&world, -1)) {
+        drain_remesh_queue(&world);
+        long start_vertices = 0;
+        for (int x = 0; x < world.chunk_count; x++) {
+            for (int z = 0; z < world.chunk_count; z++) {
+                start_vertices += chunk_at_slot(&world, x, z)->mesh.vertex_count;
+            }
+        }
+        disjoint &= arena_streaming(&world, 0, "default_arena");
+        // Too small for the first view, so the first placement repacks into
+        // a larger arena
+        disjoint &= arena_streaming(&world, (int)(start_vertices / 2), "tight_arena");
+
+        // Draw calls for one view: a draw per visible range with a transform
+        // per chunk before, one multi-draw of the merged ranges now
+        Camera camera = {(world.player_chunk_x * CHUNK_SIZE) + 8.0f, WORLD_HEIGHT * 0.75f,
+                         (world.player_chunk_z * CHUNK_SIZE) + 8.0f, -10.0f, 0.0f};
+        Frustum frustum;
+        frustum_from_camera(&frustum, &camera, &bench_projection);
+        DrawList list = {0};
+        draw_list_build(&list, &world, &frustum, NULL);
+        int chunks = 0, ranges = 0;
+        for (int i = 0; i < list.count; i++) {
+            const DrawItem* item = &list.items[i];
+            if (i == 0 || list.items[i - 1].chunk != item->chunk) chunks++;
+            const DrawItem* last = i > 0 ? &list.items[i - 1] : NULL;
+            bool joins = last && last->chunk->vbo_first + last->first_vertex + last->vertex_count ==
+                                     item->chunk->vbo_first + item->first_vertex;
+            ranges += !joins;
+        }
+        json_open("draw_calls");
+        json_int("per_chunk_transforms", chunks);
+        json_int("per_range_draw_calls", list.count);
+        json_int("merged_ranges", ranges);
+        json_int("multi_draw_calls", list.count > 0 ? 1 : 0);
+        json_close();
+        draw_list_free(&list);
+        cleanup_voxel_world(&world);
+    }
+    json_bool("ranges_disjoint", disjoint);
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Packed chunk vertices against the float vertices they replaced
+
+#define PACKED_MESH_REPEATS 8  // Builds of the window timed per format
+#define PACKED_WRAP_SAMPLES 100000
+
+static const int packed_view_distances[] = {4, 8, 16, 32};
+
+// A chunk's mesh as the float path held and uploaded it: decoded, then moved
+// to world coordinates
+static void expand_mesh(const Chunk* chunk, MeshVertex* out) {
+    float offset_x = (float)(chunk->world_x * CHUNK_SIZE), offset_z = (float)(chunk->world_z * CHUNK_SIZE);
+    for (int i = 0; i < chunk->mesh.vertex_count; i++) {
+        chunk_mesh_decode_vertex(&chunk->mesh.vertices[i], &out[i]);
+        out[i].x += offset_x;
+        out[i].z += offset_z;
+    }
+}
+
+// The vertex shader's decode, in the same float arithmetic, must agree with
+// chunk_mesh_decode_vertex on every vertex and put it in its own chunk
+static bool shader_decode_matches(const VoxelWorld* world, long* checked) {
+    const MeshShading* shading = chunk_mesh_shading();
+    bool ok = true;
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        const Chunk* chunk = &world->chunks[i];
+        if (!chunk->is_loaded) continue;
+        for (int v = 0; v < chunk->mesh.vertex_count; v++) {
+            const PackedVertex* vertex = &chunk->mesh.vertices[v];
+            float lo = (float)(vertex->fields & 0xffff), hi = (float)(vertex->fields >> 16);
+            float x = fmodf(lo, 32.0f), y = fmodf(floorf(lo / 32.0f), 64.0f), z = floorf(lo / 2048.0f);
+            int normal = (int)fmodf(hi, 8.0f), ao = (int)fmodf(floorf(hi / 8.0f), 4.0f);
+            int light = (int)fmodf(floorf(hi / 32.0f), 32.0f), block = (int)floorf(hi / 1024.0f);
+            if (normal >= 6 || light >= PACKED_LIGHT_LEVELS || block >= BLOCK_TYPE_COUNT) return false;
+            const Color* color = &shading->face_color[block][normal];
+            float shade = shading->brightness[normal][light] * shading->occlusion[ao];
+
+            MeshVertex want;
+            chunk_mesh_decode_vertex(vertex, &want);
+            ok &= x == want.x && y == want.y && z == want.z && ao == want.ao;
+            ok &= fabsf(color->r * shade * 255.0f - want.r) <= 0.5f &&
+                  fabsf(color->g * shade * 255.0f - want.g) <= 0.5f &&
+                  fabsf(color->b * shade * 255.0f - want.b) <= 0.5f;
+            ok &= chunk_mesh_unwrap_chunk(vertex->chunk_x, world->player_chunk_x) == chunk->world_x &&
+                  chunk_mesh_unwrap_chunk(vertex->chunk_z, world->player_chunk_z) == chunk->world_z;
+            (*checked)++;
+        }
+    }
+    return ok;
+}
+
+// Wrapped chunk coordinates come back exactly anywhere in the 32-bit range,
+// including across the 16-bit wrap, for chunks within the view distance
+static bool chunk_unwrap_exact(void) {
+    unsigned int state = bench_seed;
+    for (int i = 0; i < PACKED_WRAP_SAMPLES; i++) {
+        int near = (int)next_random(&state) - (int)(next_random(&state) >> 1);
+        if (i % 4 == 0) near = 32768 * (int)(next_random(&state) % 8) - 4 * 32768;
+        int chunk = near + (int)(next_random(&state) % (2 * MAX_VIEW_DISTANCE + 1)) - MAX_VIEW_DISTANCE;
+        if (chunk_mesh_unwrap_chunk((int16_t)(uint16_t)chunk, near) != chunk) return false;
+    }
+    return true;
+}
+
+// Mesh the window, then time a packed build against the same build expanded
+// to float vertices, and the bytes staged for upload by each
+static void packed_meshing(VoxelWorld* world) {
+    int chunk_count = world->chunk_count * world->chunk_count;
+    int largest = 0;
+    for (int i = 0; i < chunk_count; i++) {
+        if (world->chunks[i].mesh.vertex_count > largest) largest = world->chunks[i].mesh.vertex_count;
+    }
+    MeshVertex* expanded = malloc(sizeof(MeshVertex) * (largest > 0 ? largest : 1) * 2);
+    PackedVertex* staged = malloc(sizeof(PackedVertex) * (largest > 0 ? largest : 1) * 2);
+    if (!expanded || !staged) {
+        free(expanded);
+        free(staged);
+        return;
+    }
+
+    double mesh_ns = 0.0, expand_ns = 0.0, packed_upload_ns = 0.0, float_upload_ns = 0.0;
+    long vertices = 0, builds = 0;
+    for (int r = 0; r < PACKED_MESH_REPEATS; r++) {
+        for (int i = 0; i < chunk_count; i++) {
+            Chunk* chunk = &world->chunks[i];
+            if (!chunk->is_loaded) continue;
+            ChunkNeighbours neighbours = get_chunk_neighbours(world, chunk);
+            double start = now_ns();
+            chunk_mesh_build(chunk, &neighbours, &chunk->mesh);
+            double built = now_ns();
+            expand_mesh(chunk, expanded);
+            double expanded_at = now_ns();
+            mesh_ns += built - start;
+            expand_ns += expanded_at - built;
+
+            // Staging as the renderers did: the packed mesh is copied as is,
+            // the float one moved to world coordinates first
+            int count = chunk->mesh.vertex_count;
+            start = now_ns();
+            memcpy(staged, chunk->mesh.vertices, count * sizeof(PackedVertex));
+            packed_upload_ns += now_ns() - start;
+            start = now_ns();
+            expand_mesh(chunk, expanded);
+            float_upload_ns += now_ns() - start;
+            vertices += count;
+            builds++;
+        }
+    }
+    if (builds == 0) builds = 1;
+    json_open("meshing");
+    json_int("chunks", builds / PACKED_MESH_REPEATS);
+    json_num("vertices_per_chunk", (double)vertices / builds);
+    json_num("packed_mesh_ns_per_chunk", mesh_ns / builds);
+    json_num("float_mesh_ns_per_chunk", (mesh_ns + expand_ns) / builds);
+    json_int("packed_upload_bytes_per_chunk", (long)((double)vertices / builds * sizeof(PackedVertex)));
+    json_int("float_upload_bytes_per_chunk", (long)((double)vertices / builds * sizeof(MeshVertex)));
+    json_num("packed_stage_ns_per_chunk", packed_upload_ns / builds);
+    json_num("float_stage_ns_per_chunk", float_upload_ns / builds);
+    json_close();
+    free(expanded);
+    free(staged);
+}
+
+// CPU mesh storage, GPU buffer and per-frame vertex fetch of a whole window
+// in both formats
+static void packed_footprint(VoxelWorld* world, int view_distance) {
+    long vertices = 0, reserved = 0;
+    int chunks = 0;
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        const Chunk* chunk = &world->chunks[i];
+        if (!chunk->is_loaded) continue;
+        chunks++;
+        vertices += chunk->mesh.vertex_count;
+        reserved += chunk->mesh.capacity;
+    }
+    VertexArena arena;
+    int arena_capacity = 0;
+    if (vertex_arena_init(&arena, 0)) {
+        chunk_arena_place(&arena, world);
+        arena_capacity = arena.capacity;
+        mark_chunks_uploaded(world);
+        vertex_arena_destroy(&arena);
+    }
+
+    char key[32];
+    snprintf(key, sizeof(key), "view_distance_%d", view_distance);
+    json_open(key);
+    json_int("chunks", chunks);
+    json_int("vertices", vertices);
+    json_int("packed_mesh_bytes", reserved * (long)sizeof(PackedVertex));
+    json_int("float_mesh_bytes", reserved * (long)sizeof(MeshVertex));
+    json_int("packed_buffer_bytes", arena_capacity * (long)sizeof(PackedVertex));
+    json_int("float_buffer_bytes", arena_capacity * (long)sizeof(MeshVertex));
+    json_int("packed_frame_fetch_bytes", vertices * (long)sizeof(PackedVertex));
+    json_int("float_frame_fetch_bytes", vertices * (long)sizeof(MeshVertex));
+    json_close();
+}
+
+static void bench_packed_vertices(void) {
+    static VoxelWorld world;
+
+    json_open("packed_vertices");
+    json_int("packed_vertex_bytes", sizeof(PackedVertex));
+    json_int("float_vertex_bytes", sizeof(MeshVertex));
+    json_bool("chunk_unwrap_exact", chunk_unwrap_exact());
+
+    bool decode_matches = false;
+    if (init_bench_world(&world, -1)) {
+        drain_remesh_queue(&world);
+        long checked = 0;
+        decode_matches = shader_decode_matches(&world, &checked) && checked > 0;
+        json_int("vertices_decoded", checked);
+        packed_meshing(&world);
+        cleanup_voxel_world(&world);
+    }
+    json_bool("shader_decode_matches", decode_matches);
+
+    json_open("footprint");
+    for (int i = 0; i < (int)(sizeof(packed_view_distances) / sizeof(packed_view_distances[0])); i++) {
+        int view_distance = packed_view_distances[i];
+        if (!init_lod_world(&world, view_distance, true)) continue;
+        wait_for_chunk_loads(&world);
+        drain_remesh_queue(&world);
+        packed_footprint(&world, view_distance);
+        cleanup_voxel_world(&world);
+    }
+    json_close();
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Bulk region edits against set_block
+
+#define BULK_BOX_EDGE 32  // Edge of the filled box, in blocks
+#define BULK_SPHERE_RADIUS 12.0f
+#define BULK_LIST_EDITS 4096
+#define BULK_LIST_SPAN 48  // Edge of the square the edit list lands in
+
+// Times and counts of one edit made in bulk on one world and with set_block
+// on its twin
+typedef struct {
+    long bulk_voxels;
+    long single_voxels;
+    double bulk_ns;
+    double single_ns;
+    int bulk_queued;  // Chunks waiting for a remesh after the edit
+    int single_queued;
+} BulkEditResult;
+
+static void json_bulk_edit(const char* key, const BulkEditResult* result) {
+    json_open(key);
+    json_int("voxels_changed", result->bulk_voxels);
+    json_num("bulk_ms", result->bulk_ns / 1e6);
+    json_num("set_block_ms", result->single_ns / 1e6);
+    json_num("bulk_voxels_per_s", result->bulk_ns > 0 ? result->bulk_voxels * 1e9 / result->bulk_ns : 0.0);
+    json_num("set_block_voxels_per_s", result->single_ns > 0 ? result->single_voxels * 1e9 / result->single_ns : 0.0);
+    json_num("speedup", result->bulk_ns > 0 ? result->single_ns / result->bulk_ns : 0.0);
+    json_int("bulk_chunks_queued", result->bulk_queued);
+    json_int("set_block_chunks_queued", result->single_queued);
+    json_close();
+}
+
+// The edit the bulk call makes, block by block
+typedef enum { BULK_FILL, BULK_SPHERE, BULK_PASTE, BULK_LIST } BulkEditKind;
+
+typedef struct {
+    BulkEditKind kind;
+    int min[3];
+    int max[3];
+    float centre[3];
+    unsigned char block_type;
+    const VoxelBuffer* buffer;
+    const BlockEdit* edits;
+    int edit_count;
+} BulkEdit;
+
+static long bulk_edit_apply(VoxelWorld* world, const BulkEdit* edit) {
+    switch (edit->kind) {
+    case BULK_FILL:
+        return world_fill_box(world, edit->min, edit->max, edit->block_type);
+    case BULK_SPHERE:
+        return world_fill_sphere(world, edit->centre, BULK_SPHERE_RADIUS, edit->block_type);
+    case BULK_PASTE:
+        return world_paste_box(world, edit->min, edit->buffer, true);
+    default:
+        return world_apply_edits(world, edit->edits, edit->edit_count);
+    }
+}
+
+static void set_block_counted(VoxelWorld* world, int x, int y, int z, unsigned char block_type, long* changed) {
+    if (y < 0 || y >= WORLD_HEIGHT || get_block(world, x, y, z) == block_type) return;
+    set_block(world, x, y, z, block_type);
+    (*changed)++;
+}
+
+static long single_edit_apply(VoxelWorld* world, const BulkEdit* edit) {
+    long changed = 0;
+    if (edit->kind == BULK_LIST) {
+        for (int i = 0; i < edit->edit_count; i++) {
+            const BlockEdit* e = &edit->edits[i];
+            set_block_counted(world, e->x, e->y, e->z, e->block_type, &changed);
+        }
+        return changed;
+    }
+    for (int x = edit->min[0]; x < edit->max[0]; x++) {
+        for (int y = edit->min[1]; y < edit->max[1]; y++) {
+            for (int z = edit->min[2]; z < edit->max[2]; z++) {
+                if (edit->kind == BULK_FILL) {
+                    set_block_counted(world, x, y, z, edit->block_type, &changed);
+                } else if (edit->kind == BULK_SPHERE) {
+                    float dx = x + 0.5f - edit->centre[0], dy = y + 0.5f - edit->centre[1];
+                    float dz = z + 0.5f - edit->centre[2];
+                    if (dx * dx + dy * dy + dz * dz <= BULK_SPHERE_RADIUS * BULK_SPHERE_RADIUS) {
+                        set_block_counted(world, x, y, z, edit->block_type, &changed);
+                    }
+                } else {
+                    const VoxelBuffer* buffer = edit->buffer;
+                    int bx = x - edit->min[0], by = y - edit->min[1], bz = z - edit->min[2];
+                    unsigned char block_type = buffer->blocks[(bx * buffer->size[1] + by) * buffer->size[2] + bz];
+                    if (block_type != 0) set_block_counted(world, x, y, z, block_type, &changed);
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+// Make the same edit on both worlds, each drained of remeshes first
+static BulkEditResult compare_bulk_edit(VoxelWorld* bulk, VoxelWorld* single, const BulkEdit* edit) {
+    BulkEditResult result = {0};
+    drain_remesh_queue(bulk);
+    drain_remesh_queue(single);
+    double start = now_ns();
+    result.bulk_voxels = bulk_edit_apply(bulk, edit);
+    result.bulk_ns = now_ns() - start;
+    start = now_ns();
+    result.single_voxels = single_edit_apply(single, edit);
+    result.single_ns = now_ns() - start;
+    result.bulk_queued = bulk->remesh_queue.count;
+    result.single_queued = single->remesh_queue.count;
+    return result;
+}
+
+// Blocks that differ between two worlds with the same window
+static long world_block_differences(VoxelWorld* a, VoxelWorld* b) {
+    static DenseBlocks blocks_a, blocks_b;
+    long differences = 0;
+    for (int i = 0; i < a->chunk_count * a->chunk_count; i++) {
+        chunk_storage_decode(&a->chunks[i].storage, blocks_a);
+        chunk_storage_decode(&b->chunks[i].storage, blocks_b);
+        const unsigned char* pa = &blocks_a[0][0][0];
+        const unsigned char* pb = &blocks_b[0][0][0];
+        for (size_t k = 0; k < sizeof(DenseBlocks); k++) differences += pa[k] != pb[k];
+    }
+    return differences;
+}
+
+// Copy a box out, paste it elsewhere and copy it back: the two copies match
+static bool copy_paste_round_trip(VoxelWorld* world) {
+    int size[3] = {20, WORLD_HEIGHT, 12};
+    int from[3] = {-30, 0, 5}, to[3] = {9, 0, -23};
+    VoxelBuffer first, second;
+    if (!voxel_buffer_init(&first, size)) return false;
+    if (!voxel_buffer_init(&second, size)) {
+        voxel_buffer_free(&first);
+        return false;
+    }
+    world_copy_box(world, from, &first);
+    world_paste_box(world, to, &first, false);
+    world_copy_box(world, to, &second);
+    bool same = memcmp(first.blocks, second.blocks, (size_t)size[0] * size[1] * size[2]) == 0;
+    voxel_buffer_free(&first);
+    voxel_buffer_free(&second);
+    return same;
+}
+
+static void bench_bulk_edit(void) {
+    static VoxelWorld bulk, single;
+
+    json_open("bulk_edit");
+    if (!init_bench_world(&bulk, -1)) {
+        json_close();
+        return;
+    }
+    if (!init_bench_world(&single, -1)) {
+        cleanup_voxel_world(&bulk);
+        json_close();
+        return;
+    }
+    json_int("box_edge", BULK_BOX_EDGE);
+
+    int half = BULK_BOX_EDGE / 2;
+    BulkEdit fill = {BULK_FILL, {-half, 0, -half}, {half, BULK_BOX_EDGE, half}, {0}, BLOCK_DIRT, NULL, NULL, 0};
+    BulkEditResult result = compare_bulk_edit(&bulk, &single, &fill);
+    json_bulk_edit("fill_box", &result);
+    fill.block_type = 0;
+    result = compare_bulk_edit(&bulk, &single, &fill);
+    json_bulk_edit("clear_box", &result);
+
+    BulkEdit sphere = {BULK_SPHERE, {0}, {0}, {20.0f, WORLD_HEIGHT / 2.0f, -10.0f}, BLOCK_LAMP, NULL, NULL, 0};
+    for (int axis = 0; axis < 3; axis++) {
+        sphere.min[axis] = (int)floorf(sphere.centre[axis] - BULK_SPHERE_RADIUS);
+        sphere.max[axis] = (int)floorf(sphere.centre[axis] + BULK_SPHERE_RADIUS) + 1;
+    }
+    result = compare_bulk_edit(&bulk, &single, &sphere);
+    json_bulk_edit("fill_sphere", &result);
+
+    // The lamp sphere and the ground around it, stamped across the window
+    int size[3] = {24, 24, 24};
+    VoxelBuffer stamp;
+    if (voxel_buffer_init(&stamp, size)) {
+        world_copy_box(&bulk, sphere.min, &stamp);
+        BulkEdit paste = {BULK_PASTE, {30, 4, 30}, {30 + size[0], 4 + size[1], 30 + size[2]}, {0}, 0, &stamp, NULL, 0};
+        result = compare_bulk_edit(&bulk, &single, &paste);
+        json_bulk_edit("paste", &result);
+        voxel_buffer_free(&stamp);
+    }
+
+    BlockEdit* edits = malloc(sizeof(BlockEdit) * BULK_LIST_EDITS);
+    if (edits) {
+        unsigned int state = bench_seed;
+        for (int i = 0; i < BULK_LIST_EDITS; i++) {
+            int x = (int)(next_random(&state) % BULK_LIST_SPAN) - BULK_LIST_SPAN / 2;
+            int z = (int)(next_random(&state) % BULK_LIST_SPAN) - BULK_LIST_SPAN / 2;
+            int y = (int)(next_random(&state) % WORLD_HEIGHT);
+            unsigned char type = (unsigned char)(next_random(&state) % BLOCK_TYPE_COUNT);
+            edits[i] = (BlockEdit){x, y, z, type};
+        }
+        BulkEdit list = {BULK_LIST, {0}, {0}, {0}, 0, NULL, edits, BULK_LIST_EDITS};
+        result = compare_bulk_edit(&bulk, &single, &list);
+        json_bulk_edit("edit_list", &result);
+        free(edits);
+    }
+
+    // Edits of a few blocks relight block by block, so they cost about what
+    // set_block does rather than whole chunks
+    BulkEdit small = {BULK_FILL, {5, WORLD_HEIGHT / 2, 5}, {7, WORLD_HEIGHT / 2 + 2, 7}, {0}, BLOCK_LAMP, NULL, NULL, 0};
+    result = compare_bulk_edit(&bulk, &single, &small);
+    json_bulk_edit("small_box", &result);
+    BlockEdit one = {-3, WORLD_HEIGHT - 2, 9, BLOCK_DIRT};
+    BulkEdit single_edit = {BULK_LIST, {0}, {0}, {0}, 0, NULL, &one, 1};
+    result = compare_bulk_edit(&bulk, &single, &single_edit);
+    json_bulk_edit("single_edit", &result);
+
+    long differences = world_block_differences(&bulk, &single);
+    json_int("blocks_differing_from_set_block", differences);
+    json_bool("blocks_match_set_block", differences == 0);
+
+    // Batched relighting must land where lighting from scratch does
+    int chunks = bulk.chunk_count * bulk.chunk_count;
+    DenseLight* snapshot = malloc(sizeof(DenseLight) * chunks);
+    bool light_matches = false;
+    if (snapshot) {
+        snapshot_light(&bulk, snapshot);
+        relight_window(&bulk);
+        light_matches = light_differences(&bulk, snapshot) == 0;
+        free(snapshot);
+    }
+    json_bool("light_matches_full", light_matches);
+    json_bool("copy_paste_round_trip", copy_paste_round_trip(&bulk));
+
+    cleanup_voxel_world(&single);
+    cleanup_voxel_world(&bulk);
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Chunk window scrolling against the pre-ring-buffer layout
+
+// A chunk as it was before palette compression: blocks held inline
+typedef struct {
+    DenseBlocks blocks;
+    bool is_loaded;
+    int world_x;
+    int world_z;
+} LegacyChunk;
+
+// The chunk window as it was before the ring buffer: a dense grid centred on
+// the player that is rebuilt through a temporary copy on every crossing
+typedef struct {
+    LegacyChunk chunks[LEGACY_CHUNK_COUNT][LEGACY_CHUNK_COUNT];
+    int offset_x;
+    int offset_z;
+} LegacyWindow;
+
+static LegacyChunk legacy_scratch[LEGACY_CHUNK_COUNT][LEGACY_CHUNK_COUNT];
+
+// Shift the grid through the scratch copy, leaving the chunks that entered
+// unloaded; returns the number of bytes of chunk data copied
+static long legacy_scroll(LegacyWindow* window, int dx, int dz) {
+    long bytes_copied = 0;
+
+    for (int x = 0; x < LEGACY_CHUNK_COUNT; x++) {
+        for (int z = 0; z < LEGACY_CHUNK_COUNT; z++) {
+            legacy_scratch[x][z].is_loaded = false;
+            legacy_scratch[x][z].world_x = window->offset_x + dx + (x - LEGACY_VIEW_DISTANCE);
+            legacy_scratch[x][z].world_z = window->offset_z + dz + (z - LEGACY_VIEW_DISTANCE);
+        }
+    }
+
+    for (int x = 0; x < LEGACY_CHUNK_COUNT; x++) {
+        for (int z = 0; z < LEGACY_CHUNK_COUNT; z++) {
+            int old_x = x + dx;
+            int old_z = z + dz;
+            if (old_x >= 0 && old_x < LEGACY_CHUNK_COUNT &&
+                old_z >= 0 && old_z < LEGACY_CHUNK_COUNT) {
+                legacy_scratch[x][z] = window->chunks[old_x][old_z];
+                bytes_copied += sizeof(LegacyChunk);
+            }
+        }
+    }
+
+    memcpy(window->chunks, legacy_scratch, sizeof(legacy_scratch));
+    bytes_copied += sizeof(legacy_scratch);
+
+    window->offset_x += dx;
+    window->offset_z += dz;
+    return bytes_copied;
+}
+
+// Generate the chunks that entered the legacy window
+static void legacy_load(LegacyWindow* window) {
+    for (int x = 0; x < LEGACY_CHUNK_COUNT; x++) {
+        for (int z = 0; z < LEGACY_CHUNK_COUNT; z++) {
+            LegacyChunk* chunk = &window->chunks[x][z];
+            if (chunk->is_loaded) continue;
+            generate_terrain_blocks(chunk->world_x, chunk->world_z, bench_seed, chunk->blocks);
+            chunk->is_loaded = true;
+        }
+    }
+}
+
+// Where a chunk's record and packed blocks sat before a crossing
+typedef struct {
+    int world_x;
+    int world_z;
+    const Chunk* slot;
+    const uint32_t* data[SECTIONS_PER_CHUNK];
+} ChunkPlace;
+
+static void record_chunk_places(const VoxelWorld* world, ChunkPlace* places) {
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        const Chunk* chunk = &world->chunks[i];
+        places[i] = (ChunkPlace){chunk->world_x, chunk->world_z, chunk, {NULL}};
+        for (int s = 0; s < SECTIONS_PER_CHUNK; s++) places[i].data[s] = chunk->storage.sections[s].data;
+    }
+}
+
+// Bytes of chunk data a crossing moved, counted as the legacy path counts
+// them: the record of every chunk that stayed in the window but now sits in
+// another slot, and its packed blocks if they were copied elsewhere
+static long chunk_bytes_moved(VoxelWorld* world, const ChunkPlace* places, int count) {
+    long bytes = 0;
+    for (int i = 0; i < count; i++) {
+        const Chunk* chunk = find_chunk(world, places[i].world_x, places[i].world_z);
+        if (!chunk) continue;
+        if (chunk != places[i].slot) bytes += sizeof(Chunk);
+        bool blocks_moved = false;
+        for (int s = 0; s < SECTIONS_PER_CHUNK; s++) blocks_moved |= chunk->storage.sections[s].data != places[i].data[s];
+        if (blocks_moved) bytes += chunk_storage_bytes(&chunk->storage);
+    }
+    return bytes;
+}
+
+static void bench_chunk_crossings(void) {
+    static LegacyWindow legacy;
+    static VoxelWorld world;
+    Timings legacy_timings = {0};
+    Timings ring_timings = {0};
+
+    // Both paths are timed on the window update alone. The chunks that
+    // entered are loaded after the timer stops: the legacy grid generates
+    // dense blocks, while the world also encodes, lights and caches them,
+    // which is not what the layout change is about.
+
+    // Old path: dense grid shifted through a temporary copy
+    memset(&legacy, 0, sizeof(legacy));
+    for (int x = 0; x < LEGACY_CHUNK_COUNT; x++) {
+        for (int z = 0; z < LEGACY_CHUNK_COUNT; z++) {
+            legacy.chunks[x][z].world_x = x - LEGACY_VIEW_DISTANCE;
+            legacy.chunks[x][z].world_z = z - LEGACY_VIEW_DISTANCE;
+        }
+    }
+    legacy_load(&legacy);
+    long legacy_bytes = 0;
+    for (int i = 0; i < bench_crossings; i++) {
+        double start = now_ns();
+        legacy_bytes += legacy_scroll(&legacy, 1, 0);
+        timings_add(&legacy_timings, now_ns() - start);
+        legacy_load(&legacy);
+    }
+
+    // New path: ring buffer; the entering column is queued on a worker and
+    // waited for outside the timer
+    long ring_bytes = 0;
+    ChunkPlace* places = NULL;
+    if (init_bench_world(&world, 1)) {
+        int slots = world.chunk_count * world.chunk_count;
+        places = malloc(sizeof(ChunkPlace) * slots);
+        for (int i = 0; places && i < bench_crossings; i++) {
+            record_chunk_places(&world, places);
+            double start = now_ns();
+            scroll_chunk_window(&world, world.player_chunk_x + 1, world.player_chunk_z);
+            timings_add(&ring_timings, now_ns() - start);
+            wait_for_chunk_loads(&world);
+            ring_bytes += chunk_bytes_moved(&world, places, slots);
+        }
+        free(places);
+        cleanup_voxel_world(&world);
+    }
+
+    json_open("chunk_crossings");
+    json_int("crossings", bench_crossings);
+    json_int("window_chunks", LEGACY_CHUNK_COUNT * LEGACY_CHUNK_COUNT);
+    json_open("legacy_copy");
+    json_timings("crossing", &legacy_timings);
+    json_int("bytes_copied_per_crossing", legacy_bytes / bench_crossings);
+    json_close();
+    json_open("ring_buffer");
+    json_timings("crossing", &ring_timings);
+    json_int("bytes_copied_per_crossing", ring_timings.count ? ring_bytes / ring_timings.count : 0);
+    json_close();
+    json_close();
+}
+
+static void bench_world_startup(void) {
+    static VoxelWorld world;
+    static const int worker_counts[] = {-1, 1, 2, 4, 8};
+    const int runs = 5;
+
+    json_open("world_startup");
+    json_int("cores", job_system_core_count());
+    for (size_t i = 0; i < sizeof(worker_counts) / sizeof(worker_counts[0]); i++) {
+        Timings ready = {0};
+        for (int run = 0; run < runs; run++) {
+            double start = now_ns();
+            if (!init_bench_world(&world, worker_counts[i])) continue;
+            timings_add(&ready, now_ns() - start);
+            cleanup_voxel_world(&world);
+        }
+        char key[32];
+        if (worker_counts[i] < 0) {
+            snprintf(key, sizeof(key), "inline");
+        } else {
+            snprintf(key, sizeof(key), "workers_%d", worker_counts[i]);
+        }
+        json_timings(key, &ready);
+    }
+    json_close();
+}
+
+static void bench_noise(void) {
+    const int grids = 4096;
+    float scalar[NOISE_GRID_SIZE * NOISE_GRID_SIZE];
+    float simd[NOISE_GRID_SIZE * NOISE_GRID_SIZE];
+    float checksum = 0.0f;
+    int mismatches = 0;
+
+    double start = now_ns();
+    for (int i = 0; i < grids; i++) {
+        noise_fbm_grid_scalar(bench_seed, i * NOISE_GRID_SIZE, -i * NOISE_GRID_SIZE,
+                              TERRAIN_FREQUENCY, TERRAIN_OCTAVES, scalar);
+        checksum += scalar[i % (NOISE_GRID_SIZE * NOISE_GRID_SIZE)];
+    }
+    double scalar_s = (now_ns() - start) / 1e9;
+
+    start = now_ns();
+    for (int i = 0; i < grids; i++) {
+        noise_fbm_grid(bench_seed, i * NOISE_GRID_SIZE, -i * NOISE_GRID_SIZE,
+                       TERRAIN_FREQUENCY, TERRAIN_OCTAVES, simd);
+        checksum += simd[i % (NOISE_GRID_SIZE * NOISE_GRID_SIZE)];
+    }
+    double simd_s = (now_ns() - start) / 1e9;
+
+    // The batched path must match the scalar reference bit for bit
+    for (int i = 0; i < grids; i += 97) {
+        noise_fbm_grid_scalar(bench_seed, i * NOISE_GRID_SIZE, -i * NOISE_GRID_SIZE,
+                              TERRAIN_FREQUENCY, TERRAIN_OCTAVES, scalar);
+        noise_fbm_grid(bench_seed, i * NOISE_GRID_SIZE, -i * NOISE_GRID_SIZE,
+                       TERRAIN_FREQUENCY, TERRAIN_OCTAVES, simd);
+        if (memcmp(scalar, simd, sizeof(scalar)) != 0) mismatches++;
+    }
+
+    double samples = (double)grids * NOISE_GRID_SIZE * NOISE_GRID_SIZE;
+    json_open("noise");
+    json_int("octaves", TERRAIN_OCTAVES);
+    json_num("checksum", checksum);
+    json_num("scalar_msamples_per_s", samples / scalar_s / 1e6);
+    json_str("simd_level", noise_simd_level());
+    json_num("simd_msamples_per_s", samples / simd_s / 1e6);
+    json_int("mismatched_grids", mismatches);
+    json_close();
+}
+
+static void bench_terrain_determinism(void) {
+    static DenseBlocks first;
+    static DenseBlocks second;
+    static DenseBlocks decoded;
+    ChunkStorage storage;
+    int differing = 0;
+    int round_trip_errors = 0;
+
+    chunk_storage_init(&storage);
+    for (int cx = -8; cx < 8; cx++) {
+        for (int cz = -8; cz < 8; cz++) {
+            generate_terrain_blocks(cx, cz, bench_seed, first);
+            generate_terrain_blocks(cx, cz, bench_seed, second);
+            if (memcmp(first, second, sizeof(first)) != 0) differing++;
+
+            // Compressed storage must give back exactly what was generated
+            chunk_storage_encode(&storage, first);
+            chunk_storage_decode(&storage, decoded);
+            if (memcmp(first, decoded, sizeof(first)) != 0) round_trip_errors++;
+        }
+    }
+    chunk_storage_free(&storage);
+
+    json_open("terrain_determinism");
+    json_int("chunks", 256);
+    json_int("differing", differing);
+    json_int("storage_round_trip_errors", round_trip_errors);
+    json_close();
+}
+
+static void bench_chunk_storage(void) {
+    static VoxelWorld world;
+    static DenseBlocks dense;
+    static DenseBlocks decoded;
+    const int accesses = 1 << 22;
+
+    // Memory held by a freshly generated window
+    if (!init_bench_world(&world, -1)) return;
+    size_t packed_bytes = 0;
+    int uniform_sections = 0;
+    for (int x = 0; x < world.chunk_count; x++) {
+        for (int z = 0; z < world.chunk_count; z++) {
+            const ChunkStorage* storage = &chunk_at_slot(&world, x, z)->storage;
+            packed_bytes += sizeof(ChunkStorage) + chunk_storage_bytes(storage);
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                if (storage->sections[s].bits == 0) uniform_sections++;
+            }
+        }
+    }
+    int chunks = world.chunk_count * world.chunk_count;
+
+    // Random get/set throughput on one chunk, dense array vs packed storage
+    ChunkStorage* storage = &chunk_at_slot(&world, 0, 0)->storage;
+    chunk_storage_decode(storage, dense);
+    long checksum = 0;
+    unsigned int state = bench_seed;
+
+    double start = now_ns();
+    for (int i = 0; i < accesses; i++) {
+        unsigned int r = next_random(&state);
+        checksum += dense[r % CHUNK_SIZE][(r >> 4) % WORLD_HEIGHT][(r >> 9) % CHUNK_SIZE];
+    }
+    double dense_get_s = (now_ns() - start) / 1e9;
+
+    state = bench_seed;
+    start = now_ns();
+    for (int i = 0; i < accesses; i++) {
+        unsigned int r = next_random(&state);
+        checksum += chunk_storage_get(storage, r % CHUNK_SIZE, (r >> 4) % WORLD_HEIGHT, (r >> 9) % CHUNK_SIZE);
+    }
+    double packed_get_s = (now_ns() - start) / 1e9;
+
+    state = bench_seed;
+    start = now_ns();
+    for (int i = 0; i < accesses; i++) {
+        unsigned int r = next_random(&state);
+        dense[r % CHUNK_SIZE][(r >> 4) % WORLD_HEIGHT][(r >> 9) % CHUNK_SIZE] = (r >> 14) % 3;
+    }
+    double dense_set_s = (now_ns() - start) / 1e9;
+
+    state = bench_seed;
+    start = now_ns();
+    for (int i = 0; i < accesses; i++) {
+        unsigned int r = next_random(&state);
+        chunk_storage_set(storage, r % CHUNK_SIZE, (r >> 4) % WORLD_HEIGHT, (r >> 9) % CHUNK_SIZE, (r >> 14) % 3);
+    }
+    double packed_set_s = (now_ns() - start) / 1e9;
+
+    // Both paths applied the same edits, so their contents must agree
+    chunk_storage_decode(storage, decoded);
+    bool contents_match = memcmp(dense, decoded, sizeof(dense)) == 0;
+    cleanup_voxel_world(&world);
+
+    json_open("chunk_storage");
+    json_int("chunks", chunks);
+    json_int("uniform_sections", uniform_sections);
+    json_int("sections", chunks * SECTIONS_PER_CHUNK);
+    json_int("dense_bytes_per_chunk", sizeof(DenseBlocks));
+    json_int("palette_bytes_per_chunk", (long)(packed_bytes / chunks));
+    json_num("dense_get_maccess_per_s", accesses / dense_get_s / 1e6);
+    json_num("dense_set_maccess_per_s", accesses / dense_set_s / 1e6);
+    json_num("palette_get_maccess_per_s", accesses / packed_get_s / 1e6);
+    json_num("palette_set_maccess_per_s", accesses / packed_set_s / 1e6);
+    json_int("checksum", checksum);
+    json_bool("contents_match", contents_match);
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Region files
+
+// Remove a scratch save directory and the region files in it
+static void remove_save_directory(const char* directory) {
+    DIR* dir = opendir(directory);
+    if (dir) {
+        struct dirent* entry;
+        char path[600];
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.') continue;
+            snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+            unlink(path);
+        }
+        closedir(dir);
+    }
+    rmdir(directory);
+}
+
+// Edit a block, scroll far enough to evict its chunk, come back and read it
+static bool edit_survives_eviction(const char* directory, int worker_count) {
+    static VoxelWorld world;
+    WorldConfig config = default_world_config();
+    config.worker_count = worker_count;
+    config.seed = bench_seed;
+    config.save_directory = directory;
+    config.cache_bytes = 0;  // Evicted chunks must go through the region files
+    const int x = 5, y = WORLD_HEIGHT - 2, z = -3;
+
+    if (!init_voxel_world_with_config(&world, &config)) return false;
+    wait_for_chunk_loads(&world);
+    set_block(&world, x, y, z, 2);
+    scroll_chunk_window(&world, 4 * world.chunk_count, 0);
+    wait_for_chunk_loads(&world);
+    bool evicted = get_block(&world, x, y, z) == 0;
+    scroll_chunk_window(&world, 0, 0);
+    wait_for_chunk_loads(&world);
+    bool after_eviction = get_block(&world, x, y, z) == 2;
+    set_block(&world, x, y, z, 1);
+    cleanup_voxel_world(&world);
+
+    // A new session must see the edit made just before shutdown
+    if (!init_voxel_world_with_config(&world, &config)) return false;
+    wait_for_chunk_loads(&world);
+    bool after_restart = get_block(&world, x, y, z) == 1;
+    cleanup_voxel_world(&world);
+
+    return evicted && after_eviction && after_restart;
+}
+
+static long file_size(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Save one chunk over and over: each save appends, so the file only stays
+// bounded if compaction reclaims the replaced copies. Then cut an append
+// short by hand and check the last complete save still loads.
+static bool rewrites_stay_bounded(const char* directory, long* compactions) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/r.0.0.vvr", directory);
+    Chunk chunk = {0};
+    chunk_storage_init(&chunk.storage);
+    generate_chunk_terrain(&chunk, bench_seed);
+
+    RegionStore* store = region_store_open(directory, bench_seed, NULL);
+    region_store_save(store, 0, 0, &chunk.storage);
+    long first_size = file_size(path);
+    for (int i = 0; i < 512; i++) {
+        chunk_storage_set(&chunk.storage, i % CHUNK_SIZE, WORLD_HEIGHT - 1, i / CHUNK_SIZE % CHUNK_SIZE, i % 3);
+        region_store_save(store, 0, 0, &chunk.storage);
+    }
+    *compactions = region_store_stats(store).compactions;
+    region_store_close(store);
+    bool bounded = file_size(path) <= first_size + (256 << 10);
+
+    unsigned char partial[1000];
+    memset(partial, 0xab, sizeof(partial));
+    FILE* file = fopen(path, "ab");
+    if (file) {
+        fwrite(partial, 1, sizeof(partial), file);
+        fclose(file);
+    }
+
+    static DenseBlocks expected;
+    static DenseBlocks loaded;
+    chunk_storage_decode(&chunk.storage, expected);
+    store = region_store_open(directory, bench_seed, NULL);
+    bool found = region_store_load(store, 0, 0, &chunk.storage);
+    region_store_close(store);
+    chunk_storage_decode(&chunk.storage, loaded);
+    chunk_storage_free(&chunk.storage);
+    return bounded && found && memcmp(expected, loaded, sizeof(expected)) == 0;
+}
+
+static void bench_region_persistence(void) {
+    char directory[] = "/tmp/voxel_bench_XXXXXX";
+    if (!mkdtemp(directory)) return;
+    const int side = 16;
+    const int chunks = side * side;
+    Chunk chunk = {0};
+    chunk_storage_init(&chunk.storage);
+    Timings generated_timings = {0};
+    Timings cached_timings = {0};
+
+    // Generate and save a block of chunks, timing generation alone
+    RegionStore* store = region_store_open(directory, bench_seed, NULL);
+    for (int i = 0; i < chunks; i++) {
+        chunk.world_x = i % side - side / 2;
+        chunk.world_z = i / side - side / 2;
+        double start = now_ns();
+        generate_chunk_terrain(&chunk, bench_seed);
+        timings_add(&generated_timings, now_ns() - start);
+        region_store_save(store, chunk.world_x, chunk.world_z, &chunk.storage);
+    }
+    RegionStats saved = region_store_stats(store);
+    region_store_close(store);
+
+    // Reopen and read every chunk back through the mapped files
+    store = region_store_open(directory, bench_seed, NULL);
+    static DenseBlocks generated;
+    static DenseBlocks loaded;
+    int mismatched = 0;
+    for (int i = 0; i < chunks; i++) {
+        int chunk_x = i % side - side / 2;
+        int chunk_z = i / side - side / 2;
+        double start = now_ns();
+        bool found = region_store_load(store, chunk_x, chunk_z, &chunk.storage);
+        timings_add(&cached_timings, now_ns() - start);
+
+        generate_terrain_blocks(chunk_x, chunk_z, bench_seed, generated);
+        chunk_storage_decode(&chunk.storage, loaded);
+        if (!found || memcmp(generated, loaded, sizeof(generated)) != 0) mismatched++;
+    }
+    region_store_close(store);
+    chunk_storage_free(&chunk.storage);
+    remove_save_directory(directory);
+
+    bool inline_ok = mkdtemp(strcpy(directory, "/tmp/voxel_bench_XXXXXX")) &&
+                     edit_survives_eviction(directory, -1);
+    remove_save_directory(directory);
+    bool async_ok = mkdtemp(strcpy(directory, "/tmp/voxel_bench_XXXXXX")) &&
+                    edit_survives_eviction(directory, 2);
+    remove_save_directory(directory);
+    long compactions = 0;
+    bool rewrites_ok = mkdtemp(strcpy(directory, "/tmp/voxel_bench_XXXXXX")) &&
+                       rewrites_stay_bounded(directory, &compactions);
+    remove_save_directory(directory);
+
+    json_open("region_persistence");
+    json_int("chunks", chunks);
+    json_int("region_size", REGION_SIZE);
+    json_int("bytes_written", saved.bytes_written);
+    json_timings("generated_load", &generated_timings);
+    json_timings("cached_load", &cached_timings);
+    json_int("mismatched", mismatched);
+    json_bool("edit_round_trip_inline", inline_ok);
+    json_bool("edit_round_trip_background", async_ok);
+    json_int("rewrite_compactions", compactions);
+    json_bool("rewrites_stay_bounded", rewrites_ok);
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+// Chunk cache
+
+static void bench_chunk_cache(void) {
+    static VoxelWorld world;
+    WorldConfig config = default_world_config();
+    config.worker_count = -1;
+    config.seed = bench_seed;
+
+    json_open("chunk_cache");
+    json_int("flip_flops", bench_crossings);
+
+    // Cross the same chunk boundary back and forth, with and without the cache
+    for (int cached = 0; cached <= 1; cached++) {
+        config.cache_bytes = cached ? DEFAULT_CHUNK_CACHE_BYTES : 0;
+        if (!init_voxel_world_with_config(&world, &config)) continue;
+        long generated = world.stats.chunks_generated;
+        Timings crossings = {0};
+        for (int i = 0; i < bench_crossings; i++) {
+            double start = now_ns();
+            scroll_chunk_window(&world, (i + 1) % 2, 0);
+            timings_add(&crossings, now_ns() - start);
+        }
+
+        json_open(cached ? "cache" : "no_cache");
+        json_timings("crossing", &crossings);
+        json_int("chunks_generated", world.stats.chunks_generated - generated);
+        json_int("hits", world.cache.stats.hits);
+        json_int("misses", world.cache.stats.misses);
+        json_int("evictions", world.cache.stats.evictions);
+        json_close();
+        cleanup_voxel_world(&world);
+    }
+
+    // Walking in a straight line with a small cap must evict to stay under it
+    config.cache_bytes = 64 << 10;
+    if (!init_voxel_world_with_config(&world, &config)) {
+        json_close();
+        return;
+    }
+    for (int i = 1; i <= bench_crossings; i++) {
+        scroll_chunk_window(&world, i, 0);
+    }
+    json_open("capped_64k");
+    json_int("cached_chunks", world.cache.count);
+    json_int("cached_bytes", (long)world.cache.bytes);
+    json_int("evictions", world.cache.stats.evictions);
+    json_close();
+
+    // Changing the view distance reuses every chunk already in view
+    long generated = world.stats.chunks_generated;
+    world.cache.byte_limit = DEFAULT_CHUNK_CACHE_BYTES;
+    set_view_distance(&world, 2 * DEFAULT_VIEW_DISTANCE);
+    long grown = world.stats.chunks_generated - generated;
+    set_view_distance(&world, DEFAULT_VIEW_DISTANCE);
+    long shrunk = world.stats.chunks_generated - generated - grown;
+    json_int("generated_growing_view", grown);
+    json_int("generated_shrinking_view", shrunk);
+    cleanup_voxel_world(&world);
+
+    // A block placed and removed again must not stay in the palette of the
+    // edited chunk once it leaves the window
+    bool compacted = false;
+    config.cache_bytes = DEFAULT_CHUNK_CACHE_BYTES;
+    if (init_voxel_world_with_config(&world, &config)) {
+        set_block(&world, 1, WORLD_HEIGHT - 1, 1, BLOCK_LAMP);
+        set_block(&world, 1, WORLD_HEIGHT - 1, 1, 0);
+        scroll_chunk_window(&world, 4 * world.chunk_count, 0);
+        ChunkStorage storage;
+        bool needs_save;
+        if (chunk_cache_take(&world.cache, 0, 0, &storage, &needs_save)) {
+            const ChunkSection* top = &storage.sections[SECTIONS_PER_CHUNK - 1];
+            compacted = needs_save && top->bits != 8 && memchr(top->palette, BLOCK_LAMP, top->palette_size) == NULL;
+            chunk_storage_free(&storage);
+        }
+        cleanup_voxel_world(&world);
+    }
+    json_bool("retired_edits_compacted", compacted);
+
+    json_close();
+}
+
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} BenchSection;
+
+static const BenchSection sections[] = {
+    {"camera_paths", bench_camera_paths},
+    {"stages", bench_stages},
+    {"frustum_culling", bench_frustum_culling},
+    {"occlusion_culling", bench_occlusion_culling},
+    {"level_of_detail", bench_level_of_detail},
+    {"raycast", bench_raycast},
+    {"occupancy", bench_occupancy},
+    {"lighting", bench_lighting},
+    {"ambient_occlusion", bench_ambient_occlusion},
+    {"frame_timing", bench_frame_timing},
+    {"profiler", bench_profiler},
+    {"player_physics", bench_player_physics},
+    {"skybox", bench_skybox},
+    {"software_render", bench_software_render},
+    {"vertex_arena", bench_vertex_arena},
+    {"packed_vertices", bench_packed_vertices},
+    {"bulk_edit", bench_bulk_edit},
+    {"chunk_crossings", bench_chunk_crossings},
+    {"world_startup", bench_world_startup},
+    {"noise", bench_noise},
+    {"terrain_determinism", bench_terrain_determinism},
+    {"chunk_storage", bench_chunk_storage},
+    {"region_persistence", bench_region_persistence},
+    {"chunk_cache", bench_chunk_cache},
+};
+
+#define SECTION_COUNT ((int)(sizeof(sections) / sizeof(sections[0])))
+
+static void usage(void) {
+    fprintf(stderr, "usage: voxel_bench [--seed N] [--frames N] [--crossings N] [--trace FILE]\n"
+                    "                   [--render-distance N] [--images DIR] [section ...]\n"
+                    "sections:");
+    for (int i = 0; i < SECTION_COUNT; i++) fprintf(stderr, " %s", sections[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    bool selected[SECTION_COUNT] = {false};
+    bool any_selected = false;
+    const char* trace_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) {
+            bench_seed = (unsigned int)strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "--frames") == 0) {
+            bench_frames = atoi(argv[++i]);
+            if (bench_frames <= 0) bench_frames = DEFAULT_FRAMES;
+        } else if (i + 1 < argc && strcmp(argv[i], "--crossings") == 0) {
+            bench_crossings = atoi(argv[++i]);
+            if (bench_crossings <= 0) bench_crossings = DEFAULT_CROSSINGS;
+        } else if (i + 1 < argc && strcmp(argv[i], "--trace") == 0) {
+            trace_path = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--render-distance") == 0) {
+            bench_render_distance = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "--images") == 0) {
+            bench_image_directory = argv[++i];
+        } else {
+            int s = 0;
+            while (s < SECTION_COUNT && strcmp(argv[i], sections[s].name) != 0) s++;
+            if (s == SECTION_COUNT) {
+                usage();
+                return 1;
+            }
+            selected[s] = true;
+            any_selected = true;
+        }
+    }
+
+    json_open(NULL);
+    json_int("seed", bench_seed);
+    json_int("view_distance", DEFAULT_VIEW_DISTANCE);
+    json_str("simd_level", noise_simd_level());
+    json_int("cores", job_system_core_count());
+    PROFILE_THREAD_NAME("bench");
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        if (!any_selected || selected[s]) {
+            PROFILE_ZONE(sections[s].name);
+            sections[s].run();
+        }
+    }
+    json_close();
+
+    // The trace and summary cover the last sections run, as far as the
+    // ring buffers reach; the summary goes to stderr to keep stdout JSON
+    if (trace_path) {
+        if (profile_write_trace(trace_path) < 0) fprintf(stderr, "Could not write %s\n", trace_path);
+        profile_print_summary(stderr);
+    }
+    return 0;
+}
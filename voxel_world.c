@@ -1,12 +1,11 @@
 #include "voxel_world.h"
+#include "chunk_mesh.h"
+#include "lighting.h"
+#include "noise.h"
+#include "profiler.h"
 #include <stdlib.h>
 #include <math.h>
 
-// Simple noise function for terrain generation
-float noise2d(float x, float z) {
-    return (float)rand() / RAND_MAX;
-}
-
 // Generate random float between 0 and 1
 float random_float() {
     return (float)rand() / RAND_MAX;
@@ -22,8 +21,8 @@ Color interpolate_colors(Color c1, Color c2, float t) {
 }
 
 // Initialize stars with random positions
-void init_stars(Star stars[]) {
-    for (int i = 0; i < NUM_STARS; i++) {
+void init_stars(Star stars[], int count) {
+    for (int i = 0; i < count; i++) {
         // Generate random position in world space
         float x = (random_float() - 0.5f) * 200.0f;  // -100 to 100
         float y = random_float() * 100.0f;           // 0 to 100
@@ -36,274 +35,691 @@ void init_stars(Star stars[]) {
     }
 }
 
-void init_voxel_world(VoxelWorld* world) {
-    world->player_chunk_x = VIEW_DISTANCE;
-    world->player_chunk_z = VIEW_DISTANCE;
-    world->world_offset_x = 0;
-    world->world_offset_z = 0;
+// Ring buffer slot index for a chunk coordinate (always 0..chunk_count-1)
+static int chunk_slot(const VoxelWorld* world, int chunk_coord) {
+    int slot = chunk_coord % world->chunk_count;
+    return slot < 0 ? slot + world->chunk_count : slot;
+}
+
+// Chunk coordinate that slot `slot` holds when the window is centred on `center`
+static int window_chunk_coord(const VoxelWorld* world, int slot, int center) {
+    int first = center - world->view_distance;
+    return first + chunk_slot(world, slot - first);
+}
+
+Chunk* find_chunk(VoxelWorld* world, int chunk_x, int chunk_z) {
+    if (abs(chunk_x - world->world_offset_x) > world->view_distance ||
+        abs(chunk_z - world->world_offset_z) > world->view_distance) {
+        return NULL;
+    }
     
-    // Initialize skybox
-    world->skybox.time_of_day = 0.0f;  // Start at dawn
-    world->skybox.day_cycle_speed = 1.0f / DAY_LENGTH;
-    world->skybox.sun_angle = 0.0f;
+    Chunk* chunk = chunk_at_slot(world, chunk_slot(world, chunk_x), chunk_slot(world, chunk_z));
+    if (!chunk->is_loaded || chunk->world_x != chunk_x || chunk->world_z != chunk_z) {
+        return NULL;
+    }
+    return chunk;
+}
+
+ChunkNeighbours get_chunk_neighbours(VoxelWorld* world, const Chunk* chunk) {
+    ChunkNeighbours neighbours;
+    neighbours.neg_x = find_chunk(world, chunk->world_x - 1, chunk->world_z);
+    neighbours.pos_x = find_chunk(world, chunk->world_x + 1, chunk->world_z);
+    neighbours.neg_z = find_chunk(world, chunk->world_x, chunk->world_z - 1);
+    neighbours.pos_z = find_chunk(world, chunk->world_x, chunk->world_z + 1);
+    return neighbours;
+}
+
+static bool queue_remesh(VoxelWorld* world, int chunk_x, int chunk_z) {
+    RemeshQueue* queue = &world->remesh_queue;
+    if (queue->count == queue->capacity) {
+        queue->overflowed = true;
+        return false;
+    }
+    int tail = (queue->head + queue->count) % queue->capacity;
+    queue->entries[tail].chunk_x = chunk_x;
+    queue->entries[tail].chunk_z = chunk_z;
+    queue->count++;
+    return true;
+}
+
+void mark_chunk_dirty(VoxelWorld* world, Chunk* chunk) {
+    chunk->mesh_dirty = true;
+    if (!chunk->in_remesh_queue && chunk->is_loaded) {
+        chunk->in_remesh_queue = queue_remesh(world, chunk->world_x, chunk->world_z);
+    }
+}
+
+void mark_chunk_dirty_at(VoxelWorld* world, int chunk_x, int chunk_z) {
+    Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+    if (chunk) mark_chunk_dirty(world, chunk);
+}
+
+// A chunk loaded or changed: its neighbours can now cull their shared faces
+static void mark_neighbours_dirty(VoxelWorld* world, int chunk_x, int chunk_z) {
+    mark_chunk_dirty_at(world, chunk_x - 1, chunk_z);
+    mark_chunk_dirty_at(world, chunk_x + 1, chunk_z);
+    mark_chunk_dirty_at(world, chunk_x, chunk_z - 1);
+    mark_chunk_dirty_at(world, chunk_x, chunk_z + 1);
+}
+
+int process_remesh_queue(VoxelWorld* world, int budget) {
+    PROFILE_ZONE("process_remesh_queue");
+    RemeshQueue* queue = &world->remesh_queue;
+    int remeshed = 0;
+    
+    while (remeshed < budget) {
+        if (queue->count == 0) {
+            if (!queue->overflowed) break;
+            
+            // Requeue every dirty chunk that did not fit earlier
+            queue->overflowed = false;
+            for (int x = 0; x < world->chunk_count; x++) {
+                for (int z = 0; z < world->chunk_count; z++) {
+                    Chunk* chunk = chunk_at_slot(world, x, z);
+                    if (chunk->is_loaded && chunk->mesh_dirty && !chunk->in_remesh_queue) {
+                        mark_chunk_dirty(world, chunk);
+                    }
+                }
+            }
+            if (queue->count == 0) break;
+        }
+        
+        RemeshRequest request = queue->entries[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        
+        // The chunk may have scrolled out of view since it was queued
+        Chunk* chunk = find_chunk(world, request.chunk_x, request.chunk_z);
+        if (!chunk || !chunk->in_remesh_queue) continue;
+        chunk->in_remesh_queue = false;
+        if (!chunk->mesh_dirty) continue;
+        
+        ChunkNeighbours neighbours = get_chunk_neighbours(world, chunk);
+        chunk_mesh_build(chunk, &neighbours, &chunk->mesh);
+        chunk->mesh_dirty = false;
+        chunk->vbo_stale = true;
+        remeshed++;
+    }
+    
+    world->stats.remeshes += remeshed;
+    world->stats.total_remeshes += remeshed;
+    if (remeshed > 0) PROFILE_COUNT("remeshes", remeshed);
+    return remeshed;
+}
+
+// Hand a vertex buffer range to the renderer to free; the world never calls GL
+static void retire_range(VoxelWorld* world, int first, int count) {
+    if (world->retired_count == world->retired_capacity) {
+        int capacity = world->retired_capacity ? world->retired_capacity * 2 : 64;
+        ArenaRange* ranges = realloc(world->retired_ranges, capacity * sizeof(ArenaRange));
+        if (!ranges) return;  // Leaks the range until the renderer next repacks
+        world->retired_ranges = ranges;
+        world->retired_capacity = capacity;
+    }
+    world->retired_ranges[world->retired_count++] = (ArenaRange){first, count};
+}
+
+// Drop a chunk's blocks and CPU and GPU geometry when it leaves the view
+static void release_chunk(VoxelWorld* world, Chunk* chunk) {
+    chunk_storage_free(&chunk->storage);
+    chunk_light_free(&chunk->light);
+    chunk_mesh_free(&chunk->mesh);
+    if (chunk->vbo_capacity > 0) {
+        retire_range(world, chunk->vbo_first, chunk->vbo_capacity);
+        chunk->vbo_first = 0;
+        chunk->vbo_capacity = 0;
+    }
+    chunk->vbo_vertex_count = 0;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        chunk->vbo_section_first[s] = 0;
+        chunk->vbo_section_count[s] = 0;
+    }
+}
+
+// Reset a chunk slot to an unloaded, empty state
+static void reset_chunk(Chunk* chunk, int chunk_x, int chunk_z) {
+    chunk_storage_init(&chunk->storage);
+    chunk_light_init(&chunk->light);
+    chunk->is_loaded = false;
+    chunk->mesh = (ChunkMesh){0};
+    chunk->mesh_dirty = false;
+    chunk->lod = 0;
+    chunk->in_remesh_queue = false;
+    chunk->vbo_first = 0;
+    chunk->vbo_capacity = 0;
+    chunk->vbo_vertex_count = 0;
+    for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+        chunk->vbo_section_first[s] = 0;
+        chunk->vbo_section_count[s] = 0;
+    }
+    chunk->vbo_stale = false;
+    chunk->needs_save = false;
+    chunk->load_pending = false;
+    chunk->world_x = chunk_x;
+    chunk->world_z = chunk_z;
+}
+
+// A chunk loaded off the main thread, published through the completion queue
+typedef struct {
+    CompletionNode node;
+    CompletionQueue* completed;
+    RegionStore* regions;
+    unsigned int ticket;
+    unsigned int seed;
+    bool from_disk;
+    Chunk chunk;
+} ChunkLoadJob;
+
+// Read a previously visited chunk back from its region file, or generate
+// it, and light it on its own. Returns true if it came from disk.
+static bool load_chunk_blocks(RegionStore* regions, Chunk* chunk, unsigned int seed) {
+    bool from_disk = regions && region_store_load(regions, chunk->world_x, chunk->world_z, &chunk->storage);
+    if (from_disk) {
+        chunk->mesh_dirty = true;
+    } else {
+        generate_chunk_terrain(chunk, seed);
+    }
+    light_chunk_local(chunk);
+    return from_disk;
+}
+
+static void run_chunk_load_job(void* data) {
+    PROFILE_ZONE("load_chunk");
+    ChunkLoadJob* job = data;
+    job->from_disk = load_chunk_blocks(job->regions, &job->chunk, job->seed);
+    completion_queue_push(job->completed, &job->node);
+}
+
+// Make a freshly loaded chunk visible to the rest of the world, and let
+// light flow between it and its neighbours
+static void publish_chunk(VoxelWorld* world, Chunk* chunk, bool needs_save) {
+    chunk->needs_save = needs_save;
+    chunk->is_loaded = true;
+    chunk->load_pending = false;
+    world->stats.voxels_relit += light_chunk_borders(world, chunk);
+    mark_chunk_dirty(world, chunk);
+    mark_neighbours_dirty(world, chunk->world_x, chunk->world_z);
+}
+
+static void publish_loaded_chunk(VoxelWorld* world, Chunk* chunk, bool from_disk) {
+    if (from_disk) {
+        world->stats.chunks_loaded++;
+    } else {
+        world->stats.chunks_generated++;
+        PROFILE_COUNT("chunks_generated", 1);
+    }
+    publish_chunk(world, chunk, !from_disk);
+}
+
+// Queue blocks for write-back if they changed since they were loaded
+static void save_blocks(VoxelWorld* world, int chunk_x, int chunk_z,
+                        const ChunkStorage* storage, bool needs_save) {
+    if (!world->regions || !needs_save) return;
+    region_store_save(world->regions, chunk_x, chunk_z, storage);
+    world->stats.chunks_saved++;
+}
+
+// Edits can leave palette entries no voxel uses any more; drop them before
+// edited storage is cached or written back
+static void compact_edits(Chunk* chunk) {
+    if (chunk->needs_save) chunk_storage_compact(&chunk->storage);
+}
+
+static void write_back(VoxelWorld* world, Chunk* chunk) {
+    save_blocks(world, chunk->world_x, chunk->world_z, &chunk->storage, chunk->needs_save);
+    chunk->needs_save = false;
+}
+
+static void save_chunk(VoxelWorld* world, Chunk* chunk) {
+    if (!chunk->is_loaded) return;
+    if (world->regions) compact_edits(chunk);
+    write_back(world, chunk);
+}
+
+// Drop least recently used cache entries until the cache fits its memory
+// cap; their edits are written back only now
+static void trim_chunk_cache(VoxelWorld* world) {
+    int chunk_x, chunk_z;
+    ChunkStorage storage;
+    bool needs_save;
+    while (chunk_cache_over_limit(&world->cache) &&
+           chunk_cache_pop_oldest(&world->cache, &chunk_x, &chunk_z, &storage, &needs_save)) {
+        save_blocks(world, chunk_x, chunk_z, &storage, needs_save);
+        chunk_storage_free(&storage);
+    }
+}
+
+// Hand a chunk leaving the window to the cache, or write it back if it
+// cannot be cached. The slot keeps empty storage either way.
+static void retire_chunk(VoxelWorld* world, Chunk* chunk) {
+    if (!chunk->is_loaded) return;
+    compact_edits(chunk);
+    if (chunk_cache_put(&world->cache, chunk->world_x, chunk->world_z,
+                        &chunk->storage, chunk->needs_save)) {
+        chunk->needs_save = false;
+        trim_chunk_cache(world);
+    } else {
+        write_back(world, chunk);
+    }
+}
+
+// Distance in chunks from a point (in blocks) to the centre of a chunk,
+// along the farther axis so rings are square like the window
+static float chunk_distance(const Chunk* chunk, float x, float z) {
+    float dx = fabsf((chunk->world_x + 0.5f) - x / CHUNK_SIZE);
+    float dz = fabsf((chunk->world_z + 0.5f) - z / CHUNK_SIZE);
+    return dx > dz ? dx : dz;
+}
+
+int chunk_lod_for_distance(const VoxelWorld* world, float distance, int current) {
+    int lod = current;
+    while (lod < LOD_LEVELS - 1 && world->lod_rings[lod] > 0 &&
+           distance > world->lod_rings[lod] + LOD_HYSTERESIS) {
+        lod++;
+    }
+    while (lod > 0 && (world->lod_rings[lod - 1] == 0 ||
+                       distance < world->lod_rings[lod - 1] - LOD_HYSTERESIS)) {
+        lod--;
+    }
+    return lod;
+}
+
+void update_chunk_lods(VoxelWorld* world, float player_x, float player_z) {
+    for (int i = 0; i < world->chunk_count * world->chunk_count; i++) {
+        Chunk* chunk = &world->chunks[i];
+        int lod = chunk_lod_for_distance(world, chunk_distance(chunk, player_x, player_z), chunk->lod);
+        if (lod == chunk->lod) continue;
+
+        chunk->lod = lod;
+        if (!chunk->is_loaded) continue;
+        world->stats.lod_changes++;
+        mark_chunk_dirty(world, chunk);
+        mark_neighbours_dirty(world, chunk->world_x, chunk->world_z);
+    }
+}
+
+static void request_chunk_load(VoxelWorld* world, Chunk* chunk) {
+    // Start at the level the window centre calls for, so the first mesh is
+    // usually the one that stays
+    float centre_x = (world->world_offset_x + 0.5f) * CHUNK_SIZE;
+    float centre_z = (world->world_offset_z + 0.5f) * CHUNK_SIZE;
+    chunk->lod = chunk_lod_for_distance(world, chunk_distance(chunk, centre_x, centre_z), 0);
+
+    // A recently evicted chunk comes straight back from the cache
+    bool needs_save;
+    if (chunk_cache_take(&world->cache, chunk->world_x, chunk->world_z, &chunk->storage, &needs_save)) {
+        chunk->mesh_dirty = true;
+        light_chunk_local(chunk);
+        publish_chunk(world, chunk, needs_save);
+        return;
+    }
+    
+    ChunkLoadJob* job = world->jobs ? malloc(sizeof(ChunkLoadJob)) : NULL;
+    if (!job) {
+        bool from_disk = load_chunk_blocks(world->regions, chunk, world->seed);
+        publish_loaded_chunk(world, chunk, from_disk);
+        return;
+    }
+    
+    job->completed = &world->completed_loads;
+    job->regions = world->regions;
+    job->ticket = world->next_load_ticket++;
+    job->seed = world->seed;
+    chunk_storage_init(&job->chunk.storage);
+    chunk_light_init(&job->chunk.light);
+    job->chunk.world_x = chunk->world_x;
+    job->chunk.world_z = chunk->world_z;
+    
+    chunk->load_pending = true;
+    chunk->load_ticket = job->ticket;
+    world->loads_in_flight++;
+    job_system_submit(world->jobs, run_chunk_load_job, job);
+}
+
+void poll_chunk_loads(VoxelWorld* world) {
+    PROFILE_ZONE("poll_chunk_loads");
+    CompletionNode* node = completion_queue_take_all(&world->completed_loads);
+    while (node) {
+        ChunkLoadJob* job = (ChunkLoadJob*)node;
+        node = node->next;
+        world->loads_in_flight--;
+        
+        // Drop results for slots that scrolled to another chunk meanwhile
+        Chunk* chunk = chunk_at_slot(world, chunk_slot(world, job->chunk.world_x),
+                                     chunk_slot(world, job->chunk.world_z));
+        if (chunk->load_pending && chunk->load_ticket == job->ticket) {
+            // Hand the generated storage and light over to the slot without copying
+            chunk_storage_free(&chunk->storage);
+            chunk->storage = job->chunk.storage;
+            chunk_light_free(&chunk->light);
+            chunk->light = job->chunk.light;
+            publish_loaded_chunk(world, chunk, job->from_disk);
+        } else {
+            chunk_storage_free(&job->chunk.storage);
+            chunk_light_free(&job->chunk.light);
+        }
+        free(job);
+    }
+}
+
+void wait_for_chunk_loads(VoxelWorld* world) {
+    if (world->jobs) {
+        job_system_wait_idle(world->jobs);
+    }
+    poll_chunk_loads(world);
+}
+
+WorldConfig default_world_config(void) {
+    WorldConfig config;
+    config.worker_count = 0;
+    config.seed = DEFAULT_WORLD_SEED;
+    config.save_directory = NULL;
+    config.view_distance = DEFAULT_VIEW_DISTANCE;
+    config.cache_bytes = DEFAULT_CHUNK_CACHE_BYTES;
+    for (int i = 0; i < LOD_LEVELS - 1; i++) {
+        config.lod_rings[i] = DEFAULT_LOD_RING << i;
+    }
+    config.star_count = NUM_STARS;
+    return config;
+}
+
+bool init_voxel_world(VoxelWorld* world) {
+    WorldConfig config = default_world_config();
+    return init_voxel_world_with_config(world, &config);
+}
+
+static void free_chunk_window(VoxelWorld* world) {
+    free(world->chunks);
+    free(world->remesh_queue.entries);
+    free(world->evicted);
+    world->chunks = NULL;
+    world->remesh_queue.entries = NULL;
+    world->evicted = NULL;
+}
+
+// Allocate an empty window of the given size centred on world_offset_x/z and
+// queue loads for all of it. Leaves the current window alone on failure.
+static bool allocate_chunk_window(VoxelWorld* world, int view_distance) {
+    int chunk_count = view_distance * 2 + 1;
+    int slots = chunk_count * chunk_count;
+    Chunk* chunks = malloc(slots * sizeof(Chunk));
+    RemeshRequest* queue_entries = malloc(slots * sizeof(RemeshRequest));
+    RemeshRequest* evicted = malloc(slots * sizeof(RemeshRequest));
+    if (!chunks || !queue_entries || !evicted) {
+        free(chunks);
+        free(queue_entries);
+        free(evicted);
+        return false;
+    }
     
-    // Initialize stars
-    init_stars(world->skybox.stars);
+    free_chunk_window(world);
+    world->chunks = chunks;
+    world->evicted = evicted;
+    world->view_distance = view_distance;
+    world->chunk_count = chunk_count;
+    world->remesh_queue.entries = queue_entries;
+    world->remesh_queue.capacity = slots;
+    world->remesh_queue.head = 0;
+    world->remesh_queue.count = 0;
+    world->remesh_queue.overflowed = false;
     
     // Initialize all chunks as unloaded
-    for (int x = 0; x < CHUNK_COUNT; x++) {
-        for (int z = 0; z < CHUNK_COUNT; z++) {
-            world->chunks[x][z].is_loaded = false;
-            world->chunks[x][z].world_x = x - VIEW_DISTANCE;
-            world->chunks[x][z].world_z = z - VIEW_DISTANCE;
+    for (int x = 0; x < chunk_count; x++) {
+        for (int z = 0; z < chunk_count; z++) {
+            reset_chunk(chunk_at_slot(world, x, z),
+                        window_chunk_coord(world, x, world->world_offset_x),
+                        window_chunk_coord(world, z, world->world_offset_z));
         }
     }
     
     // Generate initial chunks around player in a 360-degree radius
-    for (int x = 0; x < CHUNK_COUNT; x++) {
-        for (int z = 0; z < CHUNK_COUNT; z++) {
-            generate_chunk_terrain(&world->chunks[x][z]);
-            world->chunks[x][z].is_loaded = true;
+    for (int x = 0; x < chunk_count; x++) {
+        for (int z = 0; z < chunk_count; z++) {
+            request_chunk_load(world, chunk_at_slot(world, x, z));
         }
     }
+    return true;
 }
 
-void update_skybox(VoxelWorld* world, float delta_time) {
-    // Update time of day
-    world->skybox.time_of_day += world->skybox.day_cycle_speed * delta_time;
-    if (world->skybox.time_of_day >= 1.0f) {
-        world->skybox.time_of_day -= 1.0f;
+static int clamp_view_distance(int view_distance) {
+    if (view_distance < 1) return 1;
+    if (view_distance > MAX_VIEW_DISTANCE) return MAX_VIEW_DISTANCE;
+    return view_distance;
+}
+
+bool init_voxel_world_with_config(VoxelWorld* world, const WorldConfig* config) {
+    // The player starts in chunk (0, 0), at the centre of the window
+    world->player_chunk_x = 0;
+    world->player_chunk_z = 0;
+    world->world_offset_x = 0;
+    world->world_offset_z = 0;
+    world->chunks = NULL;
+    world->evicted = NULL;
+    world->remesh_queue.entries = NULL;
+    world->retired_ranges = NULL;
+    world->retired_count = 0;
+    world->retired_capacity = 0;
+    world->stats = (WorldStats){0};
+    world->seed = config->seed;
+    for (int i = 0; i < LOD_LEVELS - 1; i++) {
+        world->lod_rings[i] = config->lod_rings[i];
     }
+    world->jobs = config->worker_count >= 0 ? job_system_create(config->worker_count) : NULL;
+    world->regions = config->save_directory
+        ? region_store_open(config->save_directory, config->seed, world->jobs) : NULL;
+    chunk_cache_init(&world->cache, config->cache_bytes);
+    completion_queue_init(&world->completed_loads);
+    world->next_load_ticket = 0;
+    world->loads_in_flight = 0;
     
-    // Update sun angle (0 to 2π)
-    world->skybox.sun_angle = world->skybox.time_of_day * 2.0f * M_PI;
+    // Initialize skybox
+    bool sky_ready = skybox_init(&world->skybox, config->star_count);
     
+    if (!sky_ready || !allocate_chunk_window(world, clamp_view_distance(config->view_distance))) {
+        world->view_distance = 0;
+        world->chunk_count = 0;
+        cleanup_voxel_world(world);
+        return false;
+    }
+    return true;
+}
+
+void set_view_distance(VoxelWorld* world, int view_distance) {
+    view_distance = clamp_view_distance(view_distance);
+    if (view_distance == world->view_distance) return;
+    
+    // Park every loaded chunk in the cache so the new window picks it back up.
+    // Loads still in flight carry tickets the new slots will not match.
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            retire_chunk(world, chunk);
+            release_chunk(world, chunk);
+            reset_chunk(chunk, chunk->world_x, chunk->world_z);
+        }
+    }
+    
+    if (!allocate_chunk_window(world, view_distance)) {
+        // Keep the old size; its chunks come back from the cache
+        world->remesh_queue.head = 0;
+        world->remesh_queue.count = 0;
+        world->remesh_queue.overflowed = false;
+        for (int x = 0; x < world->chunk_count; x++) {
+            for (int z = 0; z < world->chunk_count; z++) {
+                request_chunk_load(world, chunk_at_slot(world, x, z));
+            }
+        }
+    }
+}
+
+// Sky colour by time of day: dawn to day over the morning, day to dusk,
+// then dusk to night. Only used to fill the colour table.
+static Color sky_color_at(float t) {
     // Define colors for different times of day
     Color dawn = {0.7f, 0.5f, 0.3f};     // Orange-red
     Color day = {0.4f, 0.6f, 1.0f};      // Bright blue
     Color dusk = {0.7f, 0.5f, 0.3f};     // Orange-red
     Color night = {0.02f, 0.02f, 0.05f}; // Very dark blue-black
     
-    // Interpolate between colors based on time of day
-    float t = world->skybox.time_of_day;
     if (t < 0.25f) {
-        world->skybox.sky_color = interpolate_colors(dawn, day, t * 4.0f);
+        return interpolate_colors(dawn, day, t * 4.0f);
     } else if (t < 0.75f) {
-        world->skybox.sky_color = interpolate_colors(day, dusk, (t - 0.25f) * 2.0f);
-    } else {
-        world->skybox.sky_color = interpolate_colors(dusk, night, (t - 0.75f) * 4.0f);
+        return interpolate_colors(day, dusk, (t - 0.25f) * 2.0f);
     }
-    
-    // Update fog color to match sky color but slightly darker
-    world->skybox.fog_color.r = world->skybox.sky_color.r * 0.8f;
-    world->skybox.fog_color.g = world->skybox.sky_color.g * 0.8f;
-    world->skybox.fog_color.b = world->skybox.sky_color.b * 0.8f;
-}
-
-void render_skybox(VoxelWorld* world) {
-    // Save current matrix
-    glPushMatrix();
-    
-    // Reset the modelview matrix to identity
-    glLoadIdentity();
-    
-    // Disable depth testing and lighting for skybox
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_LIGHTING);
-    
-    // Set sky color
-    glClearColor(world->skybox.sky_color.r,
-                 world->skybox.sky_color.g,
-                 world->skybox.sky_color.b,
-                 1.0f);
-    
-    // Set fog color
-    glFogfv(GL_FOG_COLOR, (float*)&world->skybox.fog_color);
-    
-    // Draw skybox cube
-    float size = 100.0f;  // Size of the skybox cube
-    
-    glBegin(GL_QUADS);
-    
-    // Front face
-    glColor3f(world->skybox.sky_color.r * 0.8f,
-              world->skybox.sky_color.g * 0.8f,
-              world->skybox.sky_color.b * 0.8f);
-    glVertex3f(-size, -size, size);
-    glVertex3f(size, -size, size);
-    glVertex3f(size, size, size);
-    glVertex3f(-size, size, size);
-    
-    // Back face
-    glColor3f(world->skybox.sky_color.r * 0.8f,
-              world->skybox.sky_color.g * 0.8f,
-              world->skybox.sky_color.b * 0.8f);
-    glVertex3f(-size, -size, -size);
-    glVertex3f(-size, size, -size);
-    glVertex3f(size, size, -size);
-    glVertex3f(size, -size, -size);
-    
-    // Top face
-    glColor3f(world->skybox.sky_color.r,
-              world->skybox.sky_color.g,
-              world->skybox.sky_color.b);
-    glVertex3f(-size, size, -size);
-    glVertex3f(-size, size, size);
-    glVertex3f(size, size, size);
-    glVertex3f(size, size, -size);
-    
-    // Bottom face
-    glColor3f(world->skybox.sky_color.r * 0.6f,
-              world->skybox.sky_color.g * 0.6f,
-              world->skybox.sky_color.b * 0.6f);
-    glVertex3f(-size, -size, -size);
-    glVertex3f(size, -size, -size);
-    glVertex3f(size, -size, size);
-    glVertex3f(-size, -size, size);
-    
-    // Right face
-    glColor3f(world->skybox.sky_color.r * 0.9f,
-              world->skybox.sky_color.g * 0.9f,
-              world->skybox.sky_color.b * 0.9f);
-    glVertex3f(size, -size, -size);
-    glVertex3f(size, size, -size);
-    glVertex3f(size, size, size);
-    glVertex3f(size, -size, size);
-    
-    // Left face
-    glColor3f(world->skybox.sky_color.r * 0.9f,
-              world->skybox.sky_color.g * 0.9f,
-              world->skybox.sky_color.b * 0.9f);
-    glVertex3f(-size, -size, -size);
-    glVertex3f(-size, -size, size);
-    glVertex3f(-size, size, size);
-    glVertex3f(-size, size, -size);
-    
-    glEnd();
-    
-    // Draw sun during day
-    if (world->skybox.time_of_day >= 0.25f && world->skybox.time_of_day <= 0.75f) {
-        float sun_height = sin(world->skybox.sun_angle) * 50.0f;
-        float sun_x = cos(world->skybox.sun_angle) * 50.0f;
-        
-        glPushMatrix();
-        glTranslatef(sun_x, sun_height, -50.0f);
-        
-        // Draw sun
-        glColor3f(1.0f, 1.0f, 0.8f);
-        glBegin(GL_TRIANGLE_FAN);
-        glVertex3f(0.0f, 0.0f, 0.0f);
-        for (int i = 0; i <= 32; i++) {
-            float angle = i * 2.0f * M_PI / 32.0f;
-            glVertex3f(cos(angle) * 5.0f, sin(angle) * 5.0f, 0.0f);
-        }
-        glEnd();
-        
-        glPopMatrix();
-    }
-    
-    // Draw stars during night (with the skybox)
-    if (world->skybox.time_of_day >= 0.75f || world->skybox.time_of_day <= 0.25f) {
-        glBegin(GL_POINTS);
-        for (int i = 0; i < NUM_STARS; i++) {
-            float brightness = world->skybox.stars[i].brightness;
-            if (world->skybox.time_of_day >= 0.75f) {
-                // Fade in stars during night
-                brightness *= (world->skybox.time_of_day - 0.75f) * 4.0f;
-            } else {
-                // Fade out stars during dawn
-                brightness *= (0.25f - world->skybox.time_of_day) * 4.0f;
-            }
-            glColor3f(brightness, brightness, brightness);
-            glVertex3f(world->skybox.stars[i].position.x,
-                      world->skybox.stars[i].position.y,
-                      world->skybox.stars[i].position.z);
+    return interpolate_colors(dusk, night, (t - 0.75f) * 4.0f);
+}
+
+bool skybox_init(Skybox* skybox, int star_count) {
+    skybox->time_of_day = 0.0f;  // Start at dawn
+    skybox->day_cycle_speed = 1.0f / DAY_LENGTH;
+    skybox->sun_angle = 0.0f;
+    skybox->star_fade = 0.0f;
+    skybox->sky_buffer = 0;
+    skybox->star_buffer = 0;
+    
+    // The colour keys sit on multiples of 1 / SKY_LUT_SIZE, so linear
+    // interpolation between entries reproduces the piecewise curve exactly
+    for (int i = 0; i < SKY_LUT_SIZE; i++) {
+        skybox->sky_lut[i] = sky_color_at((float)i / SKY_LUT_SIZE);
+    }
+    skybox->sky_lut[SKY_LUT_SIZE] = sky_color_at(1.0f);
+    
+    skybox->star_count = star_count > 0 ? star_count : 0;
+    skybox->stars = NULL;
+    if (skybox->star_count > 0) {
+        skybox->stars = malloc(sizeof(Star) * skybox->star_count);
+        if (!skybox->stars) {
+            skybox->star_count = 0;
+            return false;
         }
-        glEnd();
+        init_stars(skybox->stars, skybox->star_count);
+    }
+    skybox_advance(skybox, 0.0f);
+    return true;
+}
+
+void skybox_free(Skybox* skybox) {
+    free(skybox->stars);
+    skybox->stars = NULL;
+    skybox->star_count = 0;
+}
+
+void skybox_advance(Skybox* skybox, float delta_time) {
+    // Update time of day
+    skybox->time_of_day += skybox->day_cycle_speed * delta_time;
+    if (skybox->time_of_day >= 1.0f) {
+        skybox->time_of_day -= 1.0f;
     }
+    float t = skybox->time_of_day;
     
-    // Restore matrix
-    glPopMatrix();
+    // Update sun angle (0 to 2π)
+    skybox->sun_angle = t * 2.0f * M_PI;
+    
+    // Interpolate between the two nearest table entries
+    float position = t * SKY_LUT_SIZE;
+    int index = (int)position;
+    if (index >= SKY_LUT_SIZE) index = SKY_LUT_SIZE - 1;
+    skybox->sky_color = interpolate_colors(skybox->sky_lut[index], skybox->sky_lut[index + 1], position - index);
     
-    // Re-enable depth testing and lighting
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
+    // Update fog color to match sky color but slightly darker
+    skybox->fog_color.r = skybox->sky_color.r * 0.8f;
+    skybox->fog_color.g = skybox->sky_color.g * 0.8f;
+    skybox->fog_color.b = skybox->sky_color.b * 0.8f;
+    
+    // Stars fade in after dusk and out again before mid-morning
+    if (t >= 0.75f) {
+        skybox->star_fade = (t - 0.75f) * 4.0f;
+    } else if (t <= 0.25f) {
+        skybox->star_fade = (0.25f - t) * 4.0f;
+    } else {
+        skybox->star_fade = 0.0f;
+    }
+}
+
+void update_skybox(VoxelWorld* world, float delta_time) {
+    PROFILE_ZONE("update_skybox");
+    skybox_advance(&world->skybox, delta_time);
 }
 
 void update_chunks(VoxelWorld* world, float player_x, float player_z) {
+    PROFILE_ZONE("update_chunks");
+    // Per-frame counters cover everything from here until the next update
+    world->stats.remeshes = 0;
+    world->stats.uploads = 0;
+    world->stats.bytes_uploaded = 0;
+    
+    poll_chunk_loads(world);
+    
     // Convert player position to chunk coordinates
     int new_chunk_x = (int)floorf(player_x / CHUNK_SIZE);
     int new_chunk_z = (int)floorf(player_z / CHUNK_SIZE);
     
     // Check if player has moved to a new chunk
     if (new_chunk_x != world->player_chunk_x || new_chunk_z != world->player_chunk_z) {
-        // Calculate how many chunks to shift
-        int dx = new_chunk_x - world->player_chunk_x;
-        int dz = new_chunk_z - world->player_chunk_z;
-        
-        // Shift chunks array
-        if (dx != 0 || dz != 0) {
-            // Create temporary array for new chunks
-            Chunk new_chunks[CHUNK_COUNT][CHUNK_COUNT];
-            
-            // Initialize new chunks as unloaded
-            for (int x = 0; x < CHUNK_COUNT; x++) {
-                for (int z = 0; z < CHUNK_COUNT; z++) {
-                    new_chunks[x][z].is_loaded = false;
-                    new_chunks[x][z].world_x = world->world_offset_x + (x - VIEW_DISTANCE);
-                    new_chunks[x][z].world_z = world->world_offset_z + (z - VIEW_DISTANCE);
-                }
-            }
-            
-            // Copy existing chunks to their new positions
-            for (int x = 0; x < CHUNK_COUNT; x++) {
-                for (int z = 0; z < CHUNK_COUNT; z++) {
-                    int old_x = x - dx;
-                    int old_z = z - dz;
-                    
-                    if (old_x >= 0 && old_x < CHUNK_COUNT && 
-                        old_z >= 0 && old_z < CHUNK_COUNT) {
-                        new_chunks[x][z] = world->chunks[old_x][old_z];
-                    }
-                }
-            }
+        scroll_chunk_window(world, new_chunk_x, new_chunk_z);
+    }
+    update_chunk_lods(world, player_x, player_z);
+    
+    process_remesh_queue(world, REMESH_BUDGET);
+}
+
+void scroll_chunk_window(VoxelWorld* world, int new_chunk_x, int new_chunk_z) {
+    PROFILE_ZONE("scroll_chunk_window");
+    world->player_chunk_x = new_chunk_x;
+    world->player_chunk_z = new_chunk_z;
+    world->world_offset_x = new_chunk_x;
+    world->world_offset_z = new_chunk_z;
+    
+    // Chunks stay in their ring slot; only slots whose chunk left the
+    // window are reloaded in place, so no block data is moved
+    int evicted_count = 0;
+    
+    for (int x = 0; x < world->chunk_count; x++) {
+        int chunk_x = window_chunk_coord(world, x, new_chunk_x);
+        for (int z = 0; z < world->chunk_count; z++) {
+            int chunk_z = window_chunk_coord(world, z, new_chunk_z);
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            if (chunk->world_x == chunk_x && chunk->world_z == chunk_z) continue;
             
-            // Generate new chunks that need to be loaded
-            for (int x = 0; x < CHUNK_COUNT; x++) {
-                for (int z = 0; z < CHUNK_COUNT; z++) {
-                    if (!new_chunks[x][z].is_loaded) {
-                        generate_chunk_terrain(&new_chunks[x][z]);
-                        new_chunks[x][z].is_loaded = true;
-                    }
-                }
+            if (chunk->is_loaded) {
+                world->evicted[evicted_count].chunk_x = chunk->world_x;
+                world->evicted[evicted_count].chunk_z = chunk->world_z;
+                evicted_count++;
+                retire_chunk(world, chunk);
             }
-            
-            // Update world state
-            for (int x = 0; x < CHUNK_COUNT; x++) {
-                for (int z = 0; z < CHUNK_COUNT; z++) {
-                    world->chunks[x][z] = new_chunks[x][z];
-                }
+            release_chunk(world, chunk);
+            reset_chunk(chunk, chunk_x, chunk_z);
+        }
+    }
+    
+    // Chunks that lost a neighbour must re-emit their border faces
+    for (int i = 0; i < evicted_count; i++) {
+        mark_neighbours_dirty(world, world->evicted[i].chunk_x, world->evicted[i].chunk_z);
+    }
+    
+    // Queue generation of the chunks that entered the window
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            Chunk* chunk = chunk_at_slot(world, x, z);
+            if (!chunk->is_loaded && !chunk->load_pending) {
+                request_chunk_load(world, chunk);
             }
-            
-            world->player_chunk_x = new_chunk_x;
-            world->player_chunk_z = new_chunk_z;
-            world->world_offset_x += dx;
-            world->world_offset_z += dz;
         }
     }
 }
 
-void generate_chunk_terrain(Chunk* chunk) {
-    // Simple terrain generation with smoother transitions
+_Static_assert(NOISE_GRID_SIZE == CHUNK_SIZE, "terrain noise is batched one chunk at a time");
+
+void generate_terrain_blocks(int chunk_x, int chunk_z, unsigned int seed, DenseBlocks blocks) {
+    // Heightmap for the whole chunk in one batched noise call
+    float heights[CHUNK_SIZE * CHUNK_SIZE];
+    noise_fbm_grid(seed, chunk_x * CHUNK_SIZE, chunk_z * CHUNK_SIZE,
+                   TERRAIN_FREQUENCY, TERRAIN_OCTAVES, heights);
+    
     for (int x = 0; x < CHUNK_SIZE; x++) {
         for (int z = 0; z < CHUNK_SIZE; z++) {
-            // Calculate world coordinates for this block
-            float world_x = (chunk->world_x * CHUNK_SIZE + x) * 0.05f;  // Reduced frequency for smoother terrain
-            float world_z = (chunk->world_z * CHUNK_SIZE + z) * 0.05f;
-            
-            // Use noise for height variation with smoother transitions
-            float height_noise = noise2d(world_x, world_z);
-            int ground_height = WORLD_HEIGHT / 2 + (int)(height_noise * 8); // Increased height variation
+            float height_noise = heights[x * CHUNK_SIZE + z];
+            int ground_height = WORLD_HEIGHT / 2 + (int)(height_noise * TERRAIN_AMPLITUDE);
             
             // Ensure ground height stays within bounds
             if (ground_height < 0) ground_height = 0;
@@ -312,124 +728,110 @@ void generate_chunk_terrain(Chunk* chunk) {
             // Fill blocks from bottom to ground
             for (int y = 0; y < WORLD_HEIGHT; y++) {
                 if (y < ground_height) {
-                    chunk->blocks[x][y][z] = 1; // Dirt
+                    blocks[x][y][z] = BLOCK_DIRT;
                 } else if (y == ground_height) {
-                    chunk->blocks[x][y][z] = 2; // Grass
+                    blocks[x][y][z] = BLOCK_GRASS;
                 } else {
-                    chunk->blocks[x][y][z] = 0; // Air
+                    blocks[x][y][z] = 0; // Air
                 }
             }
         }
     }
 }
 
-void render_chunk(Chunk* chunk) {
-    if (!chunk->is_loaded) return;
-    
-    glBegin(GL_QUADS);
-    
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < WORLD_HEIGHT; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                if (chunk->blocks[x][y][z] == 0) continue; // Skip air blocks
-                
-                // Set color based on block type
-                switch (chunk->blocks[x][y][z]) {
-                    case 1: // Dirt
-                        glColor3f(0.6f, 0.3f, 0.0f);
-                        break;
-                    case 2: // Grass
-                        glColor3f(0.0f, 0.8f, 0.0f);
-                        break;
-                }
-                
-                float x0 = x;
-                float x1 = x + 1.0f;
-                float y0 = y;
-                float y1 = y + 1.0f;
-                float z0 = z;
-                float z1 = z + 1.0f;
-                
-                // Front face
-                glColor3f(0.8f, 0.4f, 0.0f); // Slightly different colors for each face
-                glVertex3f(x0, y0, z0);
-                glVertex3f(x1, y0, z0);
-                glVertex3f(x1, y1, z0);
-                glVertex3f(x0, y1, z0);
-                
-                // Back face
-                glColor3f(0.7f, 0.35f, 0.0f);
-                glVertex3f(x0, y0, z1);
-                glVertex3f(x0, y1, z1);
-                glVertex3f(x1, y1, z1);
-                glVertex3f(x1, y0, z1);
-                
-                // Top face
-                glColor3f(0.0f, 0.8f, 0.0f);
-                glVertex3f(x0, y1, z0);
-                glVertex3f(x1, y1, z0);
-                glVertex3f(x1, y1, z1);
-                glVertex3f(x0, y1, z1);
-                
-                // Bottom face
-                glColor3f(0.5f, 0.25f, 0.0f);
-                glVertex3f(x0, y0, z0);
-                glVertex3f(x0, y0, z1);
-                glVertex3f(x1, y0, z1);
-                glVertex3f(x1, y0, z0);
-                
-                // Right face
-                glColor3f(0.65f, 0.325f, 0.0f);
-                glVertex3f(x1, y0, z0);
-                glVertex3f(x1, y0, z1);
-                glVertex3f(x1, y1, z1);
-                glVertex3f(x1, y1, z0);
-                
-                // Left face
-                glColor3f(0.75f, 0.375f, 0.0f);
-                glVertex3f(x0, y0, z0);
-                glVertex3f(x0, y1, z0);
-                glVertex3f(x0, y1, z1);
-                glVertex3f(x0, y0, z1);
-            }
-        }
-    }
-    
-    glEnd();
+void generate_chunk_terrain(Chunk* chunk, unsigned int seed) {
+    DenseBlocks blocks;
+    generate_terrain_blocks(chunk->world_x, chunk->world_z, seed, blocks);
+    chunk_storage_encode(&chunk->storage, blocks);
+    chunk->mesh_dirty = true;
 }
 
 unsigned char get_block(VoxelWorld* world, int x, int y, int z) {
-    int chunk_x = x / CHUNK_SIZE - world->world_offset_x + VIEW_DISTANCE;
-    int chunk_z = z / CHUNK_SIZE - world->world_offset_z + VIEW_DISTANCE;
-    
-    if (chunk_x < 0 || chunk_x >= CHUNK_COUNT || 
-        chunk_z < 0 || chunk_z >= CHUNK_COUNT ||
-        y < 0 || y >= WORLD_HEIGHT) {
+    if (y < 0 || y >= WORLD_HEIGHT) {
         return 0; // Air outside world bounds
     }
     
-    int local_x = x % CHUNK_SIZE;
-    int local_z = z % CHUNK_SIZE;
+    int chunk_x = block_to_chunk(x);
+    int chunk_z = block_to_chunk(z);
+    Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+    if (!chunk) {
+        return 0;
+    }
+    
+    int local_x = x - chunk_x * CHUNK_SIZE;
+    int local_z = z - chunk_z * CHUNK_SIZE;
     
-    return world->chunks[chunk_x][chunk_z].blocks[local_x][y][local_z];
+    return chunk_storage_get(&chunk->storage, local_x, y, local_z);
 }
 
 void set_block(VoxelWorld* world, int x, int y, int z, unsigned char block_type) {
-    int chunk_x = x / CHUNK_SIZE - world->world_offset_x + VIEW_DISTANCE;
-    int chunk_z = z / CHUNK_SIZE - world->world_offset_z + VIEW_DISTANCE;
+    if (y < 0 || y >= WORLD_HEIGHT) {
+        return;
+    }
     
-    if (chunk_x < 0 || chunk_x >= CHUNK_COUNT || 
-        chunk_z < 0 || chunk_z >= CHUNK_COUNT ||
-        y < 0 || y >= WORLD_HEIGHT) {
+    int chunk_x = block_to_chunk(x);
+    int chunk_z = block_to_chunk(z);
+    Chunk* chunk = find_chunk(world, chunk_x, chunk_z);
+    if (!chunk) {
         return;
     }
     
-    int local_x = x % CHUNK_SIZE;
-    int local_z = z % CHUNK_SIZE;
+    int local_x = x - chunk_x * CHUNK_SIZE;
+    int local_z = z - chunk_z * CHUNK_SIZE;
     
-    world->chunks[chunk_x][chunk_z].blocks[local_x][y][local_z] = block_type;
+    unsigned char old_type = chunk_storage_get(&chunk->storage, local_x, y, local_z);
+    if (old_type == block_type) {
+        return;
+    }
+    chunk_storage_set(&chunk->storage, local_x, y, local_z, block_type);
+    chunk->needs_save = true;
+    mark_chunk_dirty(world, chunk);
+    world->stats.voxels_relit += light_update_block(world, x, y, z, old_type, block_type);
+    
+    // Edits on a shared edge change what the neighbour can see
+    if (local_x == 0) mark_chunk_dirty_at(world, chunk_x - 1, chunk_z);
+    if (local_x == CHUNK_SIZE - 1) mark_chunk_dirty_at(world, chunk_x + 1, chunk_z);
+    if (local_z == 0) mark_chunk_dirty_at(world, chunk_x, chunk_z - 1);
+    if (local_z == CHUNK_SIZE - 1) mark_chunk_dirty_at(world, chunk_x, chunk_z + 1);
 }
 
 void cleanup_voxel_world(VoxelWorld* world) {
-    // Nothing to clean up in this simple implementation
+    // Everything still in view or in the cache is written back along with
+    // earlier evictions
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            save_chunk(world, chunk_at_slot(world, x, z));
+        }
+    }
+    world->cache.byte_limit = 0;
+    trim_chunk_cache(world);
+    
+    // Let in-flight loads and write-backs finish, then discard loaded results
+    job_system_destroy(world->jobs);
+    world->jobs = NULL;
+    CompletionNode* node = completion_queue_take_all(&world->completed_loads);
+    while (node) {
+        ChunkLoadJob* job = (ChunkLoadJob*)node;
+        node = node->next;
+        chunk_storage_free(&job->chunk.storage);
+        chunk_light_free(&job->chunk.light);
+        free(job);
+    }
+    world->loads_in_flight = 0;
+    region_store_close(world->regions);
+    world->regions = NULL;
+    
+    for (int x = 0; x < world->chunk_count; x++) {
+        for (int z = 0; z < world->chunk_count; z++) {
+            release_chunk(world, chunk_at_slot(world, x, z));
+        }
+    }
+    free_chunk_window(world);
+    skybox_free(&world->skybox);
+    
+    // Ranges the renderer never collected go with its buffer
+    free(world->retired_ranges);
+    world->retired_ranges = NULL;
+    world->retired_count = 0;
+    world->retired_capacity = 0;
 } 
\ No newline at end of file
@@ -1,16 +1,34 @@
 #ifndef VOXEL_WORLD_H
 #define VOXEL_WORLD_H
 
-#include <SDL.h>
-#include <OpenGL/gl.h>
 #include <stdbool.h>
+#include "job_system.h"
+#include "chunk_storage.h"
+#include "region_file.h"
+#include "chunk_cache.h"
+#include "vertex_arena.h"
 
-#define CHUNK_SIZE 16
-#define WORLD_HEIGHT 32
-#define VIEW_DISTANCE 4  // Number of chunks visible in each direction
-#define CHUNK_COUNT (VIEW_DISTANCE * 2 + 1)  // Total chunks in view (including center)
+#define DEFAULT_VIEW_DISTANCE 4  // Number of chunks visible in each direction
+#define MAX_VIEW_DISTANCE 32
+#define DEFAULT_CHUNK_CACHE_BYTES (16u << 20)  // Memory for chunks kept after leaving the view
 #define DAY_LENGTH 1200.0f  // Length of a full day cycle in seconds
-#define NUM_STARS 1000  // Number of stars in the night sky
+#define NUM_STARS 1000  // Default number of stars in the night sky
+#define SKY_LUT_SIZE 256  // Entries in the time-of-day sky colour table
+#define DEFAULT_WORLD_SEED 1337u
+#define TERRAIN_FREQUENCY 0.05f  // Noise samples per block; lower is smoother
+#define TERRAIN_OCTAVES 4
+#define TERRAIN_AMPLITUDE 10.0f  // Blocks of height variation around WORLD_HEIGHT / 2
+#define REMESH_BUDGET 8  // Maximum chunk remeshes per frame
+#define SKIN_CELL_SIZE 4  // Block columns per side of one occluder cell
+#define SKIN_CELLS (CHUNK_SIZE / SKIN_CELL_SIZE)
+#define LOD_LEVELS 4  // Full detail, then meshes downsampled 2x, 4x and 8x
+#define DEFAULT_LOD_RING 4  // Chunks of full detail around the player; each further ring doubles
+#define LOD_HYSTERESIS 0.5f  // Chunks a chunk must be past a ring before it changes level
+#define MAX_LIGHT 15  // Light level of open sky and of emissive blocks
+#define BLOCK_DIRT 1
+#define BLOCK_GRASS 2
+#define BLOCK_LAMP 3  // Emissive block type; glows at MAX_LIGHT
+#define BLOCK_TYPE_COUNT 4  // Including air (0)
 
 typedef struct {
     float r, g, b;
@@ -25,42 +43,236 @@ typedef struct {
     float brightness;
 } Star;
 
+// Sky state. The stars never move, so the renderer uploads them once and
+// draws them with a single fade per frame; the sky colour is looked up in a
+// table built at init rather than recomputed, so a frame costs the same
+// whatever the star count.
 typedef struct {
     Color sky_color;
     Color fog_color;
     float time_of_day;  // 0.0 to 1.0, where 0.0 is dawn
     float day_cycle_speed;
-    Star stars[NUM_STARS];
+    Star* stars;
+    int star_count;
+    float star_fade;  // Brightness scale of the stars now, 0 while they are hidden
     float sun_angle;  // Angle of the sun in radians
+    Color sky_lut[SKY_LUT_SIZE + 1];  // Sky colour at time i / SKY_LUT_SIZE; the last entry ends the night
+    unsigned int sky_buffer;  // GPU buffers of the sky geometry and the stars; 0 until the renderer uploads them
+    unsigned int star_buffer;
 } Skybox;
 
+// Chunk mesh vertex as stored and uploaded: 64 bits. The low word holds the
+// chunk-local corner, the face and its shading inputs; the colour is looked
+// up from them when the vertex is drawn (see chunk_mesh_decode_vertex).
+// The high word places the chunk, wrapped to 16 bits per axis, so vertices
+// of every chunk can share one buffer and one draw.
 typedef struct {
-    unsigned char blocks[CHUNK_SIZE][WORLD_HEIGHT][CHUNK_SIZE];
+    uint32_t fields;  // Bit fields, lowest first: see the PACKED_* shifts
+    int16_t chunk_x;  // Chunk coordinates, wrapped to 16 bits
+    int16_t chunk_z;
+} PackedVertex;
+
+#define PACKED_X_SHIFT 0  // 5 bits, 0 to CHUNK_SIZE
+#define PACKED_Y_SHIFT 5  // 6 bits, 0 to WORLD_HEIGHT
+#define PACKED_Z_SHIFT 11  // 5 bits, 0 to CHUNK_SIZE
+#define PACKED_NORMAL_SHIFT 16  // 3 bits: axis * 2 + side, side 1 facing +axis
+#define PACKED_AO_SHIFT 19  // 2 bits: occlusion of the corner, 0 (inside corner) to 3 (open)
+#define PACKED_LIGHT_SHIFT 21  // 5 bits: light in front of the face, or PACKED_LIGHT_EMISSIVE
+#define PACKED_BLOCK_SHIFT 26  // 6 bits: block type
+#define PACKED_LIGHT_EMISSIVE (MAX_LIGHT + 1)  // Face glows at full brightness whatever its light
+#define PACKED_LIGHT_LEVELS (MAX_LIGHT + 2)
+
+// A chunk mesh vertex decoded to floats, in chunk-local block coordinates
+typedef struct {
+    float x, y, z;
+    unsigned char r, g, b;  // Block colour with light and ambient occlusion applied
+    unsigned char ao;  // Occlusion of this corner, 0 (inside corner) to 3 (open)
+} MeshVertex;
+
+// CPU-side chunk geometry. Each quad is stored as two triangles,
+// QUAD_VERTICES vertices, split along the diagonal the mesher picked: the
+// quad's corners in winding order are its vertices 0, 1, 2 and 5, and both
+// triangles share the diagonal from vertex 0 to vertex 2.
+// Quads are grouped by vertical section so each section can be drawn alone.
+#define QUAD_VERTICES 6
+
+typedef struct {
+    PackedVertex* vertices;
+    int vertex_count;
+    int capacity;
+    int quad_count;
+    int section_first[SECTIONS_PER_CHUNK];  // First vertex of each section's quads
+    int section_vertex_count[SECTIONS_PER_CHUNK];
+    int lod;  // Level of detail the mesh was built at
+    // Per cell of SKIN_CELL_SIZE^2 columns, the height every column is solid
+    // up to from y = 0; used as occluders
+    unsigned char skin_height[SKIN_CELLS][SKIN_CELLS];
+} ChunkMesh;
+
+typedef struct {
+    ChunkStorage storage;  // Palette-compressed blocks; use chunk_storage_get/set
+    ChunkLight light;  // Sky light in the high nibble, block light in the low; maintained by lighting.c
     bool is_loaded;
+    ChunkMesh mesh;
+    bool mesh_dirty;  // Blocks changed since the mesh was last built
+    int lod;  // Level of detail to mesh at: cells of (1 << lod)^3 blocks
+    bool in_remesh_queue;
+    int vbo_first;  // First vertex of the renderer's range in its shared vertex buffer
+    int vbo_capacity;  // Vertices reserved in that range; 0 until first upload
+    int vbo_vertex_count;
+    int vbo_section_first[SECTIONS_PER_CHUNK];  // Section vertex ranges of the uploaded mesh
+    int vbo_section_count[SECTIONS_PER_CHUNK];
+    bool vbo_stale;  // Mesh rebuilt since the last upload
+    bool needs_save;  // Blocks differ from the saved copy (freshly generated or edited)
+    bool load_pending;  // Waiting for a background generation job
+    unsigned int load_ticket;  // Identifies the job this slot is waiting for
     int world_x;  // World coordinates of this chunk
     int world_z;
 } Chunk;
 
+// Read-only views of a chunk's four horizontal neighbours; NULL when not loaded
+typedef struct {
+    const Chunk* neg_x;
+    const Chunk* pos_x;
+    const Chunk* neg_z;
+    const Chunk* pos_z;
+} ChunkNeighbours;
+
+// Chunk coordinates of a chunk waiting to be remeshed
+typedef struct {
+    int chunk_x;
+    int chunk_z;
+} RemeshRequest;
+
+// Bounded FIFO of dirty chunks, one entry per chunk in the window
+typedef struct {
+    RemeshRequest* entries;
+    int capacity;
+    int head;
+    int count;
+    bool overflowed;  // Some dirty chunk could not be queued; rescan when drained
+} RemeshQueue;
+
+typedef struct {
+    int remeshes;  // Chunks remeshed this frame
+    int uploads;  // Chunk meshes uploaded to the GPU this frame
+    long bytes_uploaded;  // Vertex bytes uploaded to the GPU this frame
+    long total_remeshes;
+    long total_bytes_uploaded;
+    long chunks_generated;  // Totals since init
+    long chunks_loaded;  // Chunks read back from region files instead of generated
+    long chunks_saved;  // Chunks queued for write-back on eviction or shutdown
+    long lod_changes;  // Chunks moved to another level of detail
+    long voxels_relit;  // Voxels whose light changed after chunks were published or edited
+} WorldStats;
+
+// World creation options
+typedef struct {
+    int worker_count;  // Generation threads; 0 picks one per spare core, negative generates inline
+    unsigned int seed;  // Terrain seed; the same seed always produces the same world
+    const char* save_directory;  // Region files for visited chunks; NULL keeps nothing on disk
+    int view_distance;  // Chunks visible in each direction, 1..MAX_VIEW_DISTANCE
+    size_t cache_bytes;  // Memory cap for chunks kept after leaving the view; 0 disables the cache
+    int lod_rings[LOD_LEVELS - 1];  // Chunk distance beyond which each coarser level is used; 0 ends the list
+    int star_count;  // Stars in the night sky
+} WorldConfig;
+
 typedef struct {
-    Chunk chunks[CHUNK_COUNT][CHUNK_COUNT];
+    // Toroidal ring buffer of chunk_count x chunk_count slots: chunk (cx, cz)
+    // lives in slot (cx mod chunk_count, cz mod chunk_count) while it is in view
+    Chunk* chunks;
+    int view_distance;  // Number of chunks visible in each direction
+    int chunk_count;  // Slots per side of the window (view_distance * 2 + 1)
+    int lod_rings[LOD_LEVELS - 1];  // See WorldConfig
+    RemeshRequest* evicted;  // Scratch list of chunks leaving the window
     int player_chunk_x;  // Current chunk coordinates of player
     int player_chunk_z;
     int world_offset_x;  // World coordinates of center chunk
     int world_offset_z;
     Skybox skybox;
+    RemeshQueue remesh_queue;
+    WorldStats stats;
+    unsigned int seed;
+    JobSystem* jobs;  // Background chunk generation; NULL generates inline
+    RegionStore* regions;  // Saved chunks; NULL when the world is not persisted
+    ChunkCache cache;  // Recently evicted chunks, reused before disk or generation
+    ArenaRange* retired_ranges;  // Vertex buffer ranges of released chunks, freed by the renderer
+    int retired_count;
+    int retired_capacity;
+    CompletionQueue completed_loads;  // Generated chunks waiting to be published
+    unsigned int next_load_ticket;
+    int loads_in_flight;
 } VoxelWorld;
 
-// Initialize the voxel world
-void init_voxel_world(VoxelWorld* world);
+// Initialize the voxel world, generating chunks on one worker per spare core.
+// Returns false if the chunk window could not be allocated.
+bool init_voxel_world(VoxelWorld* world);
+
+// Default world options: background generation, DEFAULT_WORLD_SEED,
+// DEFAULT_VIEW_DISTANCE and level of detail rings from DEFAULT_LOD_RING
+WorldConfig default_world_config(void);
+
+// Initialize the voxel world with explicit options; false if the window could not be allocated
+bool init_voxel_world_with_config(VoxelWorld* world, const WorldConfig* config);
+
+// Resize the chunk window. Chunks already in view pass through the chunk
+// cache, so only chunks new to the window are loaded or generated.
+void set_view_distance(VoxelWorld* world, int view_distance);
+
+// Window slot (0..chunk_count-1 on each axis)
+static inline Chunk* chunk_at_slot(VoxelWorld* world, int slot_x, int slot_z) {
+    return &world->chunks[slot_x * world->chunk_count + slot_z];
+}
+
+// Publish chunks finished by background generation jobs
+void poll_chunk_loads(VoxelWorld* world);
+
+// Block until every requested chunk has been generated and published
+void wait_for_chunk_loads(VoxelWorld* world);
 
 // Update chunks based on player position
 void update_chunks(VoxelWorld* world, float player_x, float player_z);
 
-// Generate terrain for a chunk
-void generate_chunk_terrain(Chunk* chunk);
+// Level of detail for a chunk `distance` chunks from the player that is
+// now at `current`: a ring must be passed by LOD_HYSTERESIS to change level
+int chunk_lod_for_distance(const VoxelWorld* world, float distance, int current);
+
+// Move chunks between levels of detail by their distance from the player,
+// remeshing the ones that change along with their neighbours' seams
+void update_chunk_lods(VoxelWorld* world, float player_x, float player_z);
+
+// Recentre the chunk window on a chunk, regenerating only the chunks that
+// entered the window
+void scroll_chunk_window(VoxelWorld* world, int chunk_x, int chunk_z);
+
+// Generate the dense blocks of a chunk; a pure function of the seed and chunk coordinates
+void generate_terrain_blocks(int chunk_x, int chunk_z, unsigned int seed, DenseBlocks blocks);
+
+// Generate terrain for a chunk into its compressed storage
+void generate_chunk_terrain(Chunk* chunk, unsigned int seed);
 
-// Render a chunk
-void render_chunk(Chunk* chunk);
+// Chunk coordinate of the chunk holding a world block coordinate; rounds
+// down, so negative coordinates map to the right chunk
+static inline int block_to_chunk(int block) {
+    int q = block / CHUNK_SIZE;
+    if (block % CHUNK_SIZE != 0 && block < 0) q--;
+    return q;
+}
+
+// Find a loaded chunk by chunk coordinates, or NULL if it is outside the view
+Chunk* find_chunk(VoxelWorld* world, int chunk_x, int chunk_z);
+
+// Collect the loaded horizontal neighbours of a chunk
+ChunkNeighbours get_chunk_neighbours(VoxelWorld* world, const Chunk* chunk);
+
+// Mark a chunk's mesh out of date and queue it for remeshing
+void mark_chunk_dirty(VoxelWorld* world, Chunk* chunk);
+
+// The same for the chunk at chunk coordinates, if it is loaded
+void mark_chunk_dirty_at(VoxelWorld* world, int chunk_x, int chunk_z);
+
+// Rebuild up to `budget` queued chunk meshes; returns the number rebuilt
+int process_remesh_queue(VoxelWorld* world, int budget);
 
 // Get block at world coordinates
 unsigned char get_block(VoxelWorld* world, int x, int y, int z);
@@ -68,12 +280,20 @@ unsigned char get_block(VoxelWorld* world, int x, int y, int z);
 // Set block at world coordinates
 void set_block(VoxelWorld* world, int x, int y, int z, unsigned char block_type);
 
+// Set up a skybox at dawn with `star_count` randomly placed stars and its
+// colour table; returns false if the stars could not be allocated
+bool skybox_init(Skybox* skybox, int star_count);
+
+// Free the stars; GPU buffers belong to the renderer
+void skybox_free(Skybox* skybox);
+
+// Advance the time of day and update the sky and fog colours, sun angle and
+// star fade. Constant time whatever the star count.
+void skybox_advance(Skybox* skybox, float delta_time);
+
 // Update skybox colors based on time of day
 void update_skybox(VoxelWorld* world, float delta_time);
 
-// Render the skybox
-void render_skybox(VoxelWorld* world);
-
 // Clean up the voxel world
 void cleanup_voxel_world(VoxelWorld* world);
 
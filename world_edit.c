@@ -0,0 +1,445 @@
+#include "world_edit.h"
+#include "lighting.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EDIT_INCREMENTAL_LIMIT 64  // Block writes up to which an edit relights block by block
+
+// A chunk an edit changed, with the columns it changed blocks in: local
+// x and z bounds [lo, hi)
+typedef struct {
+    Chunk* chunk;
+    int lo[2];
+    int hi[2];
+} EditedChunk;
+
+// Chunks changed so far by one edit, each listed once. A small edit updates
+// light block by block as it goes, as set_block does, which costs less than
+// relighting its chunks from scratch.
+typedef struct {
+    VoxelWorld* world;
+    EditedChunk* chunks;
+    int count;
+    int* slot_entry;  // Entry of each window slot's chunk in `chunks`, or -1
+    long changed;
+    bool incremental;  // Light is updated per block rather than in batch_finish
+} EditBatch;
+
+// Change the blocks of one chunk inside its local bounds [lo, hi); `base`
+// is the world position of the chunk's block (0, 0, 0). Returns the blocks
+// changed.
+typedef long (*ChunkEditFn)(void* context, DenseBlocks blocks, const int base[3], const int lo[3], const int hi[3]);
+
+static int slot_of(const VoxelWorld* world, const Chunk* chunk) {
+    return (int)(chunk - world->chunks);
+}
+
+// Start an edit that writes at most `writes` blocks
+static bool batch_begin(EditBatch* batch, VoxelWorld* world, long writes) {
+    int slots = world->chunk_count * world->chunk_count;
+    *batch = (EditBatch){world, malloc(sizeof(EditedChunk) * slots), 0, malloc(sizeof(int) * slots), 0,
+                         writes <= EDIT_INCREMENTAL_LIMIT};
+    if (!batch->chunks || !batch->slot_entry) {
+        free(batch->chunks);
+        free(batch->slot_entry);
+        return false;
+    }
+    for (int i = 0; i < slots; i++) batch->slot_entry[i] = -1;
+    return true;
+}
+
+static void batch_add(EditBatch* batch, Chunk* chunk, const int lo[3], const int hi[3], long changed) {
+    int slot = slot_of(batch->world, chunk);
+    if (batch->slot_entry[slot] < 0) {
+        batch->slot_entry[slot] = batch->count;
+        batch->chunks[batch->count++] = (EditedChunk){chunk, {lo[0], lo[2]}, {hi[0], hi[2]}};
+    }
+    EditedChunk* entry = &batch->chunks[batch->slot_entry[slot]];
+    for (int i = 0; i < 2; i++) {
+        if (lo[i * 2] < entry->lo[i]) entry->lo[i] = lo[i * 2];
+        if (hi[i * 2] > entry->hi[i]) entry->hi[i] = hi[i * 2];
+    }
+    batch->changed += changed;
+}
+
+// True if light from blocks changed in the entry's columns can reach the
+// neighbour chunk at offset (dx, dz): light fades a level per block across,
+// so it stops MAX_LIGHT blocks out from the nearest changed column
+static bool light_reaches(const EditedChunk* entry, int dx, int dz) {
+    int offset[2] = {dx, dz}, distance = 0;
+    for (int i = 0; i < 2; i++) {
+        if (offset[i] < 0) distance += entry->lo[i] + 1;
+        if (offset[i] > 0) distance += CHUNK_SIZE - entry->hi[i] + 1;
+    }
+    return distance < MAX_LIGHT;
+}
+
+// Relight the changed chunks and the neighbours their light can reach, then
+// queue every chunk whose blocks or light changed. Light runs out within
+// MAX_LIGHT blocks, less than a chunk, so only the ring of eight neighbours
+// can hold light from a changed chunk, and of those only the ones near
+// enough to the changed columns. An incremental edit is lit already.
+static void relight_batch(EditBatch* batch) {
+    VoxelWorld* world = batch->world;
+    int slots = world->chunk_count * world->chunk_count;
+    Chunk** relit = malloc(sizeof(Chunk*) * slots);
+    bool* in_set = calloc(slots, sizeof(bool));
+    DenseLight* before = NULL;
+    int relit_count = 0;
+    if (relit && in_set) {
+        for (int i = 0; i < batch->count; i++) {
+            const EditedChunk* entry = &batch->chunks[i];
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dz = -1; dz <= 1; dz++) {
+                    if (!light_reaches(entry, dx, dz)) continue;
+                    Chunk* near = find_chunk(world, entry->chunk->world_x + dx, entry->chunk->world_z + dz);
+                    if (!near || in_set[slot_of(world, near)]) continue;
+                    in_set[slot_of(world, near)] = true;
+                    relit[relit_count++] = near;
+                }
+            }
+        }
+        before = malloc(sizeof(DenseLight) * (relit_count + 1));
+    }
+
+    if (before) {
+        for (int i = 0; i < relit_count; i++) {
+            chunk_light_decode(&relit[i]->light, before[i]);
+            light_chunk_local(relit[i]);
+        }
+        for (int i = 0; i < relit_count; i++) light_chunk_borders(world, relit[i]);
+        // The last entry holds each relit chunk's new light in turn
+        for (int i = 0; i < relit_count; i++) {
+            chunk_light_decode(&relit[i]->light, before[relit_count]);
+            const unsigned char* a = &before[i][0][0][0];
+            const unsigned char* b = &before[relit_count][0][0][0];
+            long differences = 0;
+            for (size_t k = 0; k < sizeof(DenseLight); k++) differences += a[k] != b[k];
+            if (differences > 0) mark_chunk_dirty(world, relit[i]);
+            world->stats.voxels_relit += differences;
+        }
+    } else {
+        // Out of memory: relight the changed chunks alone
+        for (int i = 0; i < batch->count; i++) light_chunk_local(batch->chunks[i].chunk);
+        for (int i = 0; i < batch->count; i++) {
+            world->stats.voxels_relit += light_chunk_borders(world, batch->chunks[i].chunk);
+        }
+    }
+    free(before);
+    free(in_set);
+    free(relit);
+}
+
+static void batch_finish(EditBatch* batch) {
+    PROFILE_ZONE("world_edit_finish");
+    VoxelWorld* world = batch->world;
+    if (!batch->incremental) relight_batch(batch);
+
+    // Blocks on an edge change what the neighbour sees
+    for (int i = 0; i < batch->count; i++) {
+        EditedChunk* entry = &batch->chunks[i];
+        Chunk* chunk = entry->chunk;
+        chunk->needs_save = true;
+        mark_chunk_dirty(world, chunk);
+        if (entry->lo[0] == 0) mark_chunk_dirty_at(world, chunk->world_x - 1, chunk->world_z);
+        if (entry->hi[0] == CHUNK_SIZE) mark_chunk_dirty_at(world, chunk->world_x + 1, chunk->world_z);
+        if (entry->lo[1] == 0) mark_chunk_dirty_at(world, chunk->world_x, chunk->world_z - 1);
+        if (entry->hi[1] == CHUNK_SIZE) mark_chunk_dirty_at(world, chunk->world_x, chunk->world_z + 1);
+    }
+    free(batch->chunks);
+    free(batch->slot_entry);
+}
+
+// Write the blocks of a decoded chunk that differ from its storage one at a
+// time, updating light after each as set_block does
+static void apply_incrementally(VoxelWorld* world, Chunk* chunk, const DenseBlocks blocks, const int lo[3],
+                                const int hi[3]) {
+    for (int x = lo[0]; x < hi[0]; x++) {
+        for (int y = lo[1]; y < hi[1]; y++) {
+            for (int z = lo[2]; z < hi[2]; z++) {
+                unsigned char old_type = chunk_storage_get(&chunk->storage, x, y, z);
+                if (old_type == blocks[x][y][z]) continue;
+                chunk_storage_set(&chunk->storage, x, y, z, blocks[x][y][z]);
+                world->stats.voxels_relit += light_update_block(world, chunk->world_x * CHUNK_SIZE + x, y,
+                                                                chunk->world_z * CHUNK_SIZE + z, old_type,
+                                                                blocks[x][y][z]);
+            }
+        }
+    }
+}
+
+// Blocks of a box inside the world's height: the most an edit of it writes
+static long box_volume(const int min[3], const int max[3]) {
+    int y0 = min[1] > 0 ? min[1] : 0, y1 = max[1] < WORLD_HEIGHT ? max[1] : WORLD_HEIGHT;
+    if (y0 >= y1 || min[0] >= max[0] || min[2] >= max[2]) return 0;
+    return (long)(max[0] - min[0]) * (y1 - y0) * (max[2] - min[2]);
+}
+
+// Run `edit` over every loaded chunk the box reaches, with the part of the
+// box inside it, re-encoding the chunks it changed
+static void edit_box(EditBatch* batch, const int min[3], const int max[3], ChunkEditFn edit, void* context) {
+    int y0 = min[1] > 0 ? min[1] : 0, y1 = max[1] < WORLD_HEIGHT ? max[1] : WORLD_HEIGHT;
+    if (y0 >= y1 || min[0] >= max[0] || min[2] >= max[2]) return;
+
+    DenseBlocks blocks;
+    for (int cx = block_to_chunk(min[0]); cx <= block_to_chunk(max[0] - 1); cx++) {
+        for (int cz = block_to_chunk(min[2]); cz <= block_to_chunk(max[2] - 1); cz++) {
+            Chunk* chunk = find_chunk(batch->world, cx, cz);
+            if (!chunk) continue;
+            int base[3] = {cx * CHUNK_SIZE, 0, cz * CHUNK_SIZE};
+            int lo[3] = {min[0] - base[0], y0, min[2] - base[2]};
+            int hi[3] = {max[0] - base[0], y1, max[2] - base[2]};
+            if (lo[0] < 0) lo[0] = 0;
+            if (lo[2] < 0) lo[2] = 0;
+            if (hi[0] > CHUNK_SIZE) hi[0] = CHUNK_SIZE;
+            if (hi[2] > CHUNK_SIZE) hi[2] = CHUNK_SIZE;
+
+            chunk_storage_decode(&chunk->storage, blocks);
+            long changed = edit(context, blocks, base, lo, hi);
+            if (changed == 0) continue;
+            if (batch->incremental) {
+                apply_incrementally(batch->world, chunk, blocks, lo, hi);
+            } else {
+                chunk_storage_encode(&chunk->storage, blocks);
+            }
+            batch_add(batch, chunk, lo, hi, changed);
+        }
+    }
+}
+
+static long fill_chunk(void* context, DenseBlocks blocks, const int base[3], const int lo[3], const int hi[3]) {
+    (void)base;
+    unsigned char block_type = *(const unsigned char*)context;
+    long changed = 0;
+    for (int x = lo[0]; x < hi[0]; x++) {
+        for (int y = lo[1]; y < hi[1]; y++) {
+            unsigned char* row = &blocks[x][y][0];
+            for (int z = lo[2]; z < hi[2]; z++) {
+                changed += row[z] != block_type;
+                row[z] = block_type;
+            }
+        }
+    }
+    return changed;
+}
+
+long world_fill_box(VoxelWorld* world, const int min[3], const int max[3], unsigned char block_type) {
+    PROFILE_ZONE("world_fill_box");
+    EditBatch batch;
+    if (!batch_begin(&batch, world, box_volume(min, max))) return 0;
+    edit_box(&batch, min, max, fill_chunk, &block_type);
+    long changed = batch.changed;
+    batch_finish(&batch);
+    return changed;
+}
+
+typedef struct {
+    float centre[3];
+    float radius_squared;
+    unsigned char block_type;
+} SphereFill;
+
+static long fill_sphere_chunk(void* context, DenseBlocks blocks, const int base[3], const int lo[3],
+                              const int hi[3]) {
+    const SphereFill* sphere = context;
+    long changed = 0;
+    for (int x = lo[0]; x < hi[0]; x++) {
+        float dx = base[0] + x + 0.5f - sphere->centre[0];
+        for (int y = lo[1]; y < hi[1]; y++) {
+            float dy = y + 0.5f - sphere->centre[1];
+            float left = sphere->radius_squared - dx * dx - dy * dy;
+            if (left < 0.0f) continue;
+
+            // The row's run inside the sphere, in block centres
+            float reach = sqrtf(left);
+            int z0 = (int)ceilf(sphere->centre[2] - reach - 0.5f) - base[2];
+            int z1 = (int)floorf(sphere->centre[2] + reach - 0.5f) - base[2] + 1;
+            if (z0 < lo[2]) z0 = lo[2];
+            if (z1 > hi[2]) z1 = hi[2];
+            unsigned char* row = &blocks[x][y][0];
+            for (int z = z0; z < z1; z++) {
+                changed += row[z] != sphere->block_type;
+                row[z] = sphere->block_type;
+            }
+        }
+    }
+    return changed;
+}
+
+long world_fill_sphere(VoxelWorld* world, const float centre[3], float radius, unsigned char block_type) {
+    PROFILE_ZONE("world_fill_sphere");
+    if (!(radius > 0.0f)) return 0;
+    SphereFill sphere = {{centre[0], centre[1], centre[2]}, radius * radius, block_type};
+    int min[3], max[3];
+    for (int axis = 0; axis < 3; axis++) {
+        min[axis] = (int)floorf(centre[axis] - radius);
+        max[axis] = (int)floorf(centre[axis] + radius) + 1;
+    }
+    EditBatch batch;
+    if (!batch_begin(&batch, world, box_volume(min, max))) return 0;
+    edit_box(&batch, min, max, fill_sphere_chunk, &sphere);
+    long changed = batch.changed;
+    batch_finish(&batch);
+    return changed;
+}
+
+typedef struct {
+    const VoxelBuffer* buffer;
+    const int* min;
+    bool skip_air;
+} Paste;
+
+static long paste_chunk(void* context, DenseBlocks blocks, const int base[3], const int lo[3], const int hi[3]) {
+    const Paste* paste = context;
+    const VoxelBuffer* buffer = paste->buffer;
+    long changed = 0;
+    for (int x = lo[0]; x < hi[0]; x++) {
+        int bx = base[0] + x - paste->min[0];
+        for (int y = lo[1]; y < hi[1]; y++) {
+            int by = y - paste->min[1];
+            const unsigned char* source = &buffer->blocks[((size_t)bx * buffer->size[1] + by) * buffer->size[2]];
+            unsigned char* row = &blocks[x][y][0];
+            for (int z = lo[2]; z < hi[2]; z++) {
+                unsigned char block_type = source[base[2] + z - paste->min[2]];
+                if (block_type == 0 && paste->skip_air) continue;
+                changed += row[z] != block_type;
+                row[z] = block_type;
+            }
+        }
+    }
+    return changed;
+}
+
+long world_paste_box(VoxelWorld* world, const int min[3], const VoxelBuffer* buffer, bool skip_air) {
+    PROFILE_ZONE("world_paste_box");
+    Paste paste = {buffer, min, skip_air};
+    int max[3] = {min[0] + buffer->size[0], min[1] + buffer->size[1], min[2] + buffer->size[2]};
+    EditBatch batch;
+    if (!batch_begin(&batch, world, box_volume(min, max))) return 0;
+    edit_box(&batch, min, max, paste_chunk, &paste);
+    long changed = batch.changed;
+    batch_finish(&batch);
+    return changed;
+}
+
+// Position of an edit in the list, keyed by its chunk
+typedef struct {
+    int chunk_x;
+    int chunk_z;
+    int index;
+} EditKey;
+
+static int compare_edit_keys(const void* a, const void* b) {
+    const EditKey* ka = a;
+    const EditKey* kb = b;
+    if (ka->chunk_x != kb->chunk_x) return ka->chunk_x < kb->chunk_x ? -1 : 1;
+    if (ka->chunk_z != kb->chunk_z) return ka->chunk_z < kb->chunk_z ? -1 : 1;
+    return ka->index - kb->index;  // List order within a chunk, so the last edit wins
+}
+
+long world_apply_edits(VoxelWorld* world, const BlockEdit* edits, int count) {
+    PROFILE_ZONE("world_apply_edits");
+    EditKey* keys = malloc(sizeof(EditKey) * (count > 0 ? count : 1));
+    EditBatch batch;
+    if (!keys || !batch_begin(&batch, world, count)) {
+        free(keys);
+        return 0;
+    }
+    int key_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (edits[i].y < 0 || edits[i].y >= WORLD_HEIGHT) continue;
+        keys[key_count++] = (EditKey){block_to_chunk(edits[i].x), block_to_chunk(edits[i].z), i};
+    }
+    qsort(keys, key_count, sizeof(EditKey), compare_edit_keys);
+
+    DenseBlocks blocks;
+    for (int start = 0; start < key_count;) {
+        int end = start + 1;
+        while (end < key_count && keys[end].chunk_x == keys[start].chunk_x &&
+               keys[end].chunk_z == keys[start].chunk_z) {
+            end++;
+        }
+        Chunk* chunk = find_chunk(world, keys[start].chunk_x, keys[start].chunk_z);
+        if (chunk) {
+            if (!batch.incremental) chunk_storage_decode(&chunk->storage, blocks);
+            int lo[3] = {CHUNK_SIZE, 0, CHUNK_SIZE}, hi[3] = {0, WORLD_HEIGHT, 0};
+            long changed = 0;
+            for (int k = start; k < end; k++) {
+                const BlockEdit* edit = &edits[keys[k].index];
+                int x = edit->x - keys[k].chunk_x * CHUNK_SIZE, z = edit->z - keys[k].chunk_z * CHUNK_SIZE;
+                if (batch.incremental) {
+                    unsigned char old_type = chunk_storage_get(&chunk->storage, x, edit->y, z);
+                    if (old_type == edit->block_type) continue;
+                    chunk_storage_set(&chunk->storage, x, edit->y, z, edit->block_type);
+                    world->stats.voxels_relit +=
+                        light_update_block(world, edit->x, edit->y, edit->z, old_type, edit->block_type);
+                } else {
+                    unsigned char* block = &blocks[x][edit->y][z];
+                    if (*block == edit->block_type) continue;
+                    *block = edit->block_type;
+                }
+                changed++;
+                if (x < lo[0]) lo[0] = x;
+                if (x + 1 > hi[0]) hi[0] = x + 1;
+                if (z < lo[2]) lo[2] = z;
+                if (z + 1 > hi[2]) hi[2] = z + 1;
+            }
+            // Edits that set a block and later put it back count as changes
+            // here but leave the chunk as it was; it is relit all the same
+            if (changed > 0) {
+                if (!batch.incremental) chunk_storage_encode(&chunk->storage, blocks);
+                batch_add(&batch, chunk, lo, hi, changed);
+            }
+        }
+        start = end;
+    }
+    free(keys);
+    long changed = batch.changed;
+    batch_finish(&batch);
+    return changed;
+}
+
+bool voxel_buffer_init(VoxelBuffer* buffer, const int size[3]) {
+    size_t volume = (size_t)(size[0] > 0 ? size[0] : 0) * (size[1] > 0 ? size[1] : 0) * (size[2] > 0 ? size[2] : 0);
+    buffer->blocks = calloc(volume > 0 ? volume : 1, 1);
+    for (int axis = 0; axis < 3; axis++) buffer->size[axis] = buffer->blocks && size[axis] > 0 ? size[axis] : 0;
+    return buffer->blocks != NULL;
+}
+
+void voxel_buffer_free(VoxelBuffer* buffer) {
+    free(buffer->blocks);
+    *buffer = (VoxelBuffer){{0, 0, 0}, NULL};
+}
+
+void world_copy_box(VoxelWorld* world, const int min[3], VoxelBuffer* buffer) {
+    PROFILE_ZONE("world_copy_box");
+    const int* size = buffer->size;
+    memset(buffer->blocks, 0, (size_t)size[0] * size[1] * size[2]);
+    int max[3] = {min[0] + size[0], min[1] + size[1], min[2] + size[2]};
+    int y0 = min[1] > 0 ? min[1] : 0, y1 = max[1] < WORLD_HEIGHT ? max[1] : WORLD_HEIGHT;
+    if (y0 >= y1 || size[0] <= 0 || size[2] <= 0) return;
+
+    DenseBlocks blocks;
+    for (int cx = block_to_chunk(min[0]); cx <= block_to_chunk(max[0] - 1); cx++) {
+        for (int cz = block_to_chunk(min[2]); cz <= block_to_chunk(max[2] - 1); cz++) {
+            Chunk* chunk = find_chunk(world, cx, cz);
+            if (!chunk) continue;
+            int base_x = cx * CHUNK_SIZE, base_z = cz * CHUNK_SIZE;
+            int x0 = min[0] > base_x ? min[0] - base_x : 0;
+            int x1 = max[0] < base_x + CHUNK_SIZE ? max[0] - base_x : CHUNK_SIZE;
+            int z0 = min[2] > base_z ? min[2] - base_z : 0;
+            int z1 = max[2] < base_z + CHUNK_SIZE ? max[2] - base_z : CHUNK_SIZE;
+
+            chunk_storage_decode(&chunk->storage, blocks);
+            for (int x = x0; x < x1; x++) {
+                for (int y = y0; y < y1; y++) {
+                    size_t to = ((size_t)(base_x + x - min[0]) * size[1] + (y - min[1])) * size[2] +
+                                (base_z + z0 - min[2]);
+                    memcpy(&buffer->blocks[to], &blocks[x][y][z0], z1 - z0);
+                }
+            }
+        }
+    }
+}
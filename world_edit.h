@@ -0,0 +1,55 @@
+#ifndef WORLD_EDIT_H
+#define WORLD_EDIT_H
+
+#include <stdbool.h>
+#include "voxel_world.h"
+
+// Edits of many blocks at once. An edit works chunk by chunk: each chunk it
+// reaches is expanded to dense blocks once, changed in place and encoded
+// again once. When the whole edit is in, the chunks it changed and the
+// neighbours their light reaches are relit from scratch once, and every
+// chunk whose blocks or light changed is queued for remeshing once;
+// set_block relights and queues per block instead. Edits of only a few
+// blocks update light block by block as set_block does, which is cheaper
+// than relighting whole chunks, and still queue each chunk once.
+//
+// Boxes are half-open [min, max) in world coordinates. Blocks in chunks that
+// are not loaded, or above or below the world, are left alone, as with
+// set_block.
+
+typedef struct {
+    int x, y, z;
+    unsigned char block_type;
+} BlockEdit;
+
+// A box of blocks outside the world, laid out like DenseBlocks: block
+// (x, y, z) is at blocks[(x * size[1] + y) * size[2] + z]
+typedef struct {
+    int size[3];
+    unsigned char* blocks;
+} VoxelBuffer;
+
+// Allocate an all-air buffer; false if out of memory
+bool voxel_buffer_init(VoxelBuffer* buffer, const int size[3]);
+
+void voxel_buffer_free(VoxelBuffer* buffer);
+
+// The edits return how many of their block writes changed a block
+
+long world_fill_box(VoxelWorld* world, const int min[3], const int max[3], unsigned char block_type);
+
+// Fill the blocks whose centres lie within `radius` of `centre`
+long world_fill_sphere(VoxelWorld* world, const float centre[3], float radius, unsigned char block_type);
+
+// Write the buffer into the world with its first block at `min`; air in the
+// buffer is skipped if `skip_air`, so only its solid blocks are stamped
+long world_paste_box(VoxelWorld* world, const int min[3], const VoxelBuffer* buffer, bool skip_air);
+
+// Apply a list of single-block edits; where several hit one block the last wins
+long world_apply_edits(VoxelWorld* world, const BlockEdit* edits, int count);
+
+// Copy the buffer's size of blocks from `min` into it; blocks that are not
+// loaded read as air
+void world_copy_box(VoxelWorld* world, const int min[3], VoxelBuffer* buffer);
+
+#endif // WORLD_EDIT_H